@@ -45,6 +45,7 @@ enum MessageId
       MSGMGR_TEST_TIMER_MSG_ID                 = 0x0007,
       MSGMGR_TEST_DISTRIBUTED_MSG_ID           = 0x0008,
       MSGMGR_TEST_GROUP_MSG_ID                 = 0x0009,
+      MSGMGR_BATCH_MSG_ID                      = 0x000A,
 
    // Process Manager related messages
    PROCMGR_BASE = 0x0400,                      // Platform Subcomponent 1
@@ -30,7 +30,7 @@
 
 #include "platform/logger/Logger.h"
 
-#include "platform/opm/OPM.h"
+#include "platform/opm/OPMPool.h"
 
 //-----------------------------------------------------------------------------
 // Static Declarations.
@@ -207,10 +207,11 @@ int ConnectionSet::performActivation()
    if (handleObjectPoolId_ == 0)
    {
       TRACELOG(DEBUGLOG, DATAMGRLOG, "Creating connection handle objects for All ConnectionSets",0,0,0,0,0,0);
-      // Let the capacity of this pool GROW as needed. Configure the pool to grow 1 at a time, and
+      // Let the capacity of this pool GROW as needed. Configure the pool to grow 10 at a time (each
+      // increment is one contiguous slab, so growing 1 at a time would waste most of a page), and
       // set the initial size of the pool to 10 handlers (Note that this is 10 handlers PER PROCESS)
-      handleObjectPoolId_ = OPM::createPool("DbConnectionHandle", 0, (OPM_INIT_PTR)&DbConnectionHandle::initialize,
-         0.8, 1 , 10 , true, OPM_GROWTH_ALLOWED);
+      handleObjectPoolId_ = OPM::Pool<DbConnectionHandle>::createSlab("DbConnectionHandle", 0,
+         0.8, 10, 10, true, OPM_GROWTH_ALLOWED);
       if (handleObjectPoolId_ == ERROR)
       {
          TRACELOG(ERRORLOG, DATAMGRLOG, "Error creating connection handle pool",0,0,0,0,0,0);
@@ -268,18 +269,7 @@ int ConnectionSet::performDeactivation()
 //-----------------------------------------------------------------------------
 DbConnectionHandle* ConnectionSet::reserveConnection()
 {
-   // Reserve a connection from the OPM based on the connectionObjectPoolId
-   DbConnection* connection = (DbConnection*)OPM_RESERVE(connectionObjectPoolId_);
-
-   // Reserve a connection handle from the OPM
-   DbConnectionHandle* connectionHandle = (DbConnectionHandle*)OPM_RESERVE(handleObjectPoolId_);
-
-   // Store the connection inside the connection handle. ConnectionSet is a 'friend'
-   // of the DbConnectionHandle and so can call associateConnection
-   connectionHandle->associateConnection(connection, connectionSetName_);
-
-   // Return a pointer to the connection handle to the application developer
-   return connectionHandle;
+   return reserveConnection(true);
 }//end reserveConnection
 
 
@@ -290,18 +280,7 @@ DbConnectionHandle* ConnectionSet::reserveConnection()
 //-----------------------------------------------------------------------------
 DbConnectionHandle* ConnectionSet::reserveConnectionNonBlocking()
 {
-   // Reserve a connection from the OPM
-   DbConnection* connection = (DbConnection*)OPM_RESERVE_NONBLOCKED(connectionObjectPoolId_);
-
-   // Reserve a connection handle from the OPM
-   DbConnectionHandle* connectionHandle = (DbConnectionHandle*)OPM_RESERVE(handleObjectPoolId_);
-
-   // Store the connection inside the connection handle. ConnectionSet is a 'friend'
-   // of the DbConnectionHandle and so can call associateConnection
-   connectionHandle->associateConnection(connection, connectionSetName_);
-
-   // Return a pointer to the connection handle to the application developer
-   return connectionHandle;
+   return reserveConnection(false);
 }//end reserveConnectionNonBlocking
 
 
@@ -344,6 +323,39 @@ string ConnectionSet::toString()
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Common implementation of reserveConnection and
+//              reserveConnectionNonBlocking
+// Design:      If either reservation fails, the other object is released back
+//              into its pool (by its scoped pointer) and NULL is returned.
+//-----------------------------------------------------------------------------
+DbConnectionHandle* ConnectionSet::reserveConnection(bool blockWaitingForAccess)
+{
+   // Reserve a connection from the OPM based on the connectionObjectPoolId
+   OPM::Pool<DbConnection>::Ptr connection(connectionObjectPoolId_, blockWaitingForAccess);
+   if (connection.isNull())
+   {
+      return NULL;
+   }//end if
+
+   // Reserve a connection handle from the (typed) OPM pool of handles
+   OPM::Pool<DbConnectionHandle>::Ptr connectionHandle;
+   if (connectionHandle.isNull())
+   {
+      TRACELOG(ERRORLOG, DATAMGRLOG, "OPM returned null connection handle",0,0,0,0,0,0);
+      return NULL;
+   }//end if
+
+   // Store the connection inside the connection handle. ConnectionSet is a 'friend'
+   // of the DbConnectionHandle and so can call associateConnection
+   connectionHandle->associateConnection(connection.detach(), connectionSetName_);
+
+   // Return a pointer to the connection handle to the application developer
+   return connectionHandle.detach();
+}//end reserveConnection
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
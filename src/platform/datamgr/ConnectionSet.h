@@ -160,6 +160,13 @@ class ConnectionSet
        */
       ConnectionSet& operator= (const ConnectionSet& rhs);
 
+      /**
+       * Common implementation of reserveConnection and reserveConnectionNonBlocking
+       * @param blockWaitingForAccess Whether to block until a DbConnection is available
+       * @returns NULL if no DbConnection (or connection handle) is available
+       */
+      DbConnectionHandle* reserveConnection(bool blockWaitingForAccess);
+
       /** Connection Set Name that was parsed from the Configuration file Header section */
       string connectionSetName_; 
 
@@ -19,6 +19,8 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <new>
+
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
@@ -79,6 +81,22 @@ OPMBase* DbConnectionHandle::initialize(int initializer)
 }//end initialize
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method will be called to construct each object in place when
+//              the pool is created as a slab mode pool
+// Design: OPM object creation MUST be successful.
+//-----------------------------------------------------------------------------
+OPMBase* DbConnectionHandle::initializeInPlace(void* memory, long initializer)
+{
+   // Handle unused variable warning
+   initializer = 0;
+
+   // Construct the DbConnectionHandle in the slab memory
+   return (new (memory) DbConnectionHandle());
+}//end initializeInPlace
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Pure Virtual method will be called before releasing the object
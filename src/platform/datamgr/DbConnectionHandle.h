@@ -101,6 +101,16 @@ class DbConnectionHandle : public OPMBase
        */
       static OPMBase* initialize(int initializer);
 
+      /**
+       * Method will be called to construct each object in place when the pool
+       * is created as a slab mode pool (see OPM::createSlabPool).
+       * @param memory - Slab memory (of at least sizeof(DbConnectionHandle) bytes)
+       * @param initializer - Initializer integer or pointer to initialization
+       *      data needed by the object (unused).
+       * @returns Pointer to the new OPMBase object.
+       */
+      static OPMBase* initializeInPlace(void* memory, long initializer);
+
       /**
        * Inherited from OPMBase.
        * Pure Virtual method will be called before releasing the object
@@ -19,7 +19,6 @@
 //-----------------------------------------------------------------------------
 
 #include <ace/Condition_Thread_Mutex.h>
-#include <ace/Select_Reactor.h>
 #include <ace/Thread.h>
 
 //-----------------------------------------------------------------------------
@@ -27,13 +26,13 @@
 //-----------------------------------------------------------------------------
 
 #include "DistributedMailbox.h"
+#include "DistributedMailboxProxy.h"
 #include "MailboxOwnerHandle.h"
 #include "MessageFactory.h"
+#include "ReactorPool.h"
 
 #include "platform/logger/Logger.h"
 
-#include "platform/threadmgr/ThreadManager.h"
-
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
@@ -53,8 +52,8 @@ DistributedMailbox::DistributedMailbox(const MailboxAddress& distributedAddress)
                                        : LocalMailbox(distributedAddress), /* Base class */
                                          distributedAddress_ (distributedAddress),
                                          socketAcceptor_ (NULL),
-                                         messageBuffer_ (MAX_MESSAGE_LENGTH),
-                                         distributedReactor_ (NULL)
+                                         distributedReactor_ (NULL),
+                                         receiveBufferSize_ (0)
 {
 }//end constructor
 
@@ -69,7 +68,15 @@ DistributedMailbox::~DistributedMailbox()
    // Flag that we are shutting down
    isShuttingDown_ = TRUE;
 
-   distributedReactor_->end_reactor_event_loop();
+   // The reactors are shared and outlive the mailbox, so stop them from calling it back
+   if ((socketAcceptor_ != NULL) && (socketAcceptor_->get_handle() != ACE_INVALID_HANDLE))
+   {
+      distributedReactor_->remove_handler(socketAcceptor_->get_handle(),
+         ACE_Event_Handler::READ_MASK | ACE_Event_Handler::DONT_CALL);
+      socketAcceptor_->close();
+   }//end if
+   closeAllConnections();
+   delete socketAcceptor_;
 }//end virtual destructor
 
 
@@ -88,32 +95,26 @@ int DistributedMailbox::activate(MailboxOwnerHandle* mailboxOwnerHandle)
    // Begin listening for socket IO
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed Mailbox activate is called",0,0,0,0,0,0);
 
-   // Base class will start the Reactor event loop in a separate thread and
-   // handle mailbox registration. We need to perform this PRIOR to opening the
-   // group mailbox receiver socket, since we will need the ability to post as soon
-   // as we do that.
+   // Base class will handle mailbox registration. We need to perform this
+   // PRIOR to opening the group mailbox receiver socket, since we will need the
+   // ability to post as soon as we do that.
    if (LocalMailbox::activate(mailboxOwnerHandle) == ERROR)
    {
       TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to active Local Mailbox Base for Distributed Mailbox",0,0,0,0,0,0);
       return ERROR;
    }//end if
 
+   // Take the receive buffer size configured for the connections to this address
+   DistributedConnectionOptions options;
+   DistributedMailboxProxy::getConnectionOptions(distributedAddress_, options);
+   receiveBufferSize_ = options.receiveBufferSize;
+
    // For first-time activation, Create the acceptor instance. This also calls
    // the Reactor Singleton which creates the Reactor for the first time.
    if (socketAcceptor_ == NULL)
    {
       // Pass the address to accept/listen on, also specify the REUSE_ADDR flag '1'
       socketAcceptor_ = new ACE_SOCK_Acceptor (distributedAddress_.inetAddress, 1); 
-
-      // Register this instance's handle_input method with the reactor
-      if (distributedReactor_->register_handler(socketAcceptor_->get_handle(), this, ACE_Event_Handler::READ_MASK) == ERROR)
-      {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Register handler failed",0,0,0,0,0,0);
-         // IF this occurs, we need to Deactivate the LocalMailbox base class since that will de-register
-         // from the MailboxLookupService
-         LocalMailbox::deactivate(mailboxOwnerHandle);
-         return ERROR;
-      }//end if
    }//end if
    else
    {
@@ -138,6 +139,17 @@ int DistributedMailbox::activate(MailboxOwnerHandle* mailboxOwnerHandle)
       }//end if
    }//end else
 
+   // Register this instance's handle_input method with the reactor (the acceptor socket is
+   // removed from it on deactivation, so this is done on every activation)
+   if (distributedReactor_->register_handler(socketAcceptor_->get_handle(), this, ACE_Event_Handler::READ_MASK) == ERROR)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Register handler failed",0,0,0,0,0,0);
+      // IF this occurs, we need to Deactivate the LocalMailbox base class since that will de-register
+      // from the MailboxLookupService
+      LocalMailbox::deactivate(mailboxOwnerHandle);
+      return ERROR;
+   }//end if
+
    return OK;
 }//end activate
 
@@ -151,10 +163,16 @@ int DistributedMailbox::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
 {
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed mailbox deactivate is called",0,0,0,0,0,0);
 
-   // Close the listener socket
-   socketAcceptor_->close();
+   // Close the listener socket. It is removed from the reactor first, since the reactor is
+   // shared and a new socket may be given the same handle.
+   if ((socketAcceptor_ != NULL) && (socketAcceptor_->get_handle() != ACE_INVALID_HANDLE))
+   {
+      distributedReactor_->remove_handler(socketAcceptor_->get_handle(),
+         ACE_Event_Handler::READ_MASK | ACE_Event_Handler::DONT_CALL);
+      socketAcceptor_->close();
+   }//end if
 
-   // Base class will end the Reactor processing loop
+   // Base class will handle mailbox deregistration
    return (LocalMailbox::deactivate(mailboxOwnerHandle));
 }//end deactivate
                                                                                                            
@@ -202,20 +220,14 @@ MailboxOwnerHandle* DistributedMailbox::createMailbox(const MailboxAddress& dist
       TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create an owner handle to distributed mailbox",0,0,0,0,0,0);
    }//end else
 
-   // Instantiate the ACE_Select_Reactor used by the LocalMailbox for Timers
-   distributedMailbox->selectReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
-
-   // Create a new ACE_Select_Reactor for the message handling, etc to use
-   distributedMailbox->distributedReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
-
-   // Start the Reactor Event Loop -- used for Timer processing. This has to be
-   // started in a separate thread. Here, returns OS assigned unique thread Id
-   ThreadManager::createThread((ACE_THR_FUNC)LocalMailbox::startReactor,
-      (void*)distributedMailbox->selectReactor_, "LocalMailboxReactor", true);
-
-   // Start the Reactor Event Loop used for socket IO handling
-   ThreadManager::createThread((ACE_THR_FUNC)DistributedMailbox::startReactor,
-      (void*)distributedMailbox->distributedReactor_, "DistributedMailboxReactor", true);
+   // Assign the reactors of the pool used by the LocalMailbox for Timers, and for the
+   // listener socket (the connections are spread over the pool as they are accepted)
+   distributedMailbox->selectReactor_ = ReactorPool::getReactor();
+   distributedMailbox->distributedReactor_ = ReactorPool::getReactor();
+   if ((distributedMailbox->selectReactor_ == NULL) || (distributedMailbox->distributedReactor_ == NULL))
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to assign reactors to the distributed mailbox",0,0,0,0,0,0);
+   }//end if
 
    return mailboxOwnerHandle;
 }//end createMailbox
@@ -257,12 +269,31 @@ int DistributedMailbox::handle_input(ACE_HANDLE handle)
          return ERROR;
       }//end if
 
+      if ((receiveBufferSize_ > 0) &&
+          (newSockStream->set_option(SOL_SOCKET, SO_RCVBUF, &receiveBufferSize_, sizeof(receiveBufferSize_)) == ERROR))
+      {
+         TRACELOG(WARNINGLOG, MSGMGRLOG, "Unable to set receive buffer size %d on distributed mailbox connection (%d)",
+            receiveBufferSize_,errno,0,0,0,0);
+      }//end if
+
       // Insert the new sock stream into our map based on its newly created ACE_HANDLE
       TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed Mailbox storing new connection client",0,0,0,0,0,0);
 
+      ClientConnection* newConnection = new ClientConnection();
+      newConnection->sockStream = newSockStream;
+      newConnection->reactor = ReactorPool::getReactor();
+      newConnection->receivedLength = 0;
+      if (newConnection->reactor == NULL)
+      {
+         newSockStream->close();
+         delete newSockStream;
+         delete newConnection;
+         return OK;
+      }//end if
+
       clientConnectorMapMutex_.acquire();
       pair<ClientConnectorMap::iterator, bool> insertResult;
-      insertResult = clientConnectorMap_.insert(make_pair(newSockStream->get_handle(), newSockStream));
+      insertResult = clientConnectorMap_.insert(make_pair(newSockStream->get_handle(), newConnection));
       // Check to see if the map insert was successful
       if (!insertResult.second)
       {
@@ -270,9 +301,9 @@ int DistributedMailbox::handle_input(ACE_HANDLE handle)
       }//end if
       clientConnectorMapMutex_.release();
 
-      // Register this class object with the reactor as the ACE_Event_Handler for
-      // receiving messages on this data-mode socket.
-      if (distributedReactor_->register_handler(newSockStream->get_handle(), this, ACE_Event_Handler::READ_MASK) == ERROR)
+      // Register this class object with the connection's reactor as the ACE_Event_Handler
+      // for receiving messages on this data-mode socket.
+      if (newConnection->reactor->register_handler(newSockStream->get_handle(), this, ACE_Event_Handler::READ_MASK) == ERROR)
       {
          TRACELOG(ERRORLOG, MSGMGRLOG, "Register handler for data mode socket failed",0,0,0,0,0,0);
       }//end if
@@ -282,14 +313,34 @@ int DistributedMailbox::handle_input(ACE_HANDLE handle)
    // underlying local mailbox for processing
    else
    {
-      // Retrieve the associated ACE_SOCK_Stream object for the passed-in ACE_HANDLE
+      // Retrieve the associated connection for the passed-in ACE_HANDLE
       // file descriptor (from our mapping)
       clientConnectorMapMutex_.acquire();
-      ACE_SOCK_Stream* receivingSockStream = clientConnectorMap_[handle];
+      ClientConnectorMap::iterator connectionIterator = clientConnectorMap_.find(handle);
+      if (connectionIterator == clientConnectorMap_.end())
+      {
+         clientConnectorMapMutex_.release();
+         TRACELOG(ERRORLOG, MSGMGRLOG, "No connection found for data mode socket %d",handle,0,0,0,0,0);
+         return OK;
+      }//end if
+      ClientConnection* connection = connectionIterator->second;
+      clientConnectorMapMutex_.release();
+
+      // While the queue is overloaded, leave the data in the socket so that the
+      // TCP window of the sender closes and its posts are throttled
+      bool isNewlyOverloaded = false;
+      if (messageQueue_.checkOverload(isNewlyOverloaded))
+      {
+         pauseReceiving(handle, connection->reactor);
+         return OK;
+      }//end if
 
-      // Receive the data into our message buffer
+      // Receive the data behind any partial frame kept from the previous read. Since
+      // a partial frame is never longer than one frame, there is always room for
+      // several more frames.
       int numberBytes = 0;
-      if ((numberBytes = receivingSockStream->recv(messageBuffer_.getBuffer(), MAX_MESSAGE_LENGTH)) <= 0)
+      if ((numberBytes = connection->sockStream->recv(connection->receiveBuffer + connection->receivedLength,
+                            DISTRIBUTED_MAILBOX_RECEIVE_BUFFER_SIZE - connection->receivedLength)) <= 0)
       {
          char errorBuff[200];
          char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
@@ -301,82 +352,251 @@ int DistributedMailbox::handle_input(ACE_HANDLE handle)
          ostr << "Recv failed on distributed mailbox with return value (" << numberBytes
               << ") and errno (" << resultStr << ")" << ends;
          STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
- 
-         // Tell the reactor not to handle events for this handle anymore
-         if (distributedReactor_->remove_handler(handle, ACE_Event_Handler::READ_MASK) == ERROR)
-         {
-            TRACELOG(ERRORLOG, MSGMGRLOG, "Remove handler failed",0,0,0,0,0,0);
-         }//end if
 
          // if recv returns 0, assume that the communication is broken so unregister this socket
-         // from the Map, delete the associated Sock Stream, and return
-         clientConnectorMap_.erase(handle);
-         clientConnectorMapMutex_.release();
-         delete receivingSockStream;
-
+         closeConnection(handle);
          TRACELOG(WARNINGLOG, MSGMGRLOG, "Detected lost connection for distributed mailbox",0,0,0,0,0,0);
-         // Clear the buffer for the next loop iteration
-         messageBuffer_.clearBuffer();
          return OK;
       }//end if
-      else
-      {
-         clientConnectorMapMutex_.release();
-      }//end else
-
-      // Set the insertion pointer for our Message Buffer
-      messageBuffer_.setInsertPosition(numberBytes);
+      connection->receivedLength += numberBytes;
 
-      // Perform Message Id specific deserialization of the buffer back into a MessageBase type
-      MessageBase* message = MessageFactory::recreateMessageFromBuffer(messageBuffer_);
-      if (message != NULL)
+      // Decode every complete frame in the buffer
+      unsigned int decodedLength = 0;
+      while ((connection->receivedLength - decodedLength) >= MSGMGR_FRAME_HEADER_LENGTH)
       {
-         // Deserialize the Message Version Number - DO NOT DO AUTOMATIC SERIALIZATION OF VERSION...
-         // BUT LEAVE THIS CODE AS EXAMPLE OF HOW TO EMBED/SERIALIZE/DESERIALIZE HIDEN/AUTOMATIC PARMS
-         //unsigned int versionNumber = 0;
-         //messageBuffer_ >> versionNumber;
-         //message->setVersion(versionNumber);
- 
-         // First check to see if the messageBuffer is now empty, if not, we need to deserialize
-         // additional flags such as the priorityLevel flag
-         if (!messageBuffer_.areContentsProcessed())
+         unsigned char* frame = connection->receiveBuffer + decodedLength;
+         unsigned short frameLength = (unsigned short)((frame[0] << 8) | frame[1]);
+         if ((frameLength == 0) || (frameLength > MAX_MESSAGE_LENGTH))
          {
-            unsigned int messagePriorityLevel = 0;
-            messageBuffer_ >> messagePriorityLevel;
-            message->setPriority(messagePriorityLevel);
-         }//end if 
-
-         if (debugValue_)
-         {
-            ostringstream debugMsg;
-            char tmpBuffer[30];
-            char tmpBuffer2[30];
-            message->getSourceAddress().inetAddress.addr_to_string(tmpBuffer, sizeof(tmpBuffer));
-            distributedAddress_.inetAddress.addr_to_string(tmpBuffer2, sizeof(tmpBuffer2));
-            debugMsg << "##RECEIVING MESSAGE## " <<
-                        " SOURCE_ADDRESS>> " << tmpBuffer << 
-                        " DESTINATION_ADDRESS>> " << tmpBuffer2 << 
-                        " MESSAGE_ID>> 0x" << hex << message->getMessageId() << 
-                        " MESSAGE_CONTENT>> " << message->toString() << ends;
-            STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str());
+            // The framing of the connection is lost; there is no way to find the
+            // start of the next frame
+            TRACELOG(ERRORLOG, MSGMGRLOG, "Invalid frame length %d received on distributed mailbox, closing connection",
+               frameLength,0,0,0,0,0);
+            closeConnection(handle);
+            return OK;
          }//end if
+         else if ((connection->receivedLength - decodedLength) < (unsigned int)(MSGMGR_FRAME_HEADER_LENGTH + frameLength))
+         {
+            // Partial frame; the rest comes with a later read
+            break;
+         }//end else if
 
-         incrementReceivedCount();
+         deliverFrame(frame + MSGMGR_FRAME_HEADER_LENGTH, frameLength);
+         decodedLength += MSGMGR_FRAME_HEADER_LENGTH + frameLength;
+      }//end while
 
-         // if deserialization was successful, post the new message to our local mailbox 
-         if (post(message) == ERROR)
-         {
-            TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing a received distributed message to mailbox",0,0,0,0,0,0);
-         }//end if
+      // Keep the bytes of the partial frame (if any) at the front of the buffer
+      connection->receivedLength -= decodedLength;
+      if ((connection->receivedLength > 0) && (decodedLength > 0))
+      {
+         memmove(connection->receiveBuffer, connection->receiveBuffer + decodedLength, connection->receivedLength);
       }//end if
-
-      // Clear the buffer for the next loop iteration
-      messageBuffer_.clearBuffer();
    }//end else
    return OK;
 }//end handle_input
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Deserialize the messages of a received frame and post them to
+//              the local mailbox
+// Design:      The message buffer is pointed at the frame in the connection
+//              receive buffer, so the frame is not copied. It is local, since
+//              the connections are read by several reactor threads. The
+//              messages of the frame are posted together.
+//-----------------------------------------------------------------------------
+void DistributedMailbox::deliverFrame(unsigned char* frame, unsigned short frameLength)
+{
+   MessageBuffer messageBuffer((unsigned char*)NULL, 0);
+   messageBuffer.assignSharedBuffer(frame, frameLength);
+   messageBuffer.setInsertPosition(frameLength);
+
+   // Perform Message Id specific deserialization of the buffer back into MessageBase types
+   // (the frame holds either a single message or a batch of them)
+   MessageBase* messages[MSGMGR_MAX_BATCH_MESSAGES];
+   int messageCount = MessageFactory::recreateMessagesFromBuffer(messageBuffer, messages, MSGMGR_MAX_BATCH_MESSAGES);
+   for (int index = 0; index < messageCount; index++)
+   {
+      MessageBase* message = messages[index];
+
+      // Deserialize the Message Version Number - DO NOT DO AUTOMATIC SERIALIZATION OF VERSION...
+      // BUT LEAVE THIS CODE AS EXAMPLE OF HOW TO EMBED/SERIALIZE/DESERIALIZE HIDEN/AUTOMATIC PARMS
+      //unsigned int versionNumber = 0;
+      //messageBuffer >> versionNumber;
+      //message->setVersion(versionNumber);
+
+      if (debugValue_)
+      {
+         ostringstream debugMsg;
+         char tmpBuffer[30];
+         char tmpBuffer2[30];
+         message->getSourceAddress().inetAddress.addr_to_string(tmpBuffer, sizeof(tmpBuffer));
+         distributedAddress_.inetAddress.addr_to_string(tmpBuffer2, sizeof(tmpBuffer2));
+         debugMsg << "##RECEIVING MESSAGE## " <<
+                     " SOURCE_ADDRESS>> " << tmpBuffer << 
+                     " DESTINATION_ADDRESS>> " << tmpBuffer2 << 
+                     " MESSAGE_ID>> 0x" << hex << message->getMessageId() << 
+                     " MESSAGE_CONTENT>> " << message->toString() << ends;
+         STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str());
+      }//end if
+
+      incrementReceivedCount();
+   }//end for
+
+   if (messageCount <= 0)
+   {
+      return;
+   }//end if
+
+   // if deserialization was successful, post the new messages to our local mailbox.
+   // They have already been read off the connection, so they are admitted regardless
+   // of the flow control (which throttles the connections instead)
+   int postedCount = postAdmitted(messages, messageCount);
+   if (postedCount < messageCount)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing %d received distributed messages to mailbox",
+         messageCount - postedCount,0,0,0,0,0);
+      for (int index = ((postedCount > 0) ? postedCount : 0); index < messageCount; index++)
+      {
+         messages[index]->deleteMessage();
+      }//end for
+   }//end if
+}//end deliverFrame
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Stop reading a connection and release it, along with any
+//              partial frame received from it
+// Design:      The reactor is called without holding the client connector map
+//              mutex (see pauseReceiving)
+//-----------------------------------------------------------------------------
+void DistributedMailbox::closeConnection(ACE_HANDLE handle)
+{
+   // Unregister this socket from the Map
+   ClientConnection* connection = NULL;
+   clientConnectorMapMutex_.acquire();
+   ClientConnectorMap::iterator connectionIterator = clientConnectorMap_.find(handle);
+   if (connectionIterator != clientConnectorMap_.end())
+   {
+      connection = connectionIterator->second;
+      clientConnectorMap_.erase(connectionIterator);
+   }//end if
+   clientConnectorMapMutex_.release();
+
+   if (connection == NULL)
+   {
+      return;
+   }//end if
+
+   // Tell the reactor not to handle events for this handle anymore, then delete the
+   // associated Sock Stream
+   if (connection->reactor->remove_handler(handle, ACE_Event_Handler::READ_MASK) == ERROR)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Remove handler failed",0,0,0,0,0,0);
+   }//end if
+   connection->sockStream->close();
+   delete connection->sockStream;
+   delete connection;
+}//end closeConnection
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Release every connection
+// Design:      Called when the mailbox is deleted, once nothing else posts to
+//              it; the handles are collected first, since closeConnection
+//              takes the client connector map mutex
+//-----------------------------------------------------------------------------
+void DistributedMailbox::closeAllConnections()
+{
+   vector<ACE_HANDLE> handles;
+   clientConnectorMapMutex_.acquire();
+   for (ClientConnectorMap::iterator connectionIterator = clientConnectorMap_.begin();
+        connectionIterator != clientConnectorMap_.end(); connectionIterator++)
+   {
+      handles.push_back(connectionIterator->first);
+   }//end for
+   pausedHandles_.clear();
+   clientConnectorMapMutex_.release();
+
+   for (unsigned int index = 0; index < handles.size(); index++)
+   {
+      closeConnection(handles[index]);
+   }//end for
+}//end closeAllConnections
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Stop reading a connection until the queue has been drained
+// Design:      The reactor calls are never made while holding the client
+//              connector map mutex, since a thread calling into the reactor
+//              waits for the reactor thread (which may be waiting for the
+//              mutex in handle_input). The flag is set before the overload is
+//              checked again, and the processing thread clears the overload
+//              before checking the flag, so one of the two always resumes.
+//-----------------------------------------------------------------------------
+void DistributedMailbox::pauseReceiving(ACE_HANDLE handle, ACE_Reactor* reactor)
+{
+   if (reactor->suspend_handler(handle) == ERROR)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Suspend handler for data mode socket failed",0,0,0,0,0,0);
+      return;
+   }//end if
+
+   clientConnectorMapMutex_.acquire();
+   pausedHandles_.push_back(handle);
+   bool wasPaused = isReceivePaused_;
+   isReceivePaused_ = true;
+   clientConnectorMapMutex_.release();
+
+   if (!wasPaused)
+   {
+      TRACELOG(WARNINGLOG, MSGMGRLOG, "Distributed mailbox overloaded with count %d, pausing remote senders",
+         messageQueue_.getDepth(),0,0,0,0,0);
+   }//end if
+
+   __sync_synchronize();
+   if (!messageQueue_.isOverloaded())
+   {
+      resumeReceiving();
+   }//end if
+}//end pauseReceiving
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Resume reading the paused connections. Called by the processing
+//              thread once it has drained the queue.
+// Design:      See pauseReceiving. The reactor of each handle is looked up
+//              in the map, so a handle closed while it was paused is skipped.
+//-----------------------------------------------------------------------------
+void DistributedMailbox::resumeReceiving()
+{
+   vector<ACE_HANDLE> resumeHandles;
+   vector<ACE_Reactor*> resumeReactors;
+   clientConnectorMapMutex_.acquire();
+   isReceivePaused_ = false;
+   for (unsigned int index = 0; index < pausedHandles_.size(); index++)
+   {
+      ClientConnectorMap::iterator connectionIterator = clientConnectorMap_.find(pausedHandles_[index]);
+      if (connectionIterator != clientConnectorMap_.end())
+      {
+         resumeHandles.push_back(pausedHandles_[index]);
+         resumeReactors.push_back(connectionIterator->second->reactor);
+      }//end if
+   }//end for
+   pausedHandles_.clear();
+   clientConnectorMapMutex_.release();
+
+   for (unsigned int index = 0; index < resumeHandles.size(); index++)
+   {
+      resumeReactors[index]->resume_handler(resumeHandles[index]);
+   }//end for
+}//end resumeReceiving
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Overriden ACE_Event_Handler method. Called back automatically
@@ -426,46 +646,6 @@ MailboxAddress& DistributedMailbox::getMailboxAddress()
 //-----------------------------------------------------------------------------
 
 
-//-----------------------------------------------------------------------------
-// Method Type: STATIC
-// Description: This method starts the reactor thread needed for processing
-//              send/receive messages, etc.
-// Design:
-//-----------------------------------------------------------------------------
-void DistributedMailbox::startReactor(void* arg)
-{
-   // Convert the void* arg to a Reactor pointer
-   ACE_Reactor* reactor = static_cast<ACE_Reactor*>(arg); 
-
-   // Set Reactor thread ownership
-   reactor->owner (ACE_Thread::self ());
-   // Start the reactor processing loop
-   while ((isShuttingDown_ == FALSE) && (reactor->reactor_event_loop_done () == 0))
-   {
-      int result = reactor->run_reactor_event_loop ();
-
-      char errorBuff[200];
-      char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-      if (resultStr == NULL)
-      {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
-      }//end if
-      ostringstream ostr;
-      ostr << "Distributed reactor event loop returned with code (" << result << ") and errno (" << resultStr << ")" << ends;
-      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
-
-      // Perform reset on the reactor
-      reactor->reset_reactor_event_loop();
-   }//end while
-
-   // Need to do something to keep ThreadManager from restarting it
-   //if (isShuttingDown_)
-   //{
-   //   ACE_Thread_Manager::instance()->at_exit(NULL,0);
-   //}//end if
-}//end startReactor
-
-
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
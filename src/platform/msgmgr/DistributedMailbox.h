@@ -26,6 +26,7 @@
 #include <ace/Thread_Mutex.h>
 
 #include <map>
+#include <vector>
 
 using namespace std;
 
@@ -35,11 +36,18 @@ using namespace std;
 
 #include "LocalMailbox.h"
 #include "MessageBuffer.h"
+#include "MessageFactory.h"
 
 //-----------------------------------------------------------------------------
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+/**
+ * Size of the receive buffer of each client connection. It holds several
+ * frames, so that one read decodes all of the messages pipelined by a sender.
+ */
+#define DISTRIBUTED_MAILBOX_RECEIVE_BUFFER_SIZE (8 * (MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH))
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -64,6 +72,25 @@ using namespace std;
  * The size of Message which may be exchanged is limited to MAX_MESSAGE_LENGTH
  * which is defined by the MessageBuffer class.
  * <p>
+ * Since TCP does not keep the boundaries of the sends, each transmission is
+ * framed with a length header (see MSGMGR_FRAME_HEADER_LENGTH), and each
+ * connection has its own receive buffer. One read decodes every complete frame
+ * received, and the bytes of a partial frame are kept for the next read, so the
+ * senders may pipeline their posts freely. A connection that sends an invalid
+ * frame length has lost the framing, and is closed.
+ * <p>
+ * When the owner bounds the mailbox queue (see LocalMailbox::setFlowControl),
+ * the remote senders get their credit from the receive window of their TCP
+ * connection: while the queue is overloaded the connections are not read, so
+ * their windows close and the senders' posts block (or time out) until the
+ * processing thread has drained the queue to its low watermark.
+ * <p>
+ * The listener socket and the connections are handled by the reactors of the
+ * process wide ReactorPool: each accepted connection is registered with the
+ * next reactor of the pool, so the connections of one mailbox are read by
+ * several threads, and a mailbox can hold thousands of them without a thread
+ * of its own.
+ * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
@@ -74,12 +101,28 @@ class DistributedMailbox : public LocalMailbox
 
    public:
 
+      /** Receive state of a single client 'connector' connection */
+      typedef struct
+      {
+         /** Data-mode socket of the connection */
+         ACE_SOCK_Stream* sockStream;
+
+         /** Reactor of the pool that the connection is registered with */
+         ACE_Reactor* reactor;
+
+         /** Number of bytes in the receive buffer (not yet decoded) */
+         unsigned int receivedLength;
+
+         /** Bytes received from the connection; begins with a partial frame, if any */
+         unsigned char receiveBuffer[DISTRIBUTED_MAILBOX_RECEIVE_BUFFER_SIZE];
+      } ClientConnection;
+
       /**
-       * Create a map for storing ACE_HANDLEs and their associated ACE_SOCK_Stream objects.
+       * Create a map for storing ACE_HANDLEs and their associated ClientConnection objects.
        * Each map entry corresponds to a single client 'connector' connection to this 
        * distributed mailbox.
        **/
-      typedef map<ACE_HANDLE, ACE_SOCK_Stream*> ClientConnectorMap;
+      typedef map<ACE_HANDLE, ClientConnection*> ClientConnectorMap;
 
       /**
        * Allows applications to create a mailbox and get a handle to it.
@@ -154,16 +197,6 @@ class DistributedMailbox : public LocalMailbox
        */
       DistributedMailbox& operator= (const DistributedMailbox& rhs);
 
-      /**
-       * This static method is called in a new thread context to start the ACE Reactor
-       * event processing loop for distributed messages during mailbox activation. This will run the
-       * event loop until the <ACE_Reactor::handle_events> or <ACE_Reactor::alertable_handle_events> methods
-       * returns -1, the <end_reactor_event_loop> method is invoked, or the <ACE_Time_Value>
-       * expires.
-       * @param arg Pointer to the reactor that we are starting
-       */
-      static void startReactor(void* arg);
-
       /**
        * Overriden ACE_Event_Handler method. 
        * Called back automatically when a connection has been dropped
@@ -180,24 +213,56 @@ class DistributedMailbox : public LocalMailbox
        **/
       int handle_input (ACE_HANDLE);
 
+      /**
+       * Deserialize the messages of a received frame and post them to the
+       * local mailbox
+       */
+      void deliverFrame(unsigned char* frame, unsigned short frameLength);
+
+      /**
+       * Stop reading a connection and release it (lost connection or invalid
+       * framing). Called by the reactor thread of the connection.
+       */
+      void closeConnection(ACE_HANDLE handle);
+
+      /**
+       * Release every connection, so that the shared reactors no longer call
+       * this mailbox back
+       */
+      void closeAllConnections();
+
+      /**
+       * Stop reading a connection until the queue has been drained. Called by
+       * the reactor thread of the connection.
+       */
+      void pauseReceiving(ACE_HANDLE handle, ACE_Reactor* reactor);
+
+      /** Resume reading the paused connections (the queue has been drained) */
+      void resumeReceiving();
+
       /** Address of the remote mailbox for distributed communications */
       MailboxAddress distributedAddress_;
 
       /** ACE Sock Acceptor. Implementation of a server listener socket */
       ACE_SOCK_Acceptor* socketAcceptor_;
 
-      /** Message Buffer object for deserialization of the MessageBase objects */
-      MessageBuffer messageBuffer_;
-
       /** Map for associating each ACE_Handle (file descriptor) with its
-          associated ACE_SOCK_Stream */
+          associated ClientConnection */
       ClientConnectorMap clientConnectorMap_;
 
+      /** Connections not read while the queue is overloaded (protected by
+          the client connector map mutex) */
+      vector<ACE_HANDLE> pausedHandles_;
+
       /** ACE Thread Mutex for protecting the client connector map */
       ACE_Thread_Mutex clientConnectorMapMutex_;
 
-      /** ACE_Select_Reactor used for distributed message send/receive */
+      /** Reactor of the pool that the listener socket is registered with */
       ACE_Reactor* distributedReactor_;
+
+      /** Socket receive buffer size of the accepted connections (zero for the
+          system default); see DistributedMailboxProxy::setConnectionOptions */
+      int receiveBufferSize_;
 };
 
 #endif
@@ -17,24 +17,38 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+
+#include <ace/OS_NS_sys_time.h>
+
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
 #include "DistributedMailboxProxy.h"
+#include "DistributedProxyEngine.h"
 #include "MailboxLookupService.h"
 #include "MailboxOwnerHandle.h"
 #include "MessageBase.h"
+#include "MessageFactory.h"
 
 #include "platform/logger/Logger.h"
 
-#include "platform/opm/OPM.h"
+#include "platform/opm/OPMPool.h"
 
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
 
+// Options set for each remote address
+DistributedMailboxProxy::ConnectionOptionsMap DistributedMailboxProxy::connectionOptions_;
+
+// Mutex protecting the connection options
+ACE_Thread_Mutex DistributedMailboxProxy::connectionOptionsMutex_;
+
 
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
@@ -47,17 +61,34 @@
 // Design:     
 //-----------------------------------------------------------------------------
 DistributedMailboxProxy::DistributedMailboxProxy(const MailboxAddress& remoteAddress)
-                                                :remoteAddress_(remoteAddress)
+                                                :remoteAddress_(remoteAddress),
+                                                 engine_(NULL),
+                                                 isAsynchronous_(false),
+                                                 connectionState_(MAILBOX_DISCONNECTED),
+                                                 outboundChunkSize_(0),
+                                                 outboundOffset_(0),
+                                                 outboundFrameOffset_(0),
+                                                 outboundBytes_(0),
+                                                 outboundMessageCount_(0),
+                                                 isOutputRequested_(false),
+                                                 isReconnectScheduled_(false),
+                                                 outboundView_((unsigned char*)NULL, 0),
+                                                 writeCount_(0)
 {
    MailboxBase::isProxy_ = true;
+   getConnectionOptions(remoteAddress_, options_);
 
    // Create a (Thread Safe) pool of MessageBuffer objects to be used for serialization/
-   // deserialization of the Messages (use default parameters for MessageBuffer)
-   MessageBufferInitializer bufferInitializer;
-   bufferInitializer.bufferSize = MAX_MESSAGE_LENGTH;
-   bufferInitializer.performNetworkConversion = true;
-   messageBufferPoolId_ = OPM::createPool("MessageBufferDefault", (long)&bufferInitializer,
-      (OPM_INIT_PTR)&MessageBuffer::initialize, 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+   // deserialization of the Messages (use default parameters for MessageBuffer). Each
+   // buffer is constructed in a contiguous slab, with its data directly after it.
+   messageBufferPoolId_ = OPM::createSlabPool("MessageBufferDefault",
+      (long)&MessageBuffer::networkBufferInitializer_, (OPM_PLACEMENT_INIT_PTR)&MessageBuffer::initializeInPlace,
+      MessageBuffer::getInPlaceSize(MAX_MESSAGE_LENGTH), 0.8, 5, 10, true, OPM_GROWTH_ALLOWED,
+      OPM_SLAB_PREFAULT);
+
+   // Grow the pool from the OPM maintenance thread so that posting threads do not
+   // construct new buffers themselves when the pool crosses its threshold
+   OPM::setPoolBackgroundMaintenance(messageBufferPoolId_, true);
 }//end constructor
 
 
@@ -70,6 +101,12 @@ DistributedMailboxProxy::~DistributedMailboxProxy()
 {
    // Flag that we are shutting down
    isShuttingDown_ = TRUE;
+
+   dropOutbound();
+   for (unsigned int index = 0; index < spareChunks_.size(); index++)
+   {
+      delete [] spareChunks_[index];
+   }//end for
 }//end virtual destructor
 
 
@@ -98,100 +135,129 @@ int DistributedMailboxProxy::post(MessageBase* messagePtr, const ACE_Time_Value*
       STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str());
    }//end if
 
-   // Reserve Message Buffer object from the OPM
-   MessageBuffer* messageBuffer = (MessageBuffer*)OPM_RESERVE(messageBufferPoolId_);
+   // An asynchronous proxy queues the message for the engine to write, and so does a
+   // synchronous one until its connection is up
+   if (isQueueing())
+   {
+      return queueMessage(messagePtr);
+   }//end if
 
-   // Serialize the Message Id
-   *messageBuffer << messagePtr->getMessageId();
+   // Reserve Message Buffer object from the OPM. It is released back into the OPM (and
+   // cleared) for the next post operation whenever this method returns.
+   OPM::Pool<MessageBuffer>::Ptr messageBuffer(messageBufferPoolId_);
+   if (messageBuffer.isNull())
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "OPM returned null message buffer",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
 
-   // Serialize the remainder of the message so that the buffer can be sent to
-   // the remote distributed mailbox
-   messagePtr->serialize(*messageBuffer);
+   // Serialize the Message Id, the remainder of the message and its priority level (if it
+   // is flagged as high priority) so that the buffer can be sent to the remote distributed mailbox
+   MessageFactory::serializeMessage(messagePtr, *messageBuffer);
 
    // Now, serialize the version number. We do this here for the version Number and priority level
    // so the developer doesn't have to worry about it - DO NOT DO AUTOMATIC SERIALIZATION OF VERSION...
    // BUT LEAVE THIS CODE AS EXAMPLE OF HOW TO EMBED/SERIALIZE/DESERIALIZE HIDEN/AUTOMATIC PARMS
    //*messageBuffer << messagePtr->getVersion();
 
-   // Check to see if the Message is flagged as high priority, if so, serialize this flag to send as well
-   unsigned int priorityLevel = messagePtr->getPriority();
-   if (priorityLevel != 0)
+   outboundMutex_.acquire();
+   int result = sendBuffer(*messageBuffer, timeout);
+   outboundMutex_.release();
+   if (result == ERROR)
    {
-      *messageBuffer << priorityLevel;
+      return ERROR;
    }//end if
 
-   // send the buffer contents to the remote mailbox -- NOTE that send_n returns (ace/SOCK_Stream.h):
-   // - On complete transfer, the number of bytes transferred is returned.
-   // - On timeout, -1 is returned, errno == ETIME.
-   // - On error, -1 is returned, errno is set to appropriate error.
-   // - On EOF, 0 is returned, errno is irrelevant.
-   if (clientStream_.send_n(messageBuffer->getBuffer(), messageBuffer->getBufferLength(), timeout) <= 0)
+   // increment the counter
+   incrementSentCount();
+
+   // delete the message (this releases to OPM if the message is poolable)
+   messagePtr->deleteMessage();
+
+   return OK;
+}//end post
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages to the remote mailbox. Returns the
+//              number of messages posted.
+// Design:      As many messages as fit are serialized into each buffer and
+//              sent with one send_n; the receiving DistributedMailbox splits
+//              the batch back into messages
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   if (!isActive() || (messages == NULL) || (messageCount <= 0))
    {
-      char errorBuff[200];
-      char* result = strerror_r(errno, errorBuff, strlen(errorBuff));
-      if (result == NULL)
-      {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
-      }//end if
-      ostringstream ostr;
-      ostr << "Failed to post message to Distributed Mailbox; errno (" << result << ")" << ends;
-      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+      return 0;
+   }//end if
 
-      // First let's try to close and re-open the socket
-      clientStream_.close();   
-      // Attempt to re-connect to the server socket
-      if ( sockConnector_.connect( clientStream_, remoteAddress_.inetAddress ) == -1 )
+   // The messages are queued as for post, and the outbound queue already packs them
+   // into as few writes as possible
+   if (isQueueing())
+   {
+      int postedCount = 0;
+      while ((postedCount < messageCount) && (queueMessage(messages[postedCount]) == OK))
       {
-         char errorBuff[200];
-         char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-         if (resultStr == NULL)
-         {
-            TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
-         }//end if
+         postedCount++;
+      }//end while
+      return postedCount;
+   }//end if
 
-         ostringstream ostr;
-         ostr << "Failed to re-connect to the distributed mailbox at " << remoteAddress_.inetAddress.get_host_addr()
-              << " port " << remoteAddress_.inetAddress.get_port_number() << " with code ("
-              << result << ") and errno (" << resultStr << ")" << ends;
-         STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+   // Reserve the buffer that is sent and a buffer to serialize each message into
+   // before it is added to the batch
+   OPM::Pool<MessageBuffer>::Ptr batchBuffer(messageBufferPoolId_);
+   OPM::Pool<MessageBuffer>::Ptr scratchBuffer(messageBufferPoolId_);
+   if (batchBuffer.isNull() || scratchBuffer.isNull())
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "OPM returned null message buffer",0,0,0,0,0,0);
+      return 0;
+   }//end if
 
-         // Release the buffer back into the OPM (and Clear the buffer) for the next post operation
-         OPM_RELEASE((OPMBase*)messageBuffer);
-         return ERROR;
-      }//end if
-      // Attempt to re-post the message (we retry only once)
-      if (clientStream_.send_n(messageBuffer->getBuffer(), messageBuffer->getBufferLength(), timeout) <= 0)
+   int postedCount = 0;
+   while (postedCount < messageCount)
+   {
+      batchBuffer->setInsertPosition(0);
+      int batchedCount = MessageFactory::serializeBatch(&messages[postedCount], messageCount - postedCount,
+         *batchBuffer, *scratchBuffer);
+
+      // A lone message (or one too large to be batched) goes out in the regular format
+      if (batchedCount <= 1)
       {
-         char errorBuff[200];
-         char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-         if (resultStr == NULL)
+         if (post(messages[postedCount], timeout) == ERROR)
          {
-            TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+            break;
          }//end if
-
-         // Prompt the user to delete the mailbox handle and re-find later (which will attempt reconnect)
-         ostringstream ostr;
-         ostr << "Retry post Failed with code (" << result << ") and errno (" << resultStr 
-              << "). Delete proxy Mailbox Handle and re-invoke MLS::find, or delete the message" << ends;
-         STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
-
-         // Release the buffer back into the OPM (and Clear the buffer) for the next post operation
-         OPM_RELEASE((OPMBase*)messageBuffer);
-         return ERROR;
+         postedCount++;
+         continue;
       }//end if
-   }//end if
 
-   // increment the counter
-   incrementSentCount();
+      if (debugValue_)
+      {
+         TRACELOG(DEBUGLOG, MSGMGRLOG, "##POSTING BATCH## of %d messages (%d bytes)", batchedCount,
+            batchBuffer->getBufferLength(),0,0,0,0);
+      }//end if
 
-   // delete the message (this releases to OPM if the message is poolable)
-   messagePtr->deleteMessage();
+      outboundMutex_.acquire();
+      int result = sendBuffer(*batchBuffer, timeout);
+      outboundMutex_.release();
+      if (result == ERROR)
+      {
+         break;
+      }//end if
 
-   // Release the buffer back into the OPM (and Clear the buffer) for the next post operation 
-   OPM_RELEASE((OPMBase*)messageBuffer);
+      // delete the messages (this releases to OPM if the message is poolable)
+      for (int index = postedCount; index < (postedCount + batchedCount); index++)
+      {
+         incrementSentCount();
+         messages[index]->deleteMessage();
+      }//end for
+      postedCount += batchedCount;
+   }//end while
 
-   return OK;
-}//end post
+   return postedCount;
+}//end postBatch
 
 
 //-----------------------------------------------------------------------------
@@ -209,22 +275,58 @@ int DistributedMailboxProxy::activate(MailboxOwnerHandle* mailboxOwnerHandle)
    // Begin socket IO
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed Mailbox Proxy activate is called",0,0,0,0,0,0);
 
-   // Attempt to connect to the server socket. Do this in Non-blocking mode (so that we don't block
-   // the calling thread (we could also specify a timeout...). Note that we could also specify
-   // the local port that gets used instead of sap_any. 1 specifies SO_REUSE_ADDR
-   if ( sockConnector_.connect( clientStream_, remoteAddress_.inetAddress, 0, ACE_Addr::sap_any, 1 ) == -1 )
+   // Size the outbound queue. Each chunk of the queue has room for a message of the
+   // maximum length behind the coalescing size; proxies without coalescing only queue
+   // the messages posted while they are not connected.
+   if (options_.coalesceBytes > DISTRIBUTED_PROXY_MAX_COALESCE_BYTES)
    {
-      char errorBuff[200];
-      char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-      if (resultStr == NULL)
+      TRACELOG(WARNINGLOG, MSGMGRLOG, "Coalescing size %d of distributed mailbox proxy reduced to %d",
+         options_.coalesceBytes, DISTRIBUTED_PROXY_MAX_COALESCE_BYTES,0,0,0,0);
+      options_.coalesceBytes = DISTRIBUTED_PROXY_MAX_COALESCE_BYTES;
+   }//end if
+   outboundChunkSize_ = options_.coalesceBytes + MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH;
+
+   // Have the engine connect to the server socket, so that the calling thread (usually
+   // performing MailboxLookupService::find) never blocks on an unreachable peer
+   if (engine_ == NULL)
+   {
+      engine_ = DistributedProxyEngine::getInstance();
+   }//end if
+   if (engine_ != NULL)
+   {
+      isAsynchronous_ = (options_.coalesceBytes > 0);
+
+      outboundMutex_.acquire();
+      connectionState_ = MAILBOX_DISCONNECTED;
+      disconnectTime_ = ACE_OS::gettimeofday();
+      startConnect();
+      outboundMutex_.release();
+   }//end if
+   else
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "No proxy engine, distributed mailbox proxy connects synchronously",0,0,0,0,0,0);
+
+      // Attempt to connect to the server socket on the calling thread. Note that we could
+      // also specify the local port that gets used instead of sap_any. 1 specifies SO_REUSE_ADDR
+      if ( sockConnector_.connect( clientStream_, remoteAddress_.inetAddress, 0, ACE_Addr::sap_any, 1 ) == -1 )
       {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+         char errorBuff[200];
+         char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
+         if (resultStr == NULL)
+         {
+            TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+         }//end if
+         ostringstream ostr;
+         ostr << "Failed to connect to the distributed mailbox with errno (" << resultStr << ")" << ends;
+         STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+         return ERROR;
       }//end if
-      ostringstream ostr;
-      ostr << "Failed to connect to the distributed mailbox with errno (" << resultStr << ")" << ends;
-      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
-      return ERROR;
-   }//end if
+      applySocketOptions();
+
+      outboundMutex_.acquire();
+      connectionState_ = MAILBOX_CONNECTED;
+      outboundMutex_.release();
+   }//end else
 
    // Register the proxy mailbox with the Mailbox Lookup Service
    MailboxLookupService::registerMailbox(mailboxOwnerHandle, this);
@@ -249,8 +351,25 @@ int DistributedMailboxProxy::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
 
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed mailbox proxy deactivate is called",0,0,0,0,0,0);
 
-   // Close the client socket
-   clientStream_.close();
+   // Make a last attempt to write the outbound queue and drop what is left. While the
+   // engine has the socket registered, it is closed by handle_close instead.
+   unsigned int droppedCount = 0;
+   outboundMutex_.acquire();
+   if (engine_ != NULL)
+   {
+      if (connectionState_ == MAILBOX_CONNECTED)
+      {
+         writeOutbound();
+      }//end if
+      droppedCount = dropOutbound();
+   }//end if
+   connectionState_ = MAILBOX_CLOSED;
+   if (!isOutputRequested_)
+   {
+      clientStream_.close();
+   }//end if
+   outboundMutex_.release();
+   notifyDeliveryFailure(droppedCount);
  
    setActive(FALSE); 
    MailboxLookupService::deregisterMailbox(mailboxOwnerHandle);
@@ -322,11 +441,67 @@ MailboxOwnerHandle* DistributedMailboxProxy::createMailbox(const MailboxAddress&
 //-----------------------------------------------------------------------------
 string DistributedMailboxProxy::toString()
 {
-   string s = "";
-   return (s);
+   ostringstream ostr;
+   ostr << "Distributed mailbox proxy to " << remoteAddress_.toString()
+        << " sent " << getSentCount() << " messages in " << writeCount_.value() << " writes"
+        << " (coalescing " << options_.coalesceBytes << " bytes / "
+        << options_.coalesceDelayUsec << " usec, " << outboundBytes_ << " bytes queued)"
+        << " connection state " << connectionState_ << ends;
+   return ostr.str();
 }//end toString
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Set the socket and coalescing options of the connections to a
+//              distributed mailbox
+// Design:      The options are indexed by the IP address and port, since they
+//              describe the connection rather than a mailbox name
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::setConnectionOptions(const MailboxAddress& remoteAddress,
+   const DistributedConnectionOptions& options)
+{
+   char addressString[30];
+   remoteAddress.inetAddress.addr_to_string(addressString, sizeof(addressString));
+
+   connectionOptionsMutex_.acquire();
+   connectionOptions_[addressString] = options;
+   connectionOptionsMutex_.release();
+}//end setConnectionOptions
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Get the options of the connections to a distributed mailbox
+// Design:
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::getConnectionOptions(const MailboxAddress& remoteAddress,
+   DistributedConnectionOptions& options)
+{
+   char addressString[30];
+   remoteAddress.inetAddress.addr_to_string(addressString, sizeof(addressString));
+
+   connectionOptionsMutex_.acquire();
+   ConnectionOptionsMap::iterator optionsIterator = connectionOptions_.find(addressString);
+   if (optionsIterator != connectionOptions_.end())
+   {
+      options = optionsIterator->second;
+   }//end if
+   else
+   {
+      options.isNoDelay = false;
+      options.sendBufferSize = 0;
+      options.receiveBufferSize = 0;
+      options.coalesceBytes = 0;
+      options.coalesceDelayUsec = DISTRIBUTED_PROXY_DEFAULT_COALESCE_DELAY_USEC;
+      options.maxQueuedBytes = DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES;
+      options.deliveryTimeoutMsec = DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC;
+      options.deliveryFailureHandler = DeliveryFailureHandler();
+   }//end else
+   connectionOptionsMutex_.release();
+}//end getConnectionOptions
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Required by base class. Not implemented
@@ -352,6 +527,21 @@ MessageBase* DistributedMailboxProxy::getMessageNonBlocking()
 }//end getMessageNonBlocking
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Required by base class. Not implemented
+// Design:
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue)
+{
+   messages = NULL;
+   maxMessages = 0;
+   timeoutValue = 0;
+   TRACELOG(ERRORLOG, MSGMGRLOG, "Illegal call to Distributed Mailbox proxy getMessages",0,0,0,0,0,0);
+   return 0;
+}//end getMessages
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
@@ -368,10 +558,726 @@ MailboxAddress& DistributedMailboxProxy::getMailboxAddress()
 }//end getMailboxAddress
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the state of the connection to the distributed mailbox
+// Design:
+//-----------------------------------------------------------------------------
+MailboxConnectionStateType DistributedMailboxProxy::getConnectionState()
+{
+   outboundMutex_.acquire();
+   MailboxConnectionStateType connectionState = connectionState_;
+   outboundMutex_.release();
+   return connectionState;
+}//end getConnectionState
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of writes made to the client socket
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int DistributedMailboxProxy::getWriteCount()
+{
+   return writeCount_.value();
+}//end getWriteCount
+
+
 //-----------------------------------------------------------------------------
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Send a serialized buffer to the remote mailbox
+// Design:      The frame header (the length of the buffer, see MessageFactory.h)
+//              and the buffer contents go out together in one gathered write
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::sendBuffer(MessageBuffer& messageBuffer, const ACE_Time_Value* timeout)
+{
+   unsigned short bufferLength = messageBuffer.getBufferLength();
+   unsigned char frameHeader[MSGMGR_FRAME_HEADER_LENGTH];
+   frameHeader[0] = (unsigned char)(bufferLength >> 8);
+   frameHeader[1] = (unsigned char)(bufferLength & 0xff);
+   iovec frames[2];
+   frames[0].iov_base = (char*)frameHeader;
+   frames[0].iov_len = MSGMGR_FRAME_HEADER_LENGTH;
+   frames[1].iov_base = (char*)messageBuffer.getBuffer();
+   frames[1].iov_len = bufferLength;
+   return sendFrames(frames, 2, timeout);
+}//end sendBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Send framed data to the remote mailbox
+// Design:      Upon failure the socket is closed and re-connected, and the
+//              data is sent once more
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::sendFrames(const iovec* frames, int frameCount, const ACE_Time_Value* timeout)
+{
+   // send the frames to the remote mailbox -- NOTE that sendv_n returns (ace/SOCK_Stream.h):
+   // - On complete transfer, the number of bytes transferred is returned.
+   // - On timeout, -1 is returned, errno == ETIME.
+   // - On error, -1 is returned, errno is set to appropriate error.
+   // - On EOF, 0 is returned, errno is irrelevant.
+   writeCount_++;
+   if (clientStream_.sendv_n(frames, frameCount, timeout) <= 0)
+   {
+      char errorBuff[200];
+      char* result = strerror_r(errno, errorBuff, strlen(errorBuff));
+      if (result == NULL)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+      }//end if
+      ostringstream ostr;
+      ostr << "Failed to post message to Distributed Mailbox; errno (" << result << ")" << ends;
+      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+
+      // With an engine, hand the reconnect over to it rather than connecting on the caller's
+      // thread. The posts made meanwhile (including the application's retry) are queued.
+      if (engine_ != NULL)
+      {
+         connectionState_ = MAILBOX_DISCONNECTED;
+         disconnectTime_ = ACE_OS::gettimeofday();
+         if (!isOutputRequested_)
+         {
+            clientStream_.close();
+         }//end if
+         scheduleReconnect(disconnectTime_);
+         return ERROR;
+      }//end if
+
+      // First let's try to close and re-open the socket
+      clientStream_.close();   
+      // Attempt to re-connect to the server socket
+      if ( sockConnector_.connect( clientStream_, remoteAddress_.inetAddress ) == -1 )
+      {
+         char errorBuff[200];
+         char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
+         if (resultStr == NULL)
+         {
+            TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+         }//end if
+
+         ostringstream ostr;
+         ostr << "Failed to re-connect to the distributed mailbox at " << remoteAddress_.inetAddress.get_host_addr()
+              << " port " << remoteAddress_.inetAddress.get_port_number() << " with code ("
+              << result << ") and errno (" << resultStr << ")" << ends;
+         STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+         return ERROR;
+      }//end if
+      applySocketOptions();
+
+      // Attempt to re-post the message (we retry only once). A frame partially sent on
+      // the old connection was discarded with it by the receiver.
+      writeCount_++;
+      if (clientStream_.sendv_n(frames, frameCount, timeout) <= 0)
+      {
+         char errorBuff[200];
+         char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
+         if (resultStr == NULL)
+         {
+            TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+         }//end if
+
+         // Prompt the user to delete the mailbox handle and re-find later (which will attempt reconnect)
+         ostringstream ostr;
+         ostr << "Retry post Failed with code (" << result << ") and errno (" << resultStr 
+              << "). Delete proxy Mailbox Handle and re-invoke MLS::find, or delete the message" << ends;
+         STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+         return ERROR;
+      }//end if
+   }//end if
+   return OK;
+}//end sendFrames
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Apply the socket options to the client socket after it is
+//              connected
+// Design:      A failure is only logged; the connection works without them
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::applySocketOptions()
+{
+   if (options_.isNoDelay)
+   {
+      int noDelay = 1;
+      if (clientStream_.set_option(IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) == ERROR)
+      {
+         TRACELOG(WARNINGLOG, MSGMGRLOG, "Unable to set TCP_NODELAY on distributed mailbox proxy (%d)",errno,0,0,0,0,0);
+      }//end if
+   }//end if
+
+   if (options_.sendBufferSize > 0)
+   {
+      int sendBufferSize = options_.sendBufferSize;
+      if (clientStream_.set_option(SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) == ERROR)
+      {
+         TRACELOG(WARNINGLOG, MSGMGRLOG, "Unable to set send buffer size %d on distributed mailbox proxy (%d)",
+            sendBufferSize,errno,0,0,0,0);
+      }//end if
+   }//end if
+}//end applySocketOptions
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether a post goes to the outbound queue
+// Design:      A synchronous proxy sends on the caller's thread only once the
+//              messages queued before its connection was up have been written,
+//              so that the messages stay in order
+//-----------------------------------------------------------------------------
+bool DistributedMailboxProxy::isQueueing()
+{
+   if (engine_ == NULL)
+   {
+      return false;
+   }//end if
+   else if (isAsynchronous_)
+   {
+      return true;
+   }//end else if
+
+   outboundMutex_.acquire();
+   bool isQueued = ((connectionState_ != MAILBOX_CONNECTED) || (outboundBytes_ > 0));
+   outboundMutex_.release();
+   return isQueued;
+}//end isQueueing
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Serialize a message into the outbound queue
+// Design:      The message is serialized in place behind the room for its frame
+//              header, so the queue is written without copying. A frame never
+//              spans two chunks. The first message of the queue sets the time by
+//              which it is written; the engine is asked to write it at once when
+//              it reaches the coalescing size (or has no coalescing delay). A
+//              disconnected proxy with nothing scheduled starts reconnecting.
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::queueMessage(MessageBase* messagePtr)
+{
+   outboundMutex_.acquire();
+   if (connectionState_ == MAILBOX_CLOSED)
+   {
+      outboundMutex_.release();
+      return ERROR;
+   }//end if
+   else if (outboundBytes_ >= options_.maxQueuedBytes)
+   {
+      unsigned int queuedBytes = outboundBytes_;
+      outboundMutex_.release();
+      TRACELOG(WARNINGLOG, MSGMGRLOG, "Distributed mailbox proxy outbound queue is full (%d bytes)",
+         queuedBytes,0,0,0,0,0);
+      return ERROR;
+   }//end else if
+
+   if (outboundChunks_.empty() ||
+       ((outboundChunkSize_ - outboundChunks_.back().length) < (MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH)))
+   {
+      OutboundChunk newChunk;
+      if (spareChunks_.empty())
+      {
+         newChunk.data = new unsigned char[outboundChunkSize_];
+      }//end if
+      else
+      {
+         newChunk.data = spareChunks_.back();
+         spareChunks_.pop_back();
+      }//end else
+      newChunk.length = 0;
+      outboundChunks_.push_back(newChunk);
+   }//end if
+
+   OutboundChunk& tailChunk = outboundChunks_.back();
+   unsigned char* frame = tailChunk.data + tailChunk.length;
+   outboundView_.assignSharedBuffer(frame + MSGMGR_FRAME_HEADER_LENGTH, MAX_MESSAGE_LENGTH);
+   MessageFactory::serializeMessage(messagePtr, outboundView_);
+   unsigned short frameLength = outboundView_.getBufferLength();
+   frame[0] = (unsigned char)(frameLength >> 8);
+   frame[1] = (unsigned char)(frameLength & 0xff);
+   tailChunk.length += MSGMGR_FRAME_HEADER_LENGTH + frameLength;
+   outboundBytes_ += MSGMGR_FRAME_HEADER_LENGTH + frameLength;
+   outboundMessageCount_++;
+
+   ACE_Time_Value now = ACE_OS::gettimeofday();
+   bool isFirstMessage = (outboundMessageCount_ == 1);
+   if (isFirstMessage)
+   {
+      flushTime_ = now + ACE_Time_Value(0, options_.coalesceDelayUsec);
+   }//end if
+
+   if ((connectionState_ == MAILBOX_CONNECTED) && !isOutputRequested_)
+   {
+      if ((outboundBytes_ >= options_.coalesceBytes) || (options_.coalesceDelayUsec == 0))
+      {
+         requestOutput();
+      }//end if
+      else if (isFirstMessage)
+      {
+         engine_->schedule(this, flushTime_);
+      }//end else if
+   }//end if
+   else if ((connectionState_ == MAILBOX_DISCONNECTED) && !isReconnectScheduled_)
+   {
+      disconnectTime_ = now;
+      scheduleReconnect(now);
+   }//end else if
+   outboundMutex_.release();
+
+   // increment the counter and delete the message (this releases to OPM if the
+   // message is poolable)
+   incrementSentCount();
+   messagePtr->deleteMessage();
+   return OK;
+}//end queueMessage
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the socket handle, for the engine reactor
+// Design:
+//-----------------------------------------------------------------------------
+ACE_HANDLE DistributedMailboxProxy::get_handle() const
+{
+   return clientStream_.get_handle();
+}//end get_handle
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Overriden ACE_Event_Handler method. Called back by the engine
+//              reactor while the socket is writable.
+// Design:      A writable connecting socket has completed its connect, either
+//              way. The socket is never closed here (while it is registered);
+//              handle_close does it once the registration has ended.
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::handle_output(ACE_HANDLE handle)
+{
+   // dummy declaration to prevent unused variable compiler warning
+   ACE_HANDLE dummyHandle __attribute__ ((unused)) = handle;
+
+   int result = 0;
+   unsigned int droppedCount = 0;
+   outboundMutex_.acquire();
+   if (connectionState_ == MAILBOX_CONNECTING)
+   {
+      if (sockConnector_.complete(clientStream_, NULL, &ACE_Time_Value::zero) == ERROR)
+      {
+         if ((errno == EWOULDBLOCK) || (errno == ETIME))
+         {
+            outboundMutex_.release();
+            return 0;
+         }//end if
+         droppedCount = connectionFailed();
+         outboundMutex_.release();
+         notifyDeliveryFailure(droppedCount);
+         return -1;
+      }//end if
+      connectionEstablished();
+   }//end if
+
+   if (connectionState_ != MAILBOX_CONNECTED)
+   {
+      result = -1;
+   }//end if
+   else
+   {
+      int writeResult = writeOutbound();
+      if (writeResult == ERROR)
+      {
+         connectionLost();
+         result = -1;
+      }//end if
+      else if (writeResult == 0)
+      {
+         // Nothing left to write
+         result = -1;
+      }//end else if
+   }//end else
+   outboundMutex_.release();
+   return result;
+}//end handle_output
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Overriden ACE_Event_Handler method. Called back by the engine
+//              reactor when the output registration ends.
+// Design:      Messages queued while the registration was ending did not ask
+//              for output (it was still requested), so they are taken care of
+//              here. Releasing the reference of the registration may delete
+//              the proxy, so it is done last.
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::handle_close(ACE_HANDLE handle, ACE_Reactor_Mask closeMask)
+{
+   // dummy declaration to prevent unused variable compiler warning
+   ACE_HANDLE dummyHandle __attribute__ ((unused)) = handle;
+
+   if ((closeMask & ACE_Event_Handler::WRITE_MASK) == 0)
+   {
+      return 0;
+   }//end if
+
+   outboundMutex_.acquire();
+   isOutputRequested_ = false;
+   if ((connectionState_ == MAILBOX_DISCONNECTED) || (connectionState_ == MAILBOX_CLOSED))
+   {
+      clientStream_.close();
+   }//end if
+   else if ((connectionState_ == MAILBOX_CONNECTED) && (outboundBytes_ > 0))
+   {
+      if ((outboundBytes_ >= options_.coalesceBytes) || (flushTime_ <= ACE_OS::gettimeofday()))
+      {
+         requestOutput();
+      }//end if
+      else
+      {
+         engine_->schedule(this, flushTime_);
+      }//end else
+   }//end else if
+   outboundMutex_.release();
+
+   release();
+   return 0;
+}//end handle_close
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Called back by the engine at a scheduled time
+// Design:      A proxy may have several callbacks scheduled (each queue and each
+//              reconnect attempt schedules one), so each callback checks whether
+//              its time has really come
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::handleEngineTimer()
+{
+   unsigned int droppedCount = 0;
+   ACE_Time_Value now = ACE_OS::gettimeofday();
+
+   outboundMutex_.acquire();
+   if ((connectionState_ == MAILBOX_DISCONNECTED) && isReconnectScheduled_ && (reconnectTime_ <= now))
+   {
+      isReconnectScheduled_ = false;
+      droppedCount = startConnect();
+   }//end if
+   else if ((connectionState_ == MAILBOX_CONNECTED) && !isOutputRequested_ &&
+            (outboundBytes_ > 0) && (flushTime_ <= now))
+   {
+      requestOutput();
+   }//end else if
+   outboundMutex_.release();
+
+   notifyDeliveryFailure(droppedCount);
+}//end handleEngineTimer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Have the engine write the queue. Called with outboundMutex_
+//              held.
+// Design:
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::requestOutput()
+{
+   isOutputRequested_ = true;
+   engine_->requestOutput(this);
+}//end requestOutput
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Write the outbound queue without blocking. Called with
+//              outboundMutex_ held.
+// Design:      Up to DISTRIBUTED_PROXY_MAX_WRITE_CHUNKS chunks are gathered into
+//              each write. A short write means that the socket buffer is full.
+//-----------------------------------------------------------------------------
+int DistributedMailboxProxy::writeOutbound()
+{
+   while (outboundBytes_ > 0)
+   {
+      iovec frames[DISTRIBUTED_PROXY_MAX_WRITE_CHUNKS];
+      int frameCount = 0;
+      size_t requestedBytes = 0;
+      deque<OutboundChunk>::iterator chunkIterator = outboundChunks_.begin();
+      while ((chunkIterator != outboundChunks_.end()) && (frameCount < DISTRIBUTED_PROXY_MAX_WRITE_CHUNKS))
+      {
+         unsigned int chunkOffset = ((frameCount == 0) ? outboundOffset_ : 0);
+         frames[frameCount].iov_base = (char*)(chunkIterator->data + chunkOffset);
+         frames[frameCount].iov_len = chunkIterator->length - chunkOffset;
+         requestedBytes += frames[frameCount].iov_len;
+         frameCount++;
+         chunkIterator++;
+      }//end while
+
+      writeCount_++;
+      ssize_t writtenBytes = clientStream_.sendv(frames, frameCount);
+      if (writtenBytes < 0)
+      {
+         if ((errno == EWOULDBLOCK) || (errno == EAGAIN))
+         {
+            return 1;
+         }//end if
+         return ERROR;
+      }//end if
+
+      consumeOutbound(writtenBytes);
+      if ((size_t)writtenBytes < requestedBytes)
+      {
+         return 1;
+      }//end if
+   }//end while
+   return 0;
+}//end writeOutbound
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Remove written bytes from the outbound queue. Called with
+//              outboundMutex_ held.
+// Design:      The frames of the first chunk are walked as they are completed,
+//              so that the queue always knows where the first incomplete frame
+//              starts (see rewindOutbound)
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::consumeOutbound(unsigned int byteCount)
+{
+   outboundBytes_ -= byteCount;
+   while (byteCount > 0)
+   {
+      OutboundChunk& headChunk = outboundChunks_.front();
+      unsigned int chunkBytes = headChunk.length - outboundOffset_;
+      unsigned int consumedBytes = ((byteCount < chunkBytes) ? byteCount : chunkBytes);
+      outboundOffset_ += consumedBytes;
+      byteCount -= consumedBytes;
+
+      while ((outboundFrameOffset_ + MSGMGR_FRAME_HEADER_LENGTH) <= outboundOffset_)
+      {
+         unsigned char* frame = headChunk.data + outboundFrameOffset_;
+         unsigned int frameEnd = outboundFrameOffset_ + MSGMGR_FRAME_HEADER_LENGTH +
+            (unsigned short)((frame[0] << 8) | frame[1]);
+         if (frameEnd > outboundOffset_)
+         {
+            break;
+         }//end if
+         outboundFrameOffset_ = frameEnd;
+         outboundMessageCount_--;
+      }//end while
+
+      if (outboundOffset_ == headChunk.length)
+      {
+         if (spareChunks_.size() < DISTRIBUTED_PROXY_SPARE_CHUNKS)
+         {
+            spareChunks_.push_back(headChunk.data);
+         }//end if
+         else
+         {
+            delete [] headChunk.data;
+         }//end else
+         outboundChunks_.pop_front();
+         outboundOffset_ = 0;
+         outboundFrameOffset_ = 0;
+      }//end if
+   }//end while
+}//end consumeOutbound
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the partially written frame to the queue. Called with
+//              outboundMutex_ held.
+// Design:      The receiver discards a partial frame along with the connection
+//              it came on, so it is sent again whole on the next one. The frames
+//              written completely are taken as delivered.
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::rewindOutbound()
+{
+   outboundBytes_ += outboundOffset_ - outboundFrameOffset_;
+   outboundOffset_ = outboundFrameOffset_;
+}//end rewindOutbound
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Drop the contents of the outbound queue. Called with
+//              outboundMutex_ held.
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int DistributedMailboxProxy::dropOutbound()
+{
+   unsigned int droppedCount = outboundMessageCount_;
+   while (!outboundChunks_.empty())
+   {
+      if (spareChunks_.size() < DISTRIBUTED_PROXY_SPARE_CHUNKS)
+      {
+         spareChunks_.push_back(outboundChunks_.front().data);
+      }//end if
+      else
+      {
+         delete [] outboundChunks_.front().data;
+      }//end else
+      outboundChunks_.pop_front();
+   }//end while
+   outboundOffset_ = 0;
+   outboundFrameOffset_ = 0;
+   outboundBytes_ = 0;
+   outboundMessageCount_ = 0;
+   return droppedCount;
+}//end dropOutbound
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Start a non-blocking connect. Called with outboundMutex_ held.
+// Design:      A connect in progress is completed by handle_output once the
+//              socket is writable
+//-----------------------------------------------------------------------------
+unsigned int DistributedMailboxProxy::startConnect()
+{
+   if (sockConnector_.connect(clientStream_, remoteAddress_.inetAddress, &ACE_Time_Value::zero) == 0)
+   {
+      connectionEstablished();
+      if (outboundBytes_ > 0)
+      {
+         requestOutput();
+      }//end if
+   }//end if
+   else if ((errno == EWOULDBLOCK) || (errno == EINPROGRESS))
+   {
+      connectionState_ = MAILBOX_CONNECTING;
+      requestOutput();
+   }//end else if
+   else
+   {
+      clientStream_.close();
+      return connectionFailed();
+   }//end else
+   return 0;
+}//end startConnect
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record a completed connect. Called with outboundMutex_ held.
+// Design:      The queue is replayed from its first incomplete frame
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::connectionEstablished()
+{
+   connectionState_ = MAILBOX_CONNECTED;
+   reconnectDelay_ = ACE_Time_Value::zero;
+   applySocketOptions();
+   clientStream_.enable(ACE_NONBLOCK);
+   rewindOutbound();
+
+   TRACELOG(DEBUGLOG, MSGMGRLOG, "Distributed mailbox proxy connected, sending %d queued messages",
+      outboundMessageCount_,0,0,0,0,0);
+}//end connectionEstablished
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record a failed connect and schedule the next attempt. Called
+//              with outboundMutex_ held.
+// Design:      The delay between the attempts doubles up to its maximum. Once
+//              the queue is dropped, the next post starts the attempts again.
+//-----------------------------------------------------------------------------
+unsigned int DistributedMailboxProxy::connectionFailed()
+{
+   connectionState_ = MAILBOX_DISCONNECTED;
+
+   ACE_Time_Value minDelay(0, DISTRIBUTED_PROXY_MIN_RECONNECT_MSEC * 1000);
+   ACE_Time_Value maxDelay(DISTRIBUTED_PROXY_MAX_RECONNECT_MSEC / 1000, (DISTRIBUTED_PROXY_MAX_RECONNECT_MSEC % 1000) * 1000);
+   reconnectDelay_ = ((reconnectDelay_ < minDelay) ? minDelay : (reconnectDelay_ + reconnectDelay_));
+   if (reconnectDelay_ > maxDelay)
+   {
+      reconnectDelay_ = maxDelay;
+   }//end if
+
+   unsigned int droppedCount = 0;
+   ACE_Time_Value now = ACE_OS::gettimeofday();
+   ACE_Time_Value deliveryTimeout(options_.deliveryTimeoutMsec / 1000, (options_.deliveryTimeoutMsec % 1000) * 1000);
+   if ((now - disconnectTime_) >= deliveryTimeout)
+   {
+      droppedCount = dropOutbound();
+   }//end if
+
+   if (outboundMessageCount_ > 0)
+   {
+      scheduleReconnect(now + reconnectDelay_);
+   }//end if
+   return droppedCount;
+}//end connectionFailed
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record a lost connection and schedule a reconnect. Called with
+//              outboundMutex_ held (by handle_output).
+// Design:      The first reconnect attempt is made at once, as the synchronous
+//              posts do. The socket is closed by handle_close.
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::connectionLost()
+{
+   char errorBuff[200];
+   char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
+   if (resultStr == NULL)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+   }//end if
+   ostringstream ostr;
+   ostr << "Lost connection to the distributed mailbox at " << remoteAddress_.inetAddress.get_host_addr()
+        << " port " << remoteAddress_.inetAddress.get_port_number() << " with errno (" << resultStr
+        << "), reconnecting with " << outboundMessageCount_ << " queued messages" << ends;
+   STRACELOG(WARNINGLOG, MSGMGRLOG, ostr.str().c_str());
+
+   connectionState_ = MAILBOX_DISCONNECTED;
+   disconnectTime_ = ACE_OS::gettimeofday();
+   rewindOutbound();
+   scheduleReconnect(disconnectTime_);
+}//end connectionLost
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Schedule a reconnect attempt. Called with outboundMutex_ held.
+// Design:
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::scheduleReconnect(const ACE_Time_Value& reconnectTime)
+{
+   isReconnectScheduled_ = true;
+   reconnectTime_ = reconnectTime;
+   engine_->schedule(this, reconnectTime);
+}//end scheduleReconnect
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Report dropped messages to the delivery failure handler
+// Design:      Called without holding outboundMutex_, so that the handler may
+//              post again
+//-----------------------------------------------------------------------------
+void DistributedMailboxProxy::notifyDeliveryFailure(unsigned int droppedCount)
+{
+   if (droppedCount == 0)
+   {
+      return;
+   }//end if
+
+   ostringstream ostr;
+   ostr << "Dropped " << droppedCount << " queued messages to the distributed mailbox at "
+        << remoteAddress_.inetAddress.get_host_addr() << " port "
+        << remoteAddress_.inetAddress.get_port_number() << ends;
+   STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+
+   if (options_.deliveryFailureHandler)
+   {
+      options_.deliveryFailureHandler(remoteAddress_, droppedCount);
+   }//end if
+}//end notifyDeliveryFailure
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
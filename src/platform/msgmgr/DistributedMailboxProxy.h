@@ -21,11 +21,17 @@
 
 #include <ace/SOCK_Connector.h>
 #include <ace/SOCK_Stream.h>
+#include <ace/Thread_Mutex.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
+#include "Callback.h"
 #include "MailboxBase.h"
 #include "MessageBuffer.h"
 
@@ -33,6 +39,70 @@
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+/** Default longest time a message waits in the outbound queue of a proxy (usec) */
+#define DISTRIBUTED_PROXY_DEFAULT_COALESCE_DELAY_USEC 1000
+
+/** Largest coalescing size of the outbound queue of a proxy (bytes) */
+#define DISTRIBUTED_PROXY_MAX_COALESCE_BYTES 65536
+
+/** Default number of bytes the outbound queue of a proxy may hold */
+#define DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES (1024 * 1024)
+
+/** Default time a proxy keeps its queued messages while it cannot connect (msec) */
+#define DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC 5000
+
+/** First delay between the reconnect attempts of a proxy (msec); doubled on each failure */
+#define DISTRIBUTED_PROXY_MIN_RECONNECT_MSEC 10
+
+/** Longest delay between the reconnect attempts of a proxy (msec) */
+#define DISTRIBUTED_PROXY_MAX_RECONNECT_MSEC 5000
+
+/** Maximum number of outbound queue chunks gathered into one write */
+#define DISTRIBUTED_PROXY_MAX_WRITE_CHUNKS 16
+
+/** Number of emptied outbound queue chunks a proxy keeps for reuse */
+#define DISTRIBUTED_PROXY_SPARE_CHUNKS 4
+
+/**
+ * Delivery failure callback of an asynchronous proxy: called by the proxy
+ * engine thread with the address of the remote mailbox and the number of
+ * queued messages dropped
+ */
+typedef CBFunctor2<const MailboxAddress&, unsigned int> DeliveryFailureHandler;
+
+/** Socket and outbound queue options of the connections to a distributed mailbox */
+typedef struct
+{
+   /** Disable the Nagle algorithm (TCP_NODELAY) on the proxy connections */
+   bool isNoDelay;
+
+   /** Socket send buffer size (SO_SNDBUF) of the proxies; zero for the system default */
+   int sendBufferSize;
+
+   /** Socket receive buffer size (SO_RCVBUF) of the connections accepted by the
+       distributed mailbox; zero for the system default */
+   int receiveBufferSize;
+
+   /** Number of queued bytes at which a proxy writes its outbound queue without
+       waiting for the coalescing delay; zero disables the outbound queue, so that
+       each post is sent synchronously on the caller's thread */
+   unsigned int coalesceBytes;
+
+   /** Longest time a message waits in the outbound queue to be coalesced with
+       others, in microseconds (zero to write the queue as soon as possible) */
+   unsigned int coalesceDelayUsec;
+
+   /** Number of bytes the outbound queue may hold; posts fail beyond it */
+   unsigned int maxQueuedBytes;
+
+   /** Time the queued messages are kept while the proxy cannot reconnect, in
+       milliseconds; they are then dropped and the failure handler is called */
+   unsigned int deliveryTimeoutMsec;
+
+   /** Called when queued messages are dropped (may be left unset) */
+   DeliveryFailureHandler deliveryFailureHandler;
+} DistributedConnectionOptions;
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -51,9 +121,35 @@
  * DistributedMailboxProxy performs serialization of the messages and interacts
  * with the transport layer to push (post) the message to the remote node or process.
  * <p>
+ * By default each post is sent at once on the caller's thread. When the options
+ * of the remote address (see setConnectionOptions) enable the outbound queue,
+ * the proxy is asynchronous: post serializes the message into the queue and
+ * returns at once, and the process wide DistributedProxyEngine thread writes
+ * the queue to the non-blocking socket. The queue is written with a gathered
+ * write once it holds coalesceBytes, or once its oldest message has waited
+ * coalesceDelayUsec, which trades a bounded delay for one system call and one
+ * TCP segment per many small messages.
+ * <p>
+ * When an asynchronous proxy loses its connection, the engine reconnects it
+ * (without blocking, and with an exponential backoff between the attempts) and
+ * replays the queue from the first frame that was not completely written. If it
+ * cannot reconnect within deliveryTimeoutMsec, the queued messages are dropped
+ * and the deliveryFailureHandler is called, so that no application thread is
+ * ever blocked by a slow, stalled or failed peer.
+ * <p>
+ * Activation never blocks either: the engine makes the connect without
+ * blocking, so MailboxLookupService::find returns a handle to a proxy that may
+ * still be connecting (see getConnectionState). Posts made before the
+ * connection is up are buffered in the outbound queue, for synchronous proxies
+ * too, and are written by the engine as soon as it is; the synchronous posts
+ * resume once the buffered messages are written. A synchronous proxy whose
+ * send fails also hands the reconnect over to the engine rather than
+ * connecting on the caller's thread.
+ * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
+class DistributedProxyEngine;
 class MailboxOwnerHandle;
 class MessageBase;
 
@@ -64,16 +160,29 @@ class DistributedMailboxProxy : public MailboxBase
       /**
        * Post a message to the distributed remote mailbox.
        * Subclass implementations should examine the "active_" state.
-       * Upon initial failure of the post, this proxy mailbox will close and re-open
-       * the socket and attempt to post the message again automatically. If the
-       * the repost fails, then ERROR will be returned, and it becomes the responsibility
+       * Upon failure of the post, this proxy mailbox will close the socket and have the
+       * engine reconnect it (without an engine, it re-opens the socket and attempts to
+       * post the message again automatically). ERROR will then be returned, and it becomes the responsibility
        * of the application to retry the message after deleting the mailbox handle
        * and performing MailboxLookupService::find (which may return a redundant mate's
        * handle); or, the application can give up and delete the message off of the heap.
+       * While the connection is not up, and when the proxy is asynchronous, the message is queued and OK is returned, unless
+       * the outbound queue is full (the message then still belongs to the caller);
+       * delivery failures are reported to the deliveryFailureHandler instead.
        * @returns zero for an error, non-zero otherwise.
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
 
+      /**
+       * Post a batch of messages to the distributed remote mailbox. The messages are
+       * serialized together into as few transmissions as MAX_MESSAGE_LENGTH allows
+       * (a message too large to be batched is posted on its own). Failures are
+       * handled as for post.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
       /**
        * Allows applications to create a mailbox and get a handle to it.
        *
@@ -89,6 +198,20 @@ class DistributedMailboxProxy : public MailboxBase
        */
       static MailboxOwnerHandle* createMailbox(const MailboxAddress& remoteAddress);
 
+      /**
+       * Set the socket and coalescing options of the connections to a distributed
+       * mailbox (by its IP address and port). They apply to the proxies connected
+       * after the call, and to the connections accepted by a distributed mailbox
+       * activated after the call.
+       */
+      static void setConnectionOptions(const MailboxAddress& remoteAddress, const DistributedConnectionOptions& options);
+
+      /**
+       * Get the options of the connections to a distributed mailbox (the defaults,
+       * with coalescing disabled, if none were set)
+       */
+      static void getConnectionOptions(const MailboxAddress& remoteAddress, DistributedConnectionOptions& options);
+
       /** 
        * Activate the mailbox.
        * For security, one must possess an Owner Handle to activate the mailbox
@@ -117,6 +240,12 @@ class DistributedMailboxProxy : public MailboxBase
       /** Return the mailbox distributed address */
       MailboxAddress& getMailboxAddress();
 
+      /** Return the state of the connection to the distributed mailbox */
+      virtual MailboxConnectionStateType getConnectionState();
+
+      /** Return the number of writes made to the client socket */
+      virtual unsigned int getWriteCount();
+
       /** 
        * String'ized debugging method
        * @return string representation of the contents of this object
@@ -133,6 +262,31 @@ class DistributedMailboxProxy : public MailboxBase
 
    private:
 
+      /** The engine calls the reactor and timer callbacks below */
+      friend class DistributedProxyEngine;
+
+      /** Chunk of the outbound queue, holding whole frames */
+      typedef struct
+      {
+         /** Memory of the chunk (outboundChunkSize_ bytes) */
+         unsigned char* data;
+
+         /** Number of bytes of frames in the chunk */
+         unsigned int length;
+      } OutboundChunk;
+
+      /**
+       * Map of the connection options set for each remote address, indexed by the
+       * string form of the address
+       */
+      typedef map<string, DistributedConnectionOptions> ConnectionOptionsMap;
+
+      /** Options set for each remote address */
+      static ConnectionOptionsMap connectionOptions_;
+
+      /** Mutex protecting the connection options */
+      static ACE_Thread_Mutex connectionOptionsMutex_;
+
       /** Default Constructor */
       DistributedMailboxProxy();
 
@@ -148,12 +302,115 @@ class DistributedMailboxProxy : public MailboxBase
        */
       DistributedMailboxProxy& operator= (const DistributedMailboxProxy& rhs);
 
+      /**
+       * Send a serialized buffer to the remote mailbox (as one frame), reconnecting
+       * and retrying once upon failure. Called with outboundMutex_ held.
+       * @returns ERROR if the buffer could not be sent, OK otherwise
+       */
+      int sendBuffer(MessageBuffer& messageBuffer, const ACE_Time_Value* timeout);
+
+      /**
+       * Send framed data to the remote mailbox, reconnecting and retrying once upon
+       * failure. Called with outboundMutex_ held.
+       * @returns ERROR if the data could not be sent, OK otherwise
+       */
+      int sendFrames(const iovec* frames, int frameCount, const ACE_Time_Value* timeout);
+
+      /** Apply the socket options to the client socket after it is connected */
+      void applySocketOptions();
+
+      /**
+       * Return whether a post goes to the outbound queue: always for an asynchronous
+       * proxy, and for a synchronous one until its connection is up and the queue
+       * has been written
+       */
+      bool isQueueing();
+
+      /**
+       * Serialize a message into the outbound queue
+       * @returns ERROR if the queue is full or the proxy closed, OK otherwise
+       */
+      int queueMessage(MessageBase* messagePtr);
+
+      /** Return the socket handle, for the engine reactor */
+      ACE_HANDLE get_handle() const;
+
+      /**
+       * Overriden ACE_Event_Handler method. Called back by the engine reactor
+       * while the socket is writable: completes a connect and writes the queue.
+       * @returns -1 to end the output registration, 0 to keep it
+       */
+      int handle_output(ACE_HANDLE handle);
+
+      /**
+       * Overriden ACE_Event_Handler method. Called back by the engine reactor
+       * when the output registration ends; releases its reference.
+       */
+      int handle_close(ACE_HANDLE handle, ACE_Reactor_Mask closeMask);
+
+      /** Called back by the engine at a scheduled time: flush or reconnect */
+      void handleEngineTimer();
+
+      /** Have the engine write the queue. Called with outboundMutex_ held. */
+      void requestOutput();
+
+      /**
+       * Write the outbound queue without blocking. Called with outboundMutex_ held.
+       * @returns 0 once the queue is empty, 1 if the socket would block, ERROR
+       *    if the connection is lost
+       */
+      int writeOutbound();
+
+      /** Remove written bytes from the outbound queue. Called with outboundMutex_ held. */
+      void consumeOutbound(unsigned int byteCount);
+
+      /**
+       * Return the partially written frame (if any) to the queue, so that it is
+       * sent again whole. Called with outboundMutex_ held.
+       */
+      void rewindOutbound();
+
+      /**
+       * Drop the contents of the outbound queue. Called with outboundMutex_ held.
+       * @returns the number of messages dropped
+       */
+      unsigned int dropOutbound();
+
+      /**
+       * Start a non-blocking connect. Called with outboundMutex_ held.
+       * @returns the number of messages dropped (the connect failed at once and
+       *    the delivery timeout is reached)
+       */
+      unsigned int startConnect();
+
+      /** Record a completed connect. Called with outboundMutex_ held. */
+      void connectionEstablished();
+
+      /**
+       * Record a failed connect and schedule the next attempt. Called with
+       * outboundMutex_ held.
+       * @returns the number of messages dropped (delivery timeout reached)
+       */
+      unsigned int connectionFailed();
+
+      /** Record a lost connection and schedule a reconnect. Called with outboundMutex_ held. */
+      void connectionLost();
+
+      /** Schedule a reconnect attempt. Called with outboundMutex_ held. */
+      void scheduleReconnect(const ACE_Time_Value& reconnectTime);
+
+      /** Report dropped messages to the delivery failure handler */
+      void notifyDeliveryFailure(unsigned int droppedCount);
+
       /** Required by base class MailboxBase. Not implemented */
       MessageBase* getMessage(unsigned short timeoutValue = 0); 
 
       /** Required by base class MailboxBase. Not implemented */
       MessageBase* getMessageNonBlocking();
 
+      /** Required by base class MailboxBase. Not implemented */
+      int getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue = 0);
+
       /** Address of the remote mailbox for distributed communications */
       MailboxAddress remoteAddress_;
 
@@ -166,6 +423,68 @@ class DistributedMailboxProxy : public MailboxBase
       /** OPM Pool ID for storing MessageBuffer objects */
       int messageBufferPoolId_;
 
+      /** Socket and outbound queue options of this proxy */
+      DistributedConnectionOptions options_;
+
+      /** Engine connecting the proxy and writing the outbound queue (NULL if it could
+          not be started, the proxy then connects and sends on the caller's thread) */
+      DistributedProxyEngine* engine_;
+
+      /** Whether every post goes to the outbound queue (coalescing enabled) */
+      bool isAsynchronous_;
+
+      /** Mutex serializing the writes to the client socket, the outbound queue
+          and the connection state */
+      ACE_Thread_Mutex outboundMutex_;
+
+      /** Connection state */
+      MailboxConnectionStateType connectionState_;
+
+      /** Outbound queue of framed messages, in chunks */
+      deque<OutboundChunk> outboundChunks_;
+
+      /** Emptied chunks kept for reuse */
+      vector<unsigned char*> spareChunks_;
+
+      /** Size of each chunk: the coalescing size plus room for a maximum frame */
+      unsigned int outboundChunkSize_;
+
+      /** Number of bytes of the first chunk already written */
+      unsigned int outboundOffset_;
+
+      /** Offset in the first chunk of the first frame not completely written */
+      unsigned int outboundFrameOffset_;
+
+      /** Number of bytes in the outbound queue not yet written */
+      unsigned int outboundBytes_;
+
+      /** Number of messages in the outbound queue not completely written */
+      unsigned int outboundMessageCount_;
+
+      /** Time by which the outbound queue must be written */
+      ACE_Time_Value flushTime_;
+
+      /** Whether the engine has been asked to write the queue (until handle_close) */
+      bool isOutputRequested_;
+
+      /** Whether a reconnect attempt is scheduled */
+      bool isReconnectScheduled_;
+
+      /** Time of the scheduled reconnect attempt */
+      ACE_Time_Value reconnectTime_;
+
+      /** Delay before the next reconnect attempt (doubled on each failure) */
+      ACE_Time_Value reconnectDelay_;
+
+      /** Time the connection was lost, for the delivery timeout */
+      ACE_Time_Value disconnectTime_;
+
+      /** Message Buffer serializing the messages straight into the outbound queue */
+      MessageBuffer outboundView_;
+
+      /** Number of writes made to the client socket */
+      ACE_Atomic_Op <ACE_Thread_Mutex, unsigned int> writeCount_;
+
 };
 
 #endif
@@ -0,0 +1,266 @@
+/******************************************************************************
+*
+* File name:   DistributedProxyEngine.cpp
+* Subsystem:   Platform Services
+* Description: Implements the process wide I/O engine that performs the
+*              socket writes and reconnects of the distributed mailbox proxies.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <ace/Dev_Poll_Reactor.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/Thread.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "DistributedProxyEngine.h"
+#include "DistributedMailboxProxy.h"
+
+#include "platform/common/Defines.h"
+
+#include "platform/logger/Logger.h"
+
+#include "platform/threadmgr/ThreadManager.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+// The engine
+DistributedProxyEngine* DistributedProxyEngine::instance_ = NULL;
+
+// Mutex serializing the creation of the engine
+ACE_Thread_Mutex DistributedProxyEngine::instanceMutex_;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the engine, creating it (and its thread) on first use
+// Design:
+//-----------------------------------------------------------------------------
+DistributedProxyEngine* DistributedProxyEngine::getInstance()
+{
+   instanceMutex_.acquire();
+   if (instance_ == NULL)
+   {
+      DistributedProxyEngine* engine = new DistributedProxyEngine();
+      if (ThreadManager::createThread((ACE_THR_FUNC)DistributedProxyEngine::runStatic, (void*)engine,
+             "DistributedProxyEngine", true) == 0)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create the distributed proxy engine thread",0,0,0,0,0,0);
+         delete engine;
+      }//end if
+      else
+      {
+         instance_ = engine;
+      }//end else
+   }//end if
+   instanceMutex_.release();
+   return instance_;
+}//end getInstance
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Have the reactor call the proxy handle_output while its socket
+//              is writable
+// Design:      The request holds a reference to the proxy, which is carried
+//              over to the registration. The engine thread is only woken by
+//              the first request since it last looked.
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::requestOutput(DistributedMailboxProxy* proxy)
+{
+   proxy->acquire();
+
+   requestMutex_.acquire();
+   bool isFirstRequest = outputRequests_.empty();
+   outputRequests_.push_back(proxy);
+   requestMutex_.release();
+
+   if (isFirstRequest)
+   {
+      reactor_->notify();
+   }//end if
+}//end requestOutput
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Call the proxy handleEngineTimer at the given time
+// Design:      The entry holds a reference to the proxy until the callback. The
+//              engine thread is only woken if its wait has to be cut short.
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::schedule(DistributedMailboxProxy* proxy, const ACE_Time_Value& callbackTime)
+{
+   proxy->acquire();
+
+   requestMutex_.acquire();
+   bool isEarliest = (callbackSchedule_.empty() || (callbackTime < callbackSchedule_.begin()->first));
+   callbackSchedule_.insert(make_pair(callbackTime, proxy));
+   requestMutex_.release();
+
+   if (isEarliest)
+   {
+      reactor_->notify();
+   }//end if
+}//end schedule
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+DistributedProxyEngine::DistributedProxyEngine()
+                       : reactor_(new ACE_Reactor(new ACE_Dev_Poll_Reactor(), 1))
+{
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+DistributedProxyEngine::~DistributedProxyEngine()
+{
+   delete reactor_;
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Static invocation method for starting run in the engine thread
+// Design:
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::runStatic(void* arg)
+{
+   ((DistributedProxyEngine*)arg)->run();
+}//end runStatic
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Engine thread main loop
+// Design:      The reactor waits for the socket events until the next callback
+//              time; the requests made meanwhile wake it with a notify. The
+//              requests and callbacks are then run here, in the reactor thread,
+//              so that no other thread ever needs the reactor token.
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::run()
+{
+   // Set Reactor thread ownership
+   reactor_->owner(ACE_Thread::self());
+
+   ACE_Time_Value maxWaitTime(DISTRIBUTED_PROXY_ENGINE_MAX_WAIT_SEC);
+   while (true)
+   {
+      ACE_Time_Value waitTime = maxWaitTime;
+      requestMutex_.acquire();
+      if (!outputRequests_.empty())
+      {
+         waitTime = ACE_Time_Value::zero;
+      }//end if
+      else if (!callbackSchedule_.empty())
+      {
+         ACE_Time_Value now = ACE_OS::gettimeofday();
+         ACE_Time_Value callbackTime = callbackSchedule_.begin()->first;
+         if (callbackTime <= now)
+         {
+            waitTime = ACE_Time_Value::zero;
+         }//end if
+         else if ((callbackTime - now) < maxWaitTime)
+         {
+            waitTime = callbackTime - now;
+         }//end else if
+      }//end else if
+      requestMutex_.release();
+
+      reactor_->handle_events(waitTime);
+
+      runOutputRequests();
+      runCallbacks();
+   }//end while
+}//end run
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Register the proxies that requested output with the reactor
+// Design:      A proxy whose socket was closed since its request cannot be
+//              registered; its handle_close is called as if the registration
+//              had ended, which releases the reference of the request.
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::runOutputRequests()
+{
+   vector<DistributedMailboxProxy*> requests;
+   requestMutex_.acquire();
+   requests.swap(outputRequests_);
+   requestMutex_.release();
+
+   for (unsigned int index = 0; index < requests.size(); index++)
+   {
+      DistributedMailboxProxy* proxy = requests[index];
+      if (reactor_->register_handler(proxy, ACE_Event_Handler::WRITE_MASK) == ERROR)
+      {
+         TRACELOG(WARNINGLOG, MSGMGRLOG, "Unable to register distributed mailbox proxy for output",0,0,0,0,0,0);
+         proxy->handle_close(ACE_INVALID_HANDLE, ACE_Event_Handler::WRITE_MASK);
+      }//end if
+   }//end for
+}//end runOutputRequests
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Call back the proxies whose time has come
+// Design:      The proxies are called without holding requestMutex_, since
+//              they make new requests from their callbacks
+//-----------------------------------------------------------------------------
+void DistributedProxyEngine::runCallbacks()
+{
+   ACE_Time_Value now = ACE_OS::gettimeofday();
+   requestMutex_.acquire();
+   while (!callbackSchedule_.empty() && (callbackSchedule_.begin()->first <= now))
+   {
+      DistributedMailboxProxy* proxy = callbackSchedule_.begin()->second;
+      callbackSchedule_.erase(callbackSchedule_.begin());
+      requestMutex_.release();
+
+      proxy->handleEngineTimer();
+      proxy->release();
+
+      requestMutex_.acquire();
+   }//end while
+   requestMutex_.release();
+}//end runCallbacks
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
+
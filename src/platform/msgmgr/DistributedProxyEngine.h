@@ -0,0 +1,150 @@
+/******************************************************************************
+*
+* File name:   DistributedProxyEngine.h
+* Subsystem:   Platform Services
+* Description: Implements the process wide I/O engine that performs the
+*              socket writes and reconnects of the distributed mailbox proxies.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_DISTRIBUTED_PROXY_ENGINE_H_
+#define _PLAT_DISTRIBUTED_PROXY_ENGINE_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <map>
+#include <vector>
+
+#include <ace/Reactor.h>
+#include <ace/Thread_Mutex.h>
+#include <ace/Time_Value.h>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+class DistributedMailboxProxy;
+
+/** Longest time the engine thread waits for socket events without a scheduled proxy (sec) */
+#define DISTRIBUTED_PROXY_ENGINE_MAX_WAIT_SEC 1
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * DistributedProxyEngine is the process wide I/O engine of the asynchronous
+ * distributed mailbox proxies (see DistributedMailboxProxy).
+ * <p>
+ * The engine has one thread, which runs an epoll reactor over the sockets of the
+ * proxies. When a proxy has queued messages to write, the engine registers it
+ * for output, and the reactor calls its handle_output as its socket becomes
+ * writable (which is also how a non-blocking connect completes). The engine
+ * also calls the proxies back at the times they schedule (to flush a
+ * coalescing queue, or to retry a connection). Application threads never
+ * write to the sockets, so a slow or stalled peer only holds back the
+ * messages queued to it.
+ * <p>
+ * Application threads never call into the reactor either: their requests are
+ * queued and carried out by the engine thread, which the reactor notify wakes
+ * up. Each request and each registration holds a reference to its proxy, so a
+ * proxy outlives the messages queued in it.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class DistributedProxyEngine
+{
+   public:
+
+      /** Return the engine, creating it (and its thread) on first use */
+      static DistributedProxyEngine* getInstance();
+
+      /**
+       * Have the reactor call the proxy handle_output while its socket is
+       * writable. The registration ends when handle_output returns -1, and
+       * the reference it holds is then released by the proxy handle_close.
+       */
+      void requestOutput(DistributedMailboxProxy* proxy);
+
+      /** Call the proxy handleEngineTimer at (or shortly after) the given time */
+      void schedule(DistributedMailboxProxy* proxy, const ACE_Time_Value& callbackTime);
+
+   protected:
+
+   private:
+
+      /** Proxies waiting for their callback time, ordered by that time */
+      typedef multimap<ACE_Time_Value, DistributedMailboxProxy*> CallbackSchedule;
+
+      /** Constructor */
+      DistributedProxyEngine();
+
+      /** Virtual Destructor. The engine is never destroyed */
+      virtual ~DistributedProxyEngine();
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      DistributedProxyEngine(const DistributedProxyEngine& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      DistributedProxyEngine& operator= (const DistributedProxyEngine& rhs);
+
+      /** Static invocation method for starting run in the engine thread */
+      static void runStatic(void* arg);
+
+      /** Engine thread main loop */
+      void run();
+
+      /** Register the proxies that requested output with the reactor */
+      void runOutputRequests();
+
+      /** Call back the proxies whose time has come */
+      void runCallbacks();
+
+      /** The engine */
+      static DistributedProxyEngine* instance_;
+
+      /** Mutex serializing the creation of the engine */
+      static ACE_Thread_Mutex instanceMutex_;
+
+      /** Reactor demultiplexing the proxy sockets (used by the engine thread only) */
+      ACE_Reactor* reactor_;
+
+      /** Mutex protecting the requests and the schedule */
+      ACE_Thread_Mutex requestMutex_;
+
+      /** Proxies waiting to be registered for output */
+      vector<DistributedMailboxProxy*> outputRequests_;
+
+      /** Proxies waiting for their callback */
+      CallbackSchedule callbackSchedule_;
+};
+
+#endif
@@ -23,7 +23,6 @@ using namespace std;
 
 #include <ace/Condition_Thread_Mutex.h>
 #include <ace/Message_Block.h>
-#include <ace/Select_Reactor.h>
 #include <ace/Thread.h>
 
 //-----------------------------------------------------------------------------
@@ -33,6 +32,7 @@ using namespace std;
 #include "GroupMailbox.h"
 #include "MailboxOwnerHandle.h"
 #include "MessageFactory.h"
+#include "ReactorPool.h"
 
 #include "platform/common/Defines.h"
 
@@ -40,8 +40,6 @@ using namespace std;
 
 #include "platform/opm/OPM.h"
 
-#include "platform/threadmgr/ThreadManager.h"
-
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
@@ -82,7 +80,20 @@ GroupMailbox::~GroupMailbox()
    // Flag that we are shutting down
    isShuttingDown_ = TRUE;
 
-   groupReactor_->end_reactor_event_loop();
+   // The reactor is shared and outlives the mailbox, so stop it from calling us back
+   ACE_HANDLE handle = ACE_INVALID_HANDLE;
+   if (multicastSocket_ != NULL)
+   {
+      handle = multicastSocket_->get_handle();
+   }//end if
+   else if (broadcastSocket_ != NULL)
+   {
+      handle = broadcastSocket_->get_handle();
+   }//end else if
+   if ((groupReactor_ != NULL) && (handle != ACE_INVALID_HANDLE))
+   {
+      groupReactor_->remove_handler(handle, ACE_Event_Handler::READ_MASK | ACE_Event_Handler::DONT_CALL);
+   }//end if
 }//end virtual destructor
 
 
@@ -101,10 +112,9 @@ int GroupMailbox::activate(MailboxOwnerHandle* mailboxOwnerHandle)
    // Begin listening for socket IO
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Group Mailbox activate is called",0,0,0,0,0,0);
 
-   // Base class will start the Reactor event loop in a separate thread and
-   // handle mailbox registration. We need to perform this PRIOR to opening the
-   // group mailbox receiver socket, since we will need the ability to post as soon
-   // as we do that.
+   // Base class will handle mailbox registration. We need to perform this
+   // PRIOR to opening the group mailbox receiver socket, since we will need the
+   // ability to post as soon as we do that.
    if (LocalMailbox::activate(mailboxOwnerHandle) == ERROR)
    {
       TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to active Local Mailbox Base for Group Mailbox",0,0,0,0,0,0);
@@ -253,9 +263,13 @@ int GroupMailbox::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
 {
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Group mailbox deactivate is called",0,0,0,0,0,0);
 
-   // Close the datagram socket; leave the multicast group
+   // Close the datagram socket; leave the multicast group. The socket is removed from
+   // the reactor first, since the reactor is shared and a new socket may be given the
+   // same handle.
    if ((isMulticast_ == true) && (multicastSocket_ != NULL))
    {
+      groupReactor_->remove_handler(multicastSocket_->get_handle(),
+         ACE_Event_Handler::READ_MASK | ACE_Event_Handler::DONT_CALL);
       if (multicastSocket_->leave(groupAddress_.inetAddress) == ERROR)
       {
          TRACELOG(ERRORLOG, MSGMGRLOG, "Error leaving multicast group",0,0,0,0,0,0);
@@ -264,10 +278,12 @@ int GroupMailbox::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
    }//end if
    else if (broadcastSocket_ != NULL)
    {
+      groupReactor_->remove_handler(broadcastSocket_->get_handle(),
+         ACE_Event_Handler::READ_MASK | ACE_Event_Handler::DONT_CALL);
       broadcastSocket_->close();
    }//end else if
 
-   // Base class will end the Reactor processing loop
+   // Base class will handle mailbox deregistration
    return (LocalMailbox::deactivate(mailboxOwnerHandle));
 }//end deactivate
                                                                                                            
@@ -331,19 +347,10 @@ MailboxOwnerHandle* GroupMailbox::createMailbox(const MailboxAddress& groupAddre
       TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create an owner handle to group mailbox",0,0,0,0,0,0);
    }//end else
 
-   // Instantiate the ACE_Select_Reactor used by the LocalMailbox for Timers
-   groupMailbox->selectReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
-
-   // Create a new ACE_Select_Reactor for the signal handling, etc to use
-   groupMailbox->groupReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
-
-   // Start the group reactor processing loop
-   ThreadManager::createThread((ACE_THR_FUNC)GroupMailbox::startReactor,
-      (void*) groupMailbox->groupReactor_, "GroupMailboxReactor", true);
-
-   // Start the Reactor Event Loop -- used for Timer processing.
-   ThreadManager::createThread((ACE_THR_FUNC)LocalMailbox::startReactor,
-      (void*)groupMailbox->selectReactor_, "LocalMailboxReactor", true);
+   // Assign the reactors of the pool used by the LocalMailbox for Timers, and for the
+   // group message send/receive
+   groupMailbox->selectReactor_ = ReactorPool::getReactor();
+   groupMailbox->groupReactor_ = ReactorPool::getReactor();
 
    return mailboxOwnerHandle;
 }//end createMailbox
@@ -409,24 +416,19 @@ int GroupMailbox::handle_input(ACE_HANDLE handle)
       messageBuffer_.setInsertPosition(numberBytes);
    }//end else if
 
-   // Perform Message Id specific deserialization of the buffer back into a MessageBase type
-   MessageBase* message = MessageFactory::recreateMessageFromBuffer(messageBuffer_);
-   if (message != NULL)
+   // Perform Message Id specific deserialization of the buffer back into MessageBase types
+   // (the buffer holds either a single message or a batch of them)
+   MessageBase* messages[MSGMGR_MAX_BATCH_MESSAGES];
+   int messageCount = MessageFactory::recreateMessagesFromBuffer(messageBuffer_, messages, MSGMGR_MAX_BATCH_MESSAGES);
+   for (int index = 0; index < messageCount; index++)
    {
+      MessageBase* message = messages[index];
+
       // Deserialize the Message Version Number - DO NOT DO AUTOMATIC SERIALIZATION OF VERSION...
       // BUT LEAVE THIS CODE AS EXAMPLE OF HOW TO EMBED/SERIALIZE/DESERIALIZE HIDEN/AUTOMATIC PARMS
       //unsigned int versionNumber = 0;
       //messageBuffer_ >> versionNumber;
       //message->setVersion(versionNumber);
- 
-      // First check to see if the messageBuffer is now empty, if not, we need to deserialize
-      // additional flags such as the priorityLevel flag
-      if (!messageBuffer_.areContentsProcessed())
-      {
-         unsigned int messagePriorityLevel = 0;
-         messageBuffer_ >> messagePriorityLevel;
-         message->setPriority(messagePriorityLevel);
-      }//end if 
 
       if (debugValue_)
       {
@@ -452,8 +454,10 @@ int GroupMailbox::handle_input(ACE_HANDLE handle)
       if (post(message) == ERROR)
       {
          TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing a received group message to mailbox",0,0,0,0,0,0);
+         // Rejected (for instance by the mailbox flow control), so it is still ours
+         message->deleteMessage();
       }//end if
-   }//end if
+   }//end for
 
    // Clear the buffer for the next loop iteration
    messageBuffer_.clearBuffer();
@@ -512,46 +516,6 @@ MailboxAddress& GroupMailbox::getMailboxAddress()
 //-----------------------------------------------------------------------------
 
 
-//-----------------------------------------------------------------------------
-// Method Type: STATIC
-// Description: This method starts the reactor thread needed for processing
-//              group signaling and send/receive messages, etc.
-// Design:
-//-----------------------------------------------------------------------------
-void GroupMailbox::startReactor(void* arg)
-{
-   // Convert the void* arg to a Reactor pointer
-   ACE_Reactor* reactor = static_cast<ACE_Reactor*> (arg);
-
-   // Set Reactor thread ownership
-   reactor->owner (ACE_Thread::self ());
-   // Start the reactor processing loop
-   while ((isShuttingDown_ == FALSE) && (reactor->reactor_event_loop_done () == 0))
-   {
-      int result = reactor->run_reactor_event_loop ();
-
-      char errorBuff[200];
-      char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-      if (resultStr == NULL)
-      {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
-      }//end if
-      ostringstream ostr;
-      ostr << "Group reactor event loop returned with code (" << result << ") and errno (" << resultStr << ")" << ends;
-      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
-
-      // Perform reset on the reactor
-      reactor->reset_reactor_event_loop();
-   }//end while
-
-   // Need to do something to prevent the ThreadManager from restarting it
-   //if (isShuttingDown_)
-   //{
-   //   ACE_Thread_Manager::instance()->at_exit(NULL,0);
-   //}//end if
-}//end startReactor
-
-
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
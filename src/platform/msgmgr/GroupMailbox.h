@@ -193,16 +193,6 @@ class GroupMailbox : public LocalMailbox
 
    private:
 
-      /**
-       * This static method is called in a new thread context to start the ACE Reactor
-       * event processing loop for group messages during mailbox activation. This will run the
-       * event loop until the <ACE_Reactor::handle_events> or <ACE_Reactor::alertable_handle_events> methods
-       * returns -1, the <end_reactor_event_loop> method is invoked, or the <ACE_Time_Value>
-       * expires.
-       * @param arg Pointer to the reactor that we are going to start
-       */
-      static void startReactor(void* arg);
-
       /**
        * Overriden ACE_Event_Handler method.
        * Called back automatically when a connection has been dropped
@@ -246,7 +236,7 @@ class GroupMailbox : public LocalMailbox
       /** ACE Broadcast Datagram socket */
       ACE_SOCK_Dgram_Bcast* broadcastSocket_;
 
-      /** ACE_Select_Reactor used for group message signaling and send/receive */
+      /** Reactor of the pool used for group message signaling and send/receive */
       ACE_Reactor* groupReactor_;
 
       /** set to TRUE if multicast loopback is enabled for this mailbox */
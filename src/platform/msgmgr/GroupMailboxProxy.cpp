@@ -68,12 +68,16 @@ GroupMailboxProxy::GroupMailboxProxy(const MailboxAddress& groupAddress,
    MailboxBase::isProxy_ = true;
 
    // Create a (Thread Safe) pool of MessageBuffer objects to be used for serialization/
-   // deserialization of the Messages (use default parameters for MessageBuffer)
-   MessageBufferInitializer bufferInitializer;
-   bufferInitializer.bufferSize = MAX_MESSAGE_LENGTH;
-   bufferInitializer.performNetworkConversion = true;
-   messageBufferPoolId_ = OPM::createPool("MessageBufferDefault", (long)&bufferInitializer,
-      (OPM_INIT_PTR)&MessageBuffer::initialize, 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+   // deserialization of the Messages (use default parameters for MessageBuffer). Each
+   // buffer is constructed in a contiguous slab, with its data directly after it.
+   messageBufferPoolId_ = OPM::createSlabPool("MessageBufferDefault",
+      (long)&MessageBuffer::networkBufferInitializer_, (OPM_PLACEMENT_INIT_PTR)&MessageBuffer::initializeInPlace,
+      MessageBuffer::getInPlaceSize(MAX_MESSAGE_LENGTH), 0.8, 5, 10, true, OPM_GROWTH_ALLOWED,
+      OPM_SLAB_PREFAULT);
+
+   // Grow the pool from the OPM maintenance thread so that posting threads do not
+   // construct new buffers themselves when the pool crosses its threshold
+   OPM::setPoolBackgroundMaintenance(messageBufferPoolId_, true);
 }//end constructor
 
 
@@ -462,6 +466,21 @@ MessageBase* GroupMailboxProxy::getMessageNonBlocking()
 }//end getMessageNonBlocking
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Required by base class. Not implemented
+// Design:
+//-----------------------------------------------------------------------------
+int GroupMailboxProxy::getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue)
+{
+   messages = NULL;
+   maxMessages = 0;
+   timeoutValue = 0;
+   TRACELOG(ERRORLOG, MSGMGRLOG, "Illegal call to Group Mailbox proxy getMessages",0,0,0,0,0,0);
+   return 0;
+}//end getMessages
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
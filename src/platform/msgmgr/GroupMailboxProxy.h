@@ -204,6 +204,9 @@ class GroupMailboxProxy : public MailboxBase
       /** Required by base class MailboxBase. Not implemented */
       MessageBase* getMessageNonBlocking();
 
+      /** Required by base class MailboxBase. Not implemented */
+      int getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue = 0);
+
       /** Address of the remote group mailbox for communications */
       MailboxAddress groupAddress_;
 
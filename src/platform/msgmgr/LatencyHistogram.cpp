@@ -0,0 +1,229 @@
+/******************************************************************************
+*
+* File name:   LatencyHistogram.cpp
+* Subsystem:   Platform Services
+* Description: Implements the lock free latency histogram used to instrument
+*              the mailbox queue wait and message handler times.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <time.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "LatencyHistogram.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the monotonic clock in microseconds
+// Design:      clock_gettime is serviced without a system call (vdso) for
+//              the monotonic clock, so timing every message is affordable
+//-----------------------------------------------------------------------------
+unsigned long long LatencyHistogram::getTimestamp()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return ((unsigned long long)now.tv_sec * 1000000ULL) + (now.tv_nsec / 1000);
+}//end getTimestamp
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the upper bound of the bucket in which a percentage of
+//              the samples of a snapshot are reached
+// Design:      The last bucket is unbounded, so the maximum is returned for it
+//-----------------------------------------------------------------------------
+unsigned long long LatencyHistogram::getPercentile(const LatencyHistogramSnapshot& snapshot, unsigned int percent)
+{
+   if (snapshot.count == 0)
+   {
+      return 0;
+   }//end if
+
+   // Round the rank up, so that the 99th percentile of 10 samples is the 10th
+   unsigned long long rank = ((snapshot.count * percent) + 99) / 100;
+   if (rank == 0)
+   {
+      rank = 1;
+   }//end if
+
+   unsigned long long cumulative = 0;
+   for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS - 1; bucket++)
+   {
+      cumulative += snapshot.buckets[bucket];
+      if (cumulative >= rank)
+      {
+         unsigned long long upperBound = (1ULL << bucket);
+         return ((upperBound < snapshot.maxUsec) ? upperBound : snapshot.maxUsec);
+      }//end if
+   }//end for
+   return snapshot.maxUsec;
+}//end getPercentile
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+                 : count_(0),
+                   totalUsec_(0),
+                   maxUsec_(0)
+{
+   for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++)
+   {
+      buckets_[bucket] = 0;
+   }//end for
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+LatencyHistogram::~LatencyHistogram()
+{
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record a sample, in microseconds
+// Design:      The maximum is read first, so a steady state of samples below
+//              it costs no compare and swap
+//-----------------------------------------------------------------------------
+void LatencyHistogram::record(unsigned long long usec)
+{
+   __sync_add_and_fetch(&buckets_[getBucket(usec)], 1);
+   __sync_add_and_fetch(&totalUsec_, usec);
+   __sync_add_and_fetch(&count_, 1);
+
+   unsigned long long maxUsec = maxUsec_;
+   while ((usec > maxUsec) && !__sync_bool_compare_and_swap(&maxUsec_, maxUsec, usec))
+   {
+      maxUsec = maxUsec_;
+   }//end while
+}//end record
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Copy the contents of the histogram
+// Design:      The count is taken as the sum of the buckets copied, so that
+//              the percentiles of a snapshot are always consistent
+//-----------------------------------------------------------------------------
+void LatencyHistogram::getSnapshot(LatencyHistogramSnapshot& snapshot) const
+{
+   snapshot.count = 0;
+   for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++)
+   {
+      snapshot.buckets[bucket] = buckets_[bucket];
+      snapshot.count += snapshot.buckets[bucket];
+   }//end for
+   snapshot.totalUsec = totalUsec_;
+   snapshot.maxUsec = maxUsec_;
+}//end getSnapshot
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of samples recorded
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long LatencyHistogram::getCount() const
+{
+   return count_;
+}//end getCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Discard the samples recorded so far
+// Design:      Samples recorded concurrently with the reset may be partially
+//              kept
+//-----------------------------------------------------------------------------
+void LatencyHistogram::reset()
+{
+   for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++)
+   {
+      buckets_[bucket] = 0;
+   }//end for
+   count_ = 0;
+   totalUsec_ = 0;
+   maxUsec_ = 0;
+   __sync_synchronize();
+}//end reset
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Append a one line summary of the histogram
+// Design:
+//-----------------------------------------------------------------------------
+void LatencyHistogram::toString(ostringstream& ostr) const
+{
+   LatencyHistogramSnapshot snapshot;
+   getSnapshot(snapshot);
+
+   ostr << "count=" << snapshot.count;
+   if (snapshot.count > 0)
+   {
+      ostr << " avg=" << (snapshot.totalUsec / snapshot.count) << "us"
+           << " p50<=" << getPercentile(snapshot, 50) << "us"
+           << " p99<=" << getPercentile(snapshot, 99) << "us";
+   }//end if
+   ostr << " max=" << snapshot.maxUsec << "us";
+}//end toString
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the bucket that a sample is counted in
+// Design:      The bucket is the bit length of the sample, found with a
+//              single count leading zeros instruction
+//-----------------------------------------------------------------------------
+unsigned int LatencyHistogram::getBucket(unsigned long long usec)
+{
+   if (usec == 0)
+   {
+      return 0;
+   }//end if
+   unsigned int bucket = 64 - __builtin_clzll(usec);
+   return ((bucket < LATENCY_HISTOGRAM_BUCKETS) ? bucket : (LATENCY_HISTOGRAM_BUCKETS - 1));
+}//end getBucket
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
@@ -0,0 +1,154 @@
+/******************************************************************************
+*
+* File name:   LatencyHistogram.h
+* Subsystem:   Platform Services
+* Description: Implements the lock free latency histogram used to instrument
+*              the mailbox queue wait and message handler times.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_LATENCY_HISTOGRAM_H_
+#define _PLAT_LATENCY_HISTOGRAM_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sstream>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/**
+ * Number of buckets in a latency histogram. Bucket 0 counts the samples under
+ * 1 microsecond, and bucket N the samples from 2^(N-1) up to 2^N microseconds;
+ * the last bucket also counts everything longer.
+ */
+#define LATENCY_HISTOGRAM_BUCKETS 32
+
+/** Copy of the contents of a latency histogram taken at some point in time */
+typedef struct
+{
+   /** Number of samples recorded */
+   unsigned long long count;
+
+   /** Sum of the samples, in microseconds */
+   unsigned long long totalUsec;
+
+   /** Longest sample, in microseconds */
+   unsigned long long maxUsec;
+
+   /** Number of samples recorded in each bucket */
+   unsigned long long buckets[LATENCY_HISTOGRAM_BUCKETS];
+} LatencyHistogramSnapshot;
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * LatencyHistogram counts latency samples in power of two buckets of
+ * microseconds.
+ * <p>
+ * Recording a sample is a handful of atomic additions (and a compare and swap
+ * only when a new maximum is seen), with no locks and no allocation, so the
+ * histograms can be left on in production. The buckets only bound each
+ * sample within a factor of two, which is enough to tell a microsecond queue
+ * wait from a millisecond one; the count, total and maximum are exact.
+ * <p>
+ * Snapshots are taken without stopping the recording threads, so a snapshot
+ * taken while samples are being recorded may be off by those samples.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class LatencyHistogram
+{
+   public:
+
+      /** Return the monotonic clock in microseconds, for timing the samples */
+      static unsigned long long getTimestamp();
+
+      /**
+       * Return the upper bound of the bucket in which a percentage of the
+       * samples of a snapshot are reached (0 if the snapshot is empty)
+       */
+      static unsigned long long getPercentile(const LatencyHistogramSnapshot& snapshot, unsigned int percent);
+
+      /** Constructor */
+      LatencyHistogram();
+
+      /** Virtual Destructor */
+      virtual ~LatencyHistogram();
+
+      /** Record a sample, in microseconds */
+      void record(unsigned long long usec);
+
+      /** Copy the contents of the histogram */
+      void getSnapshot(LatencyHistogramSnapshot& snapshot) const;
+
+      /** Return the number of samples recorded */
+      unsigned long long getCount() const;
+
+      /** Discard the samples recorded so far */
+      void reset();
+
+      /**
+       * Append a one line summary of the histogram (count, average,
+       * percentiles and maximum)
+       */
+      void toString(ostringstream& ostr) const;
+
+   protected:
+
+   private:
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      LatencyHistogram(const LatencyHistogram& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      LatencyHistogram& operator= (const LatencyHistogram& rhs);
+
+      /** Return the bucket that a sample is counted in */
+      static unsigned int getBucket(unsigned long long usec);
+
+      /** Number of samples recorded */
+      volatile unsigned long long count_;
+
+      /** Sum of the samples, in microseconds */
+      volatile unsigned long long totalUsec_;
+
+      /** Longest sample, in microseconds */
+      volatile unsigned long long maxUsec_;
+
+      /** Number of samples recorded in each bucket */
+      volatile unsigned long long buckets_[LATENCY_HISTOGRAM_BUCKETS];
+};
+
+#endif
@@ -20,8 +20,6 @@
 //-----------------------------------------------------------------------------
 
 #include <ace/Time_Value.h>
-#include <ace/Message_Block.h>
-#include <ace/Select_Reactor.h>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
@@ -32,7 +30,8 @@
 #include "MailboxAddress.h"
 #include "MailboxLookupService.h"
 #include "MailboxOwnerHandle.h"
-#include "MessageBlockWrapper.h"
+#include "ReactorPool.h"
+#include "TimerWheel.h"
 
 #include "platform/common/MailboxNames.h"
 
@@ -40,8 +39,6 @@
 
 #include "platform/logger/Logger.h"
 
-#include "platform/threadmgr/ThreadManager.h"
-
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
@@ -68,13 +65,11 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Frame
 // Design:     
 //-----------------------------------------------------------------------------
 LocalMailbox::LocalMailbox(const MailboxAddress& localAddress)
-  :localAddress_(localAddress),
-   messageBlockWrapperPoolID_(-1)
+  :isReceivePaused_(false),
+   localAddress_(localAddress),
+   flowControlPolicy_(MAILBOX_FLOW_BLOCK),
+   shedPriority_(1)
 {
-   // Create a (Thread Safe) pool of Message Block Wrapper objects to be used inside the 
-   // ACE_Message_Queue
-   messageBlockWrapperPoolID_ = OPM::createPool("MessageBlockWrapper", 0, 
-      (OPM_INIT_PTR)&MessageBlockWrapper::initialize, 0.8, 50, 100, true, OPM_GROWTH_ALLOWED);
 }//end constructor
 
 
@@ -89,80 +84,35 @@ LocalMailbox::~LocalMailbox()
    // Flag that we are shutting down
    isShuttingDown_ = TRUE;
    
-   selectReactor_->end_reactor_event_loop(); 
-
-   ACE_Message_Block* messageBlock = NULL;
-   while (!this->messageQueue_.is_empty())
+   // The reactor is shared and outlives the mailbox, so cancel the timers still
+   // outstanding in it (disposing of their Timer Messages)
+   if (selectReactor_ != NULL)
    {
-      if ( messageQueue_.dequeue(messageBlock) == -1)
-      {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error dequeuing from message queue",0,0,0,0,0,0);
-      }//end if
-
-      // Cast the ACE_Message_Block back into our data type
-      char* c_data = messageBlock->base();
-
-      // Instead of releasing the Message_Block so that it can be reference counted and disposed of
-      // we just check the message block back into the OPM. Here, we must first cast to
-      // MessageBlockWrapper*; otherwise, the contained ObjectPoolId needed by OPM to determine
-      // which pool to release into will not be visible!!
-      OPM_RELEASE((OPMBase*)((MessageBlockWrapper*)messageBlock));
-      if (c_data)
-      {
-         void* v_data = (void*) c_data;
-         MessageBase* messagePtr = (MessageBase*) v_data;
-         if (messagePtr->isPoolable())
-         {
-            // Release it back into its OPM pool
-            OPM_RELEASE((OPMBase*)messagePtr); 
-         }//end if
-         else
-         {
-            messagePtr->deleteMessage();
-         }//end else
-      }//end if
-   }//end while
-}//end virtual destructor
-
-
-//-----------------------------------------------------------------------------
-// Method Type: STATIC
-// Description: This method starts the reactor thread needed for processing
-//              timer messages, etc.
-// Design:
-//-----------------------------------------------------------------------------
-void LocalMailbox::startReactor(void* arg)
-{
-   // Convert the void* arg to a Reactor pointer
-   ACE_Reactor* reactor = static_cast<ACE_Reactor*> (arg);
+      cancelReactorTimers();
+   }//end if
 
-   // Set Reactor thread ownership
-   reactor->owner (ACE_Thread::self ());
-   // Start the reactor processing loop
-   while ((isShuttingDown_ == FALSE) && (reactor->reactor_event_loop_done () == 0))
+   // So is the timer wheel (deactivate normally took the timers off it already)
+   if (getTimerWheel() != NULL)
    {
-      int result = reactor->run_reactor_event_loop ();
+      getTimerWheel()->cancelAll(this);
+   }//end if
 
-      char errorBuff[200];
-      char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
-      if (resultStr == NULL)
+   // Dispose of the messages that were never processed
+   messageQueue_.deactivate();
+   MessageBase* messagePtr = NULL;
+   while ((messagePtr = messageQueue_.dequeue(false)) != NULL)
+   {
+      if (messagePtr->isPoolable())
       {
-         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+         // Release it back into its OPM pool
+         OPM_RELEASE((OPMBase*)messagePtr);
       }//end if
-      ostringstream ostr;
-      ostr << "Reactor event loop returned with code (" << result << ") and errno (" << resultStr << ")" << ends;
-      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
-
-      // Perform reset on the reactor
-      reactor->reset_reactor_event_loop();
+      else
+      {
+         messagePtr->deleteMessage();
+      }//end else
    }//end while
-
-   // Need to do something to keep ThreadManager from restarting it
-   //if (isShuttingDown_)
-   //{
-   //   ACE_Thread_Manager::instance()->at_exit(NULL,0);
-   //}//end if
-}//end startReactor
+}//end virtual destructor
 
 
 //-----------------------------------------------------------------------------
@@ -180,7 +130,7 @@ int LocalMailbox::activate(MailboxOwnerHandle* mailboxOwnerHandle)
 
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Local Mailbox activate is called",0,0,0,0,0,0);
 
-   // Activate the ACE Message Queue
+   // Activate the Message Queue
    messageQueue_.activate();
    MailboxLookupService::registerMailbox(mailboxOwnerHandle, this);
    setActive(TRUE);
@@ -204,8 +154,15 @@ int LocalMailbox::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
 
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Local Mailbox deactivate is called",0,0,0,0,0,0);
  
-   // Deactivate the ACE Message Queue
+   // Deactivate the Message Queue (wakes up any threads blocked in getMessage)
    messageQueue_.deactivate();
+
+   // The timer wheel is shared and cannot post to a deactivated mailbox, so its
+   // timers stop along with the mailbox
+   if (getTimerWheel() != NULL)
+   {
+      getTimerWheel()->cancelAll(this);
+   }//end if
                                                                                           
    setActive(FALSE);
    MailboxLookupService::deregisterMailbox(mailboxOwnerHandle);
@@ -220,8 +177,6 @@ int LocalMailbox::deactivate(MailboxOwnerHandle* mailboxOwnerHandle)
 //-----------------------------------------------------------------------------
 int LocalMailbox::post(MessageBase* messagePtr, const ACE_Time_Value* timeout)
 {
-   int result;
-
    if (!isActive() || (messagePtr == NULL))
    {
       return ERROR;
@@ -239,50 +194,107 @@ int LocalMailbox::post(MessageBase* messagePtr, const ACE_Time_Value* timeout)
       STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str()); 
    }//end if
 
-   // Since all messages must travel through the ACE_Message_Queue inside of an 
-   // ACE_Message_Block wrapper object, we retrieve a Message_Block from the OPM pool
-   // where we created some. Store a pointer to our local message inside the Message_Block
-   // (Message_Block needs a char*, so we need to do some manipulation). First cast to a 
-   // void pointer (this is dangerous, so need to keep close eye on it). Then cast to char*.
-   void* v_data = (void *) messagePtr;
-   char* c_data = (char *) v_data;
-
-   // Do lots of casting to work between these base classes
-   MessageBlockWrapper* messageBlockWrapper = (MessageBlockWrapper*)OPM_RESERVE(messageBlockWrapperPoolID_);
-   if (!messageBlockWrapper)
+   // Apply the flow control policy if the queue is overloaded; the timeout only
+   // matters for the blocking policy
+   if (applyFlowControl(messagePtr->getPriority(), timeout) == ERROR)
    {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "OPM returned null message block wrapper",0,0,0,0,0,0);
       return ERROR;
    }//end if
-   ACE_Message_Block* messageBlock = (ACE_Message_Block*)messageBlockWrapper;
 
-   // Store our manipulated message pointer inside the ACE Message Block 
-   messageBlock->base(c_data, sizeof(c_data));
+   return ((postAdmitted(&messagePtr, 1) == 1) ? OK : ERROR);
+}//end post
 
-   // Set the messageBlock priority that it will carry with it through the Message Queue
-   // as specified in the posted message (MessageBase). NOTE that ACE maintains FIFO
-   // order when messages of the same priority are inserted consecutively. (ace/Message_Queue_T.h)
-   messageBlock->msg_priority (ACE_DEFAULT_MESSAGE_BLOCK_PRIORITY + (int)messagePtr->getPriority());
 
-   // Enqueue the message to the mailbox priority enabled queue (in case the 
-   // developer set the priority flag for this message)
-   if ( (result = messageQueue_.enqueue_prio(messageBlock, (ACE_Time_Value*)timeout)) == -1)
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages. Returns the number of messages posted.
+// Design:      The whole batch is linked into the queue at once, so the
+//              processing thread is woken (at most) once for the batch. The
+//              flow control is applied once for the batch; when shedding, the
+//              batch stops before its first low priority message.
+//-----------------------------------------------------------------------------
+int LocalMailbox::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   if (!isActive() || (messages == NULL) || (messageCount <= 0))
    {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to enqueue message",0,0,0,0,0,0);
-      return ERROR;
+      return 0;
    }//end if
 
-   // Wake up any sleeping dequeue threads on getMessage
-   manualEvent_.signal();
+   if (debugValue_)
+   {
+      for (int index = 0; index < messageCount; index++)
+      {
+         ostringstream debugMsg;
+         debugMsg << "##POSTING MESSAGE## "
+                  << " SOURCE_ADDRESS>> " << ((MailboxAddress)messages[index]->getSourceAddress()).toString()
+                  << " DESTINATION_ADDRESS>> " << localAddress_.toString()
+                  << " MESSAGE_ID>> 0x" << hex << messages[index]->getMessageId()
+                  << " MESSAGE_CONTENT>> " << messages[index]->toString()
+                  << ends;
+         STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str());
+      }//end for
+   }//end if
 
-   // Check the capacity of the message queue
-   if (result > QUEUE_THRESHOLD)
+   int admittedCount = messageCount;
+   if (flowControlPolicy_ == MAILBOX_FLOW_SHED_LOW_PRIORITY)
    {
-      TRACELOG(WARNINGLOG, MSGMGRLOG, "Mailbox queue over threshold with count %d", result,0,0,0,0,0);
+      for (admittedCount = 0; admittedCount < messageCount; admittedCount++)
+      {
+         if (applyFlowControl(messages[admittedCount]->getPriority(), timeout) == ERROR)
+         {
+            break;
+         }//end if
+      }//end for
    }//end if
+   else if (applyFlowControl(0, timeout) == ERROR)
+   {
+      admittedCount = 0;
+   }//end else if
 
-   return OK;
-}//end post
+   return postAdmitted(messages, admittedCount);
+}//end postBatch
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages without applying the flow control.
+//              Returns the number of messages posted.
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMailbox::postAdmitted(MessageBase** messages, int messageCount)
+{
+   if (!isActive() || (messages == NULL) || (messageCount <= 0))
+   {
+      return 0;
+   }//end if
+
+   // Stamp the messages for the queue wait statistics (one clock read for the batch)
+   unsigned long long enqueueTime = LatencyHistogram::getTimestamp();
+   for (int index = 0; index < messageCount; index++)
+   {
+      messages[index]->enqueueTime_ = enqueueTime;
+   }//end for
+
+   // Link the messages into the queue. The queue keeps a FIFO lane for each priority
+   // specified in the posted messages (MessageBase), and serves the lanes according
+   // to the mailbox queue policy.
+   int postedCount = messageQueue_.enqueue(messages, messageCount);
+   if (postedCount < messageCount)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to enqueue message %d of batch since it is already in a mailbox queue",
+         postedCount,0,0,0,0,0);
+   }//end if
+
+   // Check the capacity of the message queue (only when it is unbounded; otherwise
+   // the flow control reports the overload)
+   int queueDepth = messageQueue_.getDepth();
+   if ((queueDepth > QUEUE_THRESHOLD) && (messageQueue_.getHighWatermark() == 0))
+   {
+      TRACELOG(WARNINGLOG, MSGMGRLOG, "Mailbox queue over threshold with count %d", queueDepth,0,0,0,0,0);
+   }//end if
+
+   return postedCount;
+}//end postAdmitted
 
 
 //-----------------------------------------------------------------------------
@@ -291,8 +303,7 @@ int LocalMailbox::post(MessageBase* messagePtr, const ACE_Time_Value* timeout)
 //              If the mailbox is deactivated this method may return NULL.
 // Design:      If the queue has messages, it dequeues from the head and returns
 //              the message. If no messages are in the queue, this method will
-//              block waiting on a mutex that gets released when a message is
-//              inserted in the queue.
+//              park on a futex until a message is inserted in the queue.
 //-----------------------------------------------------------------------------
 MessageBase* LocalMailbox::getMessage(unsigned short timeout)
 {
@@ -306,57 +317,10 @@ MessageBase* LocalMailbox::getMessage(unsigned short timeout)
       return NULL;
    }//end if
 
-   // Loop performing periodic sleeps until the queue becomes non-Empty
-   while (messageQueue_.is_empty())
-   {
-      // sleep for 50 msec
-      //usleep(50000);
-
-      // Instead of doing a busy wait, let's do a real wait until we are signaled
-      // by a post event that the queue is no longer empty
-      manualEvent_.wait();
-      // When wait() completes, we need to manually reset the Event so that wait()
-      // will again block the next time the queue is empty
-      manualEvent_.reset();
-   }//end while
-
-   // Retrieve the message that is now available. First check to make sure the
-   // mailbox is still active
-   if (!isActive())
-   {
-      return NULL;
-   }//end if 
-
-   // Since all messages must travel through the ACE_Message_Queue inside of an
-   // ACE_Message_Block wrapper object, we must retrieve the Message_Block from the queue
-   // and then extract the MessageBase* object from the char* that Message Block needs.
-   ACE_Message_Block* messageBlock = NULL;
-
-   // Retrieve from the queue
-   if ( (messageQueue_.dequeue_head(messageBlock) ) == -1)
-   {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "Error dequeuing from mailbox queue",0,0,0,0,0,0);
-      return NULL;
-   }//end if
-
-   // Cast the ACE_Message_Block back into our data type
-   char* c_data = messageBlock->base();
-
-   // Instead of releasing the Message_Block so that it can be reference counted and disposed of
-   // we just check the message block back into the OPM. Here, we must first cast to 
-   // MessageBlockWrapper*; otherwise, the contained ObjectPoolId needed by OPM to determine
-   // which pool to release into will not be visible!!
-   OPM_RELEASE((OPMBase*)((MessageBlockWrapper*)messageBlock)); 
-   if (c_data)
-   {
-      void* v_data = (void*) c_data;
-      messagePtr = (MessageBase*) v_data;
-   }//end if
-   else 
-   {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "Dequeued a Message Block containing a NULL data block",0,0,0,0,0,0);
-      return NULL;
-   }//end else
+   // Block until a message is posted; the queue returns NULL if the mailbox
+   // is deactivated while we wait
+   messagePtr = messageQueue_.dequeue(true);
+   checkReceiveResume();
 
    // Return the message
    return messagePtr;
@@ -379,42 +343,84 @@ MessageBase* LocalMailbox::getMessageNonBlocking()
       return NULL;
    }//end if
 
-   // Since all messages must travel through the ACE_Message_Queue inside of an
-   // ACE_Message_Block wrapper object, we must retrieve the Message_Block from the queue
-   // and then extract the MessageBase* object from the char* that Message Block needs.
-   ACE_Message_Block* messageBlock = NULL;
+   // Retrieve the message if one is available
+   messagePtr = messageQueue_.dequeue(false);
+   checkReceiveResume();
+
+   // Return the message
+   return messagePtr;   
+}//getMessageNonBlocking
 
-   if (messageQueue_.is_empty())
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Block until a message is available in the queue, then retrieve
+//              up to maxMessages of the queued messages. If the mailbox is
+//              deactivated this method may return 0.
+// Design:      Only the first message is waited for, so an idle mailbox hands
+//              over a single message as soon as getMessage would.
+//-----------------------------------------------------------------------------
+int LocalMailbox::getMessages(MessageBase** messages, int maxMessages, unsigned short timeout)
+{
+   // For now, use a dummy variable to prevent unused variable compiler warning
+   unsigned short tmp __attribute__ ((unused)) = timeout;
+
+   if (!isActive() || (messages == NULL) || (maxMessages <= 0))
    {
-      return NULL;
+      return 0;
    }//end if
-   else if ( (messageQueue_.dequeue_head(messageBlock) ) == -1)
-   {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "Error dequeuing from non-blocking mailbox queue",0,0,0,0,0,0);
-      return NULL;
-   }//end else if
 
-   // Cast the ACE_Message_Block back into our data type
-   char* c_data = messageBlock->base();
-   // Instead of releasing the Message_Block so that it can be reference counted and disposed of
-   // we just check the message block back into the OPM. Here, we must first cast to
-   // MessageBlockWrapper*; otherwise, the contained ObjectPoolId needed by OPM to determine
-   // which pool to release into will not be visible!!
-   OPM_RELEASE((OPMBase*)((MessageBlockWrapper*)messageBlock)); 
-   if (c_data)
+   int messageCount = messageQueue_.dequeue(messages, maxMessages, true);
+   checkReceiveResume();
+   return messageCount;
+}//end getMessages
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the order in which the priority lanes are served
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMailbox::setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights)
+{
+   messageQueue_.setPolicy(policy, laneWeights);
+   return OK;
+}//end setQueuePolicy
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of messages queued in a priority lane
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMailbox::getQueueLaneDepth(unsigned int lane)
+{
+   return messageQueue_.getLaneDepth(lane);
+}//end getQueueLaneDepth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Bound the message queue with high and low watermarks and set
+//              what to do with the posts made while it is overloaded
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMailbox::setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+   unsigned int shedPriority)
+{
+   if ((highWatermark < 0) || ((highWatermark > 0) && ((lowWatermark < 0) || (lowWatermark >= highWatermark))))
    {
-      void* v_data = (void*) c_data;
-      messagePtr = (MessageBase*) v_data;
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Invalid flow control watermarks high (%d) low (%d)",
+         highWatermark,lowWatermark,0,0,0,0);
+      return ERROR;
    }//end if
-   else
-   {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "Dequeued a Message Block containing a NULL data block",0,0,0,0,0,0);
-      return NULL;
-   }//end else
 
-   // Return the message
-   return messagePtr;   
-}//getMessageNonBlocking
+   flowControlPolicy_ = policy;
+   shedPriority_ = shedPriority;
+   messageQueue_.setWatermarks(highWatermark, lowWatermark);
+   checkReceiveResume();
+   return OK;
+}//end setFlowControl
 
 
 //-----------------------------------------------------------------------------
@@ -440,7 +446,7 @@ MailboxOwnerHandle* LocalMailbox::createMailbox(const MailboxAddress& localAddre
       return NULL;
    }//end if
 
-   // Instantiate the Mailbox and Create a new ACE_Select_Reactor for timers to use
+   // Instantiate the Mailbox and assign it a reactor of the pool for timers to use
    LocalMailbox* mailboxPtr = new LocalMailbox(localAddress);
    if (!mailboxPtr)
    {
@@ -448,7 +454,7 @@ MailboxOwnerHandle* LocalMailbox::createMailbox(const MailboxAddress& localAddre
    }//end if
    else
    {
-      mailboxPtr->selectReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
+      mailboxPtr->selectReactor_ = ReactorPool::getReactor();
    }//end else
 
    // Create an owner handle and return it
@@ -461,11 +467,6 @@ MailboxOwnerHandle* LocalMailbox::createMailbox(const MailboxAddress& localAddre
    // Activate the mailbox
    mailboxPtr->activate(mailboxOwnerHandlePtr);
 
-   // Start the Reactor Event Loop -- used for Timer processing. This has to be
-   // started in a separate thread. Here, returns OS assigned unique thread Id
-   ThreadManager::createThread((ACE_THR_FUNC)LocalMailbox::startReactor,
-      (void*)mailboxPtr->selectReactor_, "LocalMailboxReactor", true);
- 
    return mailboxOwnerHandlePtr;
 }//end createMailbox
 
@@ -518,11 +519,74 @@ MailboxAddress& LocalMailbox::getMailboxAddress()
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
 
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Resume receiving once the queue has been drained. Default
+//              implementation for the mailbox types that never pause.
+// Design:
+//-----------------------------------------------------------------------------
+void LocalMailbox::resumeReceiving()
+{
+   isReceivePaused_ = false;
+}//end resumeReceiving
+
+
 //-----------------------------------------------------------------------------
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
-// Nested Class Definitions:
+// Method Type: INSTANCE
+// Description: Apply the flow control policy to a post of messages with the
+//              given priority. Returns OK if the messages may be enqueued,
+//              otherwise ERROR.
+// Design:      The overload is reported once, by the post that finds the queue
+//              at its high watermark, rather than on every post after it
 //-----------------------------------------------------------------------------
+int LocalMailbox::applyFlowControl(unsigned int priorityLevel, const ACE_Time_Value* timeout)
+{
+   bool isNewlyOverloaded = false;
+   if (!messageQueue_.checkOverload(isNewlyOverloaded))
+   {
+      return OK;
+   }//end if
+
+   if (isNewlyOverloaded)
+   {
+      TRACELOG(WARNINGLOG, MSGMGRLOG, "Mailbox queue reached its high watermark with count %d, applying flow control policy %d",
+         messageQueue_.getDepth(),flowControlPolicy_,0,0,0,0);
+   }//end if
+
+   switch (flowControlPolicy_)
+   {
+      case MAILBOX_FLOW_BLOCK:
+         return messageQueue_.waitUntilDrained(timeout);
+      case MAILBOX_FLOW_SHED_LOW_PRIORITY:
+         return ((priorityLevel < shedPriority_) ? ERROR : OK);
+      case MAILBOX_FLOW_FAIL_FAST:
+      default:
+         return ERROR;
+   }//end switch
+}//end applyFlowControl
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Let subclasses resume receiving if the queue has been drained
+// Design:      Called by the processing thread after each dequeue, so it has
+//              to cost no more than two loads when nothing is paused
+//-----------------------------------------------------------------------------
+void LocalMailbox::checkReceiveResume()
+{
+   if (isReceivePaused_ && !messageQueue_.isOverloaded())
+   {
+      resumeReceiving();
+   }//end if
+}//end checkReceiveResume
+
 
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
@@ -23,9 +23,6 @@
 
 #include <string>
 
-#include <ace/Condition_Thread_Mutex.h>
-#include <ace/Manual_Event.h>
-#include <ace/Message_Queue.h>
 #include <ace/Reactor.h>
 
 using namespace std;
@@ -35,6 +32,7 @@ using namespace std;
 //-----------------------------------------------------------------------------
 
 #include "MailboxBase.h"
+#include "LocalMessageQueue.h"
 
 //-----------------------------------------------------------------------------
 // Forward Declarations.
@@ -66,9 +64,21 @@ using namespace std;
  * size of the MessageBase messages exchanged by the Local Mailbox (this is not
  * true of the other Mailbox types, which are bound by MAX_MESSAGE_LENGTH).
  * <p>
- * LocalMailbox handles the prioritization of MessageBase messages. Using the 
- * ACE Message Queue, the FIFO order of messages is maintained when messages of
- * the same priority are inserted consecutively.
+ * LocalMailbox handles the prioritization of MessageBase messages. Each
+ * priority is queued in its own FIFO lane, so the order of messages of the
+ * same priority is always maintained. The lanes are served in strict priority
+ * order unless the owner selects the weighted fair policy (see
+ * setQueuePolicy), which guarantees each lane a share of the processing.
+ * <p>
+ * The messages are linked together in a LocalMessageQueue, so posting a local
+ * message allocates nothing and takes no locks, and the processing thread
+ * only sleeps in the kernel when the mailbox is idle.
+ * <p>
+ * By default the queue is unbounded. The owner may set high and low
+ * watermarks (see setFlowControl), in which case the posts made while the
+ * queue is overloaded either wait for the processing thread to drain it, fail,
+ * or fail only for low priority messages. Note that a blocking post made from
+ * the mailbox's own processing thread can only end with its timeout.
  * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
@@ -102,6 +112,19 @@ class LocalMailbox : public MailboxBase
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
 
+      /**
+       * Post a batch of messages to this mailbox with a single enqueue.
+       * @returns Number of messages posted (the rest still belong to the caller).
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
+      /**
+       * Post a batch of messages to this mailbox with a single enqueue, without
+       * applying the flow control.
+       * @returns Number of messages posted (the rest still belong to the caller).
+       */
+      virtual int postAdmitted(MessageBase** messages, int messageCount);
+
       /**
        * Will block until a message is available. Note that all non-Proxy
        * Mailbox types use the LocalMailbox's getMessage method to dequeue
@@ -127,6 +150,40 @@ class LocalMailbox : public MailboxBase
        */
       virtual MessageBase* getMessageNonBlocking();
 
+      /**
+       * Will block until a message is available, and then retrieve up to
+       * maxMessages of the messages queued with a single dequeue.
+       * @param messages Array that receives the messages in priority order
+       * @param maxMessages Size of the messages array
+       * @return Number of messages retrieved; 0 if none (if mailbox deactivated).
+       */
+      virtual int getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue = 0);
+
+      /**
+       * Set the order in which the priority lanes are served.
+       * @param laneWeights Messages served from each lane per weighted fair round
+       *    (LOCAL_MESSAGE_QUEUE_LANES entries); NULL keeps the current weights
+       * @returns OK
+       */
+      virtual int setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights = NULL);
+
+      /** Return the number of messages queued in a priority lane */
+      virtual int getQueueLaneDepth(unsigned int lane);
+
+      /**
+       * Bound the message queue. The queue is overloaded from when it reaches
+       * the high watermark until the processing thread drains it to the low
+       * watermark; while it is overloaded, posts are handled by the policy.
+       * @param highWatermark Queue depth at which the policy applies; 0 makes
+       *    the queue unbounded again
+       * @param shedPriority With MAILBOX_FLOW_SHED_LOW_PRIORITY, the posts of
+       *    messages with a priority below this one are rejected
+       * @returns ERROR if the low watermark is not below the high watermark;
+       *    otherwise OK
+       */
+      virtual int setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+         unsigned int shedPriority = 1);
+
       /** Returns the Debug flag value for this mailbox. */
       virtual int getDebugValue();
 
@@ -163,20 +220,20 @@ class LocalMailbox : public MailboxBase
       virtual ~LocalMailbox();
 
       /**
-       * This static method is called in a new thread context to start the ACE Reactor
-       * event processing loop during mailbox activation. This will run the event loop until the
-       * <ACE_Reactor::handle_events> or <ACE_Reactor::alertable_handle_events> methods
-       * returns -1, the <end_reactor_event_loop> method is invoked, or the <ACE_Time_Value>
-       * expires.
-       * @param arg Pointer to the reactor that we are going to start
+       * Called by the processing thread once it has drained an overloaded queue
+       * if isReceivePaused_ is set. Subclasses that stop receiving while the
+       * queue is overloaded resume here; the default does nothing.
        */
-      static void startReactor(void* arg);
+      virtual void resumeReceiving();
+
+      /** Whether a subclass has stopped receiving until the queue is drained */
+      volatile bool isReceivePaused_;
 
       /** Address of this Mailbox */
       MailboxAddress localAddress_;
 
       /** Message queue for storing received messages */
-      ACE_Message_Queue<ACE_MT_SYNCH> messageQueue_;
+      LocalMessageQueue messageQueue_;
 
    private:
 
@@ -195,17 +252,21 @@ class LocalMailbox : public MailboxBase
        */
       LocalMailbox& operator= (const LocalMailbox& rhs);
 
-      /** OPM Pool ID for storing Message Block Wrapper objects */
-      int messageBlockWrapperPoolID_;
-
       /**
-       * ACE Manual Event for controlling enqueue/dequeue thread behavior; when the queue is
-       * empty the dequeue thread will block on this event until the enqueue thread signals
-       * it that the queue is no longer empty.
-       * Here we can use the Manual Event instead of a Process Semaphore since both sides
-       * (enqueue/dequeue) are guaranteed to be in the same process.
+       * Apply the flow control policy to a post of messages with the given
+       * priority, if the queue is overloaded
+       * @returns OK if the messages may be enqueued; otherwise ERROR
        */
-      ACE_Manual_Event manualEvent_;
+      int applyFlowControl(unsigned int priorityLevel, const ACE_Time_Value* timeout);
+
+      /** Let subclasses resume receiving if the queue has been drained */
+      void checkReceiveResume();
+
+      /** What to do with the posts made while the queue is overloaded */
+      MailboxFlowControlPolicyType flowControlPolicy_;
+
+      /** Lowest priority not shed by MAILBOX_FLOW_SHED_LOW_PRIORITY */
+      unsigned int shedPriority_;
 };
 
 #endif
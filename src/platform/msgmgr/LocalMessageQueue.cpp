@@ -0,0 +1,647 @@
+/******************************************************************************
+*
+* File name:   LocalMessageQueue.cpp
+* Subsystem:   Platform Services
+* Description: Implements the lock free message queue used by the LocalMailbox.
+*              Messages are linked together intrusively, so posting a local
+*              message allocates nothing and takes no locks.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <climits>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "LocalMessageQueue.h"
+#include "MessageBase.h"
+
+#include "platform/common/Defines.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+LocalMessageQueue::LocalMessageQueue()
+                  : postedHead_(NULL),
+                    depth_(0),
+                    parkedCount_(0),
+                    wakeSequence_(0),
+                    isActive_(false),
+                    readyLanes_(0),
+                    policy_(MAILBOX_STRICT_PRIORITY),
+                    currentLane_(0),
+                    laneCredits_(0),
+                    highWatermark_(0),
+                    lowWatermark_(0),
+                    isOverloaded_(0),
+                    drainWaiterCount_(0),
+                    drainSequence_(0)
+{
+   for (unsigned int lane = 0; lane < LOCAL_MESSAGE_QUEUE_LANES; lane++)
+   {
+      laneDepth_[lane] = 0;
+      laneHead_[lane] = NULL;
+      laneTail_[lane] = NULL;
+      laneWeight_[lane] = lane + 1;
+   }//end for
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description: The owner is responsible for dequeuing and disposing of any
+//              messages still in the queue
+// Design:
+//-----------------------------------------------------------------------------
+LocalMessageQueue::~LocalMessageQueue()
+{
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Allow messages to be dequeued with blocking
+// Design:
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::activate()
+{
+   isActive_ = true;
+   __sync_synchronize();
+}//end activate
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Wake up every blocked consumer (and producer waiting for the
+//              drain) and make blocking dequeues return NULL
+// Design:
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::deactivate()
+{
+   isActive_ = false;
+   __sync_synchronize();
+   wake(INT_MAX);
+   __sync_add_and_fetch(&drainSequence_, 1);
+   syscall(SYS_futex, &drainSequence_, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}//end deactivate
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Enqueue a message
+// Design:      The message is pushed onto the posted stack with a compare and
+//              swap; the consumer restores the post order when it collects
+//              the stack. The push is a full barrier, so either a consumer
+//              about to park sees the message, or we see it in parkedCount_
+//              and wake it up.
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::enqueue(MessageBase* messagePtr)
+{
+   if (!__sync_bool_compare_and_swap(&messagePtr->isQueued_, 0, 1))
+   {
+      return ERROR;
+   }//end if
+
+   messagePtr->queueLane_ = getLane(messagePtr->priorityLevel_);
+   __sync_add_and_fetch(&laneDepth_[messagePtr->queueLane_], 1);
+   int depth = __sync_add_and_fetch(&depth_, 1);
+
+   MessageBase* head;
+   do
+   {
+      head = postedHead_;
+      messagePtr->queueNext_ = head;
+   } while (!__sync_bool_compare_and_swap(&postedHead_, head, messagePtr));
+
+   if (parkedCount_ > 0)
+   {
+      wake(1);
+   }//end if
+   return depth;
+}//end enqueue
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Enqueue a batch of messages, in order
+// Design:      The messages are chained newest first (the order of the posted
+//              stack) and the chain is pushed with one compare and swap
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::enqueue(MessageBase** messages, int messageCount)
+{
+   int laneCounts[LOCAL_MESSAGE_QUEUE_LANES] = { 0 };
+   int enqueuedCount = 0;
+   while ((enqueuedCount < messageCount) &&
+          __sync_bool_compare_and_swap(&messages[enqueuedCount]->isQueued_, 0, 1))
+   {
+      MessageBase* messagePtr = messages[enqueuedCount];
+      messagePtr->queueLane_ = getLane(messagePtr->priorityLevel_);
+      laneCounts[messagePtr->queueLane_]++;
+      if (enqueuedCount > 0)
+      {
+         messagePtr->queueNext_ = messages[enqueuedCount - 1];
+      }//end if
+      enqueuedCount++;
+   }//end while
+
+   if (enqueuedCount == 0)
+   {
+      return 0;
+   }//end if
+
+   for (unsigned int lane = 0; lane < LOCAL_MESSAGE_QUEUE_LANES; lane++)
+   {
+      if (laneCounts[lane] > 0)
+      {
+         __sync_add_and_fetch(&laneDepth_[lane], laneCounts[lane]);
+      }//end if
+   }//end for
+   __sync_add_and_fetch(&depth_, enqueuedCount);
+
+   MessageBase* oldest = messages[0];
+   MessageBase* newest = messages[enqueuedCount - 1];
+   MessageBase* head;
+   do
+   {
+      head = postedHead_;
+      oldest->queueNext_ = head;
+   } while (!__sync_bool_compare_and_swap(&postedHead_, head, newest));
+
+   if (parkedCount_ > 0)
+   {
+      wake(1);
+   }//end if
+   return enqueuedCount;
+}//end enqueue
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Dequeue the highest priority message
+// Design:
+//-----------------------------------------------------------------------------
+MessageBase* LocalMessageQueue::dequeue(bool isBlocking)
+{
+   MessageBase* messagePtr = NULL;
+   dequeue(&messagePtr, 1, isBlocking);
+   return messagePtr;
+}//end dequeue
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Dequeue up to maxMessages of the highest priority messages
+// Design:      The empty check is done without the consumer lock so that idle
+//              consumers wait on the futex rather than on the lock. Only the
+//              first message is waited for; the rest are whatever is queued.
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::dequeue(MessageBase** messages, int maxMessages, bool isBlocking)
+{
+   while (true)
+   {
+      if (isBlocking && !isActive_)
+      {
+         return 0;
+      }//end if
+
+      if (!isEmpty())
+      {
+         int messageCount = 0;
+         consumerMutex_.acquire();
+         collectPosted();
+         while ((messageCount < maxMessages) && (readyLanes_ != 0))
+         {
+            unsigned int lane = selectLane();
+            MessageBase* messagePtr = laneHead_[lane];
+            laneHead_[lane] = messagePtr->queueNext_;
+            if (laneHead_[lane] == NULL)
+            {
+               laneTail_[lane] = NULL;
+               readyLanes_ &= ~(1U << lane);
+            }//end if
+            __sync_sub_and_fetch(&laneDepth_[lane], 1);
+            messages[messageCount++] = messagePtr;
+         }//end while
+         int depth = __sync_sub_and_fetch(&depth_, messageCount);
+         consumerMutex_.release();
+
+         // The depth is decremented before the overload is checked, and the
+         // producers mark the overload before checking the depth, so a drain
+         // racing with a producer marking the overload is never missed
+         if (isOverloaded_ && (depth <= lowWatermark_))
+         {
+            releaseOverload();
+         }//end if
+
+         for (int index = 0; index < messageCount; index++)
+         {
+            messages[index]->queueNext_ = NULL;
+            // The message may be posted again as soon as the flag is cleared
+            __sync_lock_release(&messages[index]->isQueued_);
+         }//end for
+         if (messageCount > 0)
+         {
+            return messageCount;
+         }//end if
+      }//end if
+
+      if (!isBlocking)
+      {
+         return 0;
+      }//end if
+      park();
+   }//end while
+}//end dequeue
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the order in which the lanes are served
+// Design:      Taken under the consumer lock so that a consumer never sees
+//              half of the new weights
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::setPolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights)
+{
+   consumerMutex_.acquire();
+   policy_ = policy;
+   if (laneWeights != NULL)
+   {
+      for (unsigned int lane = 0; lane < LOCAL_MESSAGE_QUEUE_LANES; lane++)
+      {
+         laneWeight_[lane] = (laneWeights[lane] > 0) ? laneWeights[lane] : 1;
+      }//end for
+   }//end if
+   // Start a new round; with no lane below the current one ready, selectLane
+   // wraps around to the highest ready lane
+   currentLane_ = 0;
+   laneCredits_ = 0;
+   consumerMutex_.release();
+}//end setPolicy
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of messages queued
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::getDepth() const
+{
+   return depth_;
+}//end getDepth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of messages queued in a priority lane
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::getLaneDepth(unsigned int lane) const
+{
+   if (lane >= LOCAL_MESSAGE_QUEUE_LANES)
+   {
+      return 0;
+   }//end if
+   return laneDepth_[lane];
+}//end getLaneDepth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the lane that a message priority is queued in
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int LocalMessageQueue::getLane(unsigned int priorityLevel)
+{
+   if (priorityLevel >= LOCAL_MESSAGE_QUEUE_LANES)
+   {
+      return LOCAL_MESSAGE_QUEUE_LANES - 1;
+   }//end if
+   return priorityLevel;
+}//end getLane
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether there are no messages queued
+// Design:      Messages are counted before they are linked in, so a posted
+//              message may briefly be counted but not yet dequeueable; the
+//              lists are checked instead of the count.
+//-----------------------------------------------------------------------------
+bool LocalMessageQueue::isEmpty() const
+{
+   return ((postedHead_ == NULL) && (readyLanes_ == 0));
+}//end isEmpty
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the flow control watermarks
+// Design:      An overload in progress is re-evaluated against the new
+//              watermarks by the next post
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::setWatermarks(int highWatermark, int lowWatermark)
+{
+   lowWatermark_ = lowWatermark;
+   highWatermark_ = highWatermark;
+   __sync_synchronize();
+   if (isOverloaded_)
+   {
+      releaseOverload();
+   }//end if
+}//end setWatermarks
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether the queue is overloaded, marking it overloaded
+//              first if its depth has reached the high watermark
+// Design:      Only one producer wins the compare and swap, so only one of
+//              them reports the transition. The depth is checked again after
+//              the overload is marked in case the consumer drained the queue
+//              in between (see dequeue).
+//-----------------------------------------------------------------------------
+bool LocalMessageQueue::checkOverload(bool& isNewlyOverloaded)
+{
+   isNewlyOverloaded = false;
+   if (isOverloaded_)
+   {
+      return true;
+   }//end if
+
+   int highWatermark = highWatermark_;
+   if ((highWatermark == 0) || (depth_ < highWatermark))
+   {
+      return false;
+   }//end if
+
+   if (__sync_bool_compare_and_swap(&isOverloaded_, 0, 1))
+   {
+      if (depth_ <= lowWatermark_)
+      {
+         releaseOverload();
+         return false;
+      }//end if
+      isNewlyOverloaded = true;
+   }//end if
+   return (isOverloaded_ != 0);
+}//end checkOverload
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the high watermark (0 if flow control is off)
+// Design:
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::getHighWatermark() const
+{
+   return highWatermark_;
+}//end getHighWatermark
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether the queue is overloaded
+// Design:
+//-----------------------------------------------------------------------------
+bool LocalMessageQueue::isOverloaded() const
+{
+   return (isOverloaded_ != 0);
+}//end isOverloaded
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Wait for the consumer to drain an overloaded queue to its low
+//              watermark. Returns OK once the queue is not overloaded, ERROR
+//              on timeout or if the queue is deactivated.
+// Design:      Same protocol as park: the drain sequence is read before
+//              registering as a waiter and the overload is checked after, so
+//              a drain in between changes the sequence and the futex wait
+//              returns immediately. The deadline is kept on the monotonic
+//              clock so that clock changes do not stretch the wait.
+//-----------------------------------------------------------------------------
+int LocalMessageQueue::waitUntilDrained(const ACE_Time_Value* timeout)
+{
+   struct timespec deadline = { 0, 0 };
+   if (timeout != NULL)
+   {
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      deadline.tv_sec += timeout->sec();
+      deadline.tv_nsec += timeout->usec() * 1000;
+      if (deadline.tv_nsec >= 1000000000)
+      {
+         deadline.tv_sec++;
+         deadline.tv_nsec -= 1000000000;
+      }//end if
+   }//end if
+
+   while (isOverloaded_)
+   {
+      if (!isActive_)
+      {
+         return ERROR;
+      }//end if
+
+      struct timespec remaining = { 0, 0 };
+      struct timespec* remainingPtr = NULL;
+      if (timeout != NULL)
+      {
+         struct timespec now;
+         clock_gettime(CLOCK_MONOTONIC, &now);
+         remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+         remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+         if (remaining.tv_nsec < 0)
+         {
+            remaining.tv_sec--;
+            remaining.tv_nsec += 1000000000;
+         }//end if
+         if ((remaining.tv_sec < 0) || ((remaining.tv_sec == 0) && (remaining.tv_nsec == 0)))
+         {
+            return ERROR;
+         }//end if
+         remainingPtr = &remaining;
+      }//end if
+
+      int sequence = drainSequence_;
+      __sync_add_and_fetch(&drainWaiterCount_, 1);
+      if (isOverloaded_ && isActive_)
+      {
+         syscall(SYS_futex, &drainSequence_, FUTEX_WAIT_PRIVATE, sequence, remainingPtr, NULL, 0);
+      }//end if
+      __sync_sub_and_fetch(&drainWaiterCount_, 1);
+   }//end while
+   return OK;
+}//end waitUntilDrained
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Move the messages posted since the last call into their lanes.
+//              Called with consumerMutex_ held.
+// Design:      The posted stack is newest first, so it is reversed before the
+//              messages are appended to keep FIFO order within a lane.
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::collectPosted()
+{
+   if (postedHead_ == NULL)
+   {
+      return;
+   }//end if
+
+   MessageBase* posted = __sync_lock_test_and_set(&postedHead_, (MessageBase*)NULL);
+   MessageBase* oldestFirst = NULL;
+   while (posted != NULL)
+   {
+      MessageBase* next = posted->queueNext_;
+      posted->queueNext_ = oldestFirst;
+      oldestFirst = posted;
+      posted = next;
+   }//end while
+
+   while (oldestFirst != NULL)
+   {
+      MessageBase* next = oldestFirst->queueNext_;
+      appendToLane(oldestFirst);
+      oldestFirst = next;
+   }//end while
+}//end collectPosted
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Append a message to the consumer side FIFO of its lane
+// Design:
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::appendToLane(MessageBase* messagePtr)
+{
+   unsigned int lane = messagePtr->queueLane_;
+   messagePtr->queueNext_ = NULL;
+
+   if (laneTail_[lane] == NULL)
+   {
+      laneHead_[lane] = messagePtr;
+      readyLanes_ |= (1U << lane);
+   }//end if
+   else
+   {
+      laneTail_[lane]->queueNext_ = messagePtr;
+   }//end else
+   laneTail_[lane] = messagePtr;
+}//end appendToLane
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Select the lane to take the next message from. Called with
+//              consumerMutex_ held and at least one lane ready.
+// Design:      The ready lanes are a bit mask, so finding the highest one (or
+//              the next one down for the weighted fair round) is a single
+//              count leading zeros instruction rather than a scan.
+//-----------------------------------------------------------------------------
+unsigned int LocalMessageQueue::selectLane()
+{
+   if (policy_ == MAILBOX_STRICT_PRIORITY)
+   {
+      return (31 - __builtin_clz(readyLanes_));
+   }//end if
+
+   // Weighted fair: stay on the current lane while it has credits left and
+   // messages queued, then move down to the next ready lane (wrapping around to
+   // the highest) and start its share of the round
+   if ((laneCredits_ == 0) || !(readyLanes_ & (1U << currentLane_)))
+   {
+      unsigned int lowerLanes = readyLanes_ & ((1U << currentLane_) - 1);
+      currentLane_ = 31 - __builtin_clz((lowerLanes != 0) ? lowerLanes : readyLanes_);
+      laneCredits_ = laneWeight_[currentLane_];
+   }//end if
+   laneCredits_--;
+   return currentLane_;
+}//end selectLane
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Wait until a message is posted or the queue is deactivated
+// Design:      The wake sequence is read before registering as parked and the
+//              queue is checked after, so a post that lands in between either
+//              is seen here or changes the sequence, and the futex wait then
+//              returns immediately.
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::park()
+{
+   int sequence = wakeSequence_;
+   __sync_add_and_fetch(&parkedCount_, 1);
+   if (isActive_ && isEmpty())
+   {
+      syscall(SYS_futex, &wakeSequence_, FUTEX_WAIT_PRIVATE, sequence, NULL, NULL, 0);
+   }//end if
+   __sync_sub_and_fetch(&parkedCount_, 1);
+}//end park
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Wake up parked consumers (at most wakeCount of them)
+// Design:
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::wake(int wakeCount)
+{
+   __sync_add_and_fetch(&wakeSequence_, 1);
+   syscall(SYS_futex, &wakeSequence_, FUTEX_WAKE_PRIVATE, wakeCount, NULL, NULL, 0);
+}//end wake
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Clear the overload and wake up the producers waiting for the
+//              drain
+// Design:      The clear is a full barrier, so either a producer about to wait
+//              sees the queue drained, or we see it in drainWaiterCount_
+//-----------------------------------------------------------------------------
+void LocalMessageQueue::releaseOverload()
+{
+   if (__sync_bool_compare_and_swap(&isOverloaded_, 1, 0) && (drainWaiterCount_ > 0))
+   {
+      __sync_add_and_fetch(&drainSequence_, 1);
+      syscall(SYS_futex, &drainSequence_, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+   }//end if
+}//end releaseOverload
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
@@ -0,0 +1,300 @@
+/******************************************************************************
+*
+* File name:   LocalMessageQueue.h
+* Subsystem:   Platform Services
+* Description: Implements the lock free message queue used by the LocalMailbox.
+*              Messages are linked together intrusively, so posting a local
+*              message allocates nothing and takes no locks.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_LOCAL_MESSAGE_QUEUE_H_
+#define _PLAT_LOCAL_MESSAGE_QUEUE_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <ace/Thread_Mutex.h>
+#include <ace/Time_Value.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+class MessageBase;
+
+/** Number of priority lanes. Message priorities above the last lane share it */
+#define LOCAL_MESSAGE_QUEUE_LANES 8
+
+// Order in which a LocalMailbox serves its priority lanes: always the highest
+// priority lane with messages queued, or round robin (highest lane first) across
+// the lanes with messages queued, taking up to the lane weight from each per round
+typedef enum { MAILBOX_STRICT_PRIORITY = 0,
+               MAILBOX_WEIGHTED_FAIR = 1
+             } MailboxQueuePolicyType;
+
+// What a LocalMailbox does with a post while its queue is overloaded (from when
+// it reaches the high watermark until it is drained to the low watermark): wait,
+// up to the post timeout, for the queue to drain; reject the post; or reject the
+// post only if the message priority is below the shed priority
+typedef enum { MAILBOX_FLOW_BLOCK = 0,
+               MAILBOX_FLOW_FAIL_FAST = 1,
+               MAILBOX_FLOW_SHED_LOW_PRIORITY = 2
+             } MailboxFlowControlPolicyType;
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * LocalMessageQueue is a multi-producer queue of MessageBase pointers that
+ * links the messages together through MessageBase::queueNext_ instead of
+ * wrapping each one in a pooled ACE_Message_Block.
+ * <p>
+ * Producers push onto a lock free stack with a single compare and swap. The
+ * consumer takes the whole stack with one atomic exchange, restores the post
+ * order and appends each message to the FIFO lane for its MessageBase priority
+ * (LOCAL_MESSAGE_QUEUE_LANES lanes), so both enqueue and dequeue are O(1)
+ * however deep the backlog is.
+ * <p>
+ * By default the lanes are served in strict priority order (highest priority
+ * first, FIFO within a priority, which is the ordering
+ * ACE_Message_Queue::enqueue_prio gave the LocalMailbox). With the weighted
+ * fair policy the lanes with messages queued are instead served round robin,
+ * up to the lane weight per round, so that a steady stream of high priority
+ * messages cannot starve the lower lanes.
+ * <p>
+ * A consumer that finds the queue empty parks on a futex, and producers only
+ * make the wake up system call when a consumer is parked, so a busy mailbox
+ * exchanges messages without entering the kernel. Since a mailbox may be
+ * processed by several threads, the consumer side is serialized by a mutex
+ * that is uncontended when a single thread processes the mailbox; producers
+ * never take it.
+ * <p>
+ * Flow control is optional: once the depth reaches the high watermark the
+ * queue is marked overloaded, and it stays overloaded until the consumer drains
+ * it to the low watermark. The queue itself still accepts every message; it is
+ * up to the producer to check the overload and wait for the drain (producers
+ * waiting park on a second futex that only the consumer releases).
+ * <p>
+ * A message can be in only one queue at a time, so posting a message that is
+ * still queued (for example a recurring timer that expires again before its
+ * previous expiration was processed) is rejected.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class LocalMessageQueue
+{
+   public:
+
+      /** Constructor */
+      LocalMessageQueue();
+
+      /** Virtual Destructor. Messages still queued are not disposed of */
+      virtual ~LocalMessageQueue();
+
+      /** Allow messages to be dequeued with blocking */
+      void activate();
+
+      /** Wake up every blocked consumer and make blocking dequeues return NULL */
+      void deactivate();
+
+      /**
+       * Enqueue a message. Never blocks, allocates or locks.
+       * @return Number of messages queued (including this one), or ERROR if the
+       *    message is already in a queue
+       */
+      int enqueue(MessageBase* messagePtr);
+
+      /**
+       * Enqueue a batch of messages, in order, with a single compare and swap.
+       * Never blocks, allocates or locks.
+       * @return Number of messages enqueued; the batch stops before the first
+       *    message that is already in a queue
+       */
+      int enqueue(MessageBase** messages, int messageCount);
+
+      /**
+       * Dequeue the highest priority message
+       * @param isBlocking Wait for a message if the queue is empty
+       * @return The message, or NULL if the queue is empty (or has been deactivated
+       *    for a blocking dequeue)
+       */
+      MessageBase* dequeue(bool isBlocking);
+
+      /**
+       * Dequeue up to maxMessages of the highest priority messages with one
+       * acquisition of the consumer lock
+       * @param messages Array that receives the messages in dequeue order
+       * @param maxMessages Size of the messages array
+       * @param isBlocking Wait for a message if the queue is empty
+       * @return Number of messages dequeued; 0 if the queue is empty (or has been
+       *    deactivated for a blocking dequeue)
+       */
+      int dequeue(MessageBase** messages, int maxMessages, bool isBlocking);
+
+      /**
+       * Set the order in which the lanes are served
+       * @param laneWeights Messages taken from each lane per weighted fair round
+       *    (LOCAL_MESSAGE_QUEUE_LANES entries, each at least 1); NULL keeps the
+       *    current weights (by default, the lane number plus one)
+       */
+      void setPolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights = NULL);
+
+      /** Return the number of messages queued */
+      int getDepth() const;
+
+      /** Return the number of messages queued in a priority lane */
+      int getLaneDepth(unsigned int lane) const;
+
+      /** Return the lane that a message priority is queued in */
+      static unsigned int getLane(unsigned int priorityLevel);
+
+      /** Return whether there are no messages queued */
+      bool isEmpty() const;
+
+      /**
+       * Set the flow control watermarks
+       * @param highWatermark Depth at which the queue becomes overloaded; 0
+       *    disables flow control
+       * @param lowWatermark Depth to which the consumer must drain an overloaded
+       *    queue (less than the high watermark)
+       */
+      void setWatermarks(int highWatermark, int lowWatermark);
+
+      /**
+       * Return whether the queue is overloaded, marking it overloaded first if
+       * its depth has reached the high watermark
+       * @param isNewlyOverloaded Set to whether this call marked it overloaded
+       */
+      bool checkOverload(bool& isNewlyOverloaded);
+
+      /** Return the high watermark (0 if flow control is off) */
+      int getHighWatermark() const;
+
+      /** Return whether the queue is overloaded (without checking its depth) */
+      bool isOverloaded() const;
+
+      /**
+       * Wait for the consumer to drain an overloaded queue to its low watermark
+       * @param timeout Longest time to wait; NULL waits as long as it takes
+       * @return OK once the queue is not overloaded; ERROR on timeout or if the
+       *    queue is deactivated
+       */
+      int waitUntilDrained(const ACE_Time_Value* timeout);
+
+   protected:
+
+   private:
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      LocalMessageQueue(const LocalMessageQueue& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      LocalMessageQueue& operator= (const LocalMessageQueue& rhs);
+
+      /** Move the messages posted since the last call into the ordered consumer list */
+      void collectPosted();
+
+      /** Append a message to the consumer side FIFO of its lane */
+      void appendToLane(MessageBase* messagePtr);
+
+      /** Select the lane to take the next message from (at least one lane is ready) */
+      unsigned int selectLane();
+
+      /** Wait until a message is posted or the queue is deactivated */
+      void park();
+
+      /** Wake up parked consumers (at most wakeCount of them) */
+      void wake(int wakeCount);
+
+      /** Clear the overload and wake up the producers waiting for the drain */
+      void releaseOverload();
+
+      /** Most recently posted message; the messages posted since the consumer
+          last collected them are linked from here in reverse order */
+      MessageBase* volatile postedHead_;
+
+      /** Number of messages queued */
+      volatile int depth_;
+
+      /** Number of consumers parked (or about to park) */
+      volatile int parkedCount_;
+
+      /** Futex word; changed on every wake up so that a consumer about to park
+          sees that it was woken */
+      volatile int wakeSequence_;
+
+      /** Whether blocking dequeues may wait */
+      volatile bool isActive_;
+
+      /** Number of messages queued in each lane */
+      volatile int laneDepth_[LOCAL_MESSAGE_QUEUE_LANES];
+
+      /** Bit mask of the lanes whose consumer side FIFO is not empty (only
+          changed while holding consumerMutex_) */
+      volatile unsigned int readyLanes_;
+
+      /** First message of each lane's consumer side FIFO */
+      MessageBase* laneHead_[LOCAL_MESSAGE_QUEUE_LANES];
+
+      /** Last message of each lane's consumer side FIFO */
+      MessageBase* laneTail_[LOCAL_MESSAGE_QUEUE_LANES];
+
+      /** Order in which the lanes are served */
+      MailboxQueuePolicyType policy_;
+
+      /** Messages taken from each lane per weighted fair round */
+      unsigned int laneWeight_[LOCAL_MESSAGE_QUEUE_LANES];
+
+      /** Lane currently being served by the weighted fair policy */
+      unsigned int currentLane_;
+
+      /** Messages left to take from the current lane in this round */
+      unsigned int laneCredits_;
+
+      /** Depth at which the queue becomes overloaded (0 if flow control is off) */
+      volatile int highWatermark_;
+
+      /** Depth to which an overloaded queue must be drained */
+      volatile int lowWatermark_;
+
+      /** Whether the queue is overloaded (int for compare and swap) */
+      volatile int isOverloaded_;
+
+      /** Number of producers waiting for the drain */
+      volatile int drainWaiterCount_;
+
+      /** Futex word the producers wait on; changed on every drain */
+      volatile int drainSequence_;
+
+      /** Serializes the consumers of the queue */
+      ACE_Thread_Mutex consumerMutex_;
+};
+
+#endif
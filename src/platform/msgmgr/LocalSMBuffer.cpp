@@ -2,9 +2,9 @@
 *
 * File name:   LocalSMBuffer.cpp
 * Subsystem:   Platform Services
-* Description: This class is a wrapper for the MessageBuffer's raw unsigned
-*              char buffer so that it can be passed through the shared memory
-*              queue with a position independent pointer.
+* Description: This class describes a serialized message held in a shared
+*              memory pool buffer so that it can be passed through the shared
+*              memory queue by its offset.
 *
 * Name                 Date       Release
 * -------------------- ---------- ---------------------------------------------
@@ -43,29 +43,22 @@
 // Design:     
 //-----------------------------------------------------------------------------
 LocalSMBuffer::LocalSMBuffer()
-              : priorityLevel(0),
+              : bufferOffset(0),
+                priorityLevel(0),
                 versionNumber(0),
                 bufferLength(0)
 {
-   for (unsigned int i = 0; i < sizeof(buffer); i++)
-   { 
-      buffer[i] = '\0';
-   }//end for
-   bufferPI = buffer;
-
-   // Set some dummy identifier OPMBase identifier string
-   OPMBase::setObjectTypeStr("LocalSMBuffer"); 
 }//end constructor
 
 
 //-----------------------------------------------------------------------------
-// Method Type: Virtual Destructor
+// Method Type: Destructor
 // Description: 
 // Design:     
 //-----------------------------------------------------------------------------
 LocalSMBuffer::~LocalSMBuffer()
 {
-}//end virtual destructor
+}//end destructor
 
 
 //-----------------------------------------------------------------------------
@@ -74,13 +67,11 @@ LocalSMBuffer::~LocalSMBuffer()
 // Design:
 //-----------------------------------------------------------------------------
 LocalSMBuffer::LocalSMBuffer( const LocalSMBuffer& rhs )
-              : OPMBase(),
+              : bufferOffset(rhs.bufferOffset),
                 priorityLevel(rhs.priorityLevel),
                 versionNumber(rhs.versionNumber),
                 bufferLength(rhs.bufferLength)
 {
-   ACE_OS::memcpy(buffer, rhs.buffer, sizeof(rhs.buffer));
-   bufferPI = buffer;
 }//end copy constructor
 
 
@@ -91,11 +82,7 @@ LocalSMBuffer::LocalSMBuffer( const LocalSMBuffer& rhs )
 //-----------------------------------------------------------------------------
 void LocalSMBuffer::reset()
 {
-   for (unsigned int i = 0; i < sizeof(buffer); i++)
-   {
-      buffer[i] = '\0';
-   }//end for
-   bufferPI = buffer;
+   bufferOffset = 0;
    priorityLevel = 0;
    versionNumber = 0;
    bufferLength = 0;
@@ -111,8 +98,7 @@ LocalSMBuffer& LocalSMBuffer::operator= ( const LocalSMBuffer& rhs)
 {
    if (this != &rhs)
    {
-      ACE_OS::memcpy(buffer, rhs.buffer, sizeof(rhs.buffer));
-      bufferPI = buffer;
+      bufferOffset = rhs.bufferOffset;
       priorityLevel = rhs.priorityLevel;
       versionNumber = rhs.versionNumber;
       bufferLength = rhs.bufferLength;
@@ -121,32 +107,6 @@ LocalSMBuffer& LocalSMBuffer::operator= ( const LocalSMBuffer& rhs)
 }//end assignment operator
 
 
-//-----------------------------------------------------------------------------
-// Method Type: STATIC
-// Description: OPMBase static initializer method for bootstrapping the objects
-// Design: 
-//-----------------------------------------------------------------------------
-OPMBase* LocalSMBuffer::initialize(int initializer)
-{
-   // remove compiler warning
-   initializer = 0;
-
-   return (new LocalSMBuffer());
-}//end initialize
-
-
-//-----------------------------------------------------------------------------
-// Method Type: INSTANCE
-// Description: OPMBase clean method gets called when the object gets released
-//              back into its pool
-// Design:
-//-----------------------------------------------------------------------------
-void LocalSMBuffer::clean()
-{
-   reset();
-}//end clean
-
-
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
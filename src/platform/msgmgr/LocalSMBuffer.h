@@ -2,9 +2,9 @@
 * 
 * File name:   LocalSMBuffer.h 
 * Subsystem:   Platform Services 
-* Description: This class is a wrapper for the MessageBuffer's raw unsigned
-*              char buffer so that it can be passed through the shared memory
-*              queue with a position independent pointer.
+* Description: This class describes a serialized message held in a shared
+*              memory pool buffer so that it can be passed through the shared
+*              memory queue by its offset.
 * 
 * Name                 Date       Release 
 * -------------------- ---------- ---------------------------------------------
@@ -20,7 +20,6 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
-#include <ace/Based_Pointer_T.h>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
@@ -46,24 +45,28 @@
 //
 
 /**
- * LocalSMBuffer class is a wrapper for the MessageBuffer's raw unsigned
- * char buffer so that it can be passed through the shared memory
- * queue with a position independent pointer. 
+ * LocalSMBuffer class describes a serialized message so that it can be passed
+ * through the shared memory queue. The message itself is serialized by the
+ * sender directly into a buffer of the mailbox's OPMSharedPool, and only its
+ * offset within the pool (which is position independent, unlike a pointer)
+ * and its length are queued. The receiver deserializes the message in place
+ * and releases the buffer back into the pool.
+ * <p>
+ * LocalSMBuffer is a plain structure (it is not an OPMBase object) since it is
+ * copied into shared memory, where a virtual table pointer would not be valid
+ * for another process.
  * <p>
  * LocalSMBuffer assumes that all shared memory passed message will be
- * of length MAX_MESSAGE_LENGTH.
+ * at most of length MAX_MESSAGE_LENGTH.
  * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
 
-struct LocalSMBuffer : public OPMBase
+struct LocalSMBuffer
 {
-   /** Raw unsigned char message buffer from the MessageBuffer class */
-   unsigned char buffer[MAX_MESSAGE_LENGTH];
-
-   /** Position Independent ACE Pointer to the log Message payload string. NOTE: there is no allocated memory here */
-   ACE_Based_Pointer_Basic<unsigned char> bufferPI;
+   /** Offset of the serialized message within the mailbox's shared pool */
+   unsigned long bufferOffset;
 
    /** Priority Level of the Message. Default is 0. */
    unsigned int priorityLevel;
@@ -77,8 +80,8 @@ struct LocalSMBuffer : public OPMBase
    /** Constructor */
    LocalSMBuffer();
 
-   /** Virtual Destructor */
-   virtual ~LocalSMBuffer();
+   /** Destructor */
+   ~LocalSMBuffer();
 
    /** Copy Constructor */ 
    LocalSMBuffer(const LocalSMBuffer& rhs);
@@ -88,19 +91,6 @@ struct LocalSMBuffer : public OPMBase
 
    /** Overloaded Assignment Operator*/
    LocalSMBuffer& operator= (const LocalSMBuffer& rhs);
-
-   /**
-    * OPMBase static initializer method for bootstrapping the objects
-    * @param initializer Here the initializer will be the message buffer
-    *    size to create. This assumes that we will have an OPM object pool
-    *    for each size of Message Buffer that we need.
-    */
-   static OPMBase* initialize(int initializer);
-
-   /** OPMBase clean method gets called when the object gets released back
-       into its pool */
-   void clean();
-
 };
 
 #endif
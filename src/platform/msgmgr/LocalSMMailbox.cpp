@@ -24,7 +24,6 @@
 #include <cstring>
 
 #include <ace/Process_Semaphore.h>
-#include <ace/Select_Reactor.h>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
@@ -35,6 +34,7 @@
 #include "MailboxOwnerHandle.h"
 #include "MessageBuffer.h"
 #include "MessageFactory.h"
+#include "ReactorPool.h"
 
 #include "platform/logger/Logger.h"
 
@@ -176,12 +176,8 @@ MailboxOwnerHandle* LocalSMMailbox::createMailbox(const MailboxAddress& localAdd
       return NULL;
    }//end if
 
-   // Create a new ACE_Select_Reactor for the signal handling, etc to use
-   localSMMailbox_->selectReactor_ = new ACE_Reactor (new ACE_Select_Reactor, 1);
-
-   // Start the Reactor Event Loop -- used for Timer processing.i
-   ThreadManager::createThread((ACE_THR_FUNC)LocalMailbox::startReactor,
-      (void*)localSMMailbox_->selectReactor_, "LocalMailboxReactor", true);
+   // Assign a reactor of the pool for the signal handling, timers, etc to use
+   localSMMailbox_->selectReactor_ = ReactorPool::getReactor();
 
    return mailboxOwnerHandle;
 }//end createMailbox
@@ -240,7 +236,8 @@ void LocalSMMailbox::startSMProcessingThread()
 void LocalSMMailbox::handleSMMessages()
 {
    LocalSMBuffer sharedMemoryBuffer;
-   MessageBuffer messageBuffer(MAX_MESSAGE_LENGTH, false);
+   // Has no memory of its own; it is pointed at each received shared buffer in turn
+   MessageBuffer messageBuffer((unsigned short)0, false);
    while (isActive())
    {
       // Loop performing periodic sleeps until the queue becomes non-Empty
@@ -256,9 +253,6 @@ void LocalSMMailbox::handleSMMessages()
          processSemaphore_->acquire();
       }//end while
 
-      // NOTE: This sharedMemoryBuffer bject was copied into shared memory and here it is
-      // deleted after it is dequeued. When it gets deleted, it will cause a DEVELOPER LOG
-      // WARNING since we are deleting an OPMBase object.
       if (queue_.dequeueMessage(sharedMemoryBuffer) == ERROR)
       {
          TRACELOG(ERRORLOG, MSGMGRLOG, "Error dequeuing message",0,0,0,0,0,0);
@@ -267,20 +261,39 @@ void LocalSMMailbox::handleSMMessages()
          continue;
       }//end if   
 
-      // Wrap the raw buffer with the Message Buffer class
-      unsigned char* tempBuffer = sharedMemoryBuffer.bufferPI;
-      messageBuffer.assignBuffer(tempBuffer, sharedMemoryBuffer.bufferLength); 
+      // Wrap the shared buffer that the sender serialized the message into (in place)
+      // with the Message Buffer class
+      unsigned char* tempBuffer = queue_.getBuffer(sharedMemoryBuffer.bufferOffset);
+      if ((tempBuffer == NULL) || (sharedMemoryBuffer.bufferLength > MAX_MESSAGE_LENGTH))
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Dequeued message has an invalid shared buffer offset %ld or length %d",
+            sharedMemoryBuffer.bufferOffset, sharedMemoryBuffer.bufferLength,0,0,0,0);
+         if (tempBuffer != NULL)
+         {
+            queue_.releaseBuffer(sharedMemoryBuffer.bufferOffset);
+         }//end if
+         sharedMemoryBuffer.reset();
+         continue;
+      }//end if
+      messageBuffer.assignSharedBuffer(tempBuffer, MAX_MESSAGE_LENGTH);
 
       // Set the insertion pointer for our Message Buffer
       messageBuffer.setInsertPosition(sharedMemoryBuffer.bufferLength);
 
-      // Perform Message Id specific deserialization of the buffer back into a MessageBase type
-      MessageBase* message = MessageFactory::recreateMessageFromBuffer(messageBuffer);
-      if (message != NULL)
+      // Perform Message Id specific deserialization of the buffer back into MessageBase types
+      // (the buffer holds either a single message or a batch of them). The priority level
+      // of each message is recreated from the buffer along with it.
+      MessageBase* messages[MSGMGR_MAX_BATCH_MESSAGES];
+      int messageCount = MessageFactory::recreateMessagesFromBuffer(messageBuffer, messages, MSGMGR_MAX_BATCH_MESSAGES);
+
+      // The messages have been recreated from the shared buffer, so give the buffer back
+      // for the next post operation
+      queue_.releaseBuffer(sharedMemoryBuffer.bufferOffset);
+
+      for (int index = 0; index < messageCount; index++)
       {
-         // First lets set the version and priority level, since these don't get serialized
-         // by the developer
-         message->setPriority(sharedMemoryBuffer.priorityLevel);
+         MessageBase* message = messages[index];
+
          //  - DO NOT DO AUTOMATIC SERIALIZATION OF VERSION...
          // BUT LEAVE THIS CODE AS EXAMPLE OF HOW TO EMBED/SERIALIZE/DESERIALIZE HIDEN/AUTOMATIC PARMS
          //message->setVersion(sharedMemoryBuffer.versionNumber);
@@ -307,11 +320,10 @@ void LocalSMMailbox::handleSMMessages()
          if (post(message) == ERROR)
          {
             TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing a received shared memory message to local mailbox",0,0,0,0,0,0);
+            // Rejected (for instance by the mailbox flow control), so it is still ours
+            message->deleteMessage();
          }//end if
-      }//end if
-
-      // Clear the buffer for the next loop iteration
-      messageBuffer.clearBuffer();
+      }//end for
 
       // Reset the shared memory buffer
       sharedMemoryBuffer.reset();
@@ -29,6 +29,7 @@
 #include "MailboxLookupService.h"
 #include "MailboxOwnerHandle.h"
 #include "MessageBase.h"
+#include "MessageFactory.h"
 
 #include "platform/logger/Logger.h"
 
@@ -60,17 +61,16 @@ LocalSMMailboxProxy::LocalSMMailboxProxy(const MailboxAddress& localAddress, con
    // Create/map the process semaphore. Initialize it to be blocked
    processSemaphore_ = new ACE_Process_Semaphore(0, localAddress.toString().c_str());
 
-   // Create a (Thread Safe) pool of MessageBuffer objects to be used for serialization/
-   // deserialization of the Messages (use default parameters for MessageBuffer)
-   MessageBufferInitializer bufferInitializer;
-   bufferInitializer.bufferSize = MAX_MESSAGE_LENGTH;
-   bufferInitializer.performNetworkConversion = false;
-   messageBufferPoolId_ = OPM::createPool("MessageBufferDefault", (long)&bufferInitializer,
-      (OPM_INIT_PTR)&MessageBuffer::initialize, 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
-
-   // Create a Thread Safe pool of LocalSMBuffer objects for shared memory transfer
-   localSMBufferPoolId_ = OPM::createPool("LocalSMBuffer", 0, (OPM_INIT_PTR)&LocalSMBuffer::initialize,
-      0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+   // Create a (Thread Safe) pool of MessageBuffer objects to be used for serialization
+   // of the Messages. These buffers have no memory of their own: each post serializes
+   // directly into a buffer reserved from the shared memory pool of the queue.
+   messageBufferPoolId_ = OPM::createSlabPool("MessageBufferShared",
+      (long)&MessageBuffer::sharedBufferInitializer_, (OPM_PLACEMENT_INIT_PTR)&MessageBuffer::initializeInPlace,
+      MessageBuffer::getInPlaceSize(0), 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+
+   // Grow the pool from the OPM maintenance thread so that posting threads do not
+   // construct new buffers themselves when the pool crosses its threshold
+   OPM::setPoolBackgroundMaintenance(messageBufferPoolId_, true);
 }//end constructor
 
 
@@ -114,8 +114,19 @@ int LocalSMMailboxProxy::post(MessageBase* messagePtr, const ACE_Time_Value* tim
       STRACELOG(DEBUGLOG, MSGMGRLOG, debugMsg.str().c_str());
    }//end if
 
-   // Reserve Message Buffer object from the OPM
+   // Reserve a buffer in the shared memory pool of the queue. The receiving mailbox
+   // releases it once it has deserialized the message.
+   unsigned long bufferOffset = queue_.reserveBuffer();
+   if (bufferOffset == OPM_SHARED_NULL_OFFSET)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to post message to Local SM Mailbox since all shared buffers are in use. Application should must retry the message or delete it. ",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
+
+   // Reserve Message Buffer object from the OPM and point it at the shared buffer so
+   // that the message is serialized in place
    MessageBuffer* messageBuffer = (MessageBuffer*)OPM_RESERVE(messageBufferPoolId_);
+   messageBuffer->assignSharedBuffer(queue_.getBuffer(bufferOffset), MAX_MESSAGE_LENGTH);
 
    // Serialize the Message Id
    *messageBuffer << messagePtr->getMessageId();
@@ -136,24 +147,20 @@ int LocalSMMailboxProxy::post(MessageBase* messagePtr, const ACE_Time_Value* tim
       *messageBuffer << priorityLevel;
    }//end if
 
-   // Reserve a LocalSMBuffer object from the OPM
-   // NOTE: This object will be copied into shared memory and later deleted after it is
-   // dequeued. When it gets deleted, it will cause a DEVELOPER LOG WARNING since we are
-   // deleting an OPMBase object.
-   LocalSMBuffer* sharedMemoryBuffer = (LocalSMBuffer*)OPM_RESERVE(localSMBufferPoolId_);
+   // Only the offset and length of the serialized message go through the queue
+   LocalSMBuffer sharedMemoryBuffer;
+   sharedMemoryBuffer.bufferOffset = bufferOffset;
+   sharedMemoryBuffer.bufferLength = messageBuffer->getBufferLength();
 
-   // Wrap the Message Buffer's raw buffer contents inside a shared memory buffer
-   // Shared memory message buffer is used to encapsulate messages exchanged over shared memory
-   memcpy(sharedMemoryBuffer->buffer, messageBuffer->getBuffer(), messageBuffer->getBufferLength());   
-   sharedMemoryBuffer->bufferPI = sharedMemoryBuffer->buffer;
-   sharedMemoryBuffer->bufferLength = messageBuffer->getBufferLength();
+   // Detach the shared buffer and release the Message Buffer back into the OPM (which
+   // would otherwise clear the shared buffer)
+   messageBuffer->assignSharedBuffer(NULL, 0);
+   OPM_RELEASE((OPMBase*)messageBuffer);
 
-   if (queue_.enqueueMessage(*sharedMemoryBuffer) == ERROR)
+   if (queue_.enqueueMessage(sharedMemoryBuffer) == ERROR)
    {
       TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to post message to Local SM Mailbox due to enqueue error. Application should must retry the message or delete it. ",0,0,0,0,0,0);
-      // Release the buffer back into the OPM (and Clear the buffer) for the next post operation
-      OPM_RELEASE((OPMBase*)messageBuffer);
-      OPM_RELEASE((OPMBase*)sharedMemoryBuffer);
+      queue_.releaseBuffer(bufferOffset);
       return ERROR;
    }//end if
 
@@ -166,14 +173,106 @@ int LocalSMMailboxProxy::post(MessageBase* messagePtr, const ACE_Time_Value* tim
    // delete the message (this releases to OPM if the message is poolable)
    messagePtr->deleteMessage();
 
-   // Release the buffer back into the OPM (and Clear the buffer) for the next post operation
-   OPM_RELEASE((OPMBase*)messageBuffer);
-   OPM_RELEASE((OPMBase*)sharedMemoryBuffer);
-
    return OK;
 }//end post
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages to the shared memory mailbox. Returns
+//              the number of messages posted.
+// Design:      Each shared buffer carries as many messages as fit, so a batch
+//              costs one shared buffer, one enqueue and one wake-up per
+//              MAX_MESSAGE_LENGTH bytes rather than per message
+//-----------------------------------------------------------------------------
+int LocalSMMailboxProxy::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   if (!isActive() || (messages == NULL) || (messageCount <= 0))
+   {
+      return 0;
+   }//end if
+
+   // Reserve the Message Buffer objects: one is pointed at each shared buffer in turn and
+   // the other at local memory, where each message is serialized before it is added
+   unsigned char scratchMemory[MAX_MESSAGE_LENGTH];
+   MessageBuffer* batchBuffer = (MessageBuffer*)OPM_RESERVE(messageBufferPoolId_);
+   MessageBuffer* scratchBuffer = (MessageBuffer*)OPM_RESERVE(messageBufferPoolId_);
+   if ((batchBuffer == NULL) || (scratchBuffer == NULL))
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "OPM returned null message buffer",0,0,0,0,0,0);
+      if (batchBuffer != NULL)
+      {
+         OPM_RELEASE((OPMBase*)batchBuffer);
+      }//end if
+      if (scratchBuffer != NULL)
+      {
+         OPM_RELEASE((OPMBase*)scratchBuffer);
+      }//end if
+      return 0;
+   }//end if
+   scratchBuffer->assignSharedBuffer(scratchMemory, MAX_MESSAGE_LENGTH);
+
+   int postedCount = 0;
+   while (postedCount < messageCount)
+   {
+      unsigned long bufferOffset = queue_.reserveBuffer();
+      if (bufferOffset == OPM_SHARED_NULL_OFFSET)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to post message batch to Local SM Mailbox since all shared buffers are in use. Application should must retry the messages or delete them. ",0,0,0,0,0,0);
+         break;
+      }//end if
+
+      batchBuffer->assignSharedBuffer(queue_.getBuffer(bufferOffset), MAX_MESSAGE_LENGTH);
+      int batchedCount = MessageFactory::serializeBatch(&messages[postedCount], messageCount - postedCount,
+         *batchBuffer, *scratchBuffer);
+
+      // A message too large to be batched is posted on its own
+      if (batchedCount == 0)
+      {
+         queue_.releaseBuffer(bufferOffset);
+         if (post(messages[postedCount], timeout) == ERROR)
+         {
+            break;
+         }//end if
+         postedCount++;
+         continue;
+      }//end if
+
+      // Only the offset and length of the serialized batch go through the queue
+      LocalSMBuffer sharedMemoryBuffer;
+      sharedMemoryBuffer.bufferOffset = bufferOffset;
+      sharedMemoryBuffer.bufferLength = batchBuffer->getBufferLength();
+
+      if (queue_.enqueueMessage(sharedMemoryBuffer) == ERROR)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Failed to post message batch to Local SM Mailbox due to enqueue error. Application should must retry the messages or delete them. ",0,0,0,0,0,0);
+         queue_.releaseBuffer(bufferOffset);
+         break;
+      }//end if
+
+      // Release the Blocking Process Semaphore to wake-up the dequeue thread
+      processSemaphore_->release();
+
+      // delete the messages (this releases to OPM if the message is poolable)
+      for (int index = postedCount; index < (postedCount + batchedCount); index++)
+      {
+         incrementSentCount();
+         messages[index]->deleteMessage();
+      }//end for
+      postedCount += batchedCount;
+   }//end while
+
+   // Detach the buffers and release the Message Buffers back into the OPM (which
+   // would otherwise clear the buffers)
+   batchBuffer->assignSharedBuffer(NULL, 0);
+   scratchBuffer->assignSharedBuffer(NULL, 0);
+   OPM_RELEASE((OPMBase*)batchBuffer);
+   OPM_RELEASE((OPMBase*)scratchBuffer);
+
+   return postedCount;
+}//end postBatch
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Activate the local shared memory mailbox proxy
@@ -328,6 +427,21 @@ MessageBase* LocalSMMailboxProxy::getMessageNonBlocking()
 }//end getMessageNonBlocking
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Required by base class. Not implemented
+// Design:
+//-----------------------------------------------------------------------------
+int LocalSMMailboxProxy::getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue)
+{
+   messages = NULL;
+   maxMessages = 0;
+   timeoutValue = 0;
+   TRACELOG(ERRORLOG, MSGMGRLOG, "Illegal call to Local Shared Memory Mailbox proxy getMessages",0,0,0,0,0,0);
+   return 0;
+}//end getMessages
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
@@ -75,6 +75,15 @@ class LocalSMMailboxProxy : public MailboxBase
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
 
+      /**
+       * Post a batch of messages to the local shared memory mailbox. As many
+       * messages as fit are serialized together into each shared buffer, which
+       * is then enqueued as one entry.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
       /**
        * Allows applications to create a mailbox and get a handle to it.
        *
@@ -161,18 +170,18 @@ class LocalSMMailboxProxy : public MailboxBase
       /** Required by base class MailboxBase. Not implemented */
       MessageBase* getMessageNonBlocking();
 
+      /** Required by base class MailboxBase. Not implemented */
+      int getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue = 0);
+
       /** Address of the remote mailbox for distributed communications */
       MailboxAddress localAddress_;
 
       /** Shared memory queue for exchanging MessageBase messages between processes */
       LocalSMMailboxQueue queue_;
 
-      /** OPM Pool ID for storing MessageBuffer objects */
+      /** OPM Pool ID for storing the MessageBuffer objects that serialize into shared buffers */
       int messageBufferPoolId_;
 
-      /** OPM Pool ID for storing the LocalSMBuffer objects */
-      int localSMBufferPoolId_;
-
       /** ACE Process Semaphore used to signal between enqueue/dequeue threads/processes
           when the queue is empty and non-empty */
       ACE_Process_Semaphore* processSemaphore_;
@@ -58,7 +58,8 @@ LocalSMMailboxQueue::LocalSMMailboxQueue(const char* queueName, const char* coor
               : coordinatingMutex_(coordinatingMutexName),
                 queueName_(queueName),
                 shmemAllocator_(NULL),
-                queue_(NULL)
+                queue_(NULL),
+                bufferPool_(queueName, MAX_MESSAGE_LENGTH, LOCALSM_POOL_BUFFERS)
 {
 }//end constructor
 
@@ -84,6 +85,13 @@ int LocalSMMailboxQueue::setupQueue()
 
    // No Need to Guard this method with the coordinating Mutex ??
 
+   // Map the pool of message buffers shared by the senders and the receiver
+   if (bufferPool_.open() == false)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to open the Local SM Mailbox buffer pool",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
+
    // First let's get a pointer to the common shared memory allocator
    shmemAllocator_ = SharedMemoryManager::getAllocator();
    if (shmemAllocator_ == NULL)
@@ -187,13 +195,56 @@ bool LocalSMMailboxQueue::isEmpty()
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
-// Description: Clear all queue MessageBase contents from shared memory
+// Description: Reserve a message buffer from the shared pool
+// Design:      The pool is lock free, so the coordinating mutex is not needed
+//-----------------------------------------------------------------------------
+unsigned long LocalSMMailboxQueue::reserveBuffer()
+{
+   return bufferPool_.reserve();
+}//end reserveBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Release a message buffer back into the shared pool
 // Design:
 //-----------------------------------------------------------------------------
+void LocalSMMailboxQueue::releaseBuffer(unsigned long bufferOffset)
+{
+   bufferPool_.release(bufferOffset);
+}//end releaseBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the address in this process of a message buffer
+// Design:      Offsets come from another process, so they are checked before
+//              they are used
+//-----------------------------------------------------------------------------
+unsigned char* LocalSMMailboxQueue::getBuffer(unsigned long bufferOffset)
+{
+   if (bufferPool_.isValidOffset(bufferOffset) == false)
+   {
+      return NULL;
+   }//end if
+   return (unsigned char*)bufferPool_.getAddress(bufferOffset);
+}//end getBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Clear all queue MessageBase contents from shared memory
+// Design:      The messages still in the queue hold shared pool buffers, so
+//              they are dequeued one at a time to release them.
+//-----------------------------------------------------------------------------
 void LocalSMMailboxQueue::clearQueue()
 {
    ACE_GUARD (ACE_Process_Mutex, ace_mon, coordinatingMutex_);
-   queue_->delete_nodes(shmemAllocator_);
+   LocalSMBuffer buffer;
+   while (queue_->dequeue_head(buffer, shmemAllocator_) != ERROR)
+   {
+      bufferPool_.release(buffer.bufferOffset);
+   }//end while
 }//end clearQueue
 
 
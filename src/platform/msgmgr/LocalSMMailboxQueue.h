@@ -33,6 +33,8 @@ using namespace std;
 
 #include "platform/common/Defines.h"
 
+#include "platform/opm/OPMSharedPool.h"
+
 #include "platform/utilities/UnboundedSMQueue.h"
 
 #include "platform/utilities/SharedMemoryManager.h"
@@ -58,14 +60,17 @@ using namespace std;
  * <p>
  * For simplicity, we depend on using the MessageBuffer class to serialize
  * and deserialize the Message into a raw buffer. This buffer is assumed
- * to be no larger than MAX_MESSAGE_LENGTH, and we wrap the raw buffer with
- * a LocalSMBuffer which provides the Position Independent semantics. It is
- * somewhat undesirable that we have to perform serialization/deserialization
- * as well as deep copy; however if we were to attempt manage our variable
- * length MessageBase messages in shared memory, it would not have been
- * possible to maintain the generic nature of the API exposed to the developer.
- * (NOTE that this means of IPC will still be faster than going through the
- * network stack).
+ * to be no larger than MAX_MESSAGE_LENGTH. Each queue has an OPMSharedPool
+ * of LOCALSM_POOL_BUFFERS such buffers in its own shared memory segment: the
+ * sender reserves a buffer and serializes the Message directly into it, and
+ * only a LocalSMBuffer holding the buffer's offset (which provides the
+ * Position Independent semantics) and length goes through the queue. The
+ * receiver deserializes the Message in place and then releases the buffer,
+ * so the serialized contents are never copied. If we were to attempt manage
+ * our variable length MessageBase messages in shared memory, it would not
+ * have been possible to maintain the generic nature of the API exposed to
+ * the developer. (NOTE that this means of IPC will still be faster than going
+ * through the network stack).
  * <p>
  * This shared memory queue uses the Position Independent Malloc/Allocation
  * factory in ACE, and it handles queue growth using the automatic OS
@@ -78,6 +83,9 @@ using namespace std;
 /** Shared Memory Initialization parameters */
 #define LOCALSM_QUEUENAME "LocalSMMailboxQueue"
 
+/** Number of message buffers in the shared pool of each queue (messages posted but not yet received) */
+#define LOCALSM_POOL_BUFFERS 1024
+
 class LocalSMMailboxQueue
 {
    public:
@@ -111,6 +119,24 @@ class LocalSMMailboxQueue
        */
       int dequeueMessage(LocalSMBuffer& buffer);
 
+      /**
+       * Reserve a message buffer (of MAX_MESSAGE_LENGTH) from the queue's shared pool
+       * @returns Offset of the buffer, or OPM_SHARED_NULL_OFFSET if none are free
+       */
+      unsigned long reserveBuffer();
+
+      /**
+       * Release a message buffer (reserved by this or another process) back into
+       * the queue's shared pool
+       */
+      void releaseBuffer(unsigned long bufferOffset);
+
+      /**
+       * Return the address in this process of a message buffer
+       * @returns NULL if the offset is not that of a buffer in the shared pool
+       */
+      unsigned char* getBuffer(unsigned long bufferOffset);
+
       /** Clears the MessageBase contents of the shared memory queue */
       void clearQueue();
 
@@ -151,6 +177,9 @@ class LocalSMMailboxQueue
       /** Pointer to the actual shared memory queue */
       LOCAL_SM_MAILBOX_QUEUE* queue_;
 
+      /** Shared pool of buffers that the messages are serialized into */
+      OPMSharedPool bufferPool_;
+
 };
 
 #endif
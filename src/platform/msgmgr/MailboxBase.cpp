@@ -19,6 +19,7 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <ace/Reactor.h>
 #include <ace/Select_Reactor.h>
 
 //-----------------------------------------------------------------------------
@@ -64,12 +65,17 @@ MailboxBase::MailboxBase()
      isProxy_(false),
      selectReactor_(NULL),
      activeTimers_(0),
+     timerWheel_(NULL),
      ownerHandleWhoActivatedMe_(NULL),
      active_(FALSE),
      referenceCount_(0),
      receivedCount_(0),
      sentCount_(0)
 {
+   for (int page = 0; page < MAILBOX_HISTOGRAM_PAGE_COUNT; page++)
+   {
+      handlerTimePages_[page] = NULL;
+   }//end for
 }//end constructor
 
 
@@ -80,6 +86,17 @@ MailboxBase::MailboxBase()
 //-----------------------------------------------------------------------------
 MailboxBase::~MailboxBase()
 {
+   for (int page = 0; page < MAILBOX_HISTOGRAM_PAGE_COUNT; page++)
+   {
+      if (handlerTimePages_[page] != NULL)
+      {
+         for (int entry = 0; entry < MAILBOX_HISTOGRAM_PAGE_SIZE; entry++)
+         {
+            delete handlerTimePages_[page]->histograms[entry];
+         }//end for
+         delete handlerTimePages_[page];
+      }//end if
+   }//end for
 }//end virtual destructor
 
 
@@ -150,6 +167,117 @@ unsigned int MailboxBase::getReceivedCount()
 }//end getReceivedCount
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record how long a message waited in the mailbox queue
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::recordQueueWait(unsigned long long usec)
+{
+   queueWaitHistogram_.record(usec);
+}//end recordQueueWait
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record how long the handler of a message took
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::recordHandlerTime(unsigned short messageId, unsigned long long usec)
+{
+   getHandlerTimeHistogram(messageId, true)->record(usec);
+}//end recordHandlerTime
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Copy the histogram of the time messages waited in the queue
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::getQueueWaitSnapshot(LatencyHistogramSnapshot& snapshot)
+{
+   queueWaitHistogram_.getSnapshot(snapshot);
+}//end getQueueWaitSnapshot
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Copy the histogram of the time taken by the handler of a
+//              message Id. Returns ERROR if none has been handled.
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxBase::getHandlerTimeSnapshot(unsigned short messageId, LatencyHistogramSnapshot& snapshot)
+{
+   LatencyHistogram* histogram = getHandlerTimeHistogram(messageId, false);
+   if (histogram == NULL)
+   {
+      return ERROR;
+   }//end if
+   histogram->getSnapshot(snapshot);
+   return OK;
+}//end getHandlerTimeSnapshot
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Discard the latency statistics recorded so far
+// Design:      The histograms are kept (and emptied), since the processing
+//              threads may be recording into them
+//-----------------------------------------------------------------------------
+void MailboxBase::resetLatencyStatistics()
+{
+   queueWaitHistogram_.reset();
+   for (int page = 0; page < MAILBOX_HISTOGRAM_PAGE_COUNT; page++)
+   {
+      HandlerTimePage* handlerTimePage = handlerTimePages_[page];
+      if (handlerTimePage == NULL)
+      {
+         continue;
+      }//end if
+      for (int entry = 0; entry < MAILBOX_HISTOGRAM_PAGE_SIZE; entry++)
+      {
+         if (handlerTimePage->histograms[entry] != NULL)
+         {
+            handlerTimePage->histograms[entry]->reset();
+         }//end if
+      }//end for
+   }//end for
+}//end resetLatencyStatistics
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Append a summary of the latency statistics
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::listLatencyStatistics(ostringstream& ostr)
+{
+   ostr << "   queue wait: ";
+   queueWaitHistogram_.toString(ostr);
+   ostr << endl;
+
+   for (int page = 0; page < MAILBOX_HISTOGRAM_PAGE_COUNT; page++)
+   {
+      HandlerTimePage* handlerTimePage = handlerTimePages_[page];
+      if (handlerTimePage == NULL)
+      {
+         continue;
+      }//end if
+      for (int entry = 0; entry < MAILBOX_HISTOGRAM_PAGE_SIZE; entry++)
+      {
+         LatencyHistogram* histogram = handlerTimePage->histograms[entry];
+         if ((histogram != NULL) && (histogram->getCount() > 0))
+         {
+            ostr << "   handler time for message Id 0x" << hex << ((page * MAILBOX_HISTOGRAM_PAGE_SIZE) + entry)
+                 << dec << ": ";
+            histogram->toString(ostr);
+            ostr << endl;
+         }//end if
+      }//end for
+   }//end for
+}//end listLatencyStatistics
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return number of active, outstanding Timers
@@ -183,6 +311,53 @@ void MailboxBase::decrementActiveTimers()
 }//end decrementActiveTimers
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record a timer about to be scheduled on the reactor
+// Design:      The reactor only gives back the Timer Message of a timer when
+//              it expires, so the mailbox keeps them to cancel them itself.
+//              The timer is recorded before it is scheduled, since it may
+//              expire before schedule_timer returns.
+//-----------------------------------------------------------------------------
+void MailboxBase::addReactorTimer(TimerMessage* timerMessagePtr)
+{
+   reactorTimersMutex_.acquire();
+   reactorTimers_[timerMessagePtr] = ERROR;
+   reactorTimersMutex_.release();
+}//end addReactorTimer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the timer Id of a timer scheduled on the reactor
+// Design:      A timer that expired meanwhile is left out, since the reactor
+//              may already have given its Id to another timer
+//-----------------------------------------------------------------------------
+void MailboxBase::setReactorTimerId(TimerMessage* timerMessagePtr, long timerId)
+{
+   reactorTimersMutex_.acquire();
+   ReactorTimerMap::iterator timerIterator = reactorTimers_.find(timerMessagePtr);
+   if (timerIterator != reactorTimers_.end())
+   {
+      timerIterator->second = timerId;
+   }//end if
+   reactorTimersMutex_.release();
+}//end setReactorTimerId
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Forget a timer scheduled on the reactor
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::removeReactorTimer(TimerMessage* timerMessagePtr)
+{
+   reactorTimersMutex_.acquire();
+   reactorTimers_.erase(timerMessagePtr);
+   reactorTimersMutex_.release();
+}//end removeReactorTimer
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Acquire a handle to this mailbox. Here we do reference counting.
@@ -240,6 +415,108 @@ bool MailboxBase::rename(const MailboxAddress& newRemoteAddress)
 }//end rename
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the order in which the priority lanes are served
+// Design:      Default for the mailbox types without a local queue
+//-----------------------------------------------------------------------------
+int MailboxBase::setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights)
+{
+   // Do some dummy operation to prevent compiler warning for unused variable
+   MailboxQueuePolicyType tmpPolicy __attribute__ ((unused)) = policy;
+   const unsigned int* tmpWeights __attribute__ ((unused)) = laneWeights;
+
+   TRACELOG(WARNINGLOG, MSGMGRLOG, "Default base class setQueuePolicy() method called",0,0,0,0,0,0);
+   return ERROR;
+}//end setQueuePolicy
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of messages queued in a priority lane
+// Design:      Default for the mailbox types without a local queue
+//-----------------------------------------------------------------------------
+int MailboxBase::getQueueLaneDepth(unsigned int lane)
+{
+   // Do some dummy operation to prevent compiler warning for unused variable
+   unsigned int tmpLane __attribute__ ((unused)) = lane;
+   return 0;
+}//end getQueueLaneDepth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the state of the connection that posted messages are
+//              sent over
+// Design:      Default for the mailbox types that are always reachable
+//-----------------------------------------------------------------------------
+MailboxConnectionStateType MailboxBase::getConnectionState()
+{
+   return MAILBOX_CONNECTED;
+}//end getConnectionState
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of socket writes made to send the posted
+//              messages
+// Design:      Default for the mailbox types that do not write to a socket
+//-----------------------------------------------------------------------------
+unsigned int MailboxBase::getWriteCount()
+{
+   return 0;
+}//end getWriteCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Bound the mailbox queue with high and low watermarks
+// Design:      Default for the mailbox types without a local queue
+//-----------------------------------------------------------------------------
+int MailboxBase::setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+   unsigned int shedPriority)
+{
+   // Do some dummy operation to prevent compiler warning for unused variable
+   int tmpHigh __attribute__ ((unused)) = highWatermark;
+   int tmpLow __attribute__ ((unused)) = lowWatermark;
+   MailboxFlowControlPolicyType tmpPolicy __attribute__ ((unused)) = policy;
+   unsigned int tmpPriority __attribute__ ((unused)) = shedPriority;
+
+   TRACELOG(WARNINGLOG, MSGMGRLOG, "Default base class setFlowControl() method called",0,0,0,0,0,0);
+   return ERROR;
+}//end setFlowControl
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages, in order. Returns the number of
+//              messages posted.
+// Design:      Default implementation for the mailbox types that have no
+//              cheaper way to hand over several messages at once
+//-----------------------------------------------------------------------------
+int MailboxBase::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   int postedCount = 0;
+   while ((postedCount < messageCount) && (post(messages[postedCount], timeout) == OK))
+   {
+      postedCount++;
+   }//end while
+   return postedCount;
+}//end postBatch
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post a batch of messages that the flow control must not reject.
+//              Returns the number of messages posted.
+// Design:      Default for the mailbox types without flow control
+//-----------------------------------------------------------------------------
+int MailboxBase::postAdmitted(MessageBase** messages, int messageCount)
+{
+   return postBatch(messages, messageCount);
+}//end postAdmitted
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Called upon expiration of a Timer
@@ -255,12 +532,21 @@ int MailboxBase::handle_timeout (const ACE_Time_Value &tv, const void* argument)
    // Cast the argument back to a base TimerMessage*
    TimerMessage* timerMessage = (TimerMessage*) argument;
 
+   // A timer that does not restart is no longer outstanding; its Timer Message
+   // now belongs to the mailbox queue
+   if (!timerMessage->isReusable())
+   {
+      removeReactorTimer(timerMessage);
+   }//end if
+
    // Set the time that the Timer 'actually' expired inside the Timer Message
    // This can be inspected by the applications if need be
    timerMessage->setExpirationTime(tv);
 
-   // Put the Timer Message in our Mailbox queue
-   if (post(timerMessage) == ERROR)
+   // Put the Timer Message in our Mailbox queue (timer expirations are never
+   // rejected by the flow control)
+   MessageBase* messagePtr = timerMessage;
+   if (postAdmitted(&messagePtr, 1) < 1)
    {
       TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing timer expiration message to mailbox",0,0,0,0,0,0);
    }//end if
@@ -281,6 +567,29 @@ ACE_Reactor* MailboxBase::getReactor()
 }//end getReactor
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the timer wheel that the mailbox timers are scheduled on
+// Design:
+//-----------------------------------------------------------------------------
+TimerWheel* MailboxBase::getTimerWheel()
+{
+   return timerWheel_;
+}//end getTimerWheel
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Schedule the mailbox timers on a timer wheel instead of the
+//              reactor
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxBase::setTimerWheel(TimerWheel* timerWheel)
+{
+   timerWheel_ = timerWheel;
+}//end setTimerWheel
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return the String'ized form of the class contents 
@@ -309,6 +618,35 @@ unsigned int MailboxBase::isActive()
 }//end isActive
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Cancel the timers still outstanding on the reactor
+// Design:      The Timer Messages of the timers that were still outstanding are
+//              disposed of as MailboxOwnerHandle::cancelTimer does: released to
+//              the OPM if pooled by it, left to the application if reusable,
+//              and deleted otherwise (see MessageBase::deleteMessage). A timer
+//              the reactor no longer has has expired, and its Timer Message is
+//              in the mailbox queue.
+//-----------------------------------------------------------------------------
+void MailboxBase::cancelReactorTimers()
+{
+   ReactorTimerMap outstandingTimers;
+   reactorTimersMutex_.acquire();
+   outstandingTimers.swap(reactorTimers_);
+   reactorTimersMutex_.release();
+
+   for (ReactorTimerMap::iterator timerIterator = outstandingTimers.begin();
+        timerIterator != outstandingTimers.end(); timerIterator++)
+   {
+      if ((timerIterator->second != ERROR) && (selectReactor_->cancel_timer(timerIterator->second) == 1))
+      {
+         decrementActiveTimers();
+         timerIterator->first->deleteMessage();
+      }//end if
+   }//end for
+}//end cancelReactorTimers
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Sets the activated state flag
@@ -346,6 +684,61 @@ void MailboxBase::incrementReceivedCount()
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the handler time histogram of a message Id, creating it
+//              if asked to
+// Design:      Pages and histograms are published with a compare and swap, so
+//              the processing threads never take a lock to record; a thread
+//              that loses the race deletes its copy. Neither is freed before
+//              the mailbox is destroyed.
+//-----------------------------------------------------------------------------
+LatencyHistogram* MailboxBase::getHandlerTimeHistogram(unsigned short messageId, bool isCreated)
+{
+   unsigned int page = messageId / MAILBOX_HISTOGRAM_PAGE_SIZE;
+   unsigned int entry = messageId % MAILBOX_HISTOGRAM_PAGE_SIZE;
+
+   HandlerTimePage* handlerTimePage = handlerTimePages_[page];
+   if (handlerTimePage == NULL)
+   {
+      if (!isCreated)
+      {
+         return NULL;
+      }//end if
+      HandlerTimePage* newPage = new HandlerTimePage();
+      for (int index = 0; index < MAILBOX_HISTOGRAM_PAGE_SIZE; index++)
+      {
+         newPage->histograms[index] = NULL;
+      }//end for
+      if (__sync_bool_compare_and_swap(&handlerTimePages_[page], (HandlerTimePage*)NULL, newPage))
+      {
+         handlerTimePage = newPage;
+      }//end if
+      else
+      {
+         delete newPage;
+         handlerTimePage = handlerTimePages_[page];
+      }//end else
+   }//end if
+
+   LatencyHistogram* histogram = handlerTimePage->histograms[entry];
+   if ((histogram == NULL) && isCreated)
+   {
+      LatencyHistogram* newHistogram = new LatencyHistogram();
+      if (__sync_bool_compare_and_swap(&handlerTimePage->histograms[entry], (LatencyHistogram*)NULL, newHistogram))
+      {
+         histogram = newHistogram;
+      }//end if
+      else
+      {
+         delete newHistogram;
+         histogram = handlerTimePage->histograms[entry];
+      }//end else
+   }//end if
+   return histogram;
+}//end getHandlerTimeHistogram
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
@@ -21,6 +21,8 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <map>
+#include <sstream>
 #include <string>
 #include <ace/Atomic_Op.h>
 #include <ace/Event_Handler.h>
@@ -33,6 +35,8 @@ using namespace std;
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
+#include "LatencyHistogram.h"
+#include "LocalMessageQueue.h"
 #include "MailboxAddress.h"
 #include "MessageBase.h"
 
@@ -40,6 +44,19 @@ using namespace std;
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+/** Number of message Ids covered by each page of handler time histograms */
+#define MAILBOX_HISTOGRAM_PAGE_SIZE 256
+
+/** Number of pages of handler time histograms (covering every message Id) */
+#define MAILBOX_HISTOGRAM_PAGE_COUNT 256
+
+/** Connection state of a mailbox, as seen by its senders (see getConnectionState) */
+typedef enum { MAILBOX_CONNECTED = 0,
+               MAILBOX_CONNECTING = 1,
+               MAILBOX_DISCONNECTED = 2,
+               MAILBOX_CLOSED = 3
+             } MailboxConnectionStateType;
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -57,10 +74,17 @@ using namespace std;
  * MailboxBase allows applications to activate and deactivate mailboxes, 
  * post messages, and retrieve messages in a blocked or non-blocked fashion.
  * <p>
+ * Each mailbox also keeps the latency statistics recorded by its
+ * MailboxProcessor: a histogram of how long messages wait in the queue, and a
+ * histogram per message Id of how long their handlers take. The handler time
+ * histograms are allocated the first time a message Id is handled.
+ * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
 class MailboxOwnerHandle;
+class TimerMessage;
+class TimerWheel;
 
 class MailboxBase : public ACE_Event_Handler
 {
@@ -97,6 +121,23 @@ class MailboxBase : public ACE_Event_Handler
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero) = 0;
 
+      /**
+       * Post a batch of messages to this mailbox, in order.
+       * The default implementation posts the messages one at a time; subclasses
+       * override it to hand the whole batch over in one operation.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
+      /**
+       * Post a batch of messages that the flow control must not reject, such as
+       * timer expirations. The default implementation is postBatch.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postAdmitted(MessageBase** messages, int messageCount);
+
       /**
        * Will block until an message is available.
        * May return NULL if no message available (if mailbox deactivated).
@@ -117,6 +158,15 @@ class MailboxBase : public ACE_Event_Handler
        */
       virtual MessageBase* getMessageNonBlocking() = 0;
 
+      /**
+       * Will block until a message is available, and then retrieve up to
+       * maxMessages of the messages queued in one operation.
+       * @param messages Array that receives the messages in dequeue order
+       * @param maxMessages Size of the messages array
+       * @return Number of messages retrieved; 0 if none (if mailbox deactivated).
+       */
+      virtual int getMessages(MessageBase** messages, int maxMessages, unsigned short timeoutValue = 0) = 0;
+
       /** 
        * Acquire a handle to this mailbox. Here we do reference counting.
        * We implement a reference count mechanism to keep track of mailbox objects. 
@@ -155,6 +205,45 @@ class MailboxBase : public ACE_Event_Handler
       /** Rename the Mailbox address */
       virtual bool rename(const MailboxAddress& newRemoteAddress);
 
+      /**
+       * Set the order in which the priority lanes of the mailbox queue are served.
+       * Only mailboxes with a local queue support this (not the proxies).
+       * @param laneWeights Messages served from each lane per weighted fair round
+       *    (LOCAL_MESSAGE_QUEUE_LANES entries); NULL keeps the current weights
+       * @returns ERROR if the mailbox has no local queue; otherwise OK
+       */
+      virtual int setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights = NULL);
+
+      /** Return the number of messages queued in a priority lane (0 for proxies) */
+      virtual int getQueueLaneDepth(unsigned int lane);
+
+      /**
+       * Return the state of the connection that posted messages are sent over.
+       * Only the distributed mailbox proxies have one that can be down; posts
+       * made while it is connecting or disconnected are buffered by the proxy.
+       */
+      virtual MailboxConnectionStateType getConnectionState();
+
+      /**
+       * Return the number of socket writes made to send the posted messages.
+       * Only the distributed mailbox proxies write to a socket (0 otherwise).
+       */
+      virtual unsigned int getWriteCount();
+
+      /**
+       * Bound the mailbox queue with high and low watermarks and set what to do
+       * with the posts made while it is overloaded. Only mailboxes with a local
+       * queue support this (not the proxies).
+       * @param highWatermark Queue depth at which the policy applies; 0 makes
+       *    the queue unbounded
+       * @param shedPriority With MAILBOX_FLOW_SHED_LOW_PRIORITY, the posts of
+       *    messages with a priority below this one are rejected
+       * @returns ERROR if the mailbox has no local queue or the watermarks are
+       *    not valid; otherwise OK
+       */
+      virtual int setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+         unsigned int shedPriority = 1);
+
       /**
        * Overriden ACE_Event_Handler method.
        * <p>
@@ -172,12 +261,54 @@ class MailboxBase : public ACE_Event_Handler
       /** Decrement Active Timer count */
       void decrementActiveTimers();
 
+      /**
+       * Record a timer about to be scheduled on the reactor, so that it is canceled
+       * along with the mailbox. Its timer Id is set once it is scheduled.
+       */
+      void addReactorTimer(TimerMessage* timerMessagePtr);
+
+      /** Set the timer Id of a timer scheduled on the reactor, unless it has already expired */
+      void setReactorTimerId(TimerMessage* timerMessagePtr, long timerId);
+
+      /** Forget a timer scheduled on the reactor once it is canceled */
+      void removeReactorTimer(TimerMessage* timerMessagePtr);
+
       /** Return pointer to the select reactor used for event dispatch */
       ACE_Reactor* getReactor();
 
+      /** Return the timer wheel that the mailbox timers are scheduled on (NULL for the reactor) */
+      TimerWheel* getTimerWheel();
+
+      /** Schedule the mailbox timers on a timer wheel instead of the reactor */
+      void setTimerWheel(TimerWheel* timerWheel);
+
       /** Indicate whether this mailbox is a Proxy side mailbox for posting messages */
       bool isProxy();
 
+      /** Record how long a message waited in the mailbox queue, in microseconds */
+      void recordQueueWait(unsigned long long usec);
+
+      /** Record how long the handler of a message took, in microseconds */
+      void recordHandlerTime(unsigned short messageId, unsigned long long usec);
+
+      /** Copy the histogram of the time messages waited in the mailbox queue */
+      void getQueueWaitSnapshot(LatencyHistogramSnapshot& snapshot);
+
+      /**
+       * Copy the histogram of the time taken by the handler of a message Id
+       * @returns ERROR if no message with that Id has been handled; otherwise OK
+       */
+      int getHandlerTimeSnapshot(unsigned short messageId, LatencyHistogramSnapshot& snapshot);
+
+      /** Discard the latency statistics recorded so far */
+      void resetLatencyStatistics();
+
+      /**
+       * Append a summary of the latency statistics: the queue wait and the
+       * handler time of each message Id handled
+       */
+      void listLatencyStatistics(ostringstream& ostr);
+
       /**
        * Indicates whether the Mailbox has been activated or not
        * @returns TRUE or FALSE
@@ -198,6 +329,13 @@ class MailboxBase : public ACE_Event_Handler
       /** Virtual Destructor. Protected since this is a reference counted object. */
       virtual ~MailboxBase();
 
+      /**
+       * Cancel the timers still outstanding on the (shared) reactor and dispose of
+       * their Timer Messages as for a canceled timer. Called by the destructors of
+       * the mailboxes that own a reactor.
+       */
+      void cancelReactorTimers();
+
       /** Sets the activate state flag */
       void setActive(unsigned int active);
 
@@ -213,7 +351,7 @@ class MailboxBase : public ACE_Event_Handler
       /** Flag to indicate whether this mailbox is a Proxy side mailbox for posting messages */
       bool isProxy_;
 
-      /** ACE_Select_Reactor used for event dispatch. This only gets instantiated by non-proxy mailboxes */
+      /** Reactor (of the ReactorPool) used for event dispatch. This is only assigned to non-proxy mailboxes */
       ACE_Reactor* selectReactor_;
 
       /** Flag to indicate that the Mailbox is being shutdown. Set in the Mailbox's destructor for loops to see */
@@ -221,6 +359,12 @@ class MailboxBase : public ACE_Event_Handler
 
    private:
 
+      /** Handler time histograms of MAILBOX_HISTOGRAM_PAGE_SIZE message Ids */
+      typedef struct
+      {
+         LatencyHistogram* volatile histograms[MAILBOX_HISTOGRAM_PAGE_SIZE];
+      } HandlerTimePage;
+
       /**
        * Copy Constructor declared private so that default automatic
        * methods aren't used.
@@ -233,9 +377,26 @@ class MailboxBase : public ACE_Event_Handler
        */
       MailboxBase& operator= (const MailboxBase& rhs);
 
+      /**
+       * Return the handler time histogram of a message Id
+       * @param isCreated Create the histogram if the message Id has none yet
+       * @returns NULL if the message Id has no histogram (and isCreated is false)
+       */
+      LatencyHistogram* getHandlerTimeHistogram(unsigned short messageId, bool isCreated);
+
       /** Number of Active outstanding Timers */
       ACE_Atomic_Op <ACE_Thread_Mutex, unsigned int> activeTimers_;
 
+      /** Timer wheel that the mailbox timers are scheduled on (NULL for the reactor) */
+      TimerWheel* timerWheel_;
+
+      /** Timer Ids of the timers outstanding on the reactor, by Timer Message */
+      typedef map<TimerMessage*, long> ReactorTimerMap;
+      ReactorTimerMap reactorTimers_;
+
+      /** Lock on reactorTimers_ (timers expire on the reactor thread) */
+      ACE_Thread_Mutex reactorTimersMutex_;
+
       /** Pointer to the MailboxOwnerHandle that last activated the Mailbox. This
           will be used when we do final release (and destruction) of this Mailbox */
       MailboxOwnerHandle* ownerHandleWhoActivatedMe_;
@@ -253,6 +414,13 @@ class MailboxBase : public ACE_Event_Handler
 
       /** Counter for the number of Sent Messages */
       ACE_Atomic_Op <ACE_Thread_Mutex, unsigned int> sentCount_;
+
+      /** Time messages waited in the mailbox queue */
+      LatencyHistogram queueWaitHistogram_;
+
+      /** Pages of handler time histograms, indexed by the high byte of the
+          message Id (NULL until a message Id of the page is handled) */
+      HandlerTimePage* volatile handlerTimePages_[MAILBOX_HISTOGRAM_PAGE_COUNT];
 };
 
 #endif
@@ -85,6 +85,18 @@ int MailboxHandle::post(MessageBase* messagePtr, const ACE_Time_Value* timeout)
 }//end post
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Calls the postBatch() method on the actual mailbox. Returns the
+//              number of messages posted.
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxHandle::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   return (mailboxPtr_->postBatch(messages, messageCount, timeout));
+}//end postBatch
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Retrieve the mailbox debug flag
@@ -140,6 +152,29 @@ unsigned int MailboxHandle::getSentCount()
 }//end getSentCount
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the state of the connection to the mailbox
+// Design:
+//-----------------------------------------------------------------------------
+MailboxConnectionStateType MailboxHandle::getConnectionState()
+{
+   return mailboxPtr_->getConnectionState();
+}//end getConnectionState
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of socket writes made to send the messages
+//              posted to the mailbox
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int MailboxHandle::getWriteCount()
+{
+   return mailboxPtr_->getWriteCount();
+}//end getWriteCount
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return the String'ized form of the class contents 
@@ -69,6 +69,15 @@ class MailboxHandle
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
 
+      /**
+       * Post a batch of messages to this mailbox, in order. Local mailboxes enqueue
+       * the whole batch at once, and remote proxies send it in as few transmissions
+       * as possible.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
       /** Returns the Debug flag value for this mailbox. */
       virtual int getDebugValue();
 
@@ -84,6 +93,19 @@ class MailboxHandle
       /** Return the sent message counter value */
       virtual unsigned int getSentCount();
 
+      /**
+       * Return the state of the connection to the mailbox. A proxy returned by
+       * MailboxLookupService::find may still be connecting; messages posted to
+       * it meanwhile are buffered until the connection is up.
+       */
+      virtual MailboxConnectionStateType getConnectionState();
+
+      /**
+       * Return the number of socket writes made to send the messages posted to
+       * the mailbox (non-zero only for distributed mailbox proxies)
+       */
+      virtual unsigned int getWriteCount();
+
       /** 
        * String'ized debugging method
        * @return string representation of the contents of this object
@@ -617,7 +617,9 @@ void MailboxLookupService::deregisterMailbox(MailboxOwnerHandle* mailboxOwnerHan
 //              method which will return a sequence of matching addresses.
 //              Then, if the application needs to communicate with those mailboxes,
 //              it will perform a 'find' which will create the proxy mailbox
-//              connection to that remote mailbox.
+//              connection to that remote mailbox. A distributed proxy connects
+//              without blocking, so its handle is returned while it may still
+//              be connecting (the posts made meanwhile are buffered).
 //-----------------------------------------------------------------------------
 MailboxHandle* MailboxLookupService::find(const MailboxAddress& address)
 {
@@ -730,6 +732,7 @@ MailboxHandle* MailboxLookupService::find(const MailboxAddress& address)
          }//end else
 
          // Perform activate to initiate the connection and register this proxy with the lookup service
+         // (a distributed proxy only starts its connect here, which the proxy engine completes)
          if (proxyOwnerHandle->activate() == ERROR)
          {
             TRACELOG(WARNINGLOG, MSGMGRLOG, "Error activating proxy mailbox, application must retry the find operation",0,0,0,0,0,0);
@@ -833,10 +836,11 @@ void MailboxLookupService::listAllMailboxAddresses()
    LocalMailboxRegistry::iterator mailboxIterator = localMailboxRegistry_.begin();
    LocalMailboxRegistry::iterator endIterator = localMailboxRegistry_.end();
 
-   // Loop through the map
+   // Loop through the map, listing the latency statistics of each mailbox with its address
    while (mailboxIterator != endIterator)
    {
       ostr << "|" << ((MailboxAddress)mailboxIterator->first).toString() << "|" << endl;
+      (mailboxIterator->second)->listLatencyStatistics(ostr);
       mailboxIterator++;
    }//end while 
    localRegistryMutex_.release();
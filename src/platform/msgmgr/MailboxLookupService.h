@@ -81,7 +81,8 @@ using namespace std;
  * - If a post operation using a mailbox handle fails, then the handle should be
  *   destroyed (should be explicitly deleted off the heap). Note that if a post
  *   operation returns a failure, the MsgMgr framework has ALREADY attempted to
- *   re-establish communication to the remote mailbox and retried the message again.
+ *   re-establish communication to the remote mailbox (for distributed proxies, the
+ *   reconnect carries on in the background, and the posts made meanwhile are buffered).
  * - After the handle is deleted, the application can later 're-invoke'
  *   MailboxLookupService.find(); a reconnect will be attempted, and a newly
  *   allocated handle will be returned.
@@ -154,6 +155,9 @@ using namespace std;
  *   MailboxLookupService::find will create a proxy Mailbox to the remote address,
  *   activate it, and return a handle to it (handle allocated on heap).
  *   If there is a problem in creating the Proxy connection, find() may return NULL.
+ *   A distributed proxy connects without blocking the caller, so find() returns its
+ *   handle at once, possibly while it is still connecting: the messages posted to it
+ *   are buffered until the connection is up (see MailboxHandle::getConnectionState).
  * - For non-existing/non-registered local addresses (LocalMailbox),
  *   MailboxLookupService:: will return an error (consider how this can happen
  *   since all LocalMailboxes should be within the same process).
@@ -317,7 +321,8 @@ class MailboxLookupService
          MailboxAddress& matchCriteria, MailboxOwnerHandle* mailboxToNotify);
 
       /**
-       * Display a list of all the registered mailbox addresses
+       * Display a list of all the registered mailbox addresses, along with the
+       * queue wait and handler time statistics of the local mailboxes.
        * This method displays its output in trace logs.
        */
       static void listAllMailboxAddresses();
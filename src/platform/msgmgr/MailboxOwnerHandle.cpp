@@ -29,6 +29,7 @@
 #include "MailboxHandle.h"
 #include "MailboxAddress.h"
 #include "MailboxProcessor.h"
+#include "TimerWheel.h"
 
 #include "platform/logger/Logger.h"
 
@@ -94,6 +95,18 @@ int MailboxOwnerHandle::post(MessageBase* messagePtr, const ACE_Time_Value* time
 }//end post
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Calls the postBatch() method on the actual mailbox. Returns the
+//              number of messages posted.
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout)
+{
+   return (mailboxPtr_->postBatch(messages, messageCount, timeout));
+}//end postBatch
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Schedule a Timer Message to expire at the specified timeout.
@@ -101,6 +114,12 @@ int MailboxOwnerHandle::post(MessageBase* messagePtr, const ACE_Time_Value* time
 //-----------------------------------------------------------------------------
 long MailboxOwnerHandle::scheduleTimer(TimerMessage* timerMessagePtr)
 {
+   TimerWheel* timerWheel = mailboxPtr_->getTimerWheel();
+   if (timerWheel != NULL)
+   {
+      return timerWheel->schedule(mailboxPtr_, timerMessagePtr);
+   }//end if
+
    const void* argument = (const void*) timerMessagePtr;
    ACE_Reactor* reactor = mailboxPtr_->getReactor();
    if (reactor == NULL)
@@ -113,21 +132,60 @@ long MailboxOwnerHandle::scheduleTimer(TimerMessage* timerMessagePtr)
       TRACELOG(ERRORLOG, MSGMGRLOG, "Select reactor is not running",0,0,0,0,0,0);
       return ERROR;
    }//end else if
+   mailboxPtr_->addReactorTimer(timerMessagePtr);
    long timerId = reactor->schedule_timer ( mailboxPtr_,                 /* Event Handler */
                          argument,                            /* Sent to handle_timeout() */
                          timerMessagePtr->getTimeout(),                        /* Timeout */
                          timerMessagePtr->getRestartInterval());    /* Restart after time */
    
-   // Increment the active timer count
+   // Increment the active timer count, and keep the timer for the mailbox to cancel
    if (timerId != ERROR)
+   {
       mailboxPtr_->incrementActiveTimers();
+      mailboxPtr_->setReactorTimerId(timerMessagePtr, timerId);
+   }//end if
    else
+   {
+      mailboxPtr_->removeReactorTimer(timerMessagePtr);
       TRACELOG(ERRORLOG, MSGMGRLOG, "Error attempting to schedule timer with reactor",0,0,0,0,0,0);
+   }//end else
    // Return the timer id
    return timerId;
 }//end scheduleTimer
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Schedule the timers of this mailbox on a shared TimerWheel
+//              instead of the mailbox reactor
+// Design:      Timers already scheduled on the reactor (or another wheel)
+//              could no longer be canceled, so none may be outstanding
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::useTimerWheel(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange)
+{
+   if (mailboxPtr_->isProxy())
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Attempt to use a timer wheel with a Proxy Mailbox",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
+   else if (mailboxPtr_->getActiveTimers() != 0)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Cannot switch to a timer wheel with %d timers outstanding",
+         mailboxPtr_->getActiveTimers(),0,0,0,0,0);
+      return ERROR;
+   }//end else if
+
+   TimerWheel* timerWheel = TimerWheel::getInstance(resolution, maxRange);
+   if (timerWheel == NULL)
+   {
+      return ERROR;
+   }//end if
+
+   mailboxPtr_->setTimerWheel(timerWheel);
+   return OK;
+}//end useTimerWheel
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Cancel an outstanding, active Timer Message
@@ -135,6 +193,13 @@ long MailboxOwnerHandle::scheduleTimer(TimerMessage* timerMessagePtr)
 //-----------------------------------------------------------------------------
 int MailboxOwnerHandle::cancelTimer(long timerId, TimerMessage* timerMessagePtr)
 {
+   // The wheel disposes of the Timer Message as described below itself
+   TimerWheel* timerWheel = mailboxPtr_->getTimerWheel();
+   if (timerWheel != NULL)
+   {
+      return timerWheel->cancel(timerId, timerMessagePtr);
+   }//end if
+
    const void* tmpPtr = (const void*) timerMessagePtr;
    // By providing the pointer to the attached Timer Message, the Timer Message
    // itself will be deleted by the Reactor Framework.
@@ -145,6 +210,8 @@ int MailboxOwnerHandle::cancelTimer(long timerId, TimerMessage* timerMessagePtr)
       return ERROR;
    }//end if 
  
+   mailboxPtr_->removeReactorTimer(timerMessagePtr);
+
    // If the TimerMessage is OPM Poolable and Owned by the OPM, or if the
    // TimerMessage is reusable, then we don't want to delete it. Just cancel it
    // with the reactor.
@@ -198,6 +265,12 @@ int MailboxOwnerHandle::resetTimerInterval (long timerId,
       timerMessagePtr->setNoLongerReusable();
    }//end if
 
+   TimerWheel* timerWheel = mailboxPtr_->getTimerWheel();
+   if (timerWheel != NULL)
+   {
+      return timerWheel->resetInterval(timerId, timerMessagePtr, newInterval);
+   }//end if
+
    ACE_Reactor* reactor = mailboxPtr_->getReactor();
    if (reactor == NULL)
    {
@@ -264,6 +337,23 @@ MessageBase* MailboxOwnerHandle::getMessageNonBlocking()
 }//end getMessageNonBlocking
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Retrieves up to maxMessages messages from the mailbox queue.
+//              This is a blocking call until the first message is available.
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::getMessages(MessageBase** messages, int maxMessages, unsigned short timeout)
+{
+   int messageCount = 0;
+
+   getMessageMutex_.acquire();
+   messageCount = mailboxPtr_->getMessages(messages, maxMessages, timeout);
+   getMessageMutex_.release();
+   return messageCount;
+}//end getMessages
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Retrieve the mailbox debug flag
@@ -330,6 +420,96 @@ bool MailboxOwnerHandle::rename(const MailboxAddress& newRemoteAddress)
 }//end rename
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the order in which the priority lanes are served
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights)
+{
+   return mailboxPtr_->setQueuePolicy(policy, laneWeights);
+}//end setQueuePolicy
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of messages queued in a priority lane
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::getQueueLaneDepth(unsigned int lane)
+{
+   return mailboxPtr_->getQueueLaneDepth(lane);
+}//end getQueueLaneDepth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Bound the mailbox queue with high and low watermarks
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+   unsigned int shedPriority)
+{
+   return mailboxPtr_->setFlowControl(highWatermark, lowWatermark, policy, shedPriority);
+}//end setFlowControl
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record how long a message waited in the mailbox queue
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxOwnerHandle::recordQueueWait(unsigned long long usec)
+{
+   mailboxPtr_->recordQueueWait(usec);
+}//end recordQueueWait
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Record how long the handler of a message took
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxOwnerHandle::recordHandlerTime(unsigned short messageId, unsigned long long usec)
+{
+   mailboxPtr_->recordHandlerTime(messageId, usec);
+}//end recordHandlerTime
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Copy the histogram of the time messages waited in the queue
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxOwnerHandle::getQueueWaitSnapshot(LatencyHistogramSnapshot& snapshot)
+{
+   mailboxPtr_->getQueueWaitSnapshot(snapshot);
+}//end getQueueWaitSnapshot
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Copy the histogram of the time taken by the handler of a
+//              message Id
+// Design:
+//-----------------------------------------------------------------------------
+int MailboxOwnerHandle::getHandlerTimeSnapshot(unsigned short messageId, LatencyHistogramSnapshot& snapshot)
+{
+   return mailboxPtr_->getHandlerTimeSnapshot(messageId, snapshot);
+}//end getHandlerTimeSnapshot
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Discard the latency statistics recorded so far
+// Design:
+//-----------------------------------------------------------------------------
+void MailboxOwnerHandle::resetLatencyStatistics()
+{
+   mailboxPtr_->resetLatencyStatistics();
+}//end resetLatencyStatistics
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return a regular Mailbox Handle to this same encapsulated Mailbox
@@ -77,6 +77,15 @@ class MailboxOwnerHandle
        * @returns ERROR for an error; otherwise OK
        */
       virtual int post(MessageBase* messagePtr, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
+
+      /**
+       * Post a batch of messages to this mailbox, in order. Local mailboxes enqueue
+       * the whole batch at once, and remote proxies send it in as few transmissions
+       * as possible.
+       * @returns Number of messages posted. The messages from that index on
+       *    were not posted and still belong to the caller.
+       */
+      virtual int postBatch(MessageBase** messages, int messageCount, const ACE_Time_Value* timeout = &ACE_Time_Value::zero);
                                                                                                            
       /** 
        * Schedule a Timer Message to expire at the specified timeout.
@@ -85,6 +94,17 @@ class MailboxOwnerHandle
        */
       long scheduleTimer(TimerMessage* timerMessagePtr);
 
+      /**
+       * Schedule the timers of this mailbox on a shared TimerWheel instead of the
+       * mailbox reactor, for mailboxes that keep very many timers outstanding.
+       * Must be called while no timers are outstanding.
+       * @param resolution Tick of the wheel; timers expire up to one tick late
+       * @param maxRange Longest timeout that can be scheduled
+       * @returns OK on success; ERROR if the mailbox is a proxy, has timers
+       *    outstanding, or the resolution or range is not valid
+       */
+      int useTimerWheel(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange);
+
       /**
        * Cancel an outstanding, active Timer Message.
        * NOTE that the TimerMessage is provided here and is deleted when the timer
@@ -136,6 +156,16 @@ class MailboxOwnerHandle
        */
       virtual MessageBase* getMessageNonBlocking();
 
+      /**
+       * Will block until a message is available, and then retrieve up to
+       * maxMessages of the messages queued in one operation (the
+       * MailboxProcessor uses this to drain a backlog in batches).
+       * @param messages Array that receives the messages in dequeue order
+       * @param maxMessages Size of the messages array
+       * @return Number of messages retrieved; 0 if none (if mailbox deactivated).
+       */
+      virtual int getMessages(MessageBase** messages, int maxMessages, unsigned short timeout = 0);
+
       /** Returns the Debug flag value for this mailbox. */
       virtual int getDebugValue();
 
@@ -154,6 +184,46 @@ class MailboxOwnerHandle
       /** Rename the Mailbox address */
       bool rename(const MailboxAddress& newRemoteAddress);
 
+      /**
+       * Set the order in which the priority lanes of the mailbox queue are
+       * served: strict priority (the default) or weighted fair.
+       * @param laneWeights Messages served from each lane per weighted fair round
+       *    (LOCAL_MESSAGE_QUEUE_LANES entries); NULL keeps the current weights
+       * @returns ERROR if the mailbox is a proxy; otherwise OK
+       */
+      int setQueuePolicy(MailboxQueuePolicyType policy, const unsigned int* laneWeights = NULL);
+
+      /** Return the number of messages queued in a priority lane of the mailbox */
+      int getQueueLaneDepth(unsigned int lane);
+
+      /**
+       * Bound the mailbox queue with high and low watermarks and set what to do
+       * with the posts made while it is overloaded (see LocalMailbox). For a
+       * distributed mailbox, the connections from the remote senders are also
+       * not read while the queue is overloaded.
+       * @returns ERROR for a proxy or invalid watermarks; otherwise OK
+       */
+      int setFlowControl(int highWatermark, int lowWatermark, MailboxFlowControlPolicyType policy,
+         unsigned int shedPriority = 1);
+
+      /** Record how long a message waited in the mailbox queue, in microseconds */
+      void recordQueueWait(unsigned long long usec);
+
+      /** Record how long the handler of a message took, in microseconds */
+      void recordHandlerTime(unsigned short messageId, unsigned long long usec);
+
+      /** Copy the histogram of the time messages waited in the mailbox queue */
+      void getQueueWaitSnapshot(LatencyHistogramSnapshot& snapshot);
+
+      /**
+       * Copy the histogram of the time taken by the handler of a message Id
+       * @returns ERROR if no message with that Id has been handled; otherwise OK
+       */
+      int getHandlerTimeSnapshot(unsigned short messageId, LatencyHistogramSnapshot& snapshot);
+
+      /** Discard the latency statistics recorded so far for the mailbox */
+      void resetLatencyStatistics();
+
       /**
        * Return a regular Mailbox Handle to this same encapsulated Mailbox.
        * NOTE: This method call creates a Mailbox Handle on the heap. It then
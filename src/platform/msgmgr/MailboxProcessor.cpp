@@ -24,6 +24,7 @@
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
+#include "LatencyHistogram.h"
 #include "MailboxProcessor.h"
 #include "MailboxOwnerHandle.h"
 #include "MessageHandlerList.h"
@@ -54,7 +55,12 @@ MailboxProcessor::MailboxProcessor* MailboxProcessor::mailboxProcessor_ = NULL;
 MailboxProcessor::MailboxProcessor(MessageHandlerList* handlerList, 
                                    MailboxOwnerHandle& mailboxOwnerHandle)
                                    : handlerList_(handlerList),
-                                     mailboxOwnerHandle_(mailboxOwnerHandle)
+                                     mailboxOwnerHandle_(mailboxOwnerHandle),
+                                     batchSize_(MAILBOX_PROCESSOR_BATCH_SIZE),
+                                     keyFunction_(NULL),
+                                     shards_(NULL),
+                                     numberShards_(0),
+                                     nextShard_(0)
 {
    // Populate the static instance member
    mailboxProcessor_ = this;
@@ -92,6 +98,14 @@ void MailboxProcessor::processMailbox(int numberThreads)
       return;
    }//end if
 
+   // Split the batch among the threads, so that one thread does not take the whole
+   // backlog while the others sit idle
+   batchSize_ = MAILBOX_PROCESSOR_BATCH_SIZE / numberThreads;
+   if (batchSize_ < 1)
+   {
+      batchSize_ = 1;
+   }//end if
+
    // If the number of requested threads is the default (1), then we simply call
    // processMailboxInternal method from this thread context (which blocks).
    if (numberThreads == 1)
@@ -118,6 +132,84 @@ void MailboxProcessor::processMailbox(int numberThreads)
 }//end processMailbox
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Reads messages from the mailbox message queue and hands each one
+//              to the processing thread that owns its key. Returns when the
+//              mailbox has been deactivated and the threads have handled the
+//              messages already handed to them.
+// Design:      The calling thread does the distribution. Each key group starts
+//              out owned by thread (group % numberThreads).
+//-----------------------------------------------------------------------------
+void MailboxProcessor::processMailboxSharded(int numberThreads, MessageKeyFunction keyFunction)
+{
+   // Check the number of Threads passed
+   if (numberThreads <= 0)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Illegal number of threads (%d) passed to processMailboxSharded",
+         numberThreads,0,0,0,0,0);
+      return;
+   }//end if
+
+   keyFunction_ = keyFunction;
+   numberShards_ = numberThreads;
+   nextShard_ = 0;
+   shards_ = new MailboxShard*[numberShards_];
+   for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+   {
+      shards_[shardIndex] = new MailboxShard();
+      shards_[shardIndex]->pendingCount = 0;
+      shards_[shardIndex]->stagedCount = 0;
+      shards_[shardIndex]->queue.activate();
+   }//end for
+   for (int group = 0; group < MAILBOX_PROCESSOR_KEY_GROUPS; group++)
+   {
+      groupOwner_[group] = group % numberShards_;
+      groupPending_[group] = 0;
+   }//end for
+
+   // Spawn the processing threads. They are not restarted, since they return
+   // once the mailbox is deactivated
+   ACE_thread_t* threadIds = ThreadManager::createThreadPool( numberShards_,
+      (ACE_THR_FUNC)MailboxProcessor::invokeShardStatic, (void*)this, "MailboxProcessorShard", false);
+
+   if (threadIds != 0)
+   {
+      MessageBase* messages[MAILBOX_PROCESSOR_BATCH_SIZE];
+
+      int messageCount = mailboxOwnerHandle_.getMessages(messages, MAILBOX_PROCESSOR_BATCH_SIZE);
+      while ( messageCount > 0 )
+      {
+         distributeMessages(messages, messageCount);
+         messageCount = mailboxOwnerHandle_.getMessages(messages, MAILBOX_PROCESSOR_BATCH_SIZE);
+      }//end while
+
+      // Let the threads finish the messages they were handed, and wait for them
+      for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+      {
+         shards_[shardIndex]->queue.deactivate();
+      }//end for
+      for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+      {
+         ACE_Thread_Manager::instance()->join(threadIds[shardIndex]);
+      }//end for
+      delete [] threadIds;
+   }//end if
+   else
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create the sharded mailbox processing threads",0,0,0,0,0,0);
+   }//end else
+
+   for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+   {
+      delete shards_[shardIndex];
+   }//end for
+   delete [] shards_;
+   shards_ = NULL;
+   numberShards_ = 0;
+}//end processMailboxSharded
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
@@ -130,25 +222,196 @@ void MailboxProcessor::processMailbox(int numberThreads)
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Loop on the Mailbox message queue processing messages
-// Design:
+// Design:      Each getMessages call blocks only until the first message is
+//              available, so an idle mailbox dispatches a single message as
+//              soon as it arrives while a backlog is drained a batch at a time
 //-----------------------------------------------------------------------------
 void MailboxProcessor::processMailboxInternal()
 {
-   MessageBase* messagePtr = mailboxOwnerHandle_.getMessage();
-   while ( messagePtr != NULL )
+   MessageBase* messages[MAILBOX_PROCESSOR_BATCH_SIZE];
+
+   int messageCount = mailboxOwnerHandle_.getMessages(messages, batchSize_);
+   while ( messageCount > 0 )
    {
+      dispatchMessages(messages, messageCount);
+      messageCount = mailboxOwnerHandle_.getMessages(messages, batchSize_);
+   }//end while
+}//end processMailboxInternal
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Call the message handler of each message in a batch and then
+//              delete the message (or check it in to the OPM)
+// Design:      Backlogs tend to hold runs of the same message type, so the
+//              handler found for one message is reused for the messages that
+//              follow it with the same message Id.
+//              The clock is read once per message: the time a handler returns
+//              is also the time the next message leaves the queue, so the
+//              queue wait includes the handling of the messages ahead of it
+//              in the batch (as it should).
+//-----------------------------------------------------------------------------
+void MailboxProcessor::dispatchMessages(MessageBase** messages, int messageCount)
+{
+   const MessageHandler* messageHandler = NULL;
+   unsigned short handlerMessageId = 0;
+   unsigned long long startTime = LatencyHistogram::getTimestamp();
+
+   for (int index = 0; index < messageCount; index++)
+   {
+      MessageBase* messagePtr = messages[index];
+      unsigned long long enqueueTime = messagePtr->getEnqueueTime();
+      if ((enqueueTime != 0) && (startTime >= enqueueTime))
+      {
+         mailboxOwnerHandle_.recordQueueWait(startTime - enqueueTime);
+      }//end if
+
       if (handlerList_)
       {
          // Get the mapping between the message handler functor and the message Id
-         const MessageHandler& messageHandler = handlerList_->find(messagePtr->getMessageId());
-         messageHandler(messagePtr);
+         unsigned short messageId = messagePtr->getMessageId();
+         if ((messageHandler == NULL) || (messageId != handlerMessageId))
+         {
+            messageHandler = &handlerList_->find(messageId);
+            handlerMessageId = messageId;
+         }//end if
+         (*messageHandler)(messagePtr);
+
+         unsigned long long endTime = LatencyHistogram::getTimestamp();
+         mailboxOwnerHandle_.recordHandlerTime(messageId, endTime - startTime);
+         startTime = endTime;
       }//end if
 
       messagePtr->deleteMessage();
-      messagePtr = NULL;
-      messagePtr = mailboxOwnerHandle_.getMessage();
+   }//end for
+}//end dispatchMessages
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Hand each message of a batch taken from the mailbox to the
+//              thread owning its key
+// Design:      A key group with no messages in flight can change threads
+//              without its messages being reordered, so when its owner is
+//              busy it moves to the thread with the fewest messages in flight.
+//              The messages for each thread are enqueued together.
+//-----------------------------------------------------------------------------
+void MailboxProcessor::distributeMessages(MessageBase** messages, int messageCount)
+{
+   for (int index = 0; index < messageCount; index++)
+   {
+      MessageBase* messagePtr = messages[index];
+      unsigned int group = getKeyGroup(messagePtr);
+      int owner = groupOwner_[group];
+
+      if ((groupPending_[group] == 0) && (shards_[owner]->pendingCount > 0))
+      {
+         for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+         {
+            if (shards_[shardIndex]->pendingCount < shards_[owner]->pendingCount)
+            {
+               owner = shardIndex;
+            }//end if
+         }//end for
+         groupOwner_[group] = owner;
+      }//end if
+
+      __sync_add_and_fetch(&groupPending_[group], 1);
+      __sync_add_and_fetch(&shards_[owner]->pendingCount, 1);
+      MailboxShard* shard = shards_[owner];
+      shard->staged[shard->stagedCount++] = messagePtr;
+   }//end for
+
+   for (int shardIndex = 0; shardIndex < numberShards_; shardIndex++)
+   {
+      MailboxShard* shard = shards_[shardIndex];
+      if (shard->stagedCount == 0)
+      {
+         continue;
+      }//end if
+
+      int handedCount = 0;
+      while (handedCount < shard->stagedCount)
+      {
+         handedCount += shard->queue.enqueue(&shard->staged[handedCount], shard->stagedCount - handedCount);
+         if (handedCount < shard->stagedCount)
+         {
+            // A message that was posted to the mailbox again before it could be handed
+            // over is already back in the mailbox queue, and will be distributed from there
+            TRACELOG(WARNINGLOG, MSGMGRLOG, "Message reposted before it was distributed, handling it once",0,0,0,0,0,0);
+            __sync_sub_and_fetch(&groupPending_[getKeyGroup(shard->staged[handedCount])], 1);
+            __sync_sub_and_fetch(&shard->pendingCount, 1);
+            handedCount++;
+         }//end if
+      }//end while
+      shard->stagedCount = 0;
+   }//end for
+}//end distributeMessages
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Loop on a sharded thread's queue processing messages
+// Design:      Once the queue is deactivated, the messages still in it are
+//              handled before the thread returns
+//-----------------------------------------------------------------------------
+void MailboxProcessor::processShardInternal(MailboxShard* shard)
+{
+   MessageBase* messages[MAILBOX_PROCESSOR_BATCH_SIZE];
+
+   int messageCount = shard->queue.dequeue(messages, MAILBOX_PROCESSOR_BATCH_SIZE, true);
+   while ( messageCount > 0 )
+   {
+      dispatchShardMessages(shard, messages, messageCount);
+      messageCount = shard->queue.dequeue(messages, MAILBOX_PROCESSOR_BATCH_SIZE, true);
    }//end while
-}//end processMailboxInternal
+
+   messageCount = shard->queue.dequeue(messages, MAILBOX_PROCESSOR_BATCH_SIZE, false);
+   while ( messageCount > 0 )
+   {
+      dispatchShardMessages(shard, messages, messageCount);
+      messageCount = shard->queue.dequeue(messages, MAILBOX_PROCESSOR_BATCH_SIZE, false);
+   }//end while
+}//end processShardInternal
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Handle a batch of messages from a sharded thread's queue
+// Design:      The key groups are found before the handlers run (the messages
+//              are deleted by dispatchMessages), and are only released once the
+//              handlers have returned, so a group never moves to another thread
+//              while one of its messages is being handled
+//-----------------------------------------------------------------------------
+void MailboxProcessor::dispatchShardMessages(MailboxShard* shard, MessageBase** messages, int messageCount)
+{
+   unsigned int groups[MAILBOX_PROCESSOR_BATCH_SIZE];
+   for (int index = 0; index < messageCount; index++)
+   {
+      groups[index] = getKeyGroup(messages[index]);
+   }//end for
+
+   dispatchMessages(messages, messageCount);
+
+   for (int index = 0; index < messageCount; index++)
+   {
+      __sync_sub_and_fetch(&groupPending_[groups[index]], 1);
+   }//end for
+   __sync_sub_and_fetch(&shard->pendingCount, messageCount);
+}//end dispatchShardMessages
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the key group of a message
+// Design:      Context Ids tend to be sequential, so the key is mixed (Knuth
+//              multiplicative hash) before it is reduced to a group
+//-----------------------------------------------------------------------------
+unsigned int MailboxProcessor::getKeyGroup(MessageBase* messagePtr)
+{
+   unsigned int key = (keyFunction_ != NULL) ? keyFunction_(messagePtr) : messagePtr->getDestinationContextId();
+   return (((key * 2654435761U) >> 16) % MAILBOX_PROCESSOR_KEY_GROUPS);
+}//end getKeyGroup
 
 
 //-----------------------------------------------------------------------------
@@ -169,6 +432,19 @@ void MailboxProcessor::invokeStatic()
 }//end invokeStatic
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Static method invocation of processShardInternal
+// Design:      Each thread of the pool claims the next shard
+//-----------------------------------------------------------------------------
+void MailboxProcessor::invokeShardStatic(void* arg)
+{
+   MailboxProcessor* mailboxProcessor = (MailboxProcessor*)arg;
+   int shardIndex = __sync_fetch_and_add(&mailboxProcessor->nextShard_, 1);
+   mailboxProcessor->processShardInternal(mailboxProcessor->shards_[shardIndex % mailboxProcessor->numberShards_]);
+}//end invokeShardStatic
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
@@ -25,10 +25,18 @@
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
+#include "LocalMessageQueue.h"
+
 //-----------------------------------------------------------------------------
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+/** Maximum number of messages each processing thread takes from the mailbox at once */
+#define MAILBOX_PROCESSOR_BATCH_SIZE 32
+
+/** Number of groups that message keys are hashed into for sharded processing */
+#define MAILBOX_PROCESSOR_KEY_GROUPS 1024
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -45,15 +53,36 @@
  * the appropriate Message Handler. 
  * <p>
  * By default, the mailbox processor remains blocked on the mailbox queue waiting
- * for messages. 
+ * for messages. When messages are backed up in the queue, they are taken from
+ * the mailbox and dispatched in batches (of up to MAILBOX_PROCESSOR_BATCH_SIZE
+ * messages, divided among the processing threads) rather than one at a time.
+ * <p>
+ * With processMailbox(N), the N threads all take messages from the mailbox, so
+ * two messages for the same call or context may be handled concurrently and
+ * out of order. processMailboxSharded(N) instead gives each thread its own
+ * queue: the calling thread takes the messages from the mailbox and hands
+ * each one to a thread according to its key (the destination context Id, or
+ * the result of an application supplied key function). The keys are hashed
+ * into MAILBOX_PROCESSOR_KEY_GROUPS groups, and each group belongs to one
+ * thread at a time, so the messages of a key are handled in order while the
+ * keys are spread across the threads. A group with no messages in flight is
+ * moved from a busy thread to the least busy one, so idle threads take over
+ * whole keys without ever reordering them.
  * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
 
+class MessageBase;
 class MessageHandlerList;
 class MailboxOwnerHandle;
 
+/**
+ * Function returning the key of a message for sharded processing. Messages with
+ * the same key are handled in order by one thread at a time.
+ */
+typedef unsigned int (*MessageKeyFunction)(MessageBase* messagePtr);
+
 class MailboxProcessor
 {
    public:
@@ -83,16 +112,67 @@ class MailboxProcessor
        */
       void processMailbox(int numberThreads = 1);
 
+      /**
+       * Reads messages from the queue and hands each one to one of numberThreads
+       * processing threads according to its key, so that the messages with the
+       * same key are handled in order, one at a time. Blocks (distributing the
+       * messages) until the mailbox is deactivated, and returns once the
+       * messages already distributed have been handled.
+       * <p>
+       * The handlers must still be THREAD SAFE across keys, but state kept per
+       * key is only ever accessed by one thread at a time.
+       * @param keyFunction Returns the key of a message; if NULL, the message
+       *    destination context Id is used
+       */
+      void processMailboxSharded(int numberThreads, MessageKeyFunction keyFunction = NULL);
+
    protected:
 
    private:
 
+      /** Processing thread of the sharded mode, and the messages handed to it */
+      struct MailboxShard
+      {
+         /** Messages handed to the thread */
+         LocalMessageQueue queue;
+
+         /** Messages handed to the thread that it has not finished handling */
+         volatile int pendingCount;
+
+         /** Messages of the current distribution batch for this thread */
+         MessageBase* staged[MAILBOX_PROCESSOR_BATCH_SIZE];
+
+         /** Number of staged messages */
+         int stagedCount;
+      };
+
       /** Perform the actual message dequeuing */
       void processMailboxInternal();
 
+      /**
+       * Call the message handler of each message in a batch and then delete
+       * the message (or check it in to the OPM)
+       */
+      void dispatchMessages(MessageBase** messages, int messageCount);
+
       /** Static invocation method for starting processMailboxInternal in multiple threads */
       static void invokeStatic();
 
+      /** Static invocation method for starting processShardInternal in each sharded thread */
+      static void invokeShardStatic(void* arg);
+
+      /** Hand each message of a batch taken from the mailbox to the thread owning its key */
+      void distributeMessages(MessageBase** messages, int messageCount);
+
+      /** Loop on a sharded thread's queue processing messages */
+      void processShardInternal(MailboxShard* shard);
+
+      /** Handle a batch of messages from a sharded thread's queue */
+      void dispatchShardMessages(MailboxShard* shard, MessageBase** messages, int messageCount);
+
+      /** Return the key group of a message */
+      unsigned int getKeyGroup(MessageBase* messagePtr);
+
       /** Default Constructor.*/
       MailboxProcessor();
 
@@ -114,6 +194,27 @@ class MailboxProcessor
       /** Message Handler List */
       MailboxOwnerHandle& mailboxOwnerHandle_;
 
+      /** Number of messages each processing thread takes from the mailbox at once */
+      int batchSize_;
+
+      /** Key function of the sharded mode (NULL for the destination context Id) */
+      MessageKeyFunction keyFunction_;
+
+      /** Threads of the sharded mode */
+      MailboxShard** shards_;
+
+      /** Number of threads of the sharded mode */
+      int numberShards_;
+
+      /** Next shard to be claimed by a starting sharded thread */
+      volatile int nextShard_;
+
+      /** Shard owning each key group (only accessed by the distributing thread) */
+      int groupOwner_[MAILBOX_PROCESSOR_KEY_GROUPS];
+
+      /** Messages of each key group distributed but not yet handled */
+      volatile int groupPending_[MAILBOX_PROCESSOR_KEY_GROUPS];
+
       /**
        * Static instance pointer
        */
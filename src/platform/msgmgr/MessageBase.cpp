@@ -86,7 +86,11 @@ MessageBase::MessageBase(const MailboxAddress& sourceAddress,
                            destinationContextId_(destinationContextId),
                            versionNumber_(versionNumber),
                            isReusable_(false),
-                           priorityLevel_(0)
+                           priorityLevel_(0),
+                           queueNext_(NULL),
+                           isQueued_(0),
+                           queueLane_(0),
+                           enqueueTime_(0)
 {
 }//end constructor
 
@@ -265,6 +269,18 @@ bool MessageBase::isReusable()
 }//end isReusable
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the time at which the message was last posted to a
+//              LocalMailbox queue
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long MessageBase::getEnqueueTime()
+{
+   return enqueueTime_;
+}//end getEnqueueTime
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
@@ -37,6 +37,7 @@ using namespace std;
 //-----------------------------------------------------------------------------
 
 class MessageBuffer;
+class LocalMessageQueue;
 
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
@@ -163,6 +164,8 @@ class MessageBase : public ObjectBase
        * Flag this message as high priority. This flag will cause the message to be
        * re-ordered in the Mailbox message queue (so will NOT follow FIFO rules).
        * Default priority is 0. Priorities greater than 0 have greater priority.
+       * LocalMailboxes queue each priority in its own lane; priorities from
+       * LOCAL_MESSAGE_QUEUE_LANES - 1 up share the highest lane.
        */
       void setPriority(unsigned int priorityLevel = 0);
 
@@ -193,6 +196,13 @@ class MessageBase : public ObjectBase
        */
       bool isReusable();
 
+      /**
+       * Return the monotonic time (in microseconds, see
+       * LatencyHistogram::getTimestamp) at which the message was last posted to
+       * a LocalMailbox queue; 0 if it never was
+       */
+      unsigned long long getEnqueueTime();
+
    protected:
 
       /**
@@ -221,6 +231,12 @@ class MessageBase : public ObjectBase
 
    private:
 
+      /** The LocalMailbox queue links messages through queueNext_ */
+      friend class LocalMessageQueue;
+
+      /** The LocalMailbox stamps messages with their enqueue time */
+      friend class LocalMailbox;
+
       /** Default Constructor */
       MessageBase();
 
@@ -239,6 +255,28 @@ class MessageBase : public ObjectBase
       /** Priority Level assigned to the message */
       unsigned int priorityLevel_;
 
+      /**
+       * Next message in the LocalMailbox queue. Local messages are queued by
+       * linking them together, so that posting one allocates nothing.
+       */
+      MessageBase* volatile queueNext_;
+
+      /**
+       * Non-zero while the message is in a LocalMailbox queue (a message can
+       * only be linked into one queue at a time)
+       */
+      volatile int isQueued_;
+
+      /**
+       * LocalMailbox queue lane the message was counted in when it was posted
+       * (so that changing the priority of a queued message cannot unbalance
+       * the lane depths)
+       */
+      unsigned int queueLane_;
+
+      /** Time at which the message was last posted to a LocalMailbox queue */
+      unsigned long long enqueueTime_;
+
 };
 
 #endif
@@ -18,6 +18,8 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <new>
+
 #include "netinet/in.h"
 
 //-----------------------------------------------------------------------------
@@ -32,6 +34,12 @@
 // Static Declarations.
 //-----------------------------------------------------------------------------
 
+MessageBufferInitializer MessageBuffer::networkBufferInitializer_ = { MAX_MESSAGE_LENGTH, true };
+
+MessageBufferInitializer MessageBuffer::localBufferInitializer_ = { MAX_MESSAGE_LENGTH, false };
+
+MessageBufferInitializer MessageBuffer::sharedBufferInitializer_ = { 0, false };
+
 
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
@@ -45,7 +53,8 @@
 //-----------------------------------------------------------------------------
 MessageBuffer::MessageBuffer(unsigned short bufferSize, bool performNetworkConversion)
    : maxBufferLength_(bufferSize),
-     performNetworkConversion_(performNetworkConversion)
+     performNetworkConversion_(performNetworkConversion),
+     isBufferExternal_(false)
 {
    if ( bufferSize != 0 )
    {
@@ -76,7 +85,8 @@ MessageBuffer::MessageBuffer(unsigned short bufferSize, bool performNetworkConve
 //-----------------------------------------------------------------------------
 MessageBuffer::MessageBuffer(unsigned char* bufferPtr, unsigned short bufferSize, bool performNetworkConversion)
    : maxBufferLength_(bufferSize),
-     performNetworkConversion_(performNetworkConversion)
+     performNetworkConversion_(performNetworkConversion),
+     isBufferExternal_(false)
 {
    if ( bufferSize != 0 )
    {
@@ -114,7 +124,10 @@ MessageBuffer::MessageBuffer(unsigned char* bufferPtr, unsigned short bufferSize
 //-----------------------------------------------------------------------------
 MessageBuffer::~MessageBuffer()
 {
-   delete [] bufferPtr_;
+   if (!isBufferExternal_)
+   {
+      delete [] bufferPtr_;
+   }//end if
 }//end virtual destructor
 
 
@@ -150,6 +163,40 @@ OPMBase* MessageBuffer::initialize(int initializer)
 }//end initialize
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: OPMBase static initializer method for constructing the objects
+//              in place within slab memory
+// Design: The buffer immediately follows the object in the slab, so the
+//         object header and the start of its data share cache lines.
+//-----------------------------------------------------------------------------
+OPMBase* MessageBuffer::initializeInPlace(void* memory, long initializer)
+{
+   MessageBufferInitializer* bufferInitializer = (MessageBufferInitializer*) initializer;
+
+   // Construct with no buffer of its own, then hand it the inline buffer
+   MessageBuffer* messageBuffer = new (memory) MessageBuffer((unsigned short)0,
+      bufferInitializer->performNetworkConversion);
+   messageBuffer->isBufferExternal_ = true;
+   messageBuffer->assignEmptyBuffer((unsigned char*)memory + sizeof(MessageBuffer),
+      bufferInitializer->bufferSize);
+   messageBuffer->clearBuffer();
+   return messageBuffer;
+}//end initializeInPlace
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the slab memory needed by initializeInPlace for each 
+//              MessageBuffer
+// Design:
+//-----------------------------------------------------------------------------
+size_t MessageBuffer::getInPlaceSize(unsigned short bufferSize)
+{
+   return (sizeof(MessageBuffer) + bufferSize);
+}//end getInPlaceSize
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: OPMBase clean method gets called when the object gets released
@@ -269,6 +316,23 @@ void MessageBuffer::assignEmptyBuffer(unsigned char* bufferPtr, unsigned short m
 }//end assignEmptyBuffer
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Method to assign empty contents to the buffer using memory that
+//              this object does not own
+// Design:
+//-----------------------------------------------------------------------------
+void MessageBuffer::assignSharedBuffer(unsigned char* bufferPtr, unsigned short maxBufferSize)
+{
+   if (!isBufferExternal_)
+   {
+      delete [] bufferPtr_;
+      isBufferExternal_ = true;
+   }//end if
+   assignEmptyBuffer(bufferPtr, maxBufferSize);
+}//end assignSharedBuffer
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Overloaded insertion operator for the buffer
@@ -960,6 +1024,46 @@ MessageBuffer& MessageBuffer::operator>> (MailboxAddress& mailboxValue)
 }//end extraction operator
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Append raw bytes to the buffer. Returns false (and appends
+//              nothing) if the bytes do not fit.
+// Design:      Used to pack already serialized messages into a batch
+//-----------------------------------------------------------------------------
+bool MessageBuffer::appendBytes(const unsigned char* bytes, unsigned short length)
+{
+   if ( (bufferInsertPtr_ + length) > (bufferPtr_ + maxBufferLength_) )
+   {
+      return false;
+   }//end if
+
+   memcpy(bufferInsertPtr_, bytes, length);
+   bufferInsertPtr_ += length;
+   return true;
+}//end appendBytes
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Extract raw bytes from the buffer in place. Returns NULL if
+//              fewer than length bytes remain to be deserialized.
+// Design:      Used to unpack the messages of a batch without copying them
+//-----------------------------------------------------------------------------
+unsigned char* MessageBuffer::extractBytes(unsigned short length)
+{
+   if ( (deserializeFromPtr_ + length) > bufferInsertPtr_ )
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Buffer contents exhausted prematurely: %d %d %d %d",
+         deserializeFromPtr_,length,bufferPtr_,maxBufferLength_,0,0);
+      return NULL;
+   }//end if
+
+   unsigned char* bytes = deserializeFromPtr_;
+   deserializeFromPtr_ += length;
+   return bytes;
+}//end extractBytes
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return whether all of the contents of this buffer have been
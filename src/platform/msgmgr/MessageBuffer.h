@@ -93,6 +93,37 @@ class MessageBuffer : public OPMBase
        */
       static OPMBase* initialize(int initializer);
 
+      /** 
+       * OPMBase static initializer method for constructing the objects in place
+       * within slab mode pools (see OPM::createSlabPool). The buffer itself is
+       * placed in the slab directly after the MessageBuffer object.
+       * @param memory Slab memory of at least getInPlaceSize() bytes
+       * @param initializer Address of a MessageBufferInitializer, as with initialize
+       */
+      static OPMBase* initializeInPlace(void* memory, long initializer);
+
+      /**
+       * Return the slab memory needed by initializeInPlace for each MessageBuffer
+       * @param bufferSize Size of each message buffer
+       */
+      static size_t getInPlaceSize(unsigned short bufferSize);
+
+      /**
+       * Initializer for pools of default size MessageBuffers that perform network
+       * conversion. Pools must be given an initializer that outlives them, as it
+       * is used again each time the pool grows.
+       */
+      static MessageBufferInitializer networkBufferInitializer_;
+
+      /** Initializer for pools of default size MessageBuffers used for shared memory */
+      static MessageBufferInitializer localBufferInitializer_;
+
+      /**
+       * Initializer for pools of MessageBuffers without a buffer of their own,
+       * which are given one with assignSharedBuffer (no network conversion)
+       */
+      static MessageBufferInitializer sharedBufferInitializer_;
+
       /** OPMBase clean method gets called when the object gets released back
           into its pool */
       void clean();
@@ -139,6 +170,15 @@ class MessageBuffer : public OPMBase
        */
       void assignEmptyBuffer(unsigned char* bufferPtr, unsigned short maxBufferSize);
 
+      /**
+       * Method to assign empty contents to the buffer using memory owned by someone
+       * else (such as an OPMSharedPool buffer in shared memory), so that messages are
+       * serialized directly into it. Any buffer owned by this object is deleted, and
+       * the assigned memory is never deleted or cleared by this object; assign a NULL
+       * buffer before releasing this object so that clean() does not clear it.
+       */
+      void assignSharedBuffer(unsigned char* bufferPtr, unsigned short maxBufferSize);
+
       /**
        * Overloaded insertion operators for the buffer
        */
@@ -161,6 +201,19 @@ class MessageBuffer : public OPMBase
       MessageBuffer& operator>> (bool& boolValue);
       MessageBuffer& operator>> (MailboxAddress& mailboxValue);
 
+      /**
+       * Append raw bytes (such as another serialized message) to the buffer
+       * @return false (and nothing is appended) if the bytes do not fit
+       */
+      bool appendBytes(const unsigned char* bytes, unsigned short length);
+
+      /**
+       * Extract raw bytes from the buffer in place
+       * @return Pointer to the bytes within this buffer, or NULL if fewer than
+       *    length bytes remain to be deserialized
+       */
+      unsigned char* extractBytes(unsigned short length);
+
       /**
        * Method to return whether or not this Message Buffer has been completely deserialized
        * based on the position of the deserializeFromPtr
@@ -215,6 +268,11 @@ class MessageBuffer : public OPMBase
           it should be false (such as in the case for shared memory transport). */
       bool performNetworkConversion_;
 
+      /** Flag to indicate that the buffer is not owned by this object (it was placed
+          in slab memory along with this object by initializeInPlace, or given to it
+          by assignSharedBuffer), and so must not be deleted */
+      bool isBufferExternal_;
+
 };
 
 #endif
@@ -30,17 +30,23 @@
 #include "MessageBase.h"
 #include "MessageBuffer.h"
 
+#include "platform/common/Defines.h"
+#include "platform/common/MessageIds.h"
+
 #include "platform/logger/Logger.h"
 
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
 
-// Map to implement the registry for mapping Message Bootstrap methods to their
-// Message Ids
-MessageFactory::MessageFactoryRegistry MessageFactory::messageFactoryRegistry_;
+// Registry of the Message Bootstrap methods indexed by Message Id
+const MessageBootStrapMethod* volatile MessageFactory::messageFactoryRegistry_[MSGMGR_MESSAGE_ID_COUNT];
+
+// Counters of the messages recreated and rejected, indexed by Message Id
+volatile unsigned int MessageFactory::createdCount_[MSGMGR_MESSAGE_ID_COUNT];
+volatile unsigned int MessageFactory::rejectedCount_[MSGMGR_MESSAGE_ID_COUNT];
 
-// Mutex for protecting Map (registry) access
+// Mutex for serializing the registrations
 ACE_Thread_Mutex MessageFactory::messageFactoryMutex_;
 
 //-----------------------------------------------------------------------------
@@ -73,33 +79,30 @@ MessageFactory::~MessageFactory()
 // Description: MessageBase subclasses that need to be de-serialized (re-created)
 //              must register themselves with the MessageFactory so that it knows
 //              how to perform the recreation.
-// Design:
+// Design:      A registration for a Message Id that already has one replaces
+//              it. The copy of the bootstrap method is completed before the
+//              barrier, so a receiving thread that sees the new pointer also
+//              sees the method it points to.
 //-----------------------------------------------------------------------------
 void MessageFactory::registerSupport(unsigned short messageId, MessageBootStrapMethod& messageCreator)
 {
    TRACELOG(DEBUGLOG, MSGMGRLOG, "Message Factory Registering: message Id 0x%x", messageId,0,0,0,0,0);
-                                                                                                           
-   // Map protection
+
+   // Registration protection
    messageFactoryMutex_.acquire();
-                                                                                                           
-   // First check to see if this messageId already has been registered, if so, 
-   // we want to delete the registration and replace it
-   MessageFactoryRegistry::iterator registryIterator = messageFactoryRegistry_.find(messageId);
-   if (registryIterator != messageFactoryRegistry_.end())
-   {
-      messageFactoryRegistry_.erase(registryIterator);
-   }//end if
 
-   // Perform the registration
-   pair<MessageFactoryRegistry::iterator, bool> insertResult;
-   insertResult = messageFactoryRegistry_.insert(make_pair(messageId, messageCreator));
-   // Check to see if the map insert was successful
-   if (!insertResult.second)
+   if (messageFactoryRegistry_[messageId] != NULL)
    {
-      TRACELOG(ERRORLOG, MSGMGRLOG, "MessageFactoryRegistry insertion failed",0,0,0,0,0,0);
+      TRACELOG(DEBUGLOG, MSGMGRLOG, "Replacing the registration for message Id 0x%x", messageId,0,0,0,0,0);
    }//end if
 
-   // Map protection
+   // Perform the registration. Any replaced bootstrap method is intentionally not
+   // deleted, since a receiving thread may be calling it right now
+   const MessageBootStrapMethod* newCreator = new MessageBootStrapMethod(messageCreator);
+   __sync_synchronize();
+   messageFactoryRegistry_[messageId] = newCreator;
+
+   // Registration protection
    messageFactoryMutex_.release();
 }//end registerSupport
 
@@ -115,19 +118,142 @@ MessageBase* MessageFactory::recreateMessageFromBuffer(MessageBuffer& buffer)
 
    buffer >> messageId;
 
-   MessageFactoryRegistry::iterator registryIterator = messageFactoryRegistry_.find(messageId);
-   if ( registryIterator == messageFactoryRegistry_.end() )
+   return recreateMessage(messageId, buffer);
+}//recreateMessageFromBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Convert a buffer holding one message or a batch of messages back
+//              into the Message objects
+// Design:      Each message of a batch is deserialized directly from the batch
+//              buffer; its length tells whether a priority level follows its
+//              contents and where the next message starts.
+//-----------------------------------------------------------------------------
+int MessageFactory::recreateMessagesFromBuffer(MessageBuffer& buffer, MessageBase** messages, int maxMessages)
+{
+   unsigned short messageId = 0;
+
+   buffer >> messageId;
+
+   if (messageId != MSGMGR_BATCH_MSG_ID)
    {
-      ostringstream ostr;
-      ostr << "No bootstrap method registered for message Id 0x" << hex << messageId << ends;
-      STRACELOG(WARNINGLOG, MSGMGRLOG, ostr.str().c_str()); 
-      return NULL;
+      MessageBase* message = recreateMessage(messageId, buffer);
+      if (message == NULL)
+      {
+         return 0;
+      }//end if
+
+      // If the buffer is not empty, the priority level flag follows the contents
+      if (!buffer.areContentsProcessed())
+      {
+         unsigned int messagePriorityLevel = 0;
+         buffer >> messagePriorityLevel;
+         message->setPriority(messagePriorityLevel);
+      }//end if
+      messages[0] = message;
+      return 1;
    }//end if
-   else
+
+   int messageCount = 0;
+   while (!buffer.areContentsProcessed())
    {
-      return (registryIterator->second(&buffer));
-   }//end else
-}//recreateMessageFromBuffer
+      unsigned short messageLength = 0;
+      buffer >> messageLength;
+      unsigned char* messageEnd = buffer.getBuffer() + messageLength;
+
+      if (messageCount == maxMessages)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Dropping messages beyond %d in a received batch",maxMessages,0,0,0,0,0);
+         break;
+      }//end if
+
+      buffer >> messageId;
+      MessageBase* message = recreateMessage(messageId, buffer);
+      if (buffer.getBuffer() > messageEnd)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Message Id 0x%x deserialized beyond its length %d in a received batch",
+            messageId,messageLength,0,0,0,0);
+         if (message != NULL)
+         {
+            message->deleteMessage();
+         }//end if
+         break;
+      }//end if
+
+      if (message != NULL)
+      {
+         if (buffer.getBuffer() < messageEnd)
+         {
+            unsigned int messagePriorityLevel = 0;
+            buffer >> messagePriorityLevel;
+            message->setPriority(messagePriorityLevel);
+         }//end if
+         messages[messageCount++] = message;
+      }//end if
+
+      // Skip anything left of this message (such as the contents of an unknown Message Id)
+      if ((buffer.getBuffer() < messageEnd) && (buffer.extractBytes(messageEnd - buffer.getBuffer()) == NULL))
+      {
+         break;
+      }//end if
+   }//end while
+   return messageCount;
+}//end recreateMessagesFromBuffer
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Serialize a message for transmission
+// Design:      The priority level is only sent if it is not 0; the receiver
+//              detects it as bytes left over after the contents.
+//-----------------------------------------------------------------------------
+void MessageFactory::serializeMessage(MessageBase* messagePtr, MessageBuffer& buffer)
+{
+   // Serialize the Message Id
+   buffer << messagePtr->getMessageId();
+
+   // Serialize the remainder of the message
+   messagePtr->serialize(buffer);
+
+   // Check to see if the Message is flagged as high priority, if so, serialize this flag to send as well
+   unsigned int priorityLevel = messagePtr->getPriority();
+   if (priorityLevel != 0)
+   {
+      buffer << priorityLevel;
+   }//end if
+}//end serializeMessage
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Serialize as many of the messages as fit into a batch
+// Design:      Each message is serialized into the scratch buffer first, so that
+//              a message that does not fit is left out whole rather than cut
+//              off by the buffer bounds checks.
+//-----------------------------------------------------------------------------
+int MessageFactory::serializeBatch(MessageBase** messages, int messageCount, MessageBuffer& batchBuffer,
+                                   MessageBuffer& scratchBuffer)
+{
+   batchBuffer << (unsigned short)MSGMGR_BATCH_MSG_ID;
+
+   int batchedCount = 0;
+   while ((batchedCount < messageCount) && (batchedCount < MSGMGR_MAX_BATCH_MESSAGES))
+   {
+      scratchBuffer.setInsertPosition(0);
+      serializeMessage(messages[batchedCount], scratchBuffer);
+
+      unsigned short messageLength = scratchBuffer.getBufferLength();
+      if ((batchBuffer.getBufferLength() + sizeof(unsigned short) + messageLength) > batchBuffer.getMaxBufferLength())
+      {
+         break;
+      }//end if
+      batchBuffer << messageLength;
+      batchBuffer.appendBytes(scratchBuffer.getBuffer(), messageLength);
+      batchedCount++;
+   }//end while
+   return batchedCount;
+}//end serializeBatch
 
 
 //-----------------------------------------------------------------------------
@@ -139,13 +265,15 @@ void MessageFactory::listRegisteredMessages()
 {
    ostringstream ostr;
 
-   ostr << "Message Factory Registered messages: ";
- 
-   MessageFactoryRegistry::iterator registryIterator;
-   for ( registryIterator = messageFactoryRegistry_.begin(); registryIterator != 
-         messageFactoryRegistry_.end(); registryIterator++)
+   ostr << "Message Factory Registered messages (created/rejected): ";
+
+   for (int messageId = 0; messageId < MSGMGR_MESSAGE_ID_COUNT; messageId++)
    {
-      ostr << "0x" << hex << registryIterator->first << ", ";
+      if ((messageFactoryRegistry_[messageId] != NULL) || (rejectedCount_[messageId] != 0))
+      {
+         ostr << "0x" << hex << messageId << dec << " (" << createdCount_[messageId]
+              << "/" << rejectedCount_[messageId] << "), ";
+      }//end if
    }//end for
    ostr << ends;
 
@@ -153,6 +281,29 @@ void MessageFactory::listRegisteredMessages()
 }//end listRegisteredMessages
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the number of messages recreated for a Message Id
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int MessageFactory::getCreatedCount(unsigned short messageId)
+{
+   return createdCount_[messageId];
+}//end getCreatedCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the number of received messages of a Message Id that
+//              could not be recreated
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int MessageFactory::getRejectedCount(unsigned short messageId)
+{
+   return rejectedCount_[messageId];
+}//end getRejectedCount
+
+
 //-----------------------------------------------------------------------------
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
@@ -161,6 +312,37 @@ void MessageFactory::listRegisteredMessages()
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Convert the buffer back into its Message object form once its
+//              Message Id has been read
+// Design:      Takes no lock; the bootstrap method is read with a single load
+//-----------------------------------------------------------------------------
+MessageBase* MessageFactory::recreateMessage(unsigned short messageId, MessageBuffer& buffer)
+{
+   const MessageBootStrapMethod* messageCreator = messageFactoryRegistry_[messageId];
+   if (messageCreator == NULL)
+   {
+      __sync_add_and_fetch(&rejectedCount_[messageId], 1);
+      ostringstream ostr;
+      ostr << "No bootstrap method registered for message Id 0x" << hex << messageId << ends;
+      STRACELOG(WARNINGLOG, MSGMGRLOG, ostr.str().c_str()); 
+      return NULL;
+   }//end if
+
+   MessageBase* message = (*messageCreator)(&buffer);
+   if (message == NULL)
+   {
+      __sync_add_and_fetch(&rejectedCount_[messageId], 1);
+   }//end if
+   else
+   {
+      __sync_add_and_fetch(&createdCount_[messageId], 1);
+   }//end else
+   return message;
+}//end recreateMessage
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
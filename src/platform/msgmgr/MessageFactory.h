@@ -23,7 +23,6 @@
 //-----------------------------------------------------------------------------
 
 #include <ace/Thread_Mutex.h>
-#include <map>
 
 using namespace std;
 
@@ -37,6 +36,19 @@ using namespace std;
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+/** Maximum number of messages carried by one batch transmission */
+#define MSGMGR_MAX_BATCH_MESSAGES 64
+
+/**
+ * Length of the header framing each transmission on a distributed (TCP)
+ * connection: the length of the serialized buffer that follows it, as an
+ * unsigned short in network byte order
+ */
+#define MSGMGR_FRAME_HEADER_LENGTH 2
+
+/** Number of Message Ids in the registry (every 16 bit Message Id) */
+#define MSGMGR_MESSAGE_ID_COUNT 65536
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -57,6 +69,23 @@ using namespace std;
  * Factory upon initialization--this is how the MessageFactory knows about
  * the various message types.
  * <p>
+ * The registry is a flat table indexed by Message Id, so finding the bootstrap
+ * method of each received message is a single array index and takes no lock.
+ * Registrations publish the new bootstrap method with one pointer store, so
+ * they are safe while the receiving mailboxes deserialize; a replaced method
+ * is never deleted, since a receiving thread may still be calling it. For
+ * each Message Id, the factory counts the messages it created and the ones it
+ * rejected (no bootstrap method registered, or the bootstrap method failed).
+ * <p>
+ * Several messages may also be serialized into one buffer so that they travel
+ * in a single transmission. The batch starts with MSGMGR_BATCH_MSG_ID, and each
+ * message follows with its length in front of it. The receiving mailboxes use
+ * recreateMessagesFromBuffer, which accepts both single messages and batches.
+ * <p>
+ * On the distributed (TCP) connections, which do not keep the boundaries of
+ * the transmissions, each serialized buffer (single message or batch) is sent
+ * behind a MSGMGR_FRAME_HEADER_LENGTH header holding its length.
+ * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
@@ -91,24 +120,62 @@ class MessageFactory
       static MessageBase* recreateMessageFromBuffer(MessageBuffer& buffer);
 
       /**
-       * Output registered message Ids
+       * Convert a received buffer holding either one message or a batch of messages
+       * back into the Message objects, including the priority level of each message
+       * @param messages Array that receives the messages (at least MSGMGR_MAX_BATCH_MESSAGES)
+       * @param maxMessages Size of the messages array
+       * @returns Number of messages recreated
+       */
+      static int recreateMessagesFromBuffer(MessageBuffer& buffer, MessageBase** messages, int maxMessages);
+
+      /**
+       * Serialize a message for transmission: its Message Id, its contents and (if
+       * it is not 0) its priority level
+       */
+      static void serializeMessage(MessageBase* messagePtr, MessageBuffer& buffer);
+
+      /**
+       * Serialize as many of the messages as fit (and at most MSGMGR_MAX_BATCH_MESSAGES)
+       * into an empty buffer as a batch, in order.
+       * @param scratchBuffer Empty buffer (with memory of MAX_MESSAGE_LENGTH) used
+       *    to serialize each message before it is appended to the batch
+       * @returns Number of messages serialized into the batch; 0 if the first one
+       *    is too large to be batched
+       */
+      static int serializeBatch(MessageBase** messages, int messageCount, MessageBuffer& batchBuffer,
+                                MessageBuffer& scratchBuffer);
+
+      /**
+       * Output registered message Ids (with their created and rejected counts)
        */
       static void listRegisteredMessages();
 
-      /** 
-       * Map to implement the registry for mapping Message Bootstrap methods to their
-       * Message Ids 
+      /** Return the number of messages recreated for a Message Id */
+      static unsigned int getCreatedCount(unsigned short messageId);
+
+      /**
+       * Return the number of received messages of a Message Id that could not
+       * be recreated
        */
-      typedef map<unsigned short, MessageBootStrapMethod> MessageFactoryRegistry;
+      static unsigned int getRejectedCount(unsigned short messageId);
 
    protected:
 
    private:
 
-      /** Registry Map */
-      static MessageFactoryRegistry messageFactoryRegistry_;
+      /** Convert the buffer back into a Message object once its Message Id has been read */
+      static MessageBase* recreateMessage(unsigned short messageId, MessageBuffer& buffer);
+
+      /** Registry of the Message Bootstrap methods indexed by Message Id (NULL if none) */
+      static const MessageBootStrapMethod* volatile messageFactoryRegistry_[MSGMGR_MESSAGE_ID_COUNT];
+
+      /** Number of messages recreated, indexed by Message Id */
+      static volatile unsigned int createdCount_[MSGMGR_MESSAGE_ID_COUNT];
+
+      /** Number of messages that could not be recreated, indexed by Message Id */
+      static volatile unsigned int rejectedCount_[MSGMGR_MESSAGE_ID_COUNT];
 
-      /** Non-recursive Mutex for protecting Map (registry) access */
+      /** Non-recursive Mutex that serializes the registrations */
       static ACE_Thread_Mutex messageFactoryMutex_;
 
       /** Constructor */
@@ -46,48 +46,68 @@
 // Description: The constructor creates a default message handler that will
 //              be used when a message does not have a handler associated with it.
 // Design:      It uses the makeFunctor() function provided by the 3rd party
-//              library we are using ( Callback.cpp and Callback.h ) 
+//              library we are using ( Callback.cpp and Callback.h ). The
+//              initial dispatch table has no pages.
 //-----------------------------------------------------------------------------
 MessageHandlerList::MessageHandlerList()
    : defaultHandler_ ( makeFunctor( (MessageHandler *) 0, *this, &MessageHandlerList::defaultMessageHandler)),
-     currentDefaultHandler_(defaultHandler_)
+     dispatchTable_(NULL)
 {
+   DispatchTable* table = new DispatchTable();
+   table->defaultHandler = &defaultHandler_;
+   for (int pageIndex = 0; pageIndex < MESSAGE_HANDLER_PAGE_COUNT; pageIndex++)
+   {
+      table->pages[pageIndex] = NULL;
+   }//end for
+   publishTable(table);
 }//end constructor
 
 
 //-----------------------------------------------------------------------------
 // Method Type: Virtual Destructor
 // Description: 
-// Design:     
+// Design:      Deletes every table, page and handler ever created, since none
+//              could be deleted while the list was in use
 //-----------------------------------------------------------------------------
 MessageHandlerList::~MessageHandlerList()
 {
+   for (vector<DispatchTable*>::iterator iterate = tables_.begin(); iterate != tables_.end(); iterate++)
+   {
+      delete *iterate;
+   }//end for
+   for (vector<DispatchPage*>::iterator iterate = pages_.begin(); iterate != pages_.end(); iterate++)
+   {
+      delete *iterate;
+   }//end for
+   for (vector<MessageHandler*>::iterator iterate = handlers_.begin(); iterate != handlers_.end(); iterate++)
+   {
+      delete *iterate;
+   }//end for
 }//end virtual destructor
 
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Perform the mapping between message Id and handler function
-// Design:
+// Design:      Fails if the message Id already has a handler
 //-----------------------------------------------------------------------------
 bool MessageHandlerList::add(unsigned short messageId, const MessageHandler& handler)
 {
    ACE_GUARD_RETURN (ACE_Thread_Mutex, ace_mon, listMutex_, false);
 
-   typedef pair<unsigned short, MessageHandler> MessageHandlerPair;
-   MessageHandlerPair messageHandlerPair(messageId, handler); 
-   
-   pair<map<unsigned short, MessageHandler>::iterator, bool> pairIterator =
-     messageHandlerList_.insert(messageHandlerPair);
-                                                                                                         
-   if (pairIterator.second)
-   {
-      return true;
-   }//end if
-   else
+   const DispatchPage* page = dispatchTable_->pages[messageId / MESSAGE_HANDLER_PAGE_SIZE];
+   if ((page != NULL) && (page->handlers[messageId % MESSAGE_HANDLER_PAGE_SIZE] != NULL))
    {
       return false;
-   }//end else
+   }//end if
+
+   MessageHandler* newHandler = new MessageHandler(handler);
+   handlers_.push_back(newHandler);
+
+   DispatchTable* table = copyTable();
+   setHandler(table, messageId, newHandler);
+   publishTable(table);
+   return true;
 }//end add
 
 
@@ -99,28 +119,39 @@ bool MessageHandlerList::add(unsigned short messageId, const MessageHandler& han
 void MessageHandlerList::remove(unsigned short messageId)
 {
    ACE_GUARD (ACE_Thread_Mutex, ace_mon, listMutex_);
-   messageHandlerList_.erase(messageId);
+
+   const DispatchPage* page = dispatchTable_->pages[messageId / MESSAGE_HANDLER_PAGE_SIZE];
+   if ((page == NULL) || (page->handlers[messageId % MESSAGE_HANDLER_PAGE_SIZE] == NULL))
+   {
+      return;
+   }//end if
+
+   DispatchTable* table = copyTable();
+   setHandler(table, messageId, NULL);
+   publishTable(table);
 }//end remove
 
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return a handler for a given message Id. 
-// Design: Returns default handler if message Id could not be found
+// Design: Returns default handler if message Id could not be found. Takes no
+//         lock: the published table is never changed, only replaced.
 //-----------------------------------------------------------------------------
 const MessageHandler& MessageHandlerList::find(unsigned short messageId)
 {
-   ACE_GUARD_RETURN (ACE_Thread_Mutex, ace_mon, listMutex_, currentDefaultHandler_);
- 
-   MessageHandlerRegistryType::iterator iterate = messageHandlerList_.find(messageId);
-   if (iterate != messageHandlerList_.end())
+   const DispatchTable* table = dispatchTable_;
+
+   const DispatchPage* page = table->pages[messageId / MESSAGE_HANDLER_PAGE_SIZE];
+   if (page != NULL)
    {
-      return (*iterate).second;
+      const MessageHandler* handler = page->handlers[messageId % MESSAGE_HANDLER_PAGE_SIZE];
+      if (handler != NULL)
+      {
+         return *handler;
+      }//end if
    }//end if
-   else
-   {
-      return currentDefaultHandler_;
-   }//end else
+   return *table->defaultHandler;
 }//end find
 
 
@@ -133,7 +164,13 @@ const MessageHandler& MessageHandlerList::find(unsigned short messageId)
 void MessageHandlerList::setDefault(MessageHandler& defaultHandler)
 {
    ACE_GUARD (ACE_Thread_Mutex, ace_mon, listMutex_);
-   currentDefaultHandler_ = defaultHandler;
+
+   MessageHandler* newHandler = new MessageHandler(defaultHandler);
+   handlers_.push_back(newHandler);
+
+   DispatchTable* table = copyTable();
+   table->defaultHandler = newHandler;
+   publishTable(table);
 }//end setDefault
 
 
@@ -146,9 +183,11 @@ void MessageHandlerList::restoreDefault()
 {
    ACE_GUARD (ACE_Thread_Mutex, ace_mon, listMutex_);
 
-   if(currentDefaultHandler_ != defaultHandler_)
+   if (dispatchTable_->defaultHandler != &defaultHandler_)
    {
-      currentDefaultHandler_ = defaultHandler_;
+      DispatchTable* table = copyTable();
+      table->defaultHandler = &defaultHandler_;
+      publishTable(table);
    }//end if
 }//end restoreDefault
 
@@ -164,12 +203,7 @@ void MessageHandlerList::listAllMessageHandlers()
 
    ostringstream ostr;
    ostr << "List of active message handlers: " << endl;
-
-   MessageHandlerRegistryType::iterator iterate;
-   for (iterate = messageHandlerList_.begin(); iterate != messageHandlerList_.end(); iterate++)
-   {
-      ostr << iterate->first << endl;
-   }//end for
+   listMessageIds(ostr);
 
    STRACELOG(DEBUGLOG, MSGMGRLOG, ostr.str().c_str());
 
@@ -187,12 +221,7 @@ string MessageHandlerList::toString()
 
    ostringstream ostr;
    ostr << "List of active message handlers: " << endl;
-
-   MessageHandlerRegistryType::iterator iterate;
-   for (iterate = messageHandlerList_.begin(); iterate != messageHandlerList_.end(); iterate++)
-   {
-      ostr << iterate->first << endl;
-   }//end for
+   listMessageIds(ostr);
 
    return ostr.str().c_str();
 }//end toString
@@ -222,6 +251,89 @@ int MessageHandlerList::defaultMessageHandler(MessageBase* messagePtr)
 }//end defaultMessageHandler
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return a copy of the published dispatch table
+// Design:      The pages are shared with the published table until changed
+//-----------------------------------------------------------------------------
+MessageHandlerList::DispatchTable* MessageHandlerList::copyTable()
+{
+   DispatchTable* table = new DispatchTable(*dispatchTable_);
+   return table;
+}//end copyTable
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Store a handler (or NULL) for a message Id in an unpublished
+//              table
+// Design:      The page is copied (or created), since the published table may
+//              share it
+//-----------------------------------------------------------------------------
+void MessageHandlerList::setHandler(DispatchTable* table, unsigned short messageId, const MessageHandler* handler)
+{
+   int pageIndex = messageId / MESSAGE_HANDLER_PAGE_SIZE;
+
+   DispatchPage* page = new DispatchPage();
+   if (table->pages[pageIndex] != NULL)
+   {
+      *page = *table->pages[pageIndex];
+   }//end if
+   else
+   {
+      for (int handlerIndex = 0; handlerIndex < MESSAGE_HANDLER_PAGE_SIZE; handlerIndex++)
+      {
+         page->handlers[handlerIndex] = NULL;
+      }//end for
+   }//end else
+   pages_.push_back(page);
+
+   page->handlers[messageId % MESSAGE_HANDLER_PAGE_SIZE] = handler;
+   table->pages[pageIndex] = page;
+}//end setHandler
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Publish a new dispatch table
+// Design:      The barrier makes the contents of the table (and its pages and
+//              handlers) visible before the pointer to it. The finding threads
+//              only reach them through the pointer, so they need no barrier.
+//-----------------------------------------------------------------------------
+void MessageHandlerList::publishTable(DispatchTable* table)
+{
+   tables_.push_back(table);
+   __sync_synchronize();
+   dispatchTable_ = table;
+}//end publishTable
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Append the message Ids that have a handler to the stream
+// Design:
+//-----------------------------------------------------------------------------
+void MessageHandlerList::listMessageIds(ostringstream& ostr)
+{
+   const DispatchTable* table = dispatchTable_;
+   for (int pageIndex = 0; pageIndex < MESSAGE_HANDLER_PAGE_COUNT; pageIndex++)
+   {
+      const DispatchPage* page = table->pages[pageIndex];
+      if (page == NULL)
+      {
+         continue;
+      }//end if
+      for (int handlerIndex = 0; handlerIndex < MESSAGE_HANDLER_PAGE_SIZE; handlerIndex++)
+      {
+         if (page->handlers[handlerIndex] != NULL)
+         {
+            ostr << ((pageIndex * MESSAGE_HANDLER_PAGE_SIZE) + handlerIndex) << endl;
+         }//end if
+      }//end for
+   }//end for
+}//end listMessageIds
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
@@ -20,7 +20,8 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
-#include <map>
+#include <sstream>
+#include <vector>
 
 #include <ace/Thread_Mutex.h>
 
@@ -58,10 +59,19 @@ class MessageBase;
  * (the MessageId) to associate the handler function to the receipt of a 
  * particular message.
  * <p>
- * MessageHandlerList does not implement any type of thread safety mechanisms.
- * This means that the application developer must build the handler list
- * from a SINGLE THREAD. DO NOT ATTEMPT to add message handlers from multiple
- * threads!
+ * The handlers are kept in a flat dispatch table indexed by message Id (a
+ * 256 entry table of 256 handler pages, since message Ids are 16 bits), so
+ * finding a handler costs two array indexes whatever the number of handlers
+ * registered, and takes no lock: MailboxProcessor threads processing the
+ * same mailbox in parallel do not serialize on the list.
+ * <p>
+ * The table is published through a single pointer. add, remove, setDefault
+ * and restoreDefault copy the table (and the one page they change), then
+ * swap the pointer, serialized between themselves by a mutex. Superseded
+ * tables, pages and handlers are kept until the list is destroyed, since a
+ * dispatching thread may still hold them (find returns a reference to the
+ * handler). Building the handler list is expected to be done once at
+ * startup, so this costs little memory.
  * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
@@ -73,8 +83,11 @@ class MessageBase;
  */                                                                                                         
 typedef CBFunctor1wRet<MessageBase *, int> MessageHandler;
 
-/** Map is used to maintain the message handler registry */
-typedef map<unsigned short, MessageHandler, less<unsigned short> > MessageHandlerRegistryType;
+/** Number of message Ids covered by each page of the dispatch table */
+#define MESSAGE_HANDLER_PAGE_SIZE 256
+
+/** Number of pages in the dispatch table (covers every 16 bit message Id) */
+#define MESSAGE_HANDLER_PAGE_COUNT 256
 
 class MessageHandlerList
 {
@@ -120,6 +133,22 @@ class MessageHandlerList
 
    private:
 
+      /** Handlers for MESSAGE_HANDLER_PAGE_SIZE consecutive message Ids (NULL if none) */
+      struct DispatchPage
+      {
+         const MessageHandler* handlers[MESSAGE_HANDLER_PAGE_SIZE];
+      };
+
+      /** Dispatch table published to the finding threads; never changed once published */
+      struct DispatchTable
+      {
+         /** Handler used for the message Ids without one */
+         const MessageHandler* defaultHandler;
+
+         /** Pages indexed by the high byte of the message Id (NULL if no handlers) */
+         const DispatchPage* pages[MESSAGE_HANDLER_PAGE_COUNT];
+      };
+
       /**
        * Copy Constructor declared private so that default automatic
        * methods aren't used.
@@ -135,19 +164,37 @@ class MessageHandlerList
       /** Default message handler */
       int defaultMessageHandler(MessageBase* messagePtr);
 
-      /** The functor object that contains the default message handler function */
-      MessageHandler defaultHandler_;
+      /** Return a copy of the published dispatch table. Called with listMutex_ held */
+      DispatchTable* copyTable();
 
       /**
-       * The functor object that contains the default message handler that is
-       * currently active.
+       * Store a handler (or NULL) for a message Id in a copy of the published
+       * table, copying the page that holds it. Called with listMutex_ held.
        */
-      MessageHandler currentDefaultHandler_;
+      void setHandler(DispatchTable* table, unsigned short messageId, const MessageHandler* handler);
+
+      /** Publish a new dispatch table. Called with listMutex_ held */
+      void publishTable(DispatchTable* table);
+
+      /** Append the message Ids that have a handler to the stream */
+      void listMessageIds(ostringstream& ostr);
+
+      /** The functor object that contains the default message handler function */
+      MessageHandler defaultHandler_;
+
+      /** The dispatch table currently published to the finding threads */
+      DispatchTable* volatile dispatchTable_;
+
+      /** Every table published (they are only deleted with the list) */
+      vector<DispatchTable*> tables_;
+
+      /** Every page created (they are only deleted with the list) */
+      vector<DispatchPage*> pages_;
 
-      /** Map is used to maintain the message handler registry list. */
-      MessageHandlerRegistryType messageHandlerList_;
+      /** Every handler added (they are only deleted with the list) */
+      vector<MessageHandler*> handlers_;
 
-      /** Non-recursive Ace Thread Mutex that protects/guards this list */
+      /** Non-recursive Ace Thread Mutex that serializes the changes to this list */
       ACE_Thread_Mutex listMutex_;
 };
 
@@ -0,0 +1,208 @@
+/******************************************************************************
+*
+* File name:   ReactorPool.cpp
+* Subsystem:   Platform Services
+* Description: Implements the process wide pool of epoll based reactors that
+*              the mailboxes share for their timers and socket IO.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sstream>
+
+#include <ace/Dev_Poll_Reactor.h>
+#include <ace/Thread.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "ReactorPool.h"
+
+#include "platform/common/Defines.h"
+
+#include "platform/logger/Logger.h"
+
+#include "platform/threadmgr/ThreadManager.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+// Reactors of the pool
+vector<ACE_Reactor*> ReactorPool::reactors_;
+
+// Number of reactors the pool is started with
+unsigned int ReactorPool::poolSize_ = REACTOR_POOL_DEFAULT_SIZE;
+
+// Whether the pool has been started
+bool ReactorPool::isStarted_ = false;
+
+// Counter used to hand the reactors out in turn
+unsigned int ReactorPool::nextReactor_ = 0;
+
+// Mutex serializing the start of the pool
+ACE_Thread_Mutex ReactorPool::poolMutex_;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Set the number of reactors in the pool
+// Design:
+//-----------------------------------------------------------------------------
+int ReactorPool::setPoolSize(unsigned int poolSize)
+{
+   if ((poolSize == 0) || (poolSize > REACTOR_POOL_MAX_SIZE))
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Invalid reactor pool size %d",poolSize,0,0,0,0,0);
+      return ERROR;
+   }//end if
+
+   poolMutex_.acquire();
+   if (isStarted_)
+   {
+      poolMutex_.release();
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Reactor pool already started, size not changed",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
+   poolSize_ = poolSize;
+   poolMutex_.release();
+   return OK;
+}//end setPoolSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the next reactor of the pool
+// Design:      Handing the reactors out in turn spreads the mailboxes (and
+//              the connections, which are assigned as they are accepted)
+//              evenly enough, and needs no tracking of what is released
+//-----------------------------------------------------------------------------
+ACE_Reactor* ReactorPool::getReactor()
+{
+   ACE_Reactor* reactor = NULL;
+   poolMutex_.acquire();
+   if (!isStarted_)
+   {
+      startPool();
+   }//end if
+   if (!reactors_.empty())
+   {
+      reactor = reactors_[nextReactor_ % reactors_.size()];
+      nextReactor_++;
+   }//end if
+   poolMutex_.release();
+
+   if (reactor == NULL)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "No reactor available in the reactor pool",0,0,0,0,0,0);
+   }//end if
+   return reactor;
+}//end getReactor
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+ReactorPool::ReactorPool()
+{
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+ReactorPool::~ReactorPool()
+{
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Create the reactors and start their threads. Called with
+//              poolMutex_ held.
+// Design:      A reactor whose thread cannot be started is left out of the
+//              pool (and leaked, as it may not be safe to delete)
+//-----------------------------------------------------------------------------
+void ReactorPool::startPool()
+{
+   isStarted_ = true;
+   for (unsigned int index = 0; index < poolSize_; index++)
+   {
+      ACE_Reactor* reactor = new ACE_Reactor(new ACE_Dev_Poll_Reactor(), 1);
+      if (ThreadManager::createThread((ACE_THR_FUNC)ReactorPool::runReactor, (void*)reactor,
+             "MailboxReactorPool", true) == 0)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create reactor pool thread %d",index,0,0,0,0,0);
+         continue;
+      }//end if
+      reactors_.push_back(reactor);
+   }//end for
+
+   TRACELOG(DEBUGLOG, MSGMGRLOG, "Started reactor pool with %d reactors",reactors_.size(),0,0,0,0,0);
+}//end startPool
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Run the event loop of a reactor of the pool
+// Design:      The loop only returns on an error, after which it is restarted
+//-----------------------------------------------------------------------------
+void ReactorPool::runReactor(void* arg)
+{
+   // Convert the void* arg to a Reactor pointer
+   ACE_Reactor* reactor = static_cast<ACE_Reactor*>(arg);
+
+   // Set Reactor thread ownership
+   reactor->owner (ACE_Thread::self ());
+   // Start the reactor processing loop
+   while (reactor->reactor_event_loop_done () == 0)
+   {
+      int result = reactor->run_reactor_event_loop ();
+
+      char errorBuff[200];
+      char* resultStr = strerror_r(errno, errorBuff, strlen(errorBuff));
+      if (resultStr == NULL)
+      {
+         TRACELOG(ERRORLOG, MSGMGRLOG, "Error getting errno string for (%d)",errno,0,0,0,0,0);
+      }//end if
+      ostringstream ostr;
+      ostr << "Reactor pool event loop returned with code (" << result << ") and errno (" << resultStr << ")" << ends;
+      STRACELOG(ERRORLOG, MSGMGRLOG, ostr.str().c_str());
+
+      // Perform reset on the reactor
+      reactor->reset_reactor_event_loop();
+   }//end while
+}//end runReactor
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
+
@@ -0,0 +1,134 @@
+/******************************************************************************
+*
+* File name:   ReactorPool.h
+* Subsystem:   Platform Services
+* Description: Implements the process wide pool of epoll based reactors that
+*              the mailboxes share for their timers and socket IO.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_REACTOR_POOL_H_
+#define _PLAT_REACTOR_POOL_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <vector>
+
+#include <ace/Reactor.h>
+#include <ace/Thread_Mutex.h>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Number of reactors (and threads) in the pool, unless set with setPoolSize */
+#define REACTOR_POOL_DEFAULT_SIZE 4
+
+/** Maximum number of reactors in the pool */
+#define REACTOR_POOL_MAX_SIZE 64
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * ReactorPool is the process wide pool of reactors that run the mailbox
+ * timers and socket IO (the listener and client connections of the
+ * distributed mailboxes, and the group mailbox datagram sockets).
+ * <p>
+ * Each reactor of the pool is an ACE_Dev_Poll_Reactor (epoll on Linux) with
+ * its own thread, so the cost of waiting for events does not grow with the
+ * number of sockets, and a process runs a fixed number of reactor threads
+ * however many mailboxes and connections it has. Reactors are handed out in
+ * turn, which spreads the mailboxes and their connections across the pool.
+ * <p>
+ * The reactors run until the process exits. A handler must therefore be
+ * removed from its reactor (and its timers cancelled) before it is deleted.
+ * Handlers share their reactor thread with others, so they must not block.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class ReactorPool
+{
+   public:
+
+      /**
+       * Set the number of reactors in the pool. Only takes effect before the
+       * pool is started (by the first getReactor).
+       * @returns ERROR if the pool is already started or the size is not valid
+       */
+      static int setPoolSize(unsigned int poolSize);
+
+      /**
+       * Return the next reactor of the pool, starting the pool on first use
+       * @returns NULL if no reactor thread could be started
+       */
+      static ACE_Reactor* getReactor();
+
+   protected:
+
+   private:
+
+      /** Constructor. The pool is only used through its static methods */
+      ReactorPool();
+
+      /** Virtual Destructor */
+      virtual ~ReactorPool();
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      ReactorPool(const ReactorPool& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      ReactorPool& operator= (const ReactorPool& rhs);
+
+      /** Create the reactors and start their threads */
+      static void startPool();
+
+      /** Static invocation method for running the event loop of a reactor */
+      static void runReactor(void* arg);
+
+      /** Reactors of the pool (never removed once started) */
+      static vector<ACE_Reactor*> reactors_;
+
+      /** Number of reactors the pool is started with */
+      static unsigned int poolSize_;
+
+      /** Whether the pool has been started */
+      static bool isStarted_;
+
+      /** Counter used to hand the reactors out in turn */
+      static unsigned int nextReactor_;
+
+      /** Mutex serializing the start of the pool */
+      static ACE_Thread_Mutex poolMutex_;
+};
+
+#endif
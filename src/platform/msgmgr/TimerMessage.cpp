@@ -52,7 +52,13 @@ TimerMessage::TimerMessage(const MailboxAddress& sourceAddress,
                       unsigned int destinationContextId)
                      :ReusableMessageBase(sourceAddress, versionNumber, sourceContextId, destinationContextId),
                       timeout_(timeout),
-                      restartInterval_(restartInterval)
+                      restartInterval_(restartInterval),
+                      wheelNext_(NULL),
+                      wheelPrev_(NULL),
+                      wheelExpiryTick_(0),
+                      wheelSlot_(0),
+                      wheelTimerId_(0),
+                      wheelMailbox_(NULL)
 {
    // Here, we will behave like either a MessageBase or ReusableMessageBase
    // depending on whether a non-default 'RestartInterval' parameter is given to
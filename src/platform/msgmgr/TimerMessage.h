@@ -33,6 +33,9 @@
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
+class MailboxBase;
+class TimerWheel;
+
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
 //
@@ -156,6 +159,9 @@ class TimerMessage : public ReusableMessageBase
 
    private:
 
+      /** The TimerWheel links scheduled timers through the wheel members */
+      friend class TimerWheel;
+
       /** Default Constructor */
       TimerMessage();
 
@@ -171,6 +177,24 @@ class TimerMessage : public ReusableMessageBase
        */
       TimerMessage& operator= (const TimerMessage& rhs);
 
+      /** Next timer in the same TimerWheel slot */
+      TimerMessage* wheelNext_;
+
+      /** Previous timer in the same TimerWheel slot */
+      TimerMessage* wheelPrev_;
+
+      /** TimerWheel tick at which the timer expires next */
+      unsigned long long wheelExpiryTick_;
+
+      /** TimerWheel slot (level * TIMER_WHEEL_SLOTS + slot) the timer is linked into */
+      int wheelSlot_;
+
+      /** Timer Id assigned by the TimerWheel; 0 while not scheduled on a wheel */
+      long wheelTimerId_;
+
+      /** Mailbox the expirations are posted to */
+      MailboxBase* wheelMailbox_;
+
 };
 
 #endif
@@ -0,0 +1,592 @@
+/******************************************************************************
+*
+* File name:   TimerWheel.cpp
+* Subsystem:   Platform Services
+* Description: Implements the hierarchical timing wheel timer service that
+*              mailboxes may use instead of their ACE reactor timer queue.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <climits>
+#include <time.h>
+
+#include <ace/Guard_T.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_unistd.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "TimerWheel.h"
+#include "MailboxBase.h"
+#include "TimerMessage.h"
+
+#include "platform/common/Defines.h"
+
+#include "platform/logger/Logger.h"
+
+#include "platform/threadmgr/ThreadManager.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+// Wheels created so far
+vector<TimerWheel*> TimerWheel::wheels_;
+
+// Mutex for serializing the creation of wheels
+ACE_Thread_Mutex TimerWheel::wheelsMutex_;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return a wheel with the given resolution and at least the given
+//              range, creating it (and its thread) if needed
+// Design:
+//-----------------------------------------------------------------------------
+TimerWheel* TimerWheel::getInstance(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange)
+{
+   if ((resolution <= ACE_Time_Value::zero) || (maxRange < resolution))
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Invalid timer wheel resolution (%d usec) or range (%d sec)",
+         resolution.sec() * 1000000 + resolution.usec(), maxRange.sec(),0,0,0,0);
+      return NULL;
+   }//end if
+
+   ACE_GUARD_RETURN (ACE_Thread_Mutex, ace_mon, wheelsMutex_, NULL);
+
+   for (vector<TimerWheel*>::iterator iterate = wheels_.begin(); iterate != wheels_.end(); iterate++)
+   {
+      if (((*iterate)->resolution_ == resolution) && ((*iterate)->maxRange_ >= maxRange))
+      {
+         return *iterate;
+      }//end if
+   }//end for
+
+   TimerWheel* timerWheel = new TimerWheel(resolution, maxRange);
+   if (timerWheel->levelCount_ > TIMER_WHEEL_MAX_LEVELS)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Timer wheel range (%d sec) is too long for its resolution (%d usec)",
+         maxRange.sec(), resolution.sec() * 1000000 + resolution.usec(),0,0,0,0);
+      delete timerWheel;
+      return NULL;
+   }//end if
+
+   if (ThreadManager::createThread((ACE_THR_FUNC)TimerWheel::runStatic, (void*)timerWheel,
+          "TimerWheel", true) == 0)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Unable to create the timer wheel thread",0,0,0,0,0,0);
+      delete timerWheel;
+      return NULL;
+   }//end if
+
+   wheels_.push_back(timerWheel);
+   return timerWheel;
+}//end getInstance
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Schedule a Timer Message to expire into a mailbox
+// Design:      The timer expires at the first tick that starts after its
+//              timeout has elapsed
+//-----------------------------------------------------------------------------
+long TimerWheel::schedule(MailboxBase* mailboxPtr, TimerMessage* timerMessagePtr)
+{
+   unsigned long long timeoutTicks = toTicks(timerMessagePtr->getTimeout());
+   if (timeoutTicks > maxRangeTicks_)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Timer timeout (%d sec) is beyond the timer wheel range (%d sec)",
+         timerMessagePtr->getTimeout().sec(), maxRange_.sec(),0,0,0,0);
+      return ERROR;
+   }//end if
+
+   ACE_GUARD_RETURN (ACE_Thread_Mutex, ace_mon, wheelMutex_, ERROR);
+
+   if (timerMessagePtr->wheelTimerId_ != 0)
+   {
+      TRACELOG(ERRORLOG, MSGMGRLOG, "Timer message is already scheduled",0,0,0,0,0,0);
+      return ERROR;
+   }//end if
+
+   // Timer Ids are positive, so that they are never mistaken for ERROR (or for
+   // the 0 of an unscheduled timer)
+   lastTimerId_ = (lastTimerId_ == LONG_MAX) ? 1 : (lastTimerId_ + 1);
+
+   timerMessagePtr->wheelTimerId_ = lastTimerId_;
+   timerMessagePtr->wheelMailbox_ = mailboxPtr;
+   timerMessagePtr->wheelExpiryTick_ = getElapsedTicks() + timeoutTicks + 1;
+   insert(timerMessagePtr);
+
+   mailboxPtr->incrementActiveTimers();
+   return lastTimerId_;
+}//end schedule
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Cancel an outstanding Timer Message
+// Design:      Once it is out of the wheel, the Timer Message is disposed of
+//              as the MsgMgr disposes of a handled message
+//-----------------------------------------------------------------------------
+int TimerWheel::cancel(long timerId, TimerMessage* timerMessagePtr)
+{
+   MailboxBase* mailboxPtr = NULL;
+
+   wheelMutex_.acquire();
+   if ((timerId > 0) && (timerMessagePtr->wheelTimerId_ == timerId))
+   {
+      unlink(timerMessagePtr);
+      timerMessagePtr->wheelTimerId_ = 0;
+      mailboxPtr = timerMessagePtr->wheelMailbox_;
+   }//end if
+   wheelMutex_.release();
+
+   if (mailboxPtr == NULL)
+   {
+      return ERROR;
+   }//end if
+
+   mailboxPtr->decrementActiveTimers();
+   timerMessagePtr->deleteMessage();
+   return OK;
+}//end cancel
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Cancel all of the outstanding Timer Messages of a mailbox
+// Design:      The slots of the levels in use are walked under wheelMutex_,
+//              which the wheel thread holds while it expires and posts a tick,
+//              so the mailbox is never posted to once this returns. The Timer
+//              Messages are disposed of once the wheel is released.
+//-----------------------------------------------------------------------------
+int TimerWheel::cancelAll(MailboxBase* mailboxPtr)
+{
+   vector<TimerMessage*> canceled;
+
+   wheelMutex_.acquire();
+   for (int level = 0; level < levelCount_; level++)
+   {
+      for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+      {
+         TimerMessage* timerMessagePtr = slots_[level][slot];
+         while (timerMessagePtr != NULL)
+         {
+            TimerMessage* next = timerMessagePtr->wheelNext_;
+            if (timerMessagePtr->wheelMailbox_ == mailboxPtr)
+            {
+               unlink(timerMessagePtr);
+               timerMessagePtr->wheelTimerId_ = 0;
+               canceled.push_back(timerMessagePtr);
+            }//end if
+            timerMessagePtr = next;
+         }//end while
+      }//end for
+   }//end for
+   wheelMutex_.release();
+
+   for (size_t index = 0; index < canceled.size(); index++)
+   {
+      mailboxPtr->decrementActiveTimers();
+      canceled[index]->deleteMessage();
+   }//end for
+   return (int)canceled.size();
+}//end cancelAll
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Change the restart interval of an outstanding Timer Message
+// Design:      The current expiration is unchanged; the new interval applies
+//              from it on
+//-----------------------------------------------------------------------------
+int TimerWheel::resetInterval(long timerId, TimerMessage* timerMessagePtr, const ACE_Time_Value& newInterval)
+{
+   ACE_GUARD_RETURN (ACE_Thread_Mutex, ace_mon, wheelMutex_, ERROR);
+
+   if ((timerId <= 0) || (timerMessagePtr->wheelTimerId_ != timerId))
+   {
+      return ERROR;
+   }//end if
+
+   timerMessagePtr->restartInterval_ = newInterval;
+   return OK;
+}//end resetInterval
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the wheel resolution
+// Design:
+//-----------------------------------------------------------------------------
+const ACE_Time_Value& TimerWheel::getResolution() const
+{
+   return resolution_;
+}//end getResolution
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the longest timeout the wheel accepts
+// Design:
+//-----------------------------------------------------------------------------
+const ACE_Time_Value& TimerWheel::getMaxRange() const
+{
+   return maxRange_;
+}//end getMaxRange
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:      Enough levels are used to cover twice the maximum range, so a
+//              wheel thread running late never pushes a timer beyond the top
+//              level
+//-----------------------------------------------------------------------------
+TimerWheel::TimerWheel(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange)
+                     : resolution_(resolution),
+                       maxRange_(maxRange),
+                       resolutionUsec_(((unsigned long long)resolution.sec() * 1000000) + resolution.usec()),
+                       maxRangeTicks_(0),
+                       levelCount_(1),
+                       span_(TIMER_WHEEL_SLOTS),
+                       startTime_(getMonotonicTime()),
+                       nextTick_(0),
+                       lastTimerId_(0)
+{
+   maxRangeTicks_ = toTicks(maxRange);
+   while ((span_ <= (2 * (maxRangeTicks_ + 1))) && (levelCount_ <= TIMER_WHEEL_MAX_LEVELS))
+   {
+      levelCount_++;
+      span_ <<= TIMER_WHEEL_SLOT_BITS;
+   }//end while
+
+   for (int level = 0; level < TIMER_WHEEL_MAX_LEVELS; level++)
+   {
+      for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+      {
+         slots_[level][slot] = NULL;
+      }//end for
+   }//end for
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+TimerWheel::~TimerWheel()
+{
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Static method invocation of run
+// Design:
+//-----------------------------------------------------------------------------
+void TimerWheel::runStatic(void* arg)
+{
+   ((TimerWheel*)arg)->run();
+}//end runStatic
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Loop advancing the wheel in step with the clock
+// Design:      Any ticks missed while the thread was not scheduled are caught
+//              up before it sleeps until the start of the next tick
+//-----------------------------------------------------------------------------
+void TimerWheel::run()
+{
+   while (true)
+   {
+      unsigned long long elapsedTicks = getElapsedTicks();
+      if (nextTick_ <= elapsedTicks)
+      {
+         ACE_Time_Value expirationTime = ACE_OS::gettimeofday();
+
+         wheelMutex_.acquire();
+         while (nextTick_ <= elapsedTicks)
+         {
+            runTick(expirationTime);
+         }//end while
+         wheelMutex_.release();
+      }//end if
+
+      unsigned long long nextTickTime = startTime_ + (nextTick_ * resolutionUsec_);
+      unsigned long long now = getMonotonicTime();
+      if (nextTickTime > now)
+      {
+         unsigned long long sleepUsec = nextTickTime - now;
+         ACE_OS::sleep(ACE_Time_Value((time_t)(sleepUsec / 1000000), (suseconds_t)(sleepUsec % 1000000)));
+      }//end if
+   }//end while
+}//end run
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Process the next tick
+// Design:      When level 0 wraps around, the next slot of level 1 is cascaded
+//              into it (and so on up the levels). The expiring slot is then
+//              detached; its recurring timers are linked back in for their next
+//              expiration before all of them are posted.
+//-----------------------------------------------------------------------------
+void TimerWheel::runTick(const ACE_Time_Value& expirationTime)
+{
+   int slot = (int)(nextTick_ & (TIMER_WHEEL_SLOTS - 1));
+   if (slot == 0)
+   {
+      for (int level = 1; level < levelCount_; level++)
+      {
+         int levelSlot = (int)((nextTick_ >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+         cascade(level, levelSlot);
+         if (levelSlot != 0)
+         {
+            break;
+         }//end if
+      }//end for
+   }//end if
+
+   nextTick_++;
+
+   TimerMessage* timerMessagePtr = slots_[0][slot];
+   slots_[0][slot] = NULL;
+   while (timerMessagePtr != NULL)
+   {
+      TimerMessage* next = timerMessagePtr->wheelNext_;
+      expired_.push_back(timerMessagePtr);
+      timerMessagePtr->setExpirationTime(expirationTime);
+
+      if (timerMessagePtr->restartInterval_ > ACE_Time_Value::zero)
+      {
+         unsigned long long intervalTicks = toTicks(timerMessagePtr->restartInterval_);
+         timerMessagePtr->wheelExpiryTick_ += (intervalTicks > 0) ? intervalTicks : 1;
+         insert(timerMessagePtr);
+      }//end if
+      else
+      {
+         timerMessagePtr->wheelTimerId_ = 0;
+         timerMessagePtr->wheelMailbox_->decrementActiveTimers();
+      }//end else
+      timerMessagePtr = next;
+   }//end while
+
+   if (!expired_.empty())
+   {
+      postExpired();
+   }//end if
+}//end runTick
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Move the timers of a slot of an upper level into the levels
+//              below
+// Design:
+//-----------------------------------------------------------------------------
+void TimerWheel::cascade(int level, int slot)
+{
+   TimerMessage* timerMessagePtr = slots_[level][slot];
+   slots_[level][slot] = NULL;
+   while (timerMessagePtr != NULL)
+   {
+      TimerMessage* next = timerMessagePtr->wheelNext_;
+      insert(timerMessagePtr);
+      timerMessagePtr = next;
+   }//end while
+}//end cascade
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Link a timer into the slot for its expiration tick
+// Design:      The level is chosen from the ticks left until the expiration,
+//              and the slot within it from the expiration tick itself, so a
+//              timer always reaches level 0 by cascading before it is due. A
+//              timer that is already due expires on the next tick.
+//-----------------------------------------------------------------------------
+void TimerWheel::insert(TimerMessage* timerMessagePtr)
+{
+   unsigned long long expiryTick = timerMessagePtr->wheelExpiryTick_;
+   if (expiryTick < nextTick_)
+   {
+      expiryTick = nextTick_;
+   }//end if
+   else if ((expiryTick - nextTick_) >= span_)
+   {
+      // Parked in the top level until it is cascaded (which recomputes its place)
+      expiryTick = nextTick_ + span_ - 1;
+   }//end else if
+
+   unsigned long long ticksLeft = expiryTick - nextTick_;
+   int level = 0;
+   while (ticksLeft >= (1ULL << ((level + 1) * TIMER_WHEEL_SLOT_BITS)))
+   {
+      level++;
+   }//end while
+   int slot = (int)((expiryTick >> (level * TIMER_WHEEL_SLOT_BITS)) & (TIMER_WHEEL_SLOTS - 1));
+
+   timerMessagePtr->wheelSlot_ = (level * TIMER_WHEEL_SLOTS) + slot;
+   timerMessagePtr->wheelPrev_ = NULL;
+   timerMessagePtr->wheelNext_ = slots_[level][slot];
+   if (slots_[level][slot] != NULL)
+   {
+      slots_[level][slot]->wheelPrev_ = timerMessagePtr;
+   }//end if
+   slots_[level][slot] = timerMessagePtr;
+}//end insert
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Unlink a timer from its slot
+// Design:
+//-----------------------------------------------------------------------------
+void TimerWheel::unlink(TimerMessage* timerMessagePtr)
+{
+   if (timerMessagePtr->wheelPrev_ != NULL)
+   {
+      timerMessagePtr->wheelPrev_->wheelNext_ = timerMessagePtr->wheelNext_;
+   }//end if
+   else
+   {
+      slots_[timerMessagePtr->wheelSlot_ / TIMER_WHEEL_SLOTS][timerMessagePtr->wheelSlot_ % TIMER_WHEEL_SLOTS] =
+         timerMessagePtr->wheelNext_;
+   }//end else
+   if (timerMessagePtr->wheelNext_ != NULL)
+   {
+      timerMessagePtr->wheelNext_->wheelPrev_ = timerMessagePtr->wheelPrev_;
+   }//end if
+   timerMessagePtr->wheelNext_ = NULL;
+   timerMessagePtr->wheelPrev_ = NULL;
+}//end unlink
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Post the expired timers to their mailboxes, in a batch per
+//              mailbox
+// Design:      Each pass takes the timers of the mailbox of the first timer
+//              left and keeps the others for the next pass. A one-shot timer
+//              may be handled (and deleted) as soon as it is posted, so a
+//              timer is never touched again once it has been posted.
+//-----------------------------------------------------------------------------
+void TimerWheel::postExpired()
+{
+   MessageBase* batch[TIMER_WHEEL_POST_BATCH];
+   size_t remainingCount = expired_.size();
+
+   while (remainingCount > 0)
+   {
+      MailboxBase* mailboxPtr = expired_[0]->wheelMailbox_;
+      int batchCount = 0;
+      size_t keptCount = 0;
+      for (size_t index = 0; index < remainingCount; index++)
+      {
+         TimerMessage* timerMessagePtr = expired_[index];
+         if ((timerMessagePtr->wheelMailbox_ == mailboxPtr) && (batchCount < TIMER_WHEEL_POST_BATCH))
+         {
+            batch[batchCount++] = timerMessagePtr;
+         }//end if
+         else
+         {
+            expired_[keptCount++] = timerMessagePtr;
+         }//end else
+      }//end for
+      remainingCount = keptCount;
+
+      int postedCount = 0;
+      while (postedCount < batchCount)
+      {
+         postedCount += mailboxPtr->postAdmitted(&batch[postedCount], batchCount - postedCount);
+         if (postedCount < batchCount)
+         {
+            // Most likely a recurring timer whose previous expiration is still queued. A
+            // one-shot timer is no longer outstanding, so nothing else disposes of it.
+            TRACELOG(ERRORLOG, MSGMGRLOG, "Error enqueuing timer expiration message to mailbox",0,0,0,0,0,0);
+            TimerMessage* rejectedTimer = (TimerMessage*)batch[postedCount];
+            if (rejectedTimer->wheelTimerId_ == 0)
+            {
+               rejectedTimer->deleteMessage();
+            }//end if
+            postedCount++;
+         }//end if
+      }//end while
+   }//end while
+
+   expired_.clear();
+}//end postExpired
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Convert a time interval into a number of ticks (rounded up)
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long TimerWheel::toTicks(const ACE_Time_Value& interval) const
+{
+   if (interval <= ACE_Time_Value::zero)
+   {
+      return 0;
+   }//end if
+   unsigned long long intervalUsec = ((unsigned long long)interval.sec() * 1000000) + interval.usec();
+   return ((intervalUsec + resolutionUsec_ - 1) / resolutionUsec_);
+}//end toTicks
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of whole ticks elapsed since the wheel started
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long TimerWheel::getElapsedTicks() const
+{
+   return ((getMonotonicTime() - startTime_) / resolutionUsec_);
+}//end getElapsedTicks
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the monotonic clock in microseconds
+// Design:      The wall clock may be stepped, which would stall or rush the
+//              wheel
+//-----------------------------------------------------------------------------
+unsigned long long TimerWheel::getMonotonicTime()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (((unsigned long long)now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}//end getMonotonicTime
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
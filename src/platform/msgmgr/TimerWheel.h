@@ -0,0 +1,232 @@
+/******************************************************************************
+*
+* File name:   TimerWheel.h
+* Subsystem:   Platform Services
+* Description: Implements the hierarchical timing wheel timer service that
+*              mailboxes may use instead of their ACE reactor timer queue.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_TIMER_WHEEL_H_
+#define _PLAT_TIMER_WHEEL_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <vector>
+
+#include <ace/Thread_Mutex.h>
+#include <ace/Time_Value.h>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+class MailboxBase;
+class TimerMessage;
+
+/** Number of bits of the expiration tick used to index each level of the wheel */
+#define TIMER_WHEEL_SLOT_BITS 8
+
+/** Number of slots in each level of the wheel */
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+
+/** Maximum number of levels in a wheel */
+#define TIMER_WHEEL_MAX_LEVELS 4
+
+/** Maximum number of expired timers posted to a mailbox at once */
+#define TIMER_WHEEL_POST_BATCH 64
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * TimerWheel is a hierarchical timing wheel that expires TimerMessages into
+ * their mailboxes. It replaces the ACE reactor timer queue for the mailboxes
+ * whose owner calls MailboxOwnerHandle::useTimerWheel, so that they can hold
+ * millions of outstanding timers.
+ * <p>
+ * Time advances in ticks of the wheel resolution. Level 0 of the wheel has a
+ * slot for each of the next TIMER_WHEEL_SLOTS ticks, and each level above
+ * covers TIMER_WHEEL_SLOTS times the span of the level below; when a level
+ * wraps around, the next slot of the level above is cascaded down. The timers
+ * are linked into the slots through TimerMessage itself, so schedule, cancel
+ * and reset are O(1) and allocate nothing.
+ * <p>
+ * Each wheel has its own thread. On each tick, the timers of the expiring
+ * slot are posted to their mailboxes with one batch per mailbox, and the
+ * recurring ones are linked back into the wheel for their next expiration.
+ * Timers expire at the first tick at or after their timeout, so up to one
+ * resolution late and never early.
+ * <p>
+ * Wheels are shared: the mailboxes asking for the same resolution use the
+ * same wheel (the first one created with at least the maximum range they
+ * need). Wheels live until the process exits.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class TimerWheel
+{
+   public:
+
+      /**
+       * Return a wheel with the given resolution and at least the given range,
+       * creating it (and its thread) if needed
+       * @returns NULL if the resolution or range is not valid
+       */
+      static TimerWheel* getInstance(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange);
+
+      /**
+       * Schedule a Timer Message to expire into a mailbox after its timeout
+       * (and then every restart interval, if it has one)
+       * @returns the timer Id; ERROR if the timeout is beyond the wheel range or
+       *    the Timer Message is already scheduled
+       */
+      long schedule(MailboxBase* mailboxPtr, TimerMessage* timerMessagePtr);
+
+      /**
+       * Cancel an outstanding Timer Message. If it was outstanding, it is
+       * deleted (or released to the OPM) unless it is reusable.
+       * @returns OK if the timer was outstanding; otherwise ERROR
+       */
+      int cancel(long timerId, TimerMessage* timerMessagePtr);
+
+      /**
+       * Cancel all of the outstanding Timer Messages of a mailbox, disposing of
+       * them as cancel does. Called when the mailbox is deactivated or destroyed,
+       * since the wheel outlives its mailboxes.
+       * @returns the number of timers canceled
+       */
+      int cancelAll(MailboxBase* mailboxPtr);
+
+      /**
+       * Change the restart interval of an outstanding Timer Message (zero stops
+       * it from recurring after its next expiration)
+       * @returns OK if the timer was outstanding; otherwise ERROR
+       */
+      int resetInterval(long timerId, TimerMessage* timerMessagePtr, const ACE_Time_Value& newInterval);
+
+      /** Return the wheel resolution */
+      const ACE_Time_Value& getResolution() const;
+
+      /** Return the longest timeout the wheel accepts */
+      const ACE_Time_Value& getMaxRange() const;
+
+   protected:
+
+   private:
+
+      /** Constructor */
+      TimerWheel(const ACE_Time_Value& resolution, const ACE_Time_Value& maxRange);
+
+      /** Virtual Destructor. Wheels are never destroyed */
+      virtual ~TimerWheel();
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      TimerWheel(const TimerWheel& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      TimerWheel& operator= (const TimerWheel& rhs);
+
+      /** Static invocation method for starting run in the wheel thread */
+      static void runStatic(void* arg);
+
+      /** Loop advancing the wheel in step with the clock */
+      void run();
+
+      /** Process the next tick. Called with wheelMutex_ held */
+      void runTick(const ACE_Time_Value& expirationTime);
+
+      /** Move the timers of a slot of an upper level into the levels below */
+      void cascade(int level, int slot);
+
+      /** Link a timer into the slot for its expiration tick */
+      void insert(TimerMessage* timerMessagePtr);
+
+      /** Unlink a timer from its slot */
+      void unlink(TimerMessage* timerMessagePtr);
+
+      /** Post the expired timers to their mailboxes, in a batch per mailbox */
+      void postExpired();
+
+      /** Convert a time interval into a number of ticks (rounded up) */
+      unsigned long long toTicks(const ACE_Time_Value& interval) const;
+
+      /** Return the number of whole ticks elapsed since the wheel started */
+      unsigned long long getElapsedTicks() const;
+
+      /** Return the monotonic clock in microseconds */
+      static unsigned long long getMonotonicTime();
+
+      /** Wheels created so far */
+      static vector<TimerWheel*> wheels_;
+
+      /** Non-recursive Mutex that serializes the creation of wheels */
+      static ACE_Thread_Mutex wheelsMutex_;
+
+      /** Length of a tick */
+      ACE_Time_Value resolution_;
+
+      /** Longest timeout accepted */
+      ACE_Time_Value maxRange_;
+
+      /** Length of a tick in microseconds */
+      unsigned long long resolutionUsec_;
+
+      /** Longest timeout accepted, in ticks */
+      unsigned long long maxRangeTicks_;
+
+      /** Number of levels in use */
+      int levelCount_;
+
+      /** Number of ticks covered by all of the levels in use */
+      unsigned long long span_;
+
+      /** Monotonic clock time at which the wheel started */
+      unsigned long long startTime_;
+
+      /** Next tick to be processed */
+      unsigned long long nextTick_;
+
+      /** Last timer Id assigned */
+      long lastTimerId_;
+
+      /** Timers linked into each slot of each level (NULL if none) */
+      TimerMessage* slots_[TIMER_WHEEL_MAX_LEVELS][TIMER_WHEEL_SLOTS];
+
+      /** Timers expired by the tick being processed */
+      vector<TimerMessage*> expired_;
+
+      /** Non-recursive Mutex that serializes the changes to the wheel */
+      ACE_Thread_Mutex wheelMutex_;
+};
+
+#endif
@@ -17,8 +17,11 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 #include <ace/Task.h>
+#include <ace/OS_NS_sys_time.h>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
@@ -28,6 +31,9 @@
 #include "OPMBase.h"
 #include "ObjectPool.h"
 #include "SyncObjectPool.h"
+#include "OPMNuma.h"
+#include "OPMStats.h"
+#include "OPMThreadCache.h"
 
 // Log Manager related includes.
 #include "platform/logger/Logger.h"
@@ -41,16 +47,49 @@ using namespace std;
 // Static Declarations.
 //-----------------------------------------------------------------------------
 
-/** Vector datastructure for storing Object Pools into -- this is OPM */
-vector<ObjectPool*>* OPM::poolVector_ = NULL;
+/** Append-only table (of blocks) for storing Object Pools into -- this is OPM */
+OPM::PoolBlock* volatile OPM::poolTable_[OPM_MAX_POOL_BLOCKS];
+
+/** Number of Object Pools that have been published in the pool table */
+volatile int OPM::poolCount_ = 0;
 
 /** Non-recursive Mutex that controls insertion into the OPM - Note: deletion of pools
     is not supported */
-ACE_Thread_Mutex OPM::poolVectorMutex_;
+ACE_Thread_Mutex OPM::poolTableMutex_;
+
+/** Per-thread object caches for the thread safe pools that have them enabled */
+ACE_TSS<OPMThreadCache> OPM::threadCache_;
 
 /** Flag for determining if OPM is already initialized */
 bool OPM::isInitialized_ = false;
 
+/** Incremented by shutdown, to invalidate the thread caches of every thread */
+volatile unsigned int OPM::shutdownCount_ = 0;
+
+/** Mutex protecting the maintenance thread state */
+ACE_Thread_Mutex OPM::maintenanceMutex_;
+
+/** Condition used to wake up the maintenance thread */
+ACE_Condition_Thread_Mutex OPM::maintenanceCondition_(OPM::maintenanceMutex_);
+
+/** Period at which the maintenance thread checks the pool watermarks */
+ACE_Time_Value OPM::maintenanceInterval_;
+
+/** Thread Id of the maintenance thread */
+ACE_thread_t OPM::maintenanceThreadId_;
+
+/** Flag set while the maintenance thread is running */
+volatile bool OPM::isMaintenanceRunning_ = false;
+
+/** Flag set when a pool has requested an immediate maintenance pass */
+bool OPM::isMaintenanceRequested_ = false;
+
+/** Flag for constructing the initial objects of new pools on first reserve */
+bool OPM::isLazyConstruction_ = false;
+
+/** Next NUMA node that the calling thread reserves from in interleaved mode */
+static __thread unsigned int opmNextInterleavedNode = 0;
+
 /* From the C++ FAQ, create a module-level identification string using a compile 
    define - BUILD_LABEL must have NO spaces passed in from the make command 
    line */
@@ -74,8 +113,38 @@ bool OPM::initialize()
 {
    if (isInitialized_ == false)
    {
-      //Create the Object Pool Manager (OPM)
-      poolVector_ = new vector<ObjectPool*>();
+      //Clear the Object Pool Manager (OPM) table; its blocks are added as pools
+      // are created, and kept from an earlier initialization
+      poolTableMutex_.acquire();
+      for (int i = 0; i < OPM_MAX_POOL_BLOCKS; i++)
+      {
+         PoolBlock* block = poolTable_[i];
+         if (block == NULL)
+         {
+            continue;
+         }//end if
+         for (int j = 0; j < OPM_POOL_BLOCK_SIZE; j++)
+         {
+            block->pools_[j] = NULL;
+            block->numaModes_[j] = OPM_NUMA_NONE;
+         }//end for
+      }//end for
+      poolCount_ = 0;
+      poolTableMutex_.release();
+
+      // Read the NUMA topology for pools with per-node sub-pools
+      OPMNuma::initialize();
+
+      // Publish the pool statistics for external tools (such as OPMStat)
+      OPMStats::initialize();
+
+      // Allow lazy construction to be turned on for a whole process (for example,
+      // by ProcessManager for the processes that it starts) from the environment
+      char* lazyConstruction = getenv(OPM_LAZY_CONSTRUCTION_ENV);
+      if ((lazyConstruction != NULL) && (strcmp(lazyConstruction, "1") == 0))
+      {
+         setLazyConstruction(true);
+      }//end if
 
       // Set the flag to Initialized=true
       isInitialized_ = true;
@@ -97,26 +166,40 @@ bool OPM::initialize()
 // Method Type: STATIC
 // Description: Method to be called when the node is shutdown. This method will
 //              reset all Objects to NULL
-// Design:     
+// Design:      The table entries are unpublished before the pools are deleted,
+//              so that thread caches flushed at thread exit afterwards simply
+//              drop their (already deleted) objects. The other threads' caches
+//              may still hold objects of the deleted pools under pool IDs that
+//              a later initialize reuses, so shutdownCount_ is incremented to
+//              have each of them discard its contents the next time it is used.
 //-----------------------------------------------------------------------------
 void OPM::shutdown()
 {
    //Print the Summary of statistics for all Object Pools
    printAllPoolsSummary();
-    
-   //traverse the OPM vector and call delete on each pool
-   poolVectorMutex_.acquire();
-   for (unsigned int i = 0; i < poolVector_->size(); i++)
+
+   //The maintenance thread must not be working on a pool as it is deleted
+   stopMaintenanceThread();
+
+   //Return the calling thread's cached objects while the pools still exist
+   flushThreadCache();
+
+   //traverse the OPM table and call delete on each pool
+   poolTableMutex_.acquire();
+   shutdownCount_++;
+   int poolCount = poolCount_;
+   poolCount_ = 0;
+   for (int i = 0; i < poolCount; i++)
    {
-      delete (*poolVector_)[i];
+      PoolBlock* block = poolTable_[i / OPM_POOL_BLOCK_SIZE];
+      ObjectPool* pool = block->pools_[i % OPM_POOL_BLOCK_SIZE];
+      block->pools_[i % OPM_POOL_BLOCK_SIZE] = NULL;
+      __sync_synchronize();
+      delete pool;
    }//end for
-    
-   //delete the OPM vector
-   delete poolVector_;
-   poolVectorMutex_.release();
-
-   //delete the vector protection mutex
-   //delete &poolVectorMutex_;
+   OPMStats::shutdown();
+   isInitialized_ = false;
+   poolTableMutex_.release();
 }//end shutdown
 
 
@@ -125,15 +208,12 @@ void OPM::shutdown()
 // Description: Method for Creating an Object Pool of Array Objects of 
 //              specified size, object Type, Initial Capacity, Capacity 
 //              Increment, and Threshold Percentage.
-// Design:     
+// Design:      See addPool
 //-----------------------------------------------------------------------------
 int OPM::createPool(const char* objectType, long objectInitParam, 
    OPM_INIT_PTR bootStrapMethod, double thresholdPercentage, int capacityIncrement, 
-   int initialSize, bool threadSafe, OPMGrowthModeType growthMode)
+   int initialSize, bool threadSafe, OPMGrowthModeType growthMode, OPMNumaModeType numaMode)
 {
-   int objectPoolID = ERROR;
-   ObjectPool* newPool = NULL;
-
    //verify that the OPM has been initialized
    if (isInitialized_ == false)
    {
@@ -148,64 +228,49 @@ int OPM::createPool(const char* objectType, long objectInitParam,
       return ERROR;
    }//end if   
 
-   //make sure that requested Object Pool name does not exist in the OPM already.
-   // If it does, then we just want to return the ID of the existing pool.
-   if ((objectPoolID = OPM::getObjectPoolID(objectType, objectInitParam)) != ERROR)
-   {
-      ostringstream ostr;
-      ostr <<  "Pool already exists for " << objectType << ". Returning existing Pool ID ("
-           << objectPoolID << ")" << ends;
-      STRACELOG(WARNINGLOG, OPMLOG, ostr.str().c_str());
-
-      return objectPoolID;
-   }//end if
-
-   //Mutex to protect insertion into the vector of object pools
-   poolVectorMutex_.acquire();
+   return addPool(objectType, objectInitParam, bootStrapMethod, NULL, 0,
+      OPM_SLAB_DEFAULT, thresholdPercentage, capacityIncrement, initialSize,
+      threadSafe, growthMode, numaMode);
+}//end createPool
 
-   //get the vector index to be the new objectPoolID
-   objectPoolID = poolVector_->size();
 
-   //create the new Object Pool based on whether or not it should be Thread safe    
-   if (threadSafe)
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method for Creating a slab mode Object Pool whose objects are
+//              constructed in place within contiguous, cache line aligned
+//              blocks of memory.
+// Design:      See OPMSlab
+//-----------------------------------------------------------------------------
+int OPM::createSlabPool(const char* objectType, long objectInitParam,
+   OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, 
+   double thresholdPercentage, int capacityIncrement, int initialSize, 
+   bool threadSafe, OPMGrowthModeType growthMode, int slabOptions, OPMNumaModeType numaMode)
+{
+   //verify that the OPM has been initialized
+   if (isInitialized_ == false)
    {
-      newPool = new SyncObjectPool(objectPoolID, initialSize, thresholdPercentage,
-        capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode);
+      TRACELOG(ERRORLOG, OPMLOG, "OPM has yet to be initialized",0,0,0,0,0,0);
+      return ERROR;
    }//end if
-   else
-   {
-      newPool = new ObjectPool(objectPoolID, initialSize, thresholdPercentage,
-        capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode);
-   }//end else
 
-   //debug log message 
-   if (newPool != NULL)
+   //verify that the placement method used to construct the objects is not NULL
+   if (!placementMethod)
    {
-      //store the new Object Pool in the OPM vector using the objectType 
-      // and return the new PoolID
-      poolVector_->push_back(newPool); 
-
-      //Release vector protection mutex 
-      poolVectorMutex_.release();
+      TRACELOG(ERRORLOG, OPMLOG, "Placement method passed to createSlabPool is NULL",0,0,0,0,0,0);
+      return ERROR;
+   }//end if   
 
-      //successfully created and populated the pool
-      ostringstream ostr;
-      ostr << "Object Pool successfully created for " << objectType << ends;
-      STRACELOG(DEBUGLOG, OPMLOG, ostr.str().c_str());
-      return objectPoolID;
-   }//end if
-   else
+   //verify that the objects will fit into their slab slots
+   if (objectSize < sizeof(OPMBase))
    {
-      //Release vector protection mutex
-      poolVectorMutex_.release();
-
-      //successfully created and populated the pool
-      ostringstream ostr;
-      ostr << "Error Creating Object Pool for " << objectType << " objects" << ends;
-      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+      TRACELOG(ERRORLOG, OPMLOG, "Object size (%d) passed to createSlabPool is invalid",objectSize,0,0,0,0,0);
       return ERROR;
-   }//end else
-}//end createPool
+   }//end if   
+
+   return addPool(objectType, objectInitParam, NULL, placementMethod, objectSize,
+      slabOptions, thresholdPercentage, capacityIncrement, initialSize,
+      threadSafe, growthMode, numaMode);
+}//end createSlabPool
   
 
 //-----------------------------------------------------------------------------
@@ -216,23 +281,7 @@ int OPM::createPool(const char* objectType, long objectInitParam,
 //-----------------------------------------------------------------------------
 bool OPM::isPoolCreated(const char* objectType, long objectInitParam)
 {
-   bool result = false;
-
-   poolVectorMutex_.acquire();
-
-   for (unsigned int i = 0; i < poolVector_->size(); i++)
-   {
-      //check for both the objectType and the initializer
-      if ((strcmp(objectType, (*poolVector_)[i]->getObjectType()) == 0) &&
-          (objectInitParam == (*poolVector_)[i]->getObjectInitParam()))
-      {
-         result = true;
-         break;
-      }//end if
-   }//end for
-
-   poolVectorMutex_.release();
-   return result;
+   return (getObjectPoolID(objectType, objectInitParam) != ERROR);
 }//end isPoolCreated
 
 
@@ -240,24 +289,28 @@ bool OPM::isPoolCreated(const char* objectType, long objectInitParam)
 // Method Type: STATIC
 // Description: Method to return the Object Pool ID for an existing object Pool.
 //              Returns ERROR if the object pool does not exist.
-// Design:
+// Design:      Walks the published portion of the table without locking
 //-----------------------------------------------------------------------------
 int OPM::getObjectPoolID(const char* objectType, long objectInitParam)
 {
-   poolVectorMutex_.acquire();
+   int poolCount = poolCount_;
 
-   for (unsigned int i = 0; i < poolVector_->size(); i++)
+   for (int i = 0; i < poolCount; i++)
    {
+      ObjectPool* pool = getTableEntry(i);
+      if (pool == NULL)
+      {
+         continue;
+      }//end if
+
       //check for both the objectType and the initializer
-      if ((strcmp(objectType, (*poolVector_)[i]->getObjectType()) == 0) &&
-          (objectInitParam == (*poolVector_)[i]->getObjectInitParam()))
+      if ((strcmp(objectType, pool->getObjectType()) == 0) &&
+          (objectInitParam == pool->getObjectInitParam()))
       {
-         poolVectorMutex_.release();
          return i;
       }//end if
    }//end for
 
-   poolVectorMutex_.release();
    return ERROR;
 }//end getObjectPoolID
 
@@ -266,23 +319,12 @@ int OPM::getObjectPoolID(const char* objectType, long objectInitParam)
 // Method Type: STATIC
 // Description: Method to retrieve an object from a specified pool being
 //              managed within OPM.
-// Design:     
+// Design:      See reserveFromPool and reserveNumaObject
 //-----------------------------------------------------------------------------
 OPMBase* OPM::reserveObject(int objectPoolID, bool blockWaitingForAccess)
 {
-   poolVectorMutex_.acquire();
-
-   //check the poolID
-   if (objectPoolID > ((int)(poolVector_->size()) - 1))
-   { 
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return NULL;
-   }//end if
-
    //attempt to get the specified pool from OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(objectPoolID);
 
    //generate an ERROR msg if the get operation returns 'NULL'
    if (pool == NULL)
@@ -291,11 +333,12 @@ OPMBase* OPM::reserveObject(int objectPoolID, bool blockWaitingForAccess)
       return NULL;
    }//end if
 
-   //retrieve a free object from the specified pool to return to the user - Note
-   // that ObjectPool->reserve already returns an OPMBase type object. Check to see
-   // if the user is requesting a non-blocking call
-   OPMBase* object =  pool->reserve(blockWaitingForAccess);
-   return object; 
+   //pools with NUMA sub-pools pick the sub-pool to reserve from
+   if (getNumaMode(objectPoolID) != OPM_NUMA_NONE)
+   {
+      return reserveNumaObject(objectPoolID, blockWaitingForAccess);
+   }//end if
+   return reserveFromPool(pool, blockWaitingForAccess);
 }//end reserveObject
 
 
@@ -303,7 +346,8 @@ OPMBase* OPM::reserveObject(int objectPoolID, bool blockWaitingForAccess)
 // Method Type: STATIC
 // Description: Method for releasing objects back into the OPM pool
 //              after they are no longer in-use.
-// Design:     
+// Design:      If the pool has thread caches enabled, the object is placed in
+//              the calling thread's cache (drained in a batch when full)
 //-----------------------------------------------------------------------------
 bool OPM::releaseObject(OPMBase* object, const char* callingFileName, 
    int callingLineNumb)
@@ -331,12 +375,8 @@ bool OPM::releaseObject(OPMBase* object, const char* callingFileName,
       return false;
    }//end if
 
-   poolVectorMutex_.acquire();
-
    //retrieve the pool from the OPM
-   ObjectPool* pool = (*poolVector_)[poolId];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(poolId);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -350,7 +390,11 @@ bool OPM::releaseObject(OPMBase* object, const char* callingFileName,
       return false;
    }//end if
     
-   //release the object back into the pool
+   //release the object back into the pool (or the thread's cache for the pool)
+   if (pool->getThreadCacheSize() > 0)
+   {
+      return threadCache_->release(pool, object, callingFileName, callingLineNumb);
+   }//end if
    bool result = pool->release(object, callingFileName, callingLineNumb);
    return result;
 }//end releaseObject
@@ -359,8 +403,7 @@ bool OPM::releaseObject(OPMBase* object, const char* callingFileName,
 //-----------------------------------------------------------------------------
 // Method Type: STATIC
 // Description: Method to test if an Object was created by the OPM.
-// Design: Remember that for this to be called from Multiple threads, the 
-//    object pool must be thread safe     
+// Design: Constant time check of the object's own pool ID and ownership state
 //-----------------------------------------------------------------------------
 bool OPM::isCreatedByOPM(OPMBase* object)
 {
@@ -371,12 +414,8 @@ bool OPM::isCreatedByOPM(OPMBase* object)
       return false;
    }//end if
 
-   poolVectorMutex_.acquire();
- 
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[poolId];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(poolId);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -402,15 +441,6 @@ bool OPM::isCreatedByOPM(OPMBase* object)
 //-----------------------------------------------------------------------------
 bool OPM::setPoolCapacityIncrement(int objectPoolID, int capacityIncrement)
 {
-   poolVectorMutex_.acquire();
-
-   //check the poolID
-   if (objectPoolID > (((int)poolVector_->size()) - 1))
-   {
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return false;
-   }//end if
-
    //check for a valid capacity increment; otherwise generate a ERROR
    if (capacityIncrement <= 0)
    {
@@ -419,9 +449,7 @@ bool OPM::setPoolCapacityIncrement(int objectPoolID, int capacityIncrement)
    }//end if
 
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(objectPoolID);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -431,33 +459,210 @@ bool OPM::setPoolCapacityIncrement(int objectPoolID, int capacityIncrement)
       return false;
    }//end if
 
-   //set the capacity Increment in the pool - DOES THIS NEED TO BE THREAD PROTECTED
-   pool->setCapacityIncrement(capacityIncrement);
+   //set the capacity Increment in the pool (thread safe pools protect this),
+   // and in each of its NUMA sub-pools
+   for (int i = 0; i < getSubPoolCount(objectPoolID); i++)
+   {
+      getTableEntry(objectPoolID + i)->setCapacityIncrement(capacityIncrement);
+   }//end for
    return true;
 }//end setPoolIncrementPercentage
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method enables (or disables) the per-thread object caches in
+//              front of a thread safe Object Pool.
+// Design:     
+//-----------------------------------------------------------------------------
+bool OPM::setPoolThreadCacheSize(int objectPoolID, int cacheSize)
+{
+   //check for a valid cache size; otherwise generate a ERROR
+   if (cacheSize < 0)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Thread Cache Size %d is not valid", cacheSize, 0,0,0,0,0);
+      return false;
+   }//end if
+
+   //get the correct Pool from the OPM
+   ObjectPool* pool = lookupPool(objectPoolID);
+
+   //check to make sure the Pool has been stored in the OPM
+   if (pool == NULL)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Object Pool ID %d does not exist in OPM", objectPoolID, 0,0,0,0,0);
+      return false;
+   }//end if
+
+   //only thread safe pools support the thread caches
+   bool result = true;
+   for (int i = 0; i < getSubPoolCount(objectPoolID); i++)
+   {
+      result &= getTableEntry(objectPoolID + i)->setThreadCacheSize(cacheSize);
+   }//end for
+   return result;
+}//end setPoolThreadCacheSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method returns all of the objects held in the calling thread's
+//              object caches back into their shared pools.
+// Design:     
+//-----------------------------------------------------------------------------
+void OPM::flushThreadCache()
+{
+   // Avoid allocating a cache for threads that have never used one
+   OPMThreadCache* threadCache = threadCache_.ts_object();
+   if (threadCache != NULL)
+   {
+      threadCache->flushAll();
+   }//end if
+}//end flushThreadCache
   
   
 //-----------------------------------------------------------------------------
 // Method Type: STATIC
-// Description: Get the Pool Capacity Increment value which is the number of
-//              objects to add to the pool when the threshold value is reached.
+// Description: Method selects lazy or eager construction for the initial
+//              capacity of pools created from now on
 // Design:     
 //-----------------------------------------------------------------------------
-int OPM::getPoolCapacityIncrement(int objectPoolID)
+void OPM::setLazyConstruction(bool lazyConstruction)
 {
-   poolVectorMutex_.acquire();
+   poolTableMutex_.acquire();
+   isLazyConstruction_ = lazyConstruction;
+   poolTableMutex_.release();
+   TRACELOG(DEBUGLOG, OPMLOG, "OPM lazy construction set to %d", lazyConstruction,0,0,0,0,0);
+}//end setLazyConstruction
 
-   //check the poolID
-   if (objectPoolID > (((int)poolVector_->size()) - 1))
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return true if new pools construct their initial objects on
+//              first reserve
+// Design:     
+//-----------------------------------------------------------------------------
+bool OPM::isLazyConstruction()
+{
+   return isLazyConstruction_;
+}//end isLazyConstruction
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method starts the OPM maintenance thread
+// Design:      The thread is joinable so that shutdown can wait for it to
+//              finish its current pass before the pools are deleted
+//-----------------------------------------------------------------------------
+bool OPM::startMaintenanceThread(int intervalMsec)
+{
+   //check for a valid interval; otherwise generate a ERROR
+   if (intervalMsec <= 0)
    {
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return ERROR;
+      TRACELOG(ERRORLOG, OPMLOG, "Maintenance interval %d msec is not valid", intervalMsec, 0,0,0,0,0);
+      return false;
+   }//end if
+
+   maintenanceMutex_.acquire();
+   maintenanceInterval_.msec(intervalMsec);
+   if (isMaintenanceRunning_ == true)
+   {
+      maintenanceMutex_.release();
+      return true;
+   }//end if
+
+   isMaintenanceRunning_ = true;
+   isMaintenanceRequested_ = false;
+   if (ACE_Thread_Manager::instance()->spawn((ACE_THR_FUNC)OPM::runMaintenanceThread, 0,
+       THR_NEW_LWP | THR_JOINABLE, &maintenanceThreadId_) == ERROR)
+   {
+      isMaintenanceRunning_ = false;
+      maintenanceMutex_.release();
+      TRACELOG(ERRORLOG, OPMLOG, "Unable to spawn the OPM maintenance thread", 0,0,0,0,0,0);
+      return false;
+   }//end if
+   maintenanceMutex_.release();
+
+   TRACELOG(DEBUGLOG, OPMLOG, "OPM maintenance thread started (interval %d msec)", intervalMsec,0,0,0,0,0);
+   return true;
+}//end startMaintenanceThread
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method stops the OPM maintenance thread
+// Design:     
+//-----------------------------------------------------------------------------
+void OPM::stopMaintenanceThread()
+{
+   maintenanceMutex_.acquire();
+   if (isMaintenanceRunning_ == false)
+   {
+      maintenanceMutex_.release();
+      return;
+   }//end if
+   isMaintenanceRunning_ = false;
+   maintenanceCondition_.signal();
+   maintenanceMutex_.release();
+
+   ACE_Thread_Manager::instance()->join(maintenanceThreadId_);
+   TRACELOG(DEBUGLOG, OPMLOG, "OPM maintenance thread stopped", 0,0,0,0,0,0);
+}//end stopMaintenanceThread
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Method hands the growing and shrinking of a thread safe Object
+//              Pool over to the OPM maintenance thread (or takes it back)
+// Design:     
+//-----------------------------------------------------------------------------
+bool OPM::setPoolBackgroundMaintenance(int objectPoolID, bool enable, int shrinkDelaySeconds)
+{
+   //check for a valid shrink delay; otherwise generate a ERROR
+   if (shrinkDelaySeconds < 0)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Shrink delay %d is not valid", shrinkDelaySeconds, 0,0,0,0,0);
+      return false;
    }//end if
 
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
+   ObjectPool* pool = lookupPool(objectPoolID);
 
-   poolVectorMutex_.release();
+   //check to make sure the Pool has been stored in the OPM
+   if (pool == NULL)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Object Pool ID %d does not exist in OPM", objectPoolID, 0,0,0,0,0);
+      return false;
+   }//end if
+
+   //make sure there is a thread to hand the pool to
+   if ((enable == true) && (isMaintenanceRunning_ == false) &&
+       (startMaintenanceThread() == false))
+   {
+      return false;
+   }//end if
+
+   //only thread safe pools support background maintenance
+   bool result = true;
+   for (int i = 0; i < getSubPoolCount(objectPoolID); i++)
+   {
+      result &= getTableEntry(objectPoolID + i)->setBackgroundMaintenance(enable,
+         ACE_Time_Value(shrinkDelaySeconds));
+   }//end for
+   return result;
+}//end setPoolBackgroundMaintenance
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Get the Pool Capacity Increment value which is the number of
+//              objects to add to the pool when the threshold value is reached.
+// Design:     
+//-----------------------------------------------------------------------------
+int OPM::getPoolCapacityIncrement(int objectPoolID)
+{
+   //get the correct Pool from the OPM
+   ObjectPool* pool = lookupPool(objectPoolID);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -481,19 +686,8 @@ int OPM::getPoolCapacityIncrement(int objectPoolID)
 //-----------------------------------------------------------------------------
 double OPM::getPoolThresholdPercentage(int objectPoolID)
 {
-   poolVectorMutex_.acquire();
-
-   //check the poolID
-   if (objectPoolID > (((int)poolVector_->size()) - 1))
-   {
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return 0.0;
-   }//end if
-
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(objectPoolID);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -515,19 +709,8 @@ double OPM::getPoolThresholdPercentage(int objectPoolID)
 //-----------------------------------------------------------------------------
 int OPM::getPoolObjectInitParam(int objectPoolID)
 {
-   poolVectorMutex_.acquire();
-
-   //check the poolID
-   if (objectPoolID > (((int)poolVector_->size()) - 1))
-   {
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return ERROR;
-   }//end if
-
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(objectPoolID);
 
    //check to make sure the Pool has been stored in the OPM for this object
    //generate an ERROR msg if the get operation returns 'NULL'
@@ -551,17 +734,20 @@ int OPM::getPoolObjectInitParam(int objectPoolID)
 //-----------------------------------------------------------------------------
 void OPM::printAllPoolsSummary()
 {
-   poolVectorMutex_.acquire();
+   int poolCount = poolCount_;
+
    //print the total number of pools being managed by the OPM
-   // (use %zd for printing size_t types)
-   printf("Total Pools managed by OPM: %zd\n", poolVector_->size());
+   printf("Total Pools managed by OPM: %d\n", poolCount);
     
-   //traverse the OPM vector and call printUsageSummary on each pool
-   for (unsigned int i = 0; i < poolVector_->size(); i++)
+   //traverse the OPM table and call printUsageSummary on each pool
+   for (int i = 0; i < poolCount; i++)
    {
-      (*poolVector_)[i]->printUsageSummary();
+      ObjectPool* pool = getTableEntry(i);
+      if (pool != NULL)
+      {
+         pool->printUsageSummary();
+      }//end if
    }//end for
-   poolVectorMutex_.release();
 }//end printAllPoolsSummary
 
 
@@ -572,18 +758,8 @@ void OPM::printAllPoolsSummary()
 //-----------------------------------------------------------------------------
 void OPM::printPoolSummary(int objectPoolID)
 {
-   poolVectorMutex_.acquire();
-   //check the poolID
-   if (objectPoolID > (((int)poolVector_->size()) - 1))
-   {
-      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID",0,0,0,0,0,0);
-      return;
-   }//end if
-
    //get the correct Pool from the OPM
-   ObjectPool* pool = (*poolVector_)[objectPoolID];
-
-   poolVectorMutex_.release();
+   ObjectPool* pool = lookupPool(objectPoolID);
     
    //check to make sure the Pool has been stored in the OPM for this object
    //generate a ERROR msg if the get operation returns 'NULL'
@@ -593,7 +769,10 @@ void OPM::printPoolSummary(int objectPoolID)
       return;
    }//end if
     
-   pool->printUsageSummary();
+   for (int i = 0; i < getSubPoolCount(objectPoolID); i++)
+   {
+      getTableEntry(objectPoolID + i)->printUsageSummary();
+   }//end for
 }//end printPoolSummary
 
 
@@ -602,28 +781,33 @@ void OPM::printPoolSummary(int objectPoolID)
 // Description: Method tests all of the pools and prints the statistics per 
 //              Object Pool for objects which HAVE NOT been properly 
 //              returned/released into the OPM.
-// Design:     
+// Design:      Objects parked in thread caches have been released by the
+//              application, so they are not reported.
 //-----------------------------------------------------------------------------
 void OPM::checkForUnreleasedObjects()
 {
    //print that we are checking for unreleased objects
    TRACELOG(DEBUGLOG, OPMLOG, "Checking for Objects NOT properly released into OPM",0,0,0,0,0,0);
       
-   poolVectorMutex_.acquire();
+   int poolCount = poolCount_;
 
-   //traverse the OPM vector and check for unreleased objects in the Used Pool
-   for (unsigned int i = 0; i < poolVector_->size(); i++)
+   //traverse the OPM table and check for unreleased objects in the Used Pool
+   for (int i = 0; i < poolCount; i++)
    {
-      ObjectPool* pool = (*poolVector_)[i];
-      if (pool->getCurrentUsedObjects() > 0)
+      ObjectPool* pool = getTableEntry(i);
+      if (pool == NULL)
+      {
+         continue;
+      }//end if
+
+      int unreleasedObjects = pool->getCurrentUsedObjects() - pool->getCurrentCachedObjects();
+      if (unreleasedObjects > 0)
       {
          ostringstream ostr;
-         ostr <<  "Pool (" << pool->getObjectType() << ") with Current Capacity = " << pool->getCurrentCapacity() << " has " << pool->getCurrentUsedObjects() << " Unreleased objects" << ends;
+         ostr <<  "Pool (" << pool->getObjectType() << ") with Current Capacity = " << pool->getCurrentCapacity() << " has " << unreleasedObjects << " Unreleased objects" << ends;
          STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
       }//end if
    }//end for
-
-   poolVectorMutex_.release();
 }//end checkForUnreleasedObjects
 
 //-----------------------------------------------------------------------------
@@ -634,6 +818,369 @@ void OPM::checkForUnreleasedObjects()
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Common implementation of createPool and createSlabPool
+// Design:      The new pool is fully constructed before a memory barrier and
+//              only then stored into the table, so lock-free readers never
+//              see a partially built pool. NUMA sub-pools are each built by
+//              this thread bound to their node, so that the node's memory is
+//              first touched there, and take consecutive pool IDs.
+//-----------------------------------------------------------------------------
+int OPM::addPool(const char* objectType, long objectInitParam,
+   OPM_INIT_PTR bootStrapMethod, OPM_PLACEMENT_INIT_PTR placementMethod,
+   size_t objectSize, int slabOptions, double thresholdPercentage,
+   int capacityIncrement, int initialSize, bool threadSafe,
+   OPMGrowthModeType growthMode, OPMNumaModeType numaMode)
+{
+   int objectPoolID = ERROR;
+   ObjectPool* newPools[OPM_MAX_NUMA_NODES];
+
+   //a single node machine has nothing to place, and only thread safe pools may
+   // be reserved from by the threads of every node
+   int subPoolCount = OPMNuma::getNodeCount();
+   if ((numaMode == OPM_NUMA_NONE) || (subPoolCount <= 1))
+   {
+      numaMode = OPM_NUMA_NONE;
+      subPoolCount = 1;
+   }//end if
+   else
+   {
+      threadSafe = true;
+      initialSize = (initialSize + subPoolCount - 1) / subPoolCount;
+   }//end else
+
+   //Mutex to protect insertion into the table of object pools
+   poolTableMutex_.acquire();
+
+   //make sure that requested Object Pool name does not exist in the OPM already.
+   // If it does, then we just want to return the ID of the existing pool. This is
+   // checked while holding the mutex so that two threads cannot both create it.
+   if ((objectPoolID = OPM::getObjectPoolID(objectType, objectInitParam)) != ERROR)
+   {
+      poolTableMutex_.release();
+
+      ostringstream ostr;
+      ostr <<  "Pool already exists for " << objectType << ". Returning existing Pool ID ("
+           << objectPoolID << ")" << ends;
+      STRACELOG(WARNINGLOG, OPMLOG, ostr.str().c_str());
+
+      return objectPoolID;
+   }//end if
+
+   //get the table index to be the new objectPoolID
+   objectPoolID = poolCount_;
+   if ((objectPoolID + subPoolCount) > OPM_MAX_POOLS)
+   {
+      poolTableMutex_.release();
+      TRACELOG(ERRORLOG, OPMLOG, "Maximum number of Object Pools (%d) already created", OPM_MAX_POOLS,0,0,0,0,0);
+      return ERROR;
+   }//end if
+
+   //add the blocks of the pool table that the new pool IDs fall into. A block
+   // is cleared before it is published, like the pools themselves.
+   for (int blockIndex = (objectPoolID / OPM_POOL_BLOCK_SIZE);
+        blockIndex <= ((objectPoolID + subPoolCount - 1) / OPM_POOL_BLOCK_SIZE); blockIndex++)
+   {
+      if (poolTable_[blockIndex] == NULL)
+      {
+         PoolBlock* block = new PoolBlock();
+         for (int j = 0; j < OPM_POOL_BLOCK_SIZE; j++)
+         {
+            block->pools_[j] = NULL;
+            block->numaModes_[j] = OPM_NUMA_NONE;
+         }//end for
+         __sync_synchronize();
+         poolTable_[blockIndex] = block;
+      }//end if
+   }//end for
+
+   //create the new Object Pool (or one sub-pool on each NUMA node)
+   int createdCount = 0;
+   for (; createdCount < subPoolCount; createdCount++)
+   {
+      cpu_set_t previousCpus;
+      bool isBound = ((numaMode != OPM_NUMA_NONE) && OPMNuma::bindToNode(createdCount, &previousCpus));
+
+      newPools[createdCount] = constructPool(objectPoolID + createdCount, objectType, objectInitParam,
+         bootStrapMethod, placementMethod, objectSize, slabOptions, thresholdPercentage,
+         capacityIncrement, initialSize, threadSafe, growthMode);
+      if ((newPools[createdCount] != NULL) && (numaMode != OPM_NUMA_NONE))
+      {
+         newPools[createdCount]->setNumaNode(createdCount);
+      }//end if
+
+      if (isBound)
+      {
+         OPMNuma::restoreBinding(&previousCpus);
+      }//end if
+      if (newPools[createdCount] == NULL)
+      {
+         break;
+      }//end if
+   }//end for
+
+   //debug log message 
+   if (createdCount == subPoolCount)
+   {
+      //make sure the pool construction is visible to other threads before
+      // publishing it, then store the new Object Pool(s) in the OPM table and
+      // return the new PoolID
+      poolTable_[objectPoolID / OPM_POOL_BLOCK_SIZE]->numaModes_[objectPoolID % OPM_POOL_BLOCK_SIZE] = numaMode;
+      __sync_synchronize();
+      for (int i = 0; i < subPoolCount; i++)
+      {
+         int poolID = objectPoolID + i;
+         poolTable_[poolID / OPM_POOL_BLOCK_SIZE]->pools_[poolID % OPM_POOL_BLOCK_SIZE] = newPools[i];
+      }//end for
+      __sync_synchronize();
+      poolCount_ = objectPoolID + subPoolCount;
+
+      //Release table protection mutex 
+      poolTableMutex_.release();
+
+      //successfully created and populated the pool
+      ostringstream ostr;
+      ostr << "Object Pool successfully created for " << objectType;
+      if (numaMode != OPM_NUMA_NONE)
+      {
+         ostr << " with " << subPoolCount << " NUMA sub-pools";
+      }//end if
+      ostr << ends;
+      STRACELOG(DEBUGLOG, OPMLOG, ostr.str().c_str());
+      return objectPoolID;
+   }//end if
+   else
+   {
+      //delete any sub-pools that were built before the failure
+      for (int i = 0; i < createdCount; i++)
+      {
+         delete newPools[i];
+      }//end for
+
+      //Release table protection mutex
+      poolTableMutex_.release();
+
+      //successfully created and populated the pool
+      ostringstream ostr;
+      ostr << "Error Creating Object Pool for " << objectType << " objects" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+      return ERROR;
+   }//end else
+}//end addPool
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Construct (but do not publish) one pool or NUMA sub-pool
+// Design:      
+//-----------------------------------------------------------------------------
+ObjectPool* OPM::constructPool(int objectPoolID, const char* objectType,
+   long objectInitParam, OPM_INIT_PTR bootStrapMethod,
+   OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, int slabOptions,
+   double thresholdPercentage, int capacityIncrement, int initialSize,
+   bool threadSafe, OPMGrowthModeType growthMode)
+{
+   //create the new Object Pool based on whether or not it should be Thread safe    
+   if (threadSafe)
+   {
+      return new SyncObjectPool(objectPoolID, initialSize, thresholdPercentage,
+        capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode,
+        placementMethod, objectSize, slabOptions, isLazyConstruction_);
+   }//end if
+   else
+   {
+      return new ObjectPool(objectPoolID, initialSize, thresholdPercentage,
+        capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode,
+        placementMethod, objectSize, slabOptions, isLazyConstruction_);
+   }//end else
+}//end constructPool
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Reserve an object from a pool (or its thread cache)
+// Design:      If the pool has thread caches enabled, the object is taken
+//              from the calling thread's cache (refilled in a batch when empty)
+//-----------------------------------------------------------------------------
+OPMBase* OPM::reserveFromPool(ObjectPool* pool, bool blockWaitingForAccess)
+{
+   //retrieve a free object from the specified pool to return to the user - Note
+   // that ObjectPool->reserve already returns an OPMBase type object. Check to see
+   // if the user is requesting a non-blocking call
+   if (pool->getThreadCacheSize() > 0)
+   {
+      return threadCache_->reserve(pool, blockWaitingForAccess);
+   }//end if
+   OPMBase* object =  pool->reserve(blockWaitingForAccess);
+   return object; 
+}//end reserveFromPool
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Reserve an object from the NUMA sub-pools of a pool
+// Design:      Exhaustion is checked without the sub-pool lock, so a remote
+//              node is only used once the local one has really run dry (a
+//              GROWTH_ALLOWED sub-pool grows before that). The last sub-pool
+//              tried is always reserved from, so that its usual error is
+//              reported if every node is exhausted.
+//-----------------------------------------------------------------------------
+OPMBase* OPM::reserveNumaObject(int objectPoolID, bool blockWaitingForAccess)
+{
+   int nodeCount = OPMNuma::getNodeCount();
+   int firstNode = 0;
+   if (getNumaMode(objectPoolID) == OPM_NUMA_LOCAL)
+   {
+      firstNode = OPMNuma::getCurrentNode();
+   }//end if
+   else
+   {
+      firstNode = (int)(opmNextInterleavedNode++ % (unsigned int)nodeCount);
+   }//end else
+
+   for (int i = 0; i < nodeCount; i++)
+   {
+      ObjectPool* pool = getTableEntry(objectPoolID + ((firstNode + i) % nodeCount));
+      if ((i < (nodeCount - 1)) && pool->isExhausted())
+      {
+         continue;
+      }//end if
+      return reserveFromPool(pool, blockWaitingForAccess);
+   }//end for
+   return NULL;
+}//end reserveNumaObject
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the number of pools that make up a pool
+// Design:      
+//-----------------------------------------------------------------------------
+int OPM::getSubPoolCount(int objectPoolID)
+{
+   if (getNumaMode(objectPoolID) == OPM_NUMA_NONE)
+   {
+      return 1;
+   }//end if
+   return OPMNuma::getNodeCount();
+}//end getSubPoolCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the Object Pool for the specified pool ID without taking
+//              any lock.
+// Design:      Table entries are written once (after a memory barrier) and
+//              the pool is reached through the loaded pointer, so a non-NULL
+//              entry always refers to a fully constructed pool.
+//-----------------------------------------------------------------------------
+ObjectPool* OPM::lookupPool(int objectPoolID)
+{
+   //check the poolID
+   if ((objectPoolID < 0) || (objectPoolID >= OPM_MAX_POOLS))
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Invalid object poolID %d", objectPoolID,0,0,0,0,0);
+      return NULL;
+   }//end if
+
+   return getTableEntry(objectPoolID);
+}//end lookupPool
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the Object Pool stored in the pool table for the
+//              specified pool ID, without checking the ID or logging
+// Design:      A block is only published once cleared, and is never freed
+//-----------------------------------------------------------------------------
+ObjectPool* OPM::getTableEntry(int objectPoolID)
+{
+   PoolBlock* block = poolTable_[objectPoolID / OPM_POOL_BLOCK_SIZE];
+   if (block == NULL)
+   {
+      return NULL;
+   }//end if
+   return block->pools_[objectPoolID % OPM_POOL_BLOCK_SIZE];
+}//end getTableEntry
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the NUMA mode of the specified pool ID
+// Design:      Only called for pool IDs that lookupPool has found, whose
+//              block therefore exists
+//-----------------------------------------------------------------------------
+OPMNumaModeType OPM::getNumaMode(int objectPoolID)
+{
+   return poolTable_[objectPoolID / OPM_POOL_BLOCK_SIZE]->numaModes_[objectPoolID % OPM_POOL_BLOCK_SIZE];
+}//end getNumaMode
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Wake the maintenance thread so that it performs a pass now
+// Design:      Called with the requesting pool's lock held; the maintenance
+//              thread never holds maintenanceMutex_ while taking a pool lock,
+//              so the lock ordering is always pool lock first.
+//-----------------------------------------------------------------------------
+void OPM::requestMaintenance()
+{
+   maintenanceMutex_.acquire();
+   if (isMaintenanceRequested_ == false)
+   {
+      isMaintenanceRequested_ = true;
+      maintenanceCondition_.signal();
+   }//end if
+   maintenanceMutex_.release();
+}//end requestMaintenance
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Maintenance thread main loop
+// Design:      The pool table is append-only and pools are only deleted by
+//              shutdown (after this thread is joined), so the table is walked
+//              without holding poolTableMutex_.
+//-----------------------------------------------------------------------------
+ACE_THR_FUNC_RETURN OPM::runMaintenanceThread(void* arg)
+{
+   ACE_UNUSED_ARG(arg);
+
+   maintenanceMutex_.acquire();
+   while (isMaintenanceRunning_ == true)
+   {
+      //sleep until the end of the interval unless a pool has asked for a pass
+      if (isMaintenanceRequested_ == false)
+      {
+         ACE_Time_Value wakeupTime = ACE_OS::gettimeofday();
+         wakeupTime += maintenanceInterval_;
+         maintenanceCondition_.wait(&wakeupTime);
+      }//end if
+      isMaintenanceRequested_ = false;
+      if (isMaintenanceRunning_ == false)
+      {
+         break;
+      }//end if
+      maintenanceMutex_.release();
+
+      ACE_Time_Value now = ACE_OS::gettimeofday();
+      int poolCount = poolCount_;
+      for (int i = 0; i < poolCount; i++)
+      {
+         ObjectPool* pool = getTableEntry(i);
+         if ((pool != NULL) && (pool->isBackgroundMaintained() == true))
+         {
+            pool->performMaintenance(now);
+         }//end if
+      }//end for
+
+      maintenanceMutex_.acquire();
+   }//end while
+   maintenanceMutex_.release();
+   return 0;
+}//end runMaintenanceThread
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
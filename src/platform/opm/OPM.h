@@ -22,12 +22,16 @@
 
 #include <vector>
 #include <ace/Synch.h>
+#include <ace/TSS_T.h>
+#include <ace/Time_Value.h>
+#include <ace/Thread_Manager.h>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
 #include "OPMBase.h"
+#include "OPMSlab.h"
 
 // Use a MACRO wrapper around functions to determine/track the calling Class
 // and Method names
@@ -46,14 +50,54 @@ typedef enum { OPM_NO_GROWTH = -1,
                OPM_GROW_AND_SHRINK = -3
              } OPMGrowthModeType;
 
+// NUMA placement of a pool's objects: a single pool (the default), one sub-pool
+// per NUMA node serving the caller's local node first, or one sub-pool per node
+// with reservations spread round robin across the nodes
+typedef enum { OPM_NUMA_NONE = 0,
+               OPM_NUMA_LOCAL = 1,
+               OPM_NUMA_INTERLEAVED = 2
+             } OPMNumaModeType;
+
 // Function pointer that returns OPMBase*
 typedef OPMBase* (*OPM_INIT_PTR)(int);
 
+// Function pointer that constructs an object in place (in the supplied slab
+// memory) and returns OPMBase*
+typedef OPMBase* (*OPM_PLACEMENT_INIT_PTR)(void*, long);
+
+// Number of Object Pools in each block of the pool table. The table grows by
+// one block at a time as pools are created; blocks are never moved or freed,
+// so that the table can be read without locking.
+#define OPM_POOL_BLOCK_SIZE               256
+
+// Maximum number of blocks in the pool table
+#define OPM_MAX_POOL_BLOCKS               256
+
+// Maximum number of Object Pools (including NUMA sub-pools) that may be
+// created within the OPM
+#define OPM_MAX_POOLS                     (OPM_POOL_BLOCK_SIZE * OPM_MAX_POOL_BLOCKS)
+
+// Default number of objects held per thread, per pool, in the thread caches
+#define OPM_DEFAULT_THREAD_CACHE_SIZE     32
+
+// Default period (in milliseconds) at which the maintenance thread checks the
+// watermarks of the pools that it maintains
+#define OPM_DEFAULT_MAINTENANCE_INTERVAL  100
+
+// Default time (in seconds) that usage must stay low before a background
+// maintained GROW_AND_SHRINK pool gives back a capacity increment
+#define OPM_DEFAULT_SHRINK_DELAY          30
+
+// Environment variable that turns on lazy construction (when set to "1") for
+// all of the pools of a process as OPM is initialized
+#define OPM_LAZY_CONSTRUCTION_ENV         "OPM_LAZY_CONSTRUCTION"
+
 //-----------------------------------------------------------------------------
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 
 class ObjectPool;
+class OPMThreadCache;
 
 // For C++ class declarations, we have one (and only one) of these access 
 // blocks per class in this order: public, protected, and then private.
@@ -75,6 +119,25 @@ class ObjectPool;
  * currently is no support for deleting/destroying existing pools and their
  * objects.
  * <p>
+ * Pools are stored in an append-only table that is published with a memory
+ * barrier, so looking up a pool by its ID never takes a lock. The table grows
+ * in blocks of OPM_POOL_BLOCK_SIZE pools, up to OPM_MAX_POOLS pools. Thread safe pools
+ * may additionally be given a per-thread object cache (see setPoolThreadCacheSize)
+ * which moves objects to and from the shared pool in batches, so that most
+ * reserve and release operations do not touch the pool mutex at all.
+ * <p>
+ * Thread safe pools may also be handed to the OPM maintenance thread (see
+ * setPoolBackgroundMaintenance), which grows them ahead of demand and shrinks
+ * them with hysteresis and a time delay, so that reserve does not construct
+ * objects on the caller's thread.
+ * <p>
+ * On NUMA machines a pool may be created with one sub-pool per NUMA node (see
+ * createPool). The sub-pools occupy consecutive pool IDs starting at the ID
+ * returned to the application; each object keeps the ID of its sub-pool, so it
+ * is always released back to the node whose memory it lives on. Settings made
+ * through the returned ID (capacity increment, thread caches, background
+ * maintenance) apply to every sub-pool.
+ * <p>
  *
  * $Author: Stephen Horton$
  * $Revision: 1$
@@ -104,9 +167,23 @@ class OPM
     */
    friend void checkForUnreleasedOPMObjects();
 
+   /**
+    * The per-thread object caches look pools up by ID (without locking) when
+    * they are flushed.
+    */
+   friend class OPMThreadCache;
+
+   /** Pools wake the maintenance thread when they cross their growth threshold */
+   friend class ObjectPool;
 
    public:
 
+      /**
+       * Compile time typed front end to the pools of T objects, with a scoped
+       * pointer that releases on scope exit (defined in OPMPool.h)
+       */
+      template <class T> class Pool;
+
       /**
        * initializes the Object Pool Manager (OPM).
        */
@@ -114,7 +191,11 @@ class OPM
 
       /**
        * Method to be called when the node is shutdown. This method will reset
-       * all Objects to <tt> NULL </tt>
+       * all Objects to <tt> NULL </tt>. The objects still held in the thread
+       * caches of other threads are deleted along with their pools; those
+       * caches discard them the next time they are used, so OPM may be
+       * initialized again (and reuse the pool IDs) afterwards. No other thread
+       * may be using OPM while this runs.
        */
       static void shutdown();
 
@@ -141,13 +222,59 @@ class OPM
        * @param threadSafe Boolean to determine if the ObjectPool should be created
        *   as thread safe or not
        * @param growthMode Either NO_GROWTH, GROWTH_ALLOWED, or GROW_AND_SHRINK
+       * @param numaMode OPM_NUMA_NONE for a single pool. Otherwise a thread safe
+       *   sub-pool is created for each NUMA node, with initialSize split evenly
+       *   between them, and its objects are first touched (constructed) by the
+       *   calling thread temporarily bound to that node. With OPM_NUMA_LOCAL,
+       *   reserve serves the caller's node and only falls back to the other nodes
+       *   when that sub-pool is exhausted; OPM_NUMA_INTERLEAVED spreads
+       *   reservations round robin across the nodes. On a machine with a single
+       *   node this is the same as OPM_NUMA_NONE.
        * @return integer objectPoolID used by applications in referencing this particular
        *   object pool for retrieving objects (or ERROR if pool already exists for
        *   the specified objectType and initializer).
        */
       static int createPool(const char* objectType, long objectInitParam,
          OPM_INIT_PTR bootStrapMethod, double thresholdPercentage, int capacityIncrement, 
-         int initialSize, bool threadSafe, OPMGrowthModeType growthMode);
+         int initialSize, bool threadSafe, OPMGrowthModeType growthMode,
+         OPMNumaModeType numaMode = OPM_NUMA_NONE);
+
+      /**
+       * Method for Creating a slab mode Object Pool. Rather than heap allocating each
+       * object, the pool maps one contiguous block of memory (an OPMSlab) for its
+       * initial capacity and one for each capacity increment, and constructs the
+       * objects in place within it. Each object is aligned to its own cache line(s).
+       * Objects that are frequently reserved together are therefore packed together,
+       * and the slab may optionally be backed by hugepages and/or pre-faulted so that
+       * no page faults are taken when the objects are first used.
+       * <p>
+       * A slab is only returned to the system (for GROW_AND_SHRINK pools) when
+       * every object in the most recent capacity increment is free, so shrinking
+       * may be deferred compared to a heap backed pool.
+       * <p>
+       * @param objectType Type of the object to be Created
+       * @param objectInitParam long or pointer to initialization data needed
+       *   by each of the objects in the pool, or NULL if none is needed
+       * @param placementMethod pointer to a function or method (eg. 
+       *   initializeInPlace) that will construct the object in the memory given to
+       *   it and return a pointer to it
+       * @param objectSize Number of bytes of slab memory needed for each object
+       * @param thresholdPercentage See createPool
+       * @param capacityIncrement See createPool
+       * @param initialSize See createPool
+       * @param threadSafe See createPool
+       * @param growthMode See createPool
+       * @param slabOptions OR'ed combination of OPM_SLAB_HUGEPAGES and OPM_SLAB_PREFAULT
+       *   (or OPM_SLAB_DEFAULT)
+       * @param numaMode See createPool. Slab mode gives the strictest placement,
+       *   since each sub-pool's slabs are mapped and first touched on its node.
+       * @return integer objectPoolID (or ERROR), as with createPool
+       */
+      static int createSlabPool(const char* objectType, long objectInitParam,
+         OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, 
+         double thresholdPercentage, int capacityIncrement, int initialSize, 
+         bool threadSafe, OPMGrowthModeType growthMode, int slabOptions = OPM_SLAB_DEFAULT,
+         OPMNumaModeType numaMode = OPM_NUMA_NONE);
 
       /**
        * Method to verify if an object pool has been created for the specified 
@@ -201,9 +328,11 @@ class OPM
                                 int callingLineNumb);
 
       /**
-       * Method to test if an Object was created by the OPM.
-       * Remember that for this to be called from Multiple threads, the
-       * object pool must be thread safe.
+       * Method to test if an Object was created by the OPM. This runs in
+       * constant time (using the pool ID and ownership state stored in the
+       * object) and does not lock the pool, so for an object that another
+       * thread is concurrently removing from its pool (a shrink) the answer
+       * is only a hint.
        * @param object OPMBase Object pointer to test
        * @return <tt>true</tt> if the specified Object was created by OPM <br>
        *         <tt>false</tt> if the specified Object was created elsewhere
@@ -222,6 +351,86 @@ class OPM
        */
       static bool setPoolCapacityIncrement(int objectPoolID, int capacityIncrement);
 
+      /**
+       * Method enables (or disables with a cacheSize of 0) the per-thread object
+       * caches in front of a thread safe Object Pool. Each thread keeps up to
+       * cacheSize objects for the pool; an empty cache is refilled and a full
+       * cache is drained with half of cacheSize objects in a single pool lock.
+       * This should be called right after createPool, before objects are reserved.
+       * <p>
+       * Note that objects held in a thread cache are still counted as in-use by
+       * the shared pool, so a NO_GROWTH pool should be sized with this in mind.
+       * @param objectPoolID integer used by applications in referencing this particular
+       *   object pool for retrieving objects (this is returned by createPool)
+       * @param cacheSize Maximum number of objects each thread may cache for this pool
+       * @return <tt>true</tt> if the thread cache size was successfully changed<br>
+       *         <tt>false</tt> if the pool does not exist or is not thread safe
+       */
+      static bool setPoolThreadCacheSize(int objectPoolID, int cacheSize);
+
+      /**
+       * Method returns all of the objects held in the calling thread's object
+       * caches back into their shared pools. This happens automatically when a
+       * thread exits, but threads that are about to go idle for a long time may
+       * call it to make their cached objects available to other threads.
+       */
+      static void flushThreadCache();
+
+      /**
+       * Method selects lazy or eager construction of the initial capacity for the
+       * pools created from now on. Eager construction (the default) builds all
+       * initialSize objects as the pool is created. Lazy construction only
+       * reserves the space for them (a slab mode pool maps, but does not prefault,
+       * its initial slab) and constructs each one under the pool lock the first
+       * time that it is needed by reserve, which shortens process startup and
+       * keeps unused objects from becoming resident. Capacity increments are
+       * always constructed eagerly. Lazy construction may also be turned on for
+       * a whole process by setting OPM_LAZY_CONSTRUCTION=1 in its environment.
+       * @param lazyConstruction Whether new pools construct their objects lazily
+       */
+      static void setLazyConstruction(bool lazyConstruction);
+
+      /** Return true if new pools construct their initial objects on first reserve */
+      static bool isLazyConstruction();
+
+      /**
+       * Method starts the OPM maintenance thread, which grows the pools that are
+       * handed to it (see setPoolBackgroundMaintenance) ahead of demand, and
+       * applies their time decayed shrink policy. The thread is also started on
+       * demand (with the default interval) by setPoolBackgroundMaintenance, and
+       * is stopped by shutdown.
+       * @param intervalMsec Period (in milliseconds) at which the thread checks
+       *   the pool watermarks when it is not woken up sooner by a pool
+       * @return <tt>true</tt> if the thread is running
+       */
+      static bool startMaintenanceThread(int intervalMsec = OPM_DEFAULT_MAINTENANCE_INTERVAL);
+
+      /** Method stops the OPM maintenance thread (and waits for it to exit) */
+      static void stopMaintenanceThread();
+
+      /**
+       * Method hands the growing and shrinking of a thread safe Object Pool over
+       * to the OPM maintenance thread (or takes it back), so that reserve does not
+       * construct a capacity increment on the calling thread. Once reserve finds
+       * usage at the growth threshold it only wakes the maintenance thread, which
+       * builds the next increment without holding the pool lock while the
+       * remaining free objects are handed out; reserve only grows the pool itself
+       * if the Free List runs dry first.
+       * <p>
+       * For GROW_AND_SHRINK pools, the maintenance thread gives back an increment
+       * only once usage has stayed at least half an increment below the point at
+       * which it was added for shrinkDelaySeconds, and waits another full delay
+       * before each further shrink, so that bursty pools do not thrash.
+       * @param objectPoolID integer used by applications in referencing this particular
+       *   object pool for retrieving objects (this is returned by createPool)
+       * @param enable Whether the maintenance thread grows and shrinks the pool
+       * @param shrinkDelaySeconds How long usage must stay low before each shrink
+       * @return <tt>true</tt> if the setting was successfully changed<br>
+       *         <tt>false</tt> if the pool does not exist or is not thread safe
+       */
+      static bool setPoolBackgroundMaintenance(int objectPoolID, bool enable,
+         int shrinkDelaySeconds = OPM_DEFAULT_SHRINK_DELAY);
+
       /**
        * Get the Pool Capacity Increment value which is the number of objects to
        * add to the pool when the threshold value is reached. <p>
@@ -275,15 +484,140 @@ class OPM
 
    private:
 
-      /** Vector datastructure for storing Object Pools into -- this is OPM */
-      static vector<ObjectPool*>* poolVector_;
+      /**
+       * Common implementation of createPool and createSlabPool that creates the
+       * pool and publishes it in the pool table. Exactly one of bootStrapMethod
+       * and placementMethod is non-NULL.
+       */
+      static int addPool(const char* objectType, long objectInitParam,
+         OPM_INIT_PTR bootStrapMethod, OPM_PLACEMENT_INIT_PTR placementMethod,
+         size_t objectSize, int slabOptions, double thresholdPercentage,
+         int capacityIncrement, int initialSize, bool threadSafe,
+         OPMGrowthModeType growthMode, OPMNumaModeType numaMode);
+
+      /**
+       * Construct (but do not publish) one pool or NUMA sub-pool for addPool
+       * @return New pool or NULL
+       */
+      static ObjectPool* constructPool(int objectPoolID, const char* objectType,
+         long objectInitParam, OPM_INIT_PTR bootStrapMethod,
+         OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, int slabOptions,
+         double thresholdPercentage, int capacityIncrement, int initialSize,
+         bool threadSafe, OPMGrowthModeType growthMode);
+
+      /**
+       * Reserve an object from a pool, through the calling thread's cache for the
+       * pool if it has one
+       */
+      static OPMBase* reserveFromPool(ObjectPool* pool, bool blockWaitingForAccess);
+
+      /**
+       * Reserve an object from the NUMA sub-pools of a pool: the starting node is
+       * chosen by the pool's NUMA mode, and the other nodes are tried in turn
+       * while the sub-pools are exhausted.
+       * @param objectPoolID Pool ID of the node 0 sub-pool (returned by createPool)
+       */
+      static OPMBase* reserveNumaObject(int objectPoolID, bool blockWaitingForAccess);
+
+      /**
+       * Return the number of pools that make up a pool: its number of NUMA
+       * sub-pools, or 1 for an ordinary pool
+       */
+      static int getSubPoolCount(int objectPoolID);
+
+      /**
+       * Return the Object Pool for the specified pool ID without taking any lock.
+       * @return ObjectPool pointer or NULL if the pool ID is invalid
+       */
+      static ObjectPool* lookupPool(int objectPoolID);
+
+      /**
+       * Return the Object Pool stored in the pool table for the specified pool
+       * ID, without checking the ID or logging
+       * @return ObjectPool pointer or NULL if there is no such pool
+       */
+      static ObjectPool* getTableEntry(int objectPoolID);
+
+      /**
+       * Return the NUMA mode of the specified pool ID (which must be in a block
+       * of the pool table)
+       */
+      static OPMNumaModeType getNumaMode(int objectPoolID);
+
+      /**
+       * Wake the maintenance thread so that it performs a pass now rather than
+       * at the end of its interval. Called by pools (holding their own lock) when
+       * usage crosses the growth threshold.
+       */
+      static void requestMaintenance();
+
+      /**
+       * Maintenance thread main loop: performs a maintenance pass over every
+       * background maintained pool once per interval, or when woken up.
+       */
+      static ACE_THR_FUNC_RETURN runMaintenanceThread(void* arg);
+
+      /** Block of OPM_POOL_BLOCK_SIZE entries of the pool table */
+      struct PoolBlock
+      {
+         /** Object Pools of the block, indexed by pool ID within the block */
+         ObjectPool* volatile pools_[OPM_POOL_BLOCK_SIZE];
+
+         /**
+          * NUMA mode of each pool ID returned to applications (OPM_NUMA_NONE for
+          * ordinary pools and for the node 1..N sub-pools). Written before the
+          * pool is published in the pool table.
+          */
+         OPMNumaModeType numaModes_[OPM_POOL_BLOCK_SIZE];
+      };
+
+      /**
+       * Append-only table for storing Object Pools into -- this is OPM. Blocks
+       * and entries are only written under poolTableMutex_, and are published
+       * after they are fully constructed, so readers may index the table without
+       * locking. Blocks are kept (and reused) across shutdown and initialize.
+       */
+      static PoolBlock* volatile poolTable_[OPM_MAX_POOL_BLOCKS];
+
+      /** Number of Object Pools that have been published in the pool table */
+      static volatile int poolCount_;
 
-      /** Non-recursive Mutex that controls access / insertion into the OPM - Note: deletion of pools
+      /** Non-recursive Mutex that controls insertion into the OPM - Note: deletion of pools
           is not supported */
-      static ACE_Thread_Mutex poolVectorMutex_;
+      static ACE_Thread_Mutex poolTableMutex_;
+
+      /** Per-thread object caches for the thread safe pools that have them enabled */
+      static ACE_TSS<OPMThreadCache> threadCache_;
 
       /** Flag for determining if OPM is already initialized */
       static bool isInitialized_;
+
+      /**
+       * Incremented by shutdown. A thread cache filled under an earlier value
+       * holds objects of deleted pools, and discards them.
+       */
+      static volatile unsigned int shutdownCount_;
+
+      /** Mutex protecting the maintenance thread state (below) */
+      static ACE_Thread_Mutex maintenanceMutex_;
+
+      /** Condition used to wake up the maintenance thread */
+      static ACE_Condition_Thread_Mutex maintenanceCondition_;
+
+      /** Period at which the maintenance thread checks the pool watermarks */
+      static ACE_Time_Value maintenanceInterval_;
+
+      /** Thread Id of the maintenance thread (for joining it) */
+      static ACE_thread_t maintenanceThreadId_;
+
+      /** Flag set while the maintenance thread is (supposed to be) running */
+      static volatile bool isMaintenanceRunning_;
+
+      /** Flag set when a pool has requested an immediate maintenance pass */
+      static bool isMaintenanceRequested_;
+
+      /** Flag for constructing the initial objects of new pools on first reserve */
+      static bool isLazyConstruction_;
 };
 
 #endif
@@ -53,7 +53,8 @@ OPMBase::OPMBase()
   :next_(NULL),
    prev_(NULL),
    objectType_("<Unassigned>"),
-   poolID_(UNKNOWN_POOLID)
+   poolID_(UNKNOWN_POOLID),
+   objectState_(OPM_OBJECT_UNOWNED)
 {
    //Identify this ObjectBase as a poolable object so that we know in child class
    // instantiations that it inherits from OPMBase
@@ -166,6 +167,29 @@ void OPMBase::setPoolID(int poolID)
 }//end setPoolID
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the ownership state of this object within its Object Pool
+// Design:     
+//-----------------------------------------------------------------------------
+OPMObjectStateType OPMBase::getObjectState()
+{
+   return objectState_;
+}//end getObjectState
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Set the ownership state of this object - called only by the
+//              Object Pools
+// Design:     
+//-----------------------------------------------------------------------------
+void OPMBase::setObjectState(OPMObjectStateType objectState)
+{
+   objectState_ = objectState;
+}//end setObjectState
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return a pointer to the object type string for this object
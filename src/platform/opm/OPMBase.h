@@ -57,6 +57,16 @@ using namespace std;
 
 #define UNKNOWN_POOLID -1
 
+/**
+ * Ownership state of an OPMBase object, maintained by its Object Pool so that
+ * pool membership and double releases can be checked in constant time.
+ */
+typedef enum { OPM_OBJECT_UNOWNED = 0,   // Not created by (or no longer in) an Object Pool
+               OPM_OBJECT_FREE,          // In the pool's Free List
+               OPM_OBJECT_USED,          // Reserved by the application
+               OPM_OBJECT_CACHED         // Released into a per-thread object cache
+             } OPMObjectStateType;
+
 class OPMBase : public ObjectBase
 {
    public:
@@ -91,6 +101,12 @@ class OPMBase : public ObjectBase
       /** Set the integer poolID that identifies which pool this object belongs to */
       void setPoolID(int poolID);
 
+      /** Return the ownership state of this object within its Object Pool */
+      OPMObjectStateType getObjectState();
+
+      /** Set the ownership state of this object - called only by the Object Pools */
+      void setObjectState(OPMObjectStateType objectState);
+
       /** Return a pointer to the object type string for this object */
       const char* getObjectTypeStr();
    
@@ -138,6 +154,15 @@ class OPMBase : public ObjectBase
        */
       int poolID_;
 
+      /**
+       * Ownership state used to -self- identify whether this object is free,
+       * in use, or cached within its object pool. It is written under the
+       * pool lock (or by the owning thread cache) but read without it by
+       * ObjectPool::containsObject, so it is volatile to make each read a
+       * single whole-word load from memory.
+       */
+      volatile OPMObjectStateType objectState_;
+
    private:
 
       /**
@@ -182,6 +182,43 @@ void OPMLinkedList::insertLast(OPMBase* object)
 }//end insertFirst
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Move all of the objects of another list to the Head (First) of
+//              this Linked List
+// Design:      Splices the other list in by relinking its tail, so the cost
+//              does not depend on the number of objects moved
+//-----------------------------------------------------------------------------
+void OPMLinkedList::insertListFirst(OPMLinkedList* list)
+{
+   //nothing to do if the other list is empty
+   if (list->head_ == NULL)
+      return;
+
+   //check to see if this list is empty, if so, just take over the other list
+   if (head_ == NULL)
+   {
+      head_ = list->head_;
+      tail_ = list->tail_;
+   }//end if
+   else
+   {
+      //link the other list's tail to the current head
+      list->tail_->setNext(head_);
+      head_->setPrev(list->tail_);
+
+      //reference to head now assigned to the other list's head
+      head_ = list->head_;
+   }//end else
+   listSize_ += list->listSize_;
+
+   //the other list no longer references the objects
+   list->head_ = NULL;
+   list->tail_ = NULL;
+   list->listSize_ = 0;
+}//end insertListFirst
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return the size of the List
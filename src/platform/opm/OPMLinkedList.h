@@ -89,6 +89,14 @@ class OPMLinkedList
        */
       void insertLast(OPMBase* object);
 
+      /**
+       * Move all of the objects of another list (keeping their order) to the
+       * Head (First) of this Linked List in constant time. The other list is
+       * left empty.
+       * @param list Linked List whose objects are moved into this list
+       */
+      void insertListFirst(OPMLinkedList* list);
+
       /** Return the size of the List */
       int getListSize();
 
@@ -0,0 +1,257 @@
+/******************************************************************************
+*
+* File name:   OPMNuma.cpp
+* Subsystem:   Platform Services
+* Description: Discovers the NUMA topology of the node (from sysfs) so that OPM
+*              can keep one sub-pool per NUMA node and serve reservations from
+*              the memory local to the calling thread.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMNuma.h"
+
+// Common Defines
+#include "platform/common/Defines.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+/** Whether the topology has been read */
+volatile bool OPMNuma::isInitialized_ = false;
+
+/** Number of NUMA nodes */
+int OPMNuma::nodeCount_ = 1;
+
+/** CPUs of each NUMA node */
+cpu_set_t OPMNuma::nodeCpus_[OPM_MAX_NUMA_NODES];
+
+/** NUMA node of each CPU */
+unsigned char OPMNuma::cpuNodeTable_[CPU_SETSIZE];
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Read the NUMA topology
+// Design:      Kernel node numbers may have gaps (eg. node0 and node2), so
+//              the nodes listed as online are numbered densely. Nodes without
+//              CPUs (memory only) are skipped since no thread can be local to
+//              them. The online list has the same format as a CPU list.
+//-----------------------------------------------------------------------------
+void OPMNuma::initialize()
+{
+   if (isInitialized_)
+   {
+      return;
+   }//end if
+
+   cpu_set_t kernelNodes;
+   CPU_ZERO(&kernelNodes);
+   FILE* onlineFile = fopen(OPM_NUMA_SYSFS_DIR "/online", "r");
+   if (onlineFile != NULL)
+   {
+      char nodeList[256];
+      if (fgets(nodeList, sizeof(nodeList), onlineFile) != NULL)
+      {
+         parseCpuList(nodeList, &kernelNodes);
+      }//end if
+      fclose(onlineFile);
+   }//end if
+
+   memset(cpuNodeTable_, 0, sizeof(cpuNodeTable_));
+   int nodeCount = 0;
+   for (int kernelNode = 0; (kernelNode < CPU_SETSIZE) && (nodeCount < OPM_MAX_NUMA_NODES); kernelNode++)
+   {
+      if (!CPU_ISSET(kernelNode, &kernelNodes))
+      {
+         continue;
+      }//end if
+
+      char fileName[128];
+      snprintf(fileName, sizeof(fileName), "%s/node%d/cpulist", OPM_NUMA_SYSFS_DIR, kernelNode);
+      FILE* cpuListFile = fopen(fileName, "r");
+      if (cpuListFile == NULL)
+      {
+         continue;
+      }//end if
+
+      char cpuList[1024];
+      bool hasCpus = ((fgets(cpuList, sizeof(cpuList), cpuListFile) != NULL) &&
+                      parseCpuList(cpuList, &nodeCpus_[nodeCount]));
+      fclose(cpuListFile);
+      if (hasCpus)
+      {
+         for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+         {
+            if (CPU_ISSET(cpu, &nodeCpus_[nodeCount]))
+            {
+               cpuNodeTable_[cpu] = (unsigned char)nodeCount;
+            }//end if
+         }//end for
+         nodeCount++;
+      }//end if
+   }//end for
+
+   //no NUMA information, so every CPU is on the one node
+   if (nodeCount == 0)
+   {
+      CPU_ZERO(&nodeCpus_[0]);
+      for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      {
+         CPU_SET(cpu, &nodeCpus_[0]);
+      }//end for
+      nodeCount = 1;
+   }//end if
+
+   nodeCount_ = nodeCount;
+   __sync_synchronize();
+   isInitialized_ = true;
+
+   TRACELOG(DEBUGLOG, OPMLOG, "OPM found %d NUMA node(s)", nodeCount_,0,0,0,0,0);
+}//end initialize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the number of NUMA nodes
+// Design:
+//-----------------------------------------------------------------------------
+int OPMNuma::getNodeCount()
+{
+   if (isInitialized_ == false)
+   {
+      initialize();
+   }//end if
+   return nodeCount_;
+}//end getNodeCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the NUMA node of the CPU the calling thread is on
+// Design:      The thread may migrate right after this returns; that only
+//              costs locality for one reservation.
+//-----------------------------------------------------------------------------
+int OPMNuma::getCurrentNode()
+{
+   int cpu = sched_getcpu();
+   if ((cpu < 0) || (cpu >= CPU_SETSIZE))
+   {
+      return 0;
+   }//end if
+   return cpuNodeTable_[cpu];
+}//end getCurrentNode
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Bind the calling thread to the CPUs of a NUMA node
+// Design:
+//-----------------------------------------------------------------------------
+bool OPMNuma::bindToNode(int node, cpu_set_t* previousCpus)
+{
+   if ((node < 0) || (node >= getNodeCount()))
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Invalid NUMA node %d", node,0,0,0,0,0);
+      return false;
+   }//end if
+
+   if (sched_getaffinity(0, sizeof(cpu_set_t), previousCpus) == ERROR)
+   {
+      TRACELOG(WARNINGLOG, OPMLOG, "Unable to read the thread CPU affinity", 0,0,0,0,0,0);
+      return false;
+   }//end if
+
+   if (sched_setaffinity(0, sizeof(cpu_set_t), &nodeCpus_[node]) == ERROR)
+   {
+      TRACELOG(WARNINGLOG, OPMLOG, "Unable to bind the thread to NUMA node %d", node,0,0,0,0,0);
+      return false;
+   }//end if
+   return true;
+}//end bindToNode
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Restore the CPU affinity saved by bindToNode
+// Design:
+//-----------------------------------------------------------------------------
+void OPMNuma::restoreBinding(const cpu_set_t* previousCpus)
+{
+   sched_setaffinity(0, sizeof(cpu_set_t), previousCpus);
+}//end restoreBinding
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Parse a sysfs CPU list (eg. "0-3,8-11") into a CPU set
+// Design:
+//-----------------------------------------------------------------------------
+bool OPMNuma::parseCpuList(const char* cpuList, cpu_set_t* cpus)
+{
+   CPU_ZERO(cpus);
+   bool foundCpu = false;
+   const char* position = cpuList;
+   while ((*position >= '0') && (*position <= '9'))
+   {
+      char* end = NULL;
+      long firstCpu = strtol(position, &end, 10);
+      long lastCpu = firstCpu;
+      if (*end == '-')
+      {
+         lastCpu = strtol(end + 1, &end, 10);
+      }//end if
+
+      for (long cpu = firstCpu; (cpu <= lastCpu) && (cpu < CPU_SETSIZE); cpu++)
+      {
+         CPU_SET(cpu, cpus);
+         foundCpu = true;
+      }//end for
+
+      if (*end != ',')
+      {
+         break;
+      }//end if
+      position = end + 1;
+   }//end while
+   return foundCpu;
+}//end parseCpuList
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
@@ -0,0 +1,120 @@
+/******************************************************************************
+*
+* File name:   OPMNuma.h
+* Subsystem:   Platform Services
+* Description: Discovers the NUMA topology of the node (from sysfs) so that OPM
+*              can keep one sub-pool per NUMA node and serve reservations from
+*              the memory local to the calling thread.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_NUMA_H_
+#define _PLAT_OPM_NUMA_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sched.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Maximum number of NUMA nodes that OPM keeps sub-pools for */
+#define OPM_MAX_NUMA_NODES                8
+
+/** Directory in which the kernel describes the NUMA nodes */
+#define OPM_NUMA_SYSFS_DIR                "/sys/devices/system/node"
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPMNuma maps CPUs to NUMA nodes and binds threads to the CPUs of a node.
+ * <p>
+ * The topology is read once from sysfs (without requiring libnuma). Nodes are
+ * numbered densely from 0 in the order the kernel lists them. On a machine
+ * without NUMA (or where sysfs is not available) a single node holding every
+ * CPU is reported, so callers never need a special case.
+ * <p>
+ * Memory placement relies on the kernel's default first-touch policy: a page
+ * is allocated on the node of the thread that first writes to it. OPM binds
+ * the thread that constructs a sub-pool's objects to that sub-pool's node.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMNuma
+{
+   public:
+
+      /** Read the NUMA topology (called by OPM::initialize; safe to repeat) */
+      static void initialize();
+
+      /** Return the number of NUMA nodes (at least 1) */
+      static int getNodeCount();
+
+      /**
+       * Return the NUMA node of the CPU that the calling thread is running on.
+       * This is a vDSO call and a table lookup, cheap enough for every reserve.
+       */
+      static int getCurrentNode();
+
+      /**
+       * Bind the calling thread to the CPUs of a NUMA node
+       * @param node NUMA node (0 to getNodeCount() - 1)
+       * @param previousCpus Receives the thread's current CPU affinity, to be
+       *    given to restoreBinding
+       * @return <tt>true</tt> if the thread was bound
+       */
+      static bool bindToNode(int node, cpu_set_t* previousCpus);
+
+      /**
+       * Restore the CPU affinity of the calling thread saved by bindToNode
+       * @param previousCpus CPU affinity returned by bindToNode
+       */
+      static void restoreBinding(const cpu_set_t* previousCpus);
+
+   protected:
+
+   private:
+
+      /**
+       * Parse a sysfs CPU list (for example "0-3,8-11") into a CPU set
+       * @return <tt>true</tt> if at least one CPU was parsed
+       */
+      static bool parseCpuList(const char* cpuList, cpu_set_t* cpus);
+
+      /** Whether the topology has been read */
+      static volatile bool isInitialized_;
+
+      /** Number of NUMA nodes */
+      static int nodeCount_;
+
+      /** CPUs of each NUMA node */
+      static cpu_set_t nodeCpus_[OPM_MAX_NUMA_NODES];
+
+      /** NUMA node of each CPU */
+      static unsigned char cpuNodeTable_[CPU_SETSIZE];
+};
+
+#endif
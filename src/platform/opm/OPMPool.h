@@ -0,0 +1,257 @@
+/******************************************************************************
+*
+* File name:   OPMPool.h
+* Subsystem:   Platform Services
+* Description: Implements the typed (template) front end to the OPM, along
+*              with a scoped pointer that releases pooled objects when it goes
+*              out of scope.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_POOL_H_
+#define _PLAT_OPM_POOL_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPM.h"
+
+#include "platform/common/Defines.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPM::Pool is the compile time typed front end to an Object Pool of T objects,
+ * where T derives from OPMBase.
+ * <p>
+ * Each type T has one default pool whose ID is remembered (statically, per type)
+ * when the pool is created through create or createSlab. Later reservations from
+ * it need no pool ID, no string lookup, and no casting of the OPMBase* result.
+ * Types that have more than one pool (for example, MessageBuffer pools with and
+ * without network conversion) may still pass an explicit pool ID.
+ * <p>
+ * OPM::Pool<T>::Ptr holds a reserved object and releases it back into its pool
+ * when the Ptr goes out of scope, so that error paths which return early no
+ * longer leak pooled objects. Ownership is handed off (for example, once an
+ * object is successfully enqueued) with detach.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+template <class T>
+class OPM::Pool
+{
+   public:
+
+      /**
+       * Scoped pointer to a pooled T object. Ptr is not copyable; the object is
+       * released back into its pool when the Ptr is destroyed unless it has been
+       * detached first.
+       */
+      class Ptr
+      {
+         public:
+
+            /**
+             * Constructor reserves an object from the default pool for T
+             * @param blockWaitingForAccess See OPM::reserveObject
+             */
+            explicit Ptr(bool blockWaitingForAccess = true)
+               :object_(Pool<T>::reserve(blockWaitingForAccess))
+            {
+            }//end constructor
+
+            /**
+             * Constructor reserves an object from the specified pool of T objects
+             * @param objectPoolID Pool ID returned by OPM::createPool (or createSlabPool)
+             * @param blockWaitingForAccess See OPM::reserveObject
+             */
+            explicit Ptr(int objectPoolID, bool blockWaitingForAccess = true)
+               :object_(Pool<T>::reserve(objectPoolID, blockWaitingForAccess))
+            {
+            }//end constructor
+
+            /** Destructor releases the object (if any is still held) */
+            ~Ptr()
+            {
+               reset();
+            }//end destructor
+
+            /** Return the held object (or NULL) */
+            T* get() const
+            {
+               return object_;
+            }//end get
+
+            /** Access the held object */
+            T* operator->() const
+            {
+               return object_;
+            }//end operator->
+
+            /** Dereference the held object */
+            T& operator*() const
+            {
+               return *object_;
+            }//end operator*
+
+            /** Return true if no object is held (the reservation failed) */
+            bool isNull() const
+            {
+               return (object_ == NULL);
+            }//end isNull
+
+            /**
+             * Give up ownership of the held object without releasing it. The
+             * caller (or whoever it hands the object to) becomes responsible
+             * for releasing it with OPM_RELEASE.
+             * @return The held object (or NULL)
+             */
+            T* detach()
+            {
+               T* object = object_;
+               object_ = NULL;
+               return object;
+            }//end detach
+
+            /** Release the held object (if any) back into its pool now */
+            void reset()
+            {
+               if (object_ != NULL)
+               {
+                  OPM::releaseObject(object_, __FILE__, __LINE__);
+                  object_ = NULL;
+               }//end if
+            }//end reset
+
+         private:
+
+            /**
+             * Copy Constructor declared private so that default automatic
+             * methods aren't used.
+             */
+            Ptr(const Ptr& rhs);
+
+            /**
+             * Assignment operator declared private so that default automatic
+             * methods aren't used.
+             */
+            Ptr& operator= (const Ptr& rhs);
+
+            /** Reserved object (NULL once released or detached) */
+            T* object_;
+      };
+
+      /**
+       * Create (or find) the default pool for T using T::initialize to bootstrap
+       * the objects. See OPM::createPool for the parameters.
+       * @return Pool ID, or ERROR
+       */
+      static int create(const char* objectType, long objectInitParam, double thresholdPercentage,
+         int capacityIncrement, int initialSize, bool threadSafe, OPMGrowthModeType growthMode,
+         OPMNumaModeType numaMode = OPM_NUMA_NONE)
+      {
+         if (getPoolID() == ERROR)
+         {
+            shutdownCount_ = OPM::shutdownCount_;
+            poolID_ = OPM::createPool(objectType, objectInitParam, (OPM_INIT_PTR)&T::initialize,
+               thresholdPercentage, capacityIncrement, initialSize, threadSafe, growthMode, numaMode);
+         }//end if
+         return poolID_;
+      }//end create
+
+      /**
+       * Create (or find) the default pool for T as a slab mode pool using
+       * T::initializeInPlace to construct the objects. See OPM::createSlabPool
+       * for the parameters.
+       * @return Pool ID, or ERROR
+       */
+      static int createSlab(const char* objectType, long objectInitParam, double thresholdPercentage,
+         int capacityIncrement, int initialSize, bool threadSafe, OPMGrowthModeType growthMode,
+         int slabOptions = OPM_SLAB_DEFAULT, OPMNumaModeType numaMode = OPM_NUMA_NONE)
+      {
+         if (getPoolID() == ERROR)
+         {
+            shutdownCount_ = OPM::shutdownCount_;
+            poolID_ = OPM::createSlabPool(objectType, objectInitParam,
+               (OPM_PLACEMENT_INIT_PTR)&T::initializeInPlace, sizeof(T), thresholdPercentage,
+               capacityIncrement, initialSize, threadSafe, growthMode, slabOptions, numaMode);
+         }//end if
+         return poolID_;
+      }//end createSlab
+
+      /**
+       * Return the ID of the default pool for T (or ERROR if not yet created,
+       * or if it was deleted by an OPM::shutdown since)
+       */
+      static int getPoolID()
+      {
+         return ((shutdownCount_ == OPM::shutdownCount_) ? poolID_ : ERROR);
+      }//end getPoolID
+
+      /**
+       * Reserve an object from the default pool for T
+       * @param blockWaitingForAccess See OPM::reserveObject
+       * @return T object or NULL
+       */
+      static T* reserve(bool blockWaitingForAccess = true)
+      {
+         return reserve(getPoolID(), blockWaitingForAccess);
+      }//end reserve
+
+      /**
+       * Reserve an object from the specified pool of T objects
+       * @param objectPoolID Pool ID returned by OPM::createPool (or createSlabPool)
+       * @param blockWaitingForAccess See OPM::reserveObject
+       * @return T object or NULL
+       */
+      static T* reserve(int objectPoolID, bool blockWaitingForAccess)
+      {
+         return static_cast<T*>(OPM::reserveObject(objectPoolID, blockWaitingForAccess));
+      }//end reserve
+
+   protected:
+
+   private:
+
+      /** ID of the default pool for T (ERROR until it is created) */
+      static int poolID_;
+
+      /**
+       * OPM shutdown count that the default pool was created under. The pool
+       * is deleted by shutdown and its ID reused by a later initialize.
+       */
+      static unsigned int shutdownCount_;
+};
+
+template <class T>
+int OPM::Pool<T>::poolID_ = ERROR;
+
+template <class T>
+unsigned int OPM::Pool<T>::shutdownCount_ = 0;
+
+#endif
@@ -0,0 +1,463 @@
+/******************************************************************************
+*
+* File name:   OPMSharedPool.cpp
+* Subsystem:   Platform Services
+* Description: Implements a fixed capacity pool of buffers that lives inside a
+*              named shared memory segment, so that processes on the same node
+*              can reserve a buffer, fill it in place and hand it to another
+*              process by its offset.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMSharedPool.h"
+
+// Common Defines
+#include "platform/common/Defines.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:      Each buffer holds the free list link while it is free, so it
+//              is at least that large, and starts on its own cache line so
+//              that processes filling neighbouring buffers do not share lines.
+//-----------------------------------------------------------------------------
+OPMSharedPool::OPMSharedPool(const char* poolName, unsigned int bufferSize, unsigned int bufferCount)
+              : poolName_(poolName),
+                segmentName_(OPM_SHARED_POOL_SEGMENT_PREFIX),
+                bufferSize_(bufferSize),
+                bufferCount_(bufferCount),
+                slotSize_(0),
+                segmentSize_(0),
+                segment_(NULL),
+                header_(NULL)
+{
+   segmentName_ += poolName_;
+
+   if (bufferSize_ < sizeof(unsigned int))
+   {
+      bufferSize_ = sizeof(unsigned int);
+   }//end if
+
+   slotSize_ = ((bufferSize_ + OPM_CACHE_LINE_SIZE - 1) / OPM_CACHE_LINE_SIZE) * OPM_CACHE_LINE_SIZE;
+   segmentSize_ = sizeof(OPMSharedPoolHeader) + ((size_t)slotSize_ * bufferCount_);
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+OPMSharedPool::~OPMSharedPool()
+{
+   close();
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Create the (or map the already created) shared memory segment
+// Design:      O_EXCL decides which process creates the segment, so two
+//              processes opening the pool at the same time never both
+//              initialize it.
+//-----------------------------------------------------------------------------
+bool OPMSharedPool::open()
+{
+   if (segment_ != NULL)
+   {
+      return true;
+   }//end if
+
+   if (bufferCount_ == 0)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Shared pool must have at least one buffer", 0,0,0,0,0,0);
+      return false;
+   }//end if
+
+   bool isOpened = false;
+   int fd = ::open(segmentName_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+   if (fd != ERROR)
+   {
+      isOpened = createSegment(fd);
+      ::close(fd);
+      if (isOpened == false)
+      {
+         unlink(segmentName_.c_str());
+      }//end if
+   }//end if
+   else if (errno == EEXIST)
+   {
+      fd = ::open(segmentName_.c_str(), O_RDWR);
+      if (fd != ERROR)
+      {
+         isOpened = attachSegment(fd);
+         ::close(fd);
+      }//end if
+   }//end else if
+
+   if (isOpened == false)
+   {
+      ostringstream ostr;
+      ostr << "Unable to open shared pool segment " << segmentName_ << ends;
+      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+   }//end if
+   return isOpened;
+}//end open
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Unmap the segment
+// Design:
+//-----------------------------------------------------------------------------
+void OPMSharedPool::close()
+{
+   if (segment_ != NULL)
+   {
+      munmap(segment_, segmentSize_);
+      segment_ = NULL;
+      header_ = NULL;
+   }//end if
+}//end close
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Remove the segment name
+// Design:
+//-----------------------------------------------------------------------------
+void OPMSharedPool::remove()
+{
+   unlink(segmentName_.c_str());
+}//end remove
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Reserve a buffer
+// Design:      Pops the head of the free list. The link read from the head
+//              buffer may already be stale (if another process popped it and
+//              wrote into it), but then the head counter has changed and the
+//              compare and swap fails, so the stale link is never used.
+//-----------------------------------------------------------------------------
+unsigned long OPMSharedPool::reserve()
+{
+   unsigned long long head;
+   unsigned int first;
+   for (;;)
+   {
+      head = header_->freeHead_;
+      first = (unsigned int)head;
+      if (first == 0)
+      {
+         __sync_fetch_and_add(&header_->reserveFailCount_, 1);
+         return OPM_SHARED_NULL_OFFSET;
+      }//end if
+
+      unsigned long long newHead = ((((head >> 32) + 1) & 0xffffffffULL) << 32) | *getNextLink(first - 1);
+      if (__sync_bool_compare_and_swap(&header_->freeHead_, head, newHead))
+      {
+         break;
+      }//end if
+   }//end for
+
+   int usedCount = __sync_add_and_fetch(&header_->usedCount_, 1);
+   if (usedCount > header_->peakUsed_)
+   {
+      header_->peakUsed_ = usedCount;
+   }//end if
+   return (header_->slotsOffset_ + ((unsigned long)(first - 1) * header_->slotSize_));
+}//end reserve
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Release a buffer
+// Design:      Pushes the buffer onto the head of the free list
+//-----------------------------------------------------------------------------
+void OPMSharedPool::release(unsigned long offset)
+{
+   if (isValidOffset(offset) == false)
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Attempt to release invalid offset %ld into a shared pool",
+         offset,0,0,0,0,0);
+      return;
+   }//end if
+
+   unsigned int index = (unsigned int)((offset - header_->slotsOffset_) / header_->slotSize_);
+   for (;;)
+   {
+      unsigned long long head = header_->freeHead_;
+      *getNextLink(index) = (unsigned int)head;
+      unsigned long long newHead = ((((head >> 32) + 1) & 0xffffffffULL) << 32) | (index + 1);
+      if (__sync_bool_compare_and_swap(&header_->freeHead_, head, newHead))
+      {
+         break;
+      }//end if
+   }//end for
+   __sync_fetch_and_sub(&header_->usedCount_, 1);
+}//end release
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the address of a buffer in this process
+// Design:
+//-----------------------------------------------------------------------------
+void* OPMSharedPool::getAddress(unsigned long offset) const
+{
+   return (segment_ + offset);
+}//end getAddress
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the offset of a buffer from its address in this process
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long OPMSharedPool::getOffset(const void* address) const
+{
+   return ((const char*)address - segment_);
+}//end getOffset
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether an offset is that of a buffer in this pool
+// Design:
+//-----------------------------------------------------------------------------
+bool OPMSharedPool::isValidOffset(unsigned long offset) const
+{
+   if ((header_ == NULL) || (offset < header_->slotsOffset_))
+   {
+      return false;
+   }//end if
+
+   unsigned long slotOffset = offset - header_->slotsOffset_;
+   return (((slotOffset % header_->slotSize_) == 0) &&
+           ((slotOffset / header_->slotSize_) < header_->slotCount_));
+}//end isValidOffset
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return whether the pool is open
+// Design:
+//-----------------------------------------------------------------------------
+bool OPMSharedPool::isOpen() const
+{
+   return (segment_ != NULL);
+}//end isOpen
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the size of each buffer
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int OPMSharedPool::getBufferSize() const
+{
+   return bufferSize_;
+}//end getBufferSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of buffers
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int OPMSharedPool::getBufferCount() const
+{
+   return bufferCount_;
+}//end getBufferCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of buffers currently reserved
+// Design:
+//-----------------------------------------------------------------------------
+int OPMSharedPool::getUsedCount() const
+{
+   return ((header_ != NULL) ? header_->usedCount_ : 0);
+}//end getUsedCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the String'ized form of the class contents
+// Design:
+//-----------------------------------------------------------------------------
+string OPMSharedPool::toString()
+{
+   ostringstream ostr;
+   ostr << "Shared pool " << poolName_ << " (" << bufferCount_ << " buffers of "
+        << bufferSize_ << " bytes)";
+   if (header_ != NULL)
+   {
+      ostr << " used " << header_->usedCount_ << " peak " << header_->peakUsed_
+           << " failed " << header_->reserveFailCount_;
+   }//end if
+   else
+   {
+      ostr << " not open";
+   }//end else
+   return ostr.str();
+}//end toString
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Create and initialize a new segment
+// Design:      The magic number is written last, so a process attaching
+//              while the segment is being set up waits for it.
+//-----------------------------------------------------------------------------
+bool OPMSharedPool::createSegment(int fd)
+{
+   if (ftruncate(fd, segmentSize_) != 0)
+   {
+      return false;
+   }//end if
+
+   void* memory = mmap(NULL, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      return false;
+   }//end if
+
+   segment_ = (char*)memory;
+   header_ = (OPMSharedPoolHeader*)memory;
+   header_->version_ = OPM_SHARED_POOL_VERSION;
+   header_->slotSize_ = slotSize_;
+   header_->slotCount_ = bufferCount_;
+   header_->slotsOffset_ = sizeof(OPMSharedPoolHeader);
+   header_->usedCount_ = 0;
+   header_->peakUsed_ = 0;
+   header_->reserveFailCount_ = 0;
+
+   //chain every buffer into the free list in order (links hold index plus one)
+   for (unsigned int i = 0; i < bufferCount_; i++)
+   {
+      *getNextLink(i) = ((i + 1) < bufferCount_) ? (i + 2) : 0;
+   }//end for
+   header_->freeHead_ = 1;
+
+   __sync_synchronize();
+   header_->magic_ = OPM_SHARED_POOL_MAGIC;
+   return true;
+}//end createSegment
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Map a segment created by another process
+// Design:      The creating process may still be sizing or initializing the
+//              segment, so wait (a bounded time) for both.
+//-----------------------------------------------------------------------------
+bool OPMSharedPool::attachSegment(int fd)
+{
+   struct stat segmentStat;
+   int waitMsec = 0;
+   while ((fstat(fd, &segmentStat) == 0) && ((size_t)segmentStat.st_size < segmentSize_))
+   {
+      if (waitMsec++ >= OPM_SHARED_POOL_ATTACH_TIMEOUT)
+      {
+         TRACELOG(ERRORLOG, OPMLOG, "Shared pool segment is smaller than expected (%d bytes)",
+            (int)segmentStat.st_size,0,0,0,0,0);
+         return false;
+      }//end if
+      usleep(1000);
+   }//end while
+
+   void* memory = mmap(NULL, segmentSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (memory == MAP_FAILED)
+   {
+      return false;
+   }//end if
+
+   OPMSharedPoolHeader* header = (OPMSharedPoolHeader*)memory;
+   while (header->magic_ != OPM_SHARED_POOL_MAGIC)
+   {
+      if (waitMsec++ >= OPM_SHARED_POOL_ATTACH_TIMEOUT)
+      {
+         TRACELOG(ERRORLOG, OPMLOG, "Timed out waiting for shared pool segment to be initialized",
+            0,0,0,0,0,0);
+         munmap(memory, segmentSize_);
+         return false;
+      }//end if
+      usleep(1000);
+   }//end while
+   __sync_synchronize();
+
+   if ((header->version_ != OPM_SHARED_POOL_VERSION) || (header->slotSize_ != slotSize_) ||
+       (header->slotCount_ != bufferCount_))
+   {
+      TRACELOG(ERRORLOG, OPMLOG, "Shared pool segment has %d buffers of %d bytes, expected %d of %d",
+         header->slotCount_, header->slotSize_, bufferCount_, slotSize_,0,0);
+      munmap(memory, segmentSize_);
+      return false;
+   }//end if
+
+   segment_ = (char*)memory;
+   header_ = header;
+   return true;
+}//end attachSegment
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the address of the free list link kept in a free buffer
+// Design:
+//-----------------------------------------------------------------------------
+volatile unsigned int* OPMSharedPool::getNextLink(unsigned int index) const
+{
+   return (volatile unsigned int*)(segment_ + header_->slotsOffset_ + ((unsigned long)index * header_->slotSize_));
+}//end getNextLink
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
+
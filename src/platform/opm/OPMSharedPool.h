@@ -0,0 +1,260 @@
+/******************************************************************************
+*
+* File name:   OPMSharedPool.h
+* Subsystem:   Platform Services
+* Description: Implements a fixed capacity pool of buffers that lives inside a
+*              named shared memory segment, so that processes on the same node
+*              can reserve a buffer, fill it in place and hand it to another
+*              process by its offset.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_SHARED_POOL_H_
+#define _PLAT_OPM_SHARED_POOL_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstddef>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMSlab.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+using namespace std;
+
+/** Identifies an initialized OPM shared pool segment ("OPMP") */
+#define OPM_SHARED_POOL_MAGIC             0x4f504d50
+
+/** Layout version of the OPM shared pool segment */
+#define OPM_SHARED_POOL_VERSION           1
+
+/** Segments are named with this prefix followed by the pool name */
+#define OPM_SHARED_POOL_SEGMENT_PREFIX    "/dev/shm/opmpool."
+
+/** Offset returned when no buffer could be reserved (the segment header is at offset 0) */
+#define OPM_SHARED_NULL_OFFSET            0
+
+/** Time (milliseconds) to wait for another process to finish initializing a segment */
+#define OPM_SHARED_POOL_ATTACH_TIMEOUT    1000
+
+/**
+ * Header at the start of an OPM shared pool segment. The buffers follow it,
+ * each starting on a cache line.
+ */
+struct OPMSharedPoolHeader
+{
+   /** OPM_SHARED_POOL_MAGIC once the segment has been initialized */
+   volatile unsigned int magic_;
+
+   /** OPM_SHARED_POOL_VERSION */
+   unsigned int version_;
+
+   /** Size of each buffer (rounded up to a multiple of OPM_CACHE_LINE_SIZE) */
+   unsigned int slotSize_;
+
+   /** Number of buffers */
+   unsigned int slotCount_;
+
+   /** Offset of the first buffer from the start of the segment */
+   unsigned long slotsOffset_;
+
+   /**
+    * Free list head: the low 32 bits hold the index of the first free buffer
+    * plus one (zero when the list is empty) and the high 32 bits a counter
+    * that changes on every update, so that a compare and swap cannot succeed
+    * on a head that was popped and pushed back in between (ABA).
+    */
+   volatile unsigned long long freeHead_;
+
+   /** Number of buffers currently reserved (gauge) */
+   volatile int usedCount_;
+
+   /** Peak number of buffers reserved (gauge) */
+   volatile int peakUsed_;
+
+   /** Reservations that failed because every buffer was reserved */
+   volatile unsigned long long reserveFailCount_;
+} __attribute__ ((aligned (OPM_CACHE_LINE_SIZE)));
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPMSharedPool is a pool of fixed size buffers kept in a shared memory
+ * segment (a file in /dev/shm named by OPM_SHARED_POOL_SEGMENT_PREFIX and the
+ * pool name) that every process opening the same pool name maps.
+ * <p>
+ * Since the segment is mapped at a different address in each process, the
+ * buffers are handed out as offsets from the start of the segment rather than
+ * pointers; getAddress converts an offset to a pointer in the calling process.
+ * A process reserves a buffer, fills it in place and passes only the offset to
+ * another process (for example through the LocalSMMailbox queue), which reads
+ * the buffer in place and releases it, so the contents are never copied.
+ * <p>
+ * Unlike the ObjectPool, the buffers hold raw bytes and not OPMBase objects
+ * (virtual tables and heap pointers are meaningless in another process), and
+ * the capacity is fixed when the segment is created since every process would
+ * otherwise have to remap it. The free list is a lock free stack updated with
+ * compare and swap, so that a process that dies while using the pool can not
+ * leave a lock held; the buffers it had reserved are lost until the segment
+ * is removed.
+ * <p>
+ * The first process to open a pool name creates and initializes the segment;
+ * the others wait for it to be initialized and check that they agree on the
+ * buffer size and count.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMSharedPool
+{
+   public:
+
+      /**
+       * Constructor
+       * @param poolName Name of the pool (shared by every process that uses it)
+       * @param bufferSize Size of each buffer in bytes
+       * @param bufferCount Number of buffers
+       */
+      OPMSharedPool(const char* poolName, unsigned int bufferSize, unsigned int bufferCount);
+
+      /** Virtual Destructor. Unmaps the segment but leaves it for the other processes */
+      virtual ~OPMSharedPool();
+
+      /**
+       * Create the (or map the already created) shared memory segment
+       * @return <tt>true</tt> if the pool can be used
+       */
+      bool open();
+
+      /** Unmap the segment (the pool can be opened again) */
+      void close();
+
+      /**
+       * Remove the segment name so that the next open creates a new segment.
+       * Processes that have it mapped keep using the old segment.
+       */
+      void remove();
+
+      /**
+       * Reserve a buffer
+       * @return Offset of the buffer, or OPM_SHARED_NULL_OFFSET if every buffer is reserved
+       */
+      unsigned long reserve();
+
+      /**
+       * Release a buffer reserved by this or another process
+       * @param offset Offset of the buffer returned by reserve
+       */
+      void release(unsigned long offset);
+
+      /**
+       * Return the address of a buffer in this process
+       * @param offset Offset of the buffer returned by reserve
+       */
+      void* getAddress(unsigned long offset) const;
+
+      /**
+       * Return the offset of a buffer from its address in this process
+       * @param address Address of a buffer in this process
+       */
+      unsigned long getOffset(const void* address) const;
+
+      /**
+       * Return whether an offset is that of a buffer in this pool (received
+       * offsets should be checked before they are used)
+       */
+      bool isValidOffset(unsigned long offset) const;
+
+      /** Return whether the pool is open */
+      bool isOpen() const;
+
+      /** Return the size of each buffer */
+      unsigned int getBufferSize() const;
+
+      /** Return the number of buffers */
+      unsigned int getBufferCount() const;
+
+      /** Return the number of buffers currently reserved by all processes */
+      int getUsedCount() const;
+
+      /**
+       * String'ized debugging method
+       * @return string representation of the contents of this object
+       */
+      string toString();
+
+   protected:
+
+   private:
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMSharedPool(const OPMSharedPool& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMSharedPool& operator= (const OPMSharedPool& rhs);
+
+      /** Create and initialize a new segment (fd is the newly created file) */
+      bool createSegment(int fd);
+
+      /** Map a segment created by another process (fd is the opened file) */
+      bool attachSegment(int fd);
+
+      /** Return the address of the free list link kept in a free buffer */
+      volatile unsigned int* getNextLink(unsigned int index) const;
+
+      /** Name of the pool */
+      string poolName_;
+
+      /** Name of the segment file */
+      string segmentName_;
+
+      /** Requested size of each buffer */
+      unsigned int bufferSize_;
+
+      /** Number of buffers */
+      unsigned int bufferCount_;
+
+      /** Size of each buffer in the segment (bufferSize_ rounded up to a cache line) */
+      unsigned int slotSize_;
+
+      /** Size of the mapped segment */
+      size_t segmentSize_;
+
+      /** Start of the mapped segment (NULL if not open) */
+      char* segment_;
+
+      /** Segment header (same address as segment_) */
+      OPMSharedPoolHeader* header_;
+};
+
+#endif
@@ -0,0 +1,210 @@
+/******************************************************************************
+*
+* File name:   OPMSlab.cpp
+* Subsystem:   Platform Services
+* Description: Implements a contiguous block of memory that holds one capacity
+*              increment worth of pooled objects for slab mode Object Pools.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMSlab.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the slot size used for objects of the specified size
+// Design:      Rounded up to a whole number of cache lines
+//-----------------------------------------------------------------------------
+size_t OPMSlab::getObjectStride(size_t objectSize)
+{
+   return ((objectSize + OPM_CACHE_LINE_SIZE - 1) / OPM_CACHE_LINE_SIZE) * OPM_CACHE_LINE_SIZE;
+}//end getObjectStride
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description: Constructor maps the memory for the slab
+// Design:      Hugepage slabs first try MAP_HUGETLB (which requires pages to
+//              be reserved via vm.nr_hugepages), then fall back to a normal
+//              mapping advised for transparent hugepages.
+//-----------------------------------------------------------------------------
+OPMSlab::OPMSlab(size_t objectSize, int objectCount, int slabOptions)
+  :memory_(NULL),
+   length_(0),
+   stride_(getObjectStride(objectSize)),
+   objectCount_(objectCount),
+   isHugePageBacked_(false)
+{
+   size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+   size_t requiredLength = stride_ * objectCount_;
+   void* memory = MAP_FAILED;
+
+   int mapFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+   if (slabOptions & OPM_SLAB_PREFAULT)
+   {
+      mapFlags |= MAP_POPULATE;
+   }//end if
+#endif
+
+#ifdef MAP_HUGETLB
+   if (slabOptions & OPM_SLAB_HUGEPAGES)
+   {
+      length_ = ((requiredLength + OPM_HUGEPAGE_SIZE - 1) / OPM_HUGEPAGE_SIZE) * OPM_HUGEPAGE_SIZE;
+      memory = mmap(NULL, length_, PROT_READ | PROT_WRITE, mapFlags | MAP_HUGETLB, -1, 0);
+      if (memory != MAP_FAILED)
+      {
+         isHugePageBacked_ = true;
+      }//end if
+      else
+      {
+         TRACELOG(DEBUGLOG, OPMLOG, "No reserved hugepages available for slab of %d bytes, using normal pages",
+            length_,0,0,0,0,0);
+      }//end else
+   }//end if
+#endif
+
+   if (memory == MAP_FAILED)
+   {
+      length_ = ((requiredLength + pageSize - 1) / pageSize) * pageSize;
+      memory = mmap(NULL, length_, PROT_READ | PROT_WRITE, mapFlags, -1, 0);
+      if (memory == MAP_FAILED)
+      {
+         TRACELOG(ERRORLOG, OPMLOG, "Unable to map slab of %d bytes for %d objects",
+            length_, objectCount_,0,0,0,0);
+         length_ = 0;
+         return;
+      }//end if
+
+#ifdef MADV_HUGEPAGE
+      if (slabOptions & OPM_SLAB_HUGEPAGES)
+      {
+         madvise(memory, length_, MADV_HUGEPAGE);
+      }//end if
+#endif
+   }//end if
+
+   memory_ = (char*)memory;
+
+   // Touch every page so that the objects never take a page fault at runtime
+   // (MAP_POPULATE is only a hint on some kernels)
+   if (slabOptions & OPM_SLAB_PREFAULT)
+   {
+      for (size_t offset = 0; offset < length_; offset += pageSize)
+      {
+         ((volatile char*)memory_)[offset] = 0;
+      }//end for
+   }//end if
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description: Unmaps the memory for the slab. All objects in the slab must
+//              already have been destroyed.
+// Design:     
+//-----------------------------------------------------------------------------
+OPMSlab::~OPMSlab()
+{
+   if (memory_ != NULL)
+   {
+      munmap(memory_, length_);
+   }//end if
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return true if the slab memory was successfully mapped
+// Design:     
+//-----------------------------------------------------------------------------
+bool OPMSlab::isAllocated()
+{
+   return (memory_ != NULL);
+}//end isAllocated
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return true if the slab is backed by reserved hugepages
+// Design:     
+//-----------------------------------------------------------------------------
+bool OPMSlab::isHugePageBacked()
+{
+   return isHugePageBacked_;
+}//end isHugePageBacked
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the memory for the specified object slot
+// Design:     
+//-----------------------------------------------------------------------------
+void* OPMSlab::getObjectMemory(int index)
+{
+   return (memory_ + (index * stride_));
+}//end getObjectMemory
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of object slots in the slab
+// Design:     
+//-----------------------------------------------------------------------------
+int OPMSlab::getObjectCount()
+{
+   return objectCount_;
+}//end getObjectCount
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of bytes of memory mapped for the slab
+// Design:     
+//-----------------------------------------------------------------------------
+size_t OPMSlab::getLength()
+{
+   return length_;
+}//end getLength
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
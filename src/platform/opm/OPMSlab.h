@@ -0,0 +1,150 @@
+/******************************************************************************
+*
+* File name:   OPMSlab.h
+* Subsystem:   Platform Services
+* Description: Implements a contiguous block of memory that holds one capacity
+*              increment worth of pooled objects for slab mode Object Pools.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_SLAB_H_
+#define _PLAT_OPM_SLAB_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstddef>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Objects within a slab are each aligned (and padded) to this size */
+#define OPM_CACHE_LINE_SIZE               64
+
+/** Size of the (x86_64 default) hugepages used for OPM_SLAB_HUGEPAGES slabs */
+#define OPM_HUGEPAGE_SIZE                 (2 * 1024 * 1024)
+
+// Options for slab mode Object Pools (may be OR'ed together)
+
+/** Plain page backed slabs, faulted in as the objects are constructed */
+#define OPM_SLAB_DEFAULT                  0x0
+
+/** Back the slabs with hugepages, falling back to transparent hugepages and
+    then to normal pages if none are reserved on the system. Since each slab is
+    rounded up to a whole hugepage, this is only sensible for pools whose
+    capacity increments are themselves large. */
+#define OPM_SLAB_HUGEPAGES                0x1
+
+/** Fault in every page of the slab when it is allocated, so that no page
+    faults are taken at runtime */
+#define OPM_SLAB_PREFAULT                 0x2
+
+// For C++ class declarations, we have one (and only one) of these access 
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPMSlab is a single contiguous, page (and therefore cache line) aligned
+ * block of memory divided into equally sized object slots. Slab mode Object
+ * Pools allocate one OPMSlab per capacity increment and construct the pooled
+ * objects in place inside of it, so that objects of a hot pool are packed
+ * together rather than scattered across the heap.
+ * <p>
+ * Each slot is padded to a multiple of OPM_CACHE_LINE_SIZE so that two objects
+ * never share a cache line. The slab does not construct or destroy objects;
+ * that is the responsibility of the owning ObjectPool.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMSlab
+{
+   public:
+
+      /**
+       * Return the slot size used for objects of the specified size
+       * @param objectSize Size in bytes of each object
+       */
+      static size_t getObjectStride(size_t objectSize);
+
+      /**
+       * Constructor maps the memory for the slab
+       * @param objectSize Size in bytes of each object
+       * @param objectCount Number of object slots in the slab
+       * @param slabOptions OR'ed combination of the OPM_SLAB_ options
+       */
+      OPMSlab(size_t objectSize, int objectCount, int slabOptions);
+
+      /** Virtual Destructor unmaps the memory for the slab */
+      virtual ~OPMSlab();
+
+      /** Return true if the slab memory was successfully mapped */
+      bool isAllocated();
+
+      /** Return true if the slab is backed by explicitly reserved hugepages */
+      bool isHugePageBacked();
+
+      /**
+       * Return the memory for the specified object slot
+       * @param index Slot number from 0 to getObjectCount() - 1
+       */
+      void* getObjectMemory(int index);
+
+      /** Return the number of object slots in the slab */
+      int getObjectCount();
+
+      /** Return the number of bytes of memory mapped for the slab */
+      size_t getLength();
+
+   protected:
+
+   private:
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMSlab(const OPMSlab& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMSlab& operator= (const OPMSlab& rhs);
+
+      /** Start of the mapped memory (NULL if the mapping failed) */
+      char* memory_;
+
+      /** Number of bytes mapped */
+      size_t length_;
+
+      /** Bytes between the start of consecutive object slots */
+      size_t stride_;
+
+      /** Number of object slots */
+      int objectCount_;
+
+      /** Whether the mapping uses explicitly reserved hugepages */
+      bool isHugePageBacked_;
+};
+
+#endif
@@ -0,0 +1,321 @@
+/******************************************************************************
+*
+* File name:   OPMStats.cpp
+* Subsystem:   Platform Services
+* Description: Implements the per-pool OPM statistics (contention, latency and
+*              growth counters) kept in a shared memory segment per process so
+*              that they can be read by an external tool while the process runs.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <ace/OS_NS_sys_time.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMStats.h"
+
+// Common Defines
+#include "platform/common/Defines.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+/** Statistics segment of this process */
+OPMStatsSegment* OPMStats::segment_ = NULL;
+
+/** Whether segment_ is mapped from the shared memory file */
+bool OPMStats::isShared_ = false;
+
+/** Statistics entry given out when no segment could be allocated */
+OPMPoolStats OPMStats::unavailableStats_;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Create and map the statistics segment for this process
+// Design:      The magic number is written last, so a reader that maps the
+//              file while it is being set up does not accept it yet.
+//-----------------------------------------------------------------------------
+bool OPMStats::initialize()
+{
+   if (segment_ != NULL)
+   {
+      return isShared_;
+   }//end if
+
+   char segmentName[128];
+   getSegmentName(getpid(), segmentName, sizeof(segmentName));
+
+   OPMStatsSegment* segment = NULL;
+   int fd = open(segmentName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd != ERROR)
+   {
+      if (ftruncate(fd, sizeof(OPMStatsSegment)) == 0)
+      {
+         void* memory = mmap(NULL, sizeof(OPMStatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+         if (memory != MAP_FAILED)
+         {
+            segment = (OPMStatsSegment*)memory;
+         }//end if
+      }//end if
+      close(fd);
+   }//end if
+
+   if (segment != NULL)
+   {
+      isShared_ = true;
+   }//end if
+   else
+   {
+      TRACELOG(WARNINGLOG, OPMLOG, "Unable to create the OPM statistics segment, keeping statistics locally",
+         0,0,0,0,0,0);
+      unlink(segmentName);
+      //anonymous memory keeps the pool statistics cache line aligned, which
+      // operator new does not guarantee
+      void* memory = mmap(NULL, sizeof(OPMStatsSegment), PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS, ERROR, 0);
+      if (memory == MAP_FAILED)
+      {
+         TRACELOG(ERRORLOG, OPMLOG, "Unable to allocate the OPM statistics", 0,0,0,0,0,0);
+         return false;
+      }//end if
+      segment = (OPMStatsSegment*)memory;
+      isShared_ = false;
+   }//end else
+
+   memset(segment, 0, sizeof(OPMStatsSegment));
+   segment->version_ = OPM_STATS_VERSION;
+   segment->processId_ = getpid();
+   __sync_synchronize();
+   segment->magic_ = OPM_STATS_MAGIC;
+   segment_ = segment;
+   return isShared_;
+}//end initialize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Unmap and remove the statistics segment
+// Design:
+//-----------------------------------------------------------------------------
+void OPMStats::shutdown()
+{
+   if (segment_ == NULL)
+   {
+      return;
+   }//end if
+
+   if (isShared_)
+   {
+      char segmentName[128];
+      getSegmentName(getpid(), segmentName, sizeof(segmentName));
+      segment_->magic_ = 0;
+      unlink(segmentName);
+   }//end if
+   munmap((void*)segment_, sizeof(OPMStatsSegment));
+   segment_ = NULL;
+   isShared_ = false;
+}//end shutdown
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return (and initialize) the statistics entry for a new pool
+// Design:      Pools are created one at a time (under the OPM pool table
+//              mutex), so no further locking is needed here.
+//-----------------------------------------------------------------------------
+OPMPoolStats* OPMStats::createPoolStats(int objectPoolID, const char* objectType)
+{
+   if (segment_ == NULL)
+   {
+      initialize();
+   }//end if
+
+   //the pools never check for statistics, so give them somewhere to count
+   if ((segment_ == NULL) || (objectPoolID < 0) || (objectPoolID >= OPM_STATS_MAX_POOLS))
+   {
+      return &unavailableStats_;
+   }//end if
+
+   OPMPoolStats* stats = &(segment_->pools_[objectPoolID]);
+   memset((void*)stats, 0, sizeof(OPMPoolStats));
+   stats->poolID_ = objectPoolID;
+   strncpy(stats->objectType_, objectType, OPM_STATS_TYPE_LENGTH - 1);
+   stats->isActive_ = 1;
+   if (segment_->poolCount_ <= objectPoolID)
+   {
+      segment_->poolCount_ = objectPoolID + 1;
+   }//end if
+   return stats;
+}//end createPoolStats
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Map the statistics segment of another process read only
+// Design:
+//-----------------------------------------------------------------------------
+const OPMStatsSegment* OPMStats::attach(pid_t processId)
+{
+   char segmentName[128];
+   getSegmentName(processId, segmentName, sizeof(segmentName));
+
+   int fd = open(segmentName, O_RDONLY);
+   if (fd == ERROR)
+   {
+      return NULL;
+   }//end if
+
+   void* memory = mmap(NULL, sizeof(OPMStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (memory == MAP_FAILED)
+   {
+      return NULL;
+   }//end if
+
+   const OPMStatsSegment* segment = (const OPMStatsSegment*)memory;
+   if ((segment->magic_ != OPM_STATS_MAGIC) || (segment->version_ != OPM_STATS_VERSION))
+   {
+      munmap(memory, sizeof(OPMStatsSegment));
+      return NULL;
+   }//end if
+   return segment;
+}//end attach
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Unmap a segment mapped with attach
+// Design:
+//-----------------------------------------------------------------------------
+void OPMStats::detach(const OPMStatsSegment* segment)
+{
+   if (segment != NULL)
+   {
+      munmap((void*)segment, sizeof(OPMStatsSegment));
+   }//end if
+}//end detach
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Record a contended pool lock wait
+// Design:
+//-----------------------------------------------------------------------------
+void OPMStats::recordLockWait(OPMPoolStats* stats, unsigned long long waitUsec)
+{
+   //contentionCount_ is also bumped (atomically) by failed non-blocking attempts
+   __sync_fetch_and_add(&stats->contentionCount_, 1ULL);
+   stats->lockWaitUsec_ += waitUsec;
+   stats->lockWaitHistogram_[getHistogramBucket(waitUsec)]++;
+}//end recordLockWait
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Record the addition of a capacity increment
+// Design:
+//-----------------------------------------------------------------------------
+void OPMStats::recordGrowth(OPMPoolStats* stats, unsigned long long growthUsec, bool isSynchronous)
+{
+   stats->growthCount_++;
+   if (isSynchronous)
+   {
+      stats->synchronousGrowthCount_++;
+   }//end if
+   stats->growthUsec_ += growthUsec;
+   if (growthUsec > stats->maxGrowthUsec_)
+   {
+      stats->maxGrowthUsec_ = growthUsec;
+   }//end if
+}//end recordGrowth
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the histogram bucket for a lock wait time
+// Design:      Bucket N holds waits from 2^N up to 2^(N+1) microseconds
+//-----------------------------------------------------------------------------
+int OPMStats::getHistogramBucket(unsigned long long waitUsec)
+{
+   int bucket = 0;
+   while ((waitUsec > 1ULL) && (bucket < (OPM_STATS_HISTOGRAM_BUCKETS - 1)))
+   {
+      waitUsec >>= 1;
+      bucket++;
+   }//end while
+   return bucket;
+}//end getHistogramBucket
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the lower bound (microseconds) of a histogram bucket
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long OPMStats::getHistogramBucketStart(int bucket)
+{
+   return ((bucket == 0) ? 0ULL : (1ULL << bucket));
+}//end getHistogramBucketStart
+
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the current time of day in microseconds
+// Design:
+//-----------------------------------------------------------------------------
+unsigned long long OPMStats::getTimeUsec()
+{
+   ACE_Time_Value now = ACE_OS::gettimeofday();
+   return (((unsigned long long)now.sec() * 1000000ULL) + (unsigned long long)now.usec());
+}//end getTimeUsec
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Build the segment file name for a process
+// Design:
+//-----------------------------------------------------------------------------
+void OPMStats::getSegmentName(pid_t processId, char* segmentName, int segmentNameLength)
+{
+   snprintf(segmentName, segmentNameLength, "%s%d", OPM_STATS_SEGMENT_PREFIX, (int)processId);
+}//end getSegmentName
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
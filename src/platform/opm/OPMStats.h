@@ -0,0 +1,266 @@
+/******************************************************************************
+*
+* File name:   OPMStats.h
+* Subsystem:   Platform Services
+* Description: Implements the per-pool OPM statistics (contention, latency and
+*              growth counters) kept in a shared memory segment per process so
+*              that they can be read by an external tool while the process runs.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_STATS_H_
+#define _PLAT_OPM_STATS_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sys/types.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPM.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Identifies a valid OPM statistics segment ("OPMS") */
+#define OPM_STATS_MAGIC                   0x4f504d53
+
+/** Layout version of the OPM statistics segment */
+#define OPM_STATS_VERSION                 1
+
+/** Segments are named with this prefix followed by the process Id */
+#define OPM_STATS_SEGMENT_PREFIX          "/dev/shm/opmstats."
+
+/** Maximum length (including the terminator) of the object type kept per pool */
+#define OPM_STATS_TYPE_LENGTH             64
+
+/**
+ * Number of buckets in the lock wait histograms. Bucket 0 counts waits under
+ * 2 microseconds, bucket N counts waits from 2^N up to 2^(N+1) microseconds,
+ * and the last bucket counts everything longer.
+ */
+#define OPM_STATS_HISTOGRAM_BUCKETS       20
+
+/**
+ * Number of pools whose statistics the segment holds (the first pool IDs);
+ * the pools beyond it still run, but are not shown by OPMStat
+ */
+#define OPM_STATS_MAX_POOLS               256
+
+/** Thread caches add their reserve/release counts to the statistics in batches of this size */
+#define OPM_STATS_FLUSH_COUNT             256
+
+/**
+ * Counters for a single Object Pool. Counters only ever increase (readers
+ * compute rates from two snapshots); gauges hold the current value. Each one
+ * is naturally aligned, so a reader never sees a torn value, although the
+ * fields of a snapshot are not read as one atomic set.
+ */
+struct OPMPoolStats
+{
+   /** Non-zero while the pool exists */
+   volatile int isActive_;
+
+   /** Object Pool ID of the pool */
+   volatile int poolID_;
+
+   /** Object type of the pool (NULL terminated) */
+   char objectType_[OPM_STATS_TYPE_LENGTH];
+
+   /** Objects reserved from the pool itself (including thread cache refills) */
+   volatile unsigned long long reserveCount_;
+
+   /** Objects released into the pool itself (including thread cache drains) */
+   volatile unsigned long long releaseCount_;
+
+   /** Reservations served by thread caches without locking the pool */
+   volatile unsigned long long cacheReserveCount_;
+
+   /** Releases absorbed by thread caches without locking the pool */
+   volatile unsigned long long cacheReleaseCount_;
+
+   /** Reservations that returned NULL (pool exhausted or lock busy for non-blocking) */
+   volatile unsigned long long reserveFailCount_;
+
+   /** Pool lock acquisitions that found the lock held by another thread */
+   volatile unsigned long long contentionCount_;
+
+   /** Total microseconds spent waiting for the (contended) pool lock */
+   volatile unsigned long long lockWaitUsec_;
+
+   /** Histogram of contended pool lock wait times (see OPM_STATS_HISTOGRAM_BUCKETS) */
+   volatile unsigned long long lockWaitHistogram_[OPM_STATS_HISTOGRAM_BUCKETS];
+
+   /** Capacity increments added to the pool */
+   volatile unsigned long long growthCount_;
+
+   /** Capacity increments that were added on a reserving thread */
+   volatile unsigned long long synchronousGrowthCount_;
+
+   /** Total microseconds spent constructing and adding capacity increments */
+   volatile unsigned long long growthUsec_;
+
+   /** Longest time (microseconds) taken to add a single capacity increment */
+   volatile unsigned long long maxGrowthUsec_;
+
+   /** Capacity increments given back by the pool */
+   volatile unsigned long long shrinkCount_;
+
+   /** Current capacity of the pool (gauge) */
+   volatile int currentCapacity_;
+
+   /** Current number of used objects, including those in thread caches (gauge) */
+   volatile int currentUsed_;
+
+   /** Peak number of used objects (gauge) */
+   volatile int peakUsed_;
+
+   /** Padding to keep each pool's statistics in separate cache lines */
+   int reserved_;
+} __attribute__ ((aligned (OPM_CACHE_LINE_SIZE)));
+
+/** Layout of the OPM statistics segment of one process */
+struct OPMStatsSegment
+{
+   /** OPM_STATS_MAGIC once the segment has been initialized */
+   volatile unsigned int magic_;
+
+   /** OPM_STATS_VERSION */
+   unsigned int version_;
+
+   /** Process Id of the writing process */
+   int processId_;
+
+   /** Number of pool entries that have been used */
+   volatile int poolCount_;
+
+   /** Statistics of each pool, indexed by Object Pool ID */
+   OPMPoolStats pools_[OPM_STATS_MAX_POOLS];
+};
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPMStats owns the statistics segment of the process. The segment is a file
+ * in /dev/shm (named by OPM_STATS_SEGMENT_PREFIX and the process Id) mapped
+ * shared, so the pools update their counters with plain stores (each pool's
+ * counters are only written while its lock is held, or atomically) and an
+ * external tool such as OPMStat maps the same file read only to see them,
+ * without stopping or signalling the process.
+ * <p>
+ * If the segment cannot be created, the statistics are kept in process local
+ * memory instead so that the pools never need to check for it.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMStats
+{
+   public:
+
+      /**
+       * Create and map the statistics segment for this process (called by
+       * OPM::initialize). Does nothing if it is already mapped.
+       * @return <tt>true</tt> if the statistics are in shared memory
+       */
+      static bool initialize();
+
+      /** Unmap and remove the statistics segment (called by OPM::shutdown) */
+      static void shutdown();
+
+      /**
+       * Return (and initialize) the statistics entry for a new Object Pool
+       * @param objectPoolID Object Pool ID of the pool
+       * @param objectType Object type of the pool
+       * @return Statistics entry (never NULL)
+       */
+      static OPMPoolStats* createPoolStats(int objectPoolID, const char* objectType);
+
+      /**
+       * Map the statistics segment of another process read only
+       * @param processId Process Id of the process to read
+       * @return Segment or NULL if it does not exist or is not valid
+       */
+      static const OPMStatsSegment* attach(pid_t processId);
+
+      /**
+       * Unmap a segment mapped with attach
+       * @param segment Segment returned by attach
+       */
+      static void detach(const OPMStatsSegment* segment);
+
+      /**
+       * Record a contended pool lock wait in a pool's statistics (the pool lock
+       * must be held)
+       * @param stats Statistics of the pool
+       * @param waitUsec Time (microseconds) spent waiting for the lock
+       */
+      static void recordLockWait(OPMPoolStats* stats, unsigned long long waitUsec);
+
+      /**
+       * Record the addition of a capacity increment in a pool's statistics (the
+       * pool lock must be held)
+       * @param stats Statistics of the pool
+       * @param growthUsec Time (microseconds) spent creating and adding the increment
+       * @param isSynchronous Whether it was added on a reserving thread
+       */
+      static void recordGrowth(OPMPoolStats* stats, unsigned long long growthUsec, bool isSynchronous);
+
+      /**
+       * Return the histogram bucket for a lock wait time
+       * @param waitUsec Time (microseconds) spent waiting for the lock
+       */
+      static int getHistogramBucket(unsigned long long waitUsec);
+
+      /**
+       * Return the lower bound (microseconds) of a histogram bucket
+       * @param bucket Histogram bucket
+       */
+      static unsigned long long getHistogramBucketStart(int bucket);
+
+      /** Return the current time of day in microseconds (for timing pool operations) */
+      static unsigned long long getTimeUsec();
+
+   protected:
+
+   private:
+
+      /**
+       * Build the segment file name for a process
+       * @param processId Process Id
+       * @param segmentName Buffer that receives the name
+       * @param segmentNameLength Size of the buffer
+       */
+      static void getSegmentName(pid_t processId, char* segmentName, int segmentNameLength);
+
+      /** Statistics segment of this process (shared or process local) */
+      static OPMStatsSegment* segment_;
+
+      /** Whether segment_ is mapped from the shared memory file */
+      static bool isShared_;
+
+      /** Statistics entry given out when no segment could be allocated (never read) */
+      static OPMPoolStats unavailableStats_;
+};
+
+#endif
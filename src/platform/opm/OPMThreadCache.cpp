@@ -0,0 +1,339 @@
+/******************************************************************************
+*
+* File name:   OPMThreadCache.cpp
+* Subsystem:   Platform Services
+* Description: Implements the per-thread object caches that sit in front of
+*              the thread safe Object Pools.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <sstream>
+
+#include <ace/OS_NS_unistd.h>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMThreadCache.h"
+#include "ObjectPool.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description: 
+// Design:     
+//-----------------------------------------------------------------------------
+OPMThreadCache::OPMThreadCache()
+               : shutdownCount_(OPM::shutdownCount_)
+{
+   for (int i = 0; i < OPM_MAX_POOL_BLOCKS; i++)
+   {
+      magazineBlocks_[i] = NULL;
+   }//end for
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description: Returns all cached objects into their pools (called by ACE_TSS
+//              when the owning thread exits)
+// Design:     
+//-----------------------------------------------------------------------------
+OPMThreadCache::~OPMThreadCache()
+{
+   flushAll();
+   deleteMagazines();
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Reserve an object for the calling thread from its cache
+// Design:      An empty magazine is refilled with half of its capacity in one
+//              pool lock.
+//-----------------------------------------------------------------------------
+OPMBase* OPMThreadCache::reserve(ObjectPool* pool, bool blockWaitingForAccess)
+{
+   checkShutdown();
+   Magazine* magazine = getMagazine(pool);
+
+   if (magazine->count_ == 0)
+   {
+      int batchSize = (magazine->capacity_ + 1) / 2;
+      magazine->count_ = pool->reserveBatch(magazine->objects_, batchSize, blockWaitingForAccess);
+      if (magazine->count_ == 0)
+      {
+         return NULL;
+      }//end if
+      // All but the object handed out below are now parked in this cache
+      for (int i = 0; i < magazine->count_; i++)
+      {
+         magazine->objects_[i]->setObjectState(OPM_OBJECT_CACHED);
+      }//end for
+      pool->adjustCachedObjects(magazine->count_ - 1);
+   }//end if
+   else
+   {
+      pool->adjustCachedObjects(-1);
+   }//end else
+
+   OPMBase* object = magazine->objects_[--magazine->count_];
+   object->setObjectState(OPM_OBJECT_USED);
+   if (++magazine->pendingReserves_ >= OPM_STATS_FLUSH_COUNT)
+   {
+      flushStats(pool, magazine);
+   }//end if
+   return object;
+}//end reserve
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Clean an object and place it into the calling thread's cache
+// Design:      A full magazine returns half of its capacity in one pool lock.
+//-----------------------------------------------------------------------------
+bool OPMThreadCache::release(ObjectPool* pool, OPMBase* object, const char* callingFileName,
+   int callingLineNumb)
+{
+   //check that the object is currently reserved; caching an object twice would
+   // hand it out to two users later
+   if (object->getObjectState() != OPM_OBJECT_USED)
+   {
+      ostringstream oss;
+      oss << "Attempt to release object into the thread cache for Pool " << pool->getObjectType()
+          << " that is already released. Called from " << callingFileName << " (" 
+          << callingLineNumb << ") and Process (" << getpid() << ")" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, oss.str().c_str());
+      return false;
+   }//end if
+
+   checkShutdown();
+   Magazine* magazine = getMagazine(pool);
+
+   if (magazine->count_ == magazine->capacity_)
+   {
+      drain(pool, magazine, (magazine->capacity_ + 1) / 2);
+   }//end if
+
+   //Clean the Object before caching it
+   object->clean();
+
+   object->setObjectState(OPM_OBJECT_CACHED);
+   magazine->objects_[magazine->count_++] = object;
+   pool->adjustCachedObjects(1);
+   if (++magazine->pendingReleases_ >= OPM_STATS_FLUSH_COUNT)
+   {
+      flushStats(pool, magazine);
+   }//end if
+
+   //if in DEBUG mode, print a successful DEBUG log message
+   if (Logger::getSubsystemLogLevel(OPMLOG) == DEVELOPERLOG)
+   {
+      ostringstream oss;
+      oss << "OPM Object successfully released into thread cache for Pool " 
+          << pool->getObjectType() << ". Called from " << callingFileName 
+          << " (" << callingLineNumb << ")" << ends;
+      STRACELOG(DEBUGLOG, OPMLOG, oss.str().c_str());
+   }//end if
+   return true;
+}//end release
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return all of the objects in this thread's caches into their
+//              pools.
+// Design:      Pools are looked up by ID, since a pool that has been deleted
+//              by OPM::shutdown no longer appears in the pool table (and has
+//              already deleted the cached objects along with its Used List).
+//-----------------------------------------------------------------------------
+void OPMThreadCache::flushAll()
+{
+   checkShutdown();
+   for (int i = 0; i < OPM_MAX_POOL_BLOCKS; i++)
+   {
+      Magazine** magazineBlock = magazineBlocks_[i];
+      if (magazineBlock == NULL)
+      {
+         continue;
+      }//end if
+
+      for (int j = 0; j < OPM_POOL_BLOCK_SIZE; j++)
+      {
+         Magazine* magazine = magazineBlock[j];
+         if (magazine == NULL)
+         {
+            continue;
+         }//end if
+
+         ObjectPool* pool = OPM::getTableEntry((i * OPM_POOL_BLOCK_SIZE) + j);
+         if (pool == NULL)
+         {
+            magazine->count_ = 0;
+            magazine->pendingReserves_ = 0;
+            magazine->pendingReleases_ = 0;
+            continue;
+         }//end if
+
+         flushStats(pool, magazine);
+         if (magazine->count_ > 0)
+         {
+            drain(pool, magazine, magazine->count_);
+         }//end if
+      }//end for
+   }//end for
+}//end flushAll
+
+
+//-----------------------------------------------------------------------------
+// PROTECTED methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// PRIVATE methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the magazine for the specified pool, creating it on
+//              first use.
+// Design:      The capacity is fixed when the magazine is created
+//-----------------------------------------------------------------------------
+OPMThreadCache::Magazine* OPMThreadCache::getMagazine(ObjectPool* pool)
+{
+   int poolID = pool->getObjectPoolID();
+   Magazine** magazineBlock = magazineBlocks_[poolID / OPM_POOL_BLOCK_SIZE];
+   if (magazineBlock == NULL)
+   {
+      magazineBlock = new Magazine*[OPM_POOL_BLOCK_SIZE];
+      for (int i = 0; i < OPM_POOL_BLOCK_SIZE; i++)
+      {
+         magazineBlock[i] = NULL;
+      }//end for
+      magazineBlocks_[poolID / OPM_POOL_BLOCK_SIZE] = magazineBlock;
+   }//end if
+
+   Magazine* magazine = magazineBlock[poolID % OPM_POOL_BLOCK_SIZE];
+   if (magazine == NULL)
+   {
+      magazine = new Magazine();
+      magazine->capacity_ = pool->getThreadCacheSize();
+      if (magazine->capacity_ <= 0)
+      {
+         magazine->capacity_ = OPM_DEFAULT_THREAD_CACHE_SIZE;
+      }//end if
+      magazine->objects_ = new OPMBase*[magazine->capacity_];
+      magazine->count_ = 0;
+      magazine->pendingReserves_ = 0;
+      magazine->pendingReleases_ = 0;
+      magazineBlock[poolID % OPM_POOL_BLOCK_SIZE] = magazine;
+   }//end if
+   return magazine;
+}//end getMagazine
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return objectCount objects from the top of the magazine into
+//              the pool.
+// Design:     
+//-----------------------------------------------------------------------------
+void OPMThreadCache::drain(ObjectPool* pool, Magazine* magazine, int objectCount)
+{
+   magazine->count_ -= objectCount;
+   pool->releaseBatch(&magazine->objects_[magazine->count_], objectCount, __FILE__, __LINE__);
+   pool->adjustCachedObjects(-objectCount);
+}//end drain
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Add the magazine's pending reserve/release counts to the pool
+//              statistics
+// Design:      Counted locally and added in batches, so that the cache hit
+//              path does not write to a cache line shared with other threads
+//-----------------------------------------------------------------------------
+void OPMThreadCache::flushStats(ObjectPool* pool, Magazine* magazine)
+{
+   pool->addCacheOperations(magazine->pendingReserves_, magazine->pendingReleases_);
+   magazine->pendingReserves_ = 0;
+   magazine->pendingReleases_ = 0;
+}//end flushStats
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Discard every magazine if OPM has been shut down since this
+//              cache was last used
+// Design:      The objects were deleted along with their pools, so they are
+//              forgotten rather than returned. This only reads a counter on
+//              the cache hit path.
+//-----------------------------------------------------------------------------
+void OPMThreadCache::checkShutdown()
+{
+   unsigned int shutdownCount = OPM::shutdownCount_;
+   if (shutdownCount != shutdownCount_)
+   {
+      deleteMagazines();
+      shutdownCount_ = shutdownCount;
+   }//end if
+}//end checkShutdown
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Delete every magazine (but not the objects in them)
+// Design:
+//-----------------------------------------------------------------------------
+void OPMThreadCache::deleteMagazines()
+{
+   for (int i = 0; i < OPM_MAX_POOL_BLOCKS; i++)
+   {
+      Magazine** magazineBlock = magazineBlocks_[i];
+      if (magazineBlock == NULL)
+      {
+         continue;
+      }//end if
+      for (int j = 0; j < OPM_POOL_BLOCK_SIZE; j++)
+      {
+         if (magazineBlock[j] != NULL)
+         {
+            delete [] magazineBlock[j]->objects_;
+            delete magazineBlock[j];
+         }//end if
+      }//end for
+      delete [] magazineBlock;
+      magazineBlocks_[i] = NULL;
+   }//end for
+}//end deleteMagazines
+
+
+//-----------------------------------------------------------------------------
+// Nested Class Definitions:
+//-----------------------------------------------------------------------------
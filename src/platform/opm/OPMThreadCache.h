@@ -0,0 +1,182 @@
+/******************************************************************************
+*
+* File name:   OPMThreadCache.h
+* Subsystem:   Platform Services
+* Description: Implements the per-thread object caches that sit in front of
+*              the thread safe Object Pools.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_THREAD_CACHE_H_
+#define _PLAT_OPM_THREAD_CACHE_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPM.h"
+#include "OPMBase.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+class ObjectPool;
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * OPMThreadCache holds, for a single thread, a small stack ('magazine') of
+ * free objects for each thread safe Object Pool that has thread caches enabled.
+ * <p>
+ * Reserving from a non-empty magazine and releasing into a non-full magazine
+ * involve no locking at all. An empty magazine is refilled with half of its
+ * capacity with one call to ObjectPool::reserveBatch, and a full magazine
+ * returns half of its capacity with one call to ObjectPool::releaseBatch, so
+ * the shared pool lock is taken at most once per batch.
+ * <p>
+ * Objects in a magazine stay on the shared pool's Used List, in the
+ * OPM_OBJECT_CACHED state, so that pool shutdown still cleans them up. One
+ * instance exists per thread (via ACE_TSS in OPM) and its destructor returns
+ * all cached objects to their pools when the thread exits.
+ * <p>
+ * OPM::shutdown deletes the pools, including the objects still in the caches
+ * of other threads. Each cache remembers the OPM shutdown count it was filled
+ * under, and discards all of its magazines (without touching their objects)
+ * when the count has changed, so that it never hands a deleted object out or
+ * returns one into a new pool that has reused the pool ID.
+ * <p>
+ * This class is NOT THREAD SAFE, by design it is only accessed by its own thread.
+ *
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMThreadCache
+{
+   public:
+
+      /** Constructor */
+      OPMThreadCache();
+
+      /** Virtual Destructor returns all cached objects into their pools */
+      virtual ~OPMThreadCache();
+
+      /**
+       * Reserve an object for the calling thread from its cache for the pool,
+       * refilling the cache from the pool in a batch if it is empty.
+       * @param pool Thread safe Object Pool to reserve from
+       * @param blockWaitingForAccess See ObjectPool::reserve
+       * @return OPMBase object or NULL if none are available
+       */
+      OPMBase* reserve(ObjectPool* pool, bool blockWaitingForAccess);
+
+      /**
+       * Clean an object and place it into the calling thread's cache for the pool,
+       * returning half of the cache to the pool in a batch if it is full.
+       * @param pool Thread safe Object Pool that owns the object
+       * @param object Object to release
+       * @param callingFileName Source file from which the object is being released
+       * @param callingLineNumb Source line from which the object is being released
+       * @return <tt>true</tt> if the object was successfully released
+       */
+      bool release(ObjectPool* pool, OPMBase* object, const char* callingFileName,
+                   int callingLineNumb);
+
+      /** Return all of the objects in this thread's caches into their pools */
+      void flushAll();
+
+   protected:
+
+   private:
+
+      /** Per pool stack of cached (free and cleaned) objects */
+      struct Magazine
+      {
+         /** Cached objects; objects_[0..count_-1] are valid */
+         OPMBase** objects_;
+
+         /** Number of objects currently cached */
+         int count_;
+
+         /** Maximum number of objects that may be cached */
+         int capacity_;
+
+         /** Reservations served by this magazine not yet added to the pool statistics */
+         int pendingReserves_;
+
+         /** Releases absorbed by this magazine not yet added to the pool statistics */
+         int pendingReleases_;
+      };
+
+      /**
+       * Return the magazine for the specified pool, creating it on first use
+       * @param pool Object Pool to get the magazine for
+       */
+      Magazine* getMagazine(ObjectPool* pool);
+
+      /**
+       * Return objectCount objects from the top of the magazine into the pool
+       * @param pool Object Pool that owns the magazine's objects
+       * @param magazine Magazine to drain
+       * @param objectCount Number of objects to return
+       */
+      void drain(ObjectPool* pool, Magazine* magazine, int objectCount);
+
+      /**
+       * Add the magazine's pending reserve/release counts to the pool statistics
+       * @param pool Object Pool that owns the magazine
+       * @param magazine Magazine whose counts are added (and reset)
+       */
+      void flushStats(ObjectPool* pool, Magazine* magazine);
+
+      /**
+       * Discard every magazine if OPM has been shut down since this cache was
+       * last used (their objects were deleted along with their pools)
+       */
+      void checkShutdown();
+
+      /** Delete every magazine (but not the objects in them) */
+      void deleteMagazines();
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMThreadCache(const OPMThreadCache& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      OPMThreadCache& operator= (const OPMThreadCache& rhs);
+
+      /**
+       * Magazines indexed by Object Pool ID, in blocks that match those of the
+       * OPM pool table (a block, and each magazine, is NULL until first used)
+       */
+      Magazine** magazineBlocks_[OPM_MAX_POOL_BLOCKS];
+
+      /** OPM shutdown count that the magazines were filled under */
+      unsigned int shutdownCount_;
+};
+
+#endif
@@ -27,6 +27,7 @@ using namespace std;
 //-----------------------------------------------------------------------------
 
 #include "ObjectPool.h"
+#include "OPMNuma.h"
 
 // Log Manager related includes.
 #include "platform/logger/Logger.h"
@@ -50,8 +51,16 @@ using namespace std;
 //-----------------------------------------------------------------------------
 ObjectPool::ObjectPool(int objectPoolID, int initialCapacity, 
    double thresholdPercentage, int capacityIncrement, const char* objectType, 
-   long objectInitParam, OPM_INIT_PTR bootStrapMethod, OPMGrowthModeType growthMode)
+   long objectInitParam, OPM_INIT_PTR bootStrapMethod, OPMGrowthModeType growthMode,
+   OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, int slabOptions,
+   bool lazyConstruction)
     :capacityIncrement_(OPM_DEFAULT_CAPACITY_INCREMENT),
+     threadCacheSize_(0),
+     backgroundMaintenance_(false),
+     shrinkDelay_(ACE_Time_Value::zero),
+     lowUsageSince_(ACE_Time_Value::zero),
+     stats_(OPMStats::createPoolStats(objectPoolID, objectType)),
+     numaNode_(-1),
      numberEnlargements_(0),
      objectInitParam_(objectInitParam),
      previousThresholdCount_(-1),
@@ -60,12 +69,23 @@ ObjectPool::ObjectPool(int objectPoolID, int initialCapacity,
      currentCapacity_(-1),
      creationCount_(-1L),
      currentFreeObjects_(-1),
+     unconstructedObjects_(0),
+     nextLazySlot_(0),
      currentUsedObjects_(0),
+     currentCachedObjects_(0),
      totalUsedObjects_(0L),
      peakUsedObjects_(0),
+     intervalPeakUsedObjects_(0),
+     growthRequested_(false),
+     synchronousGrowths_(0L),
      initialThreshold_(0),
      objectPoolID_(objectPoolID),
      bootStrapMethod_(bootStrapMethod),
+     placementMethod_(placementMethod),
+     objectSize_(objectSize),
+     slabOptions_(slabOptions),
+     slabList_(NULL),
+     slabObjectOffset_(0),
      growthMode_(growthMode)
 {
    //don't trust the user to give us an objectType char* that won't go away - so
@@ -108,38 +128,52 @@ ObjectPool::ObjectPool(int objectPoolID, int initialCapacity,
    usedList_ = new OPMLinkedList();
    freeList_ = new OPMLinkedList();
 
-   //initialize the Linked List of Free Objects to the initial capacity
-   for(int i = 0; i < initialCapacity; i++)
+   //slab mode pools keep track of the slabs that their objects live in
+   if (placementMethod_ != NULL)
    {
-      //create each object by calling its static bootStrap method (initialize)
-      // and also pass in the default objectInitializer which may be 0 if
-      // none is specified.
-      OPMBase* object = (OPMBase*)((*bootStrapMethod_)(objectInitParam));
+      slabList_ = new vector<OPMSlab*>();
+   }//end if
 
-      // We should NOT allow this to happen
-      if (object == NULL)
+   OPMSlab* slab = NULL;
+   if (lazyConstruction)
+   {
+      //only reserve the space for the initial capacity now; the objects are
+      // constructed as they are first reserved. A slab is not prefaulted, so
+      // that its pages only become resident as they are used.
+      if (placementMethod_ != NULL)
       {
-          TRACELOG(ERRORLOG, OPMLOG, "Object instance creation failed for object number (%d), but continuing with leak",(i+1),0,0,0,0,0);
-          continue;
+         slab = new OPMSlab(objectSize_, initialCapacity_, slabOptions_ & ~OPM_SLAB_PREFAULT);
+         if (slab->isAllocated() == false)
+         {
+            ostringstream ostr;
+            ostr << "Unable to allocate slab of " << initialCapacity_ << " " << objectType_
+                 << " objects" << ends;
+            STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+            delete slab;
+            slab = NULL;
+         }//end if
       }//end if
-      else if (Logger::getSubsystemLogLevel(OPMLOG) == DEVELOPERLOG)
-      {
-         TRACELOG(DEBUGLOG, OPMLOG, "OPM Object number (%d) successfully instantiated for poolId (%d)",(i+1),objectPoolID_,0,0,0,0);
-      }//end else
 
-      //set the PoolID and objectType string in the object
-      object->setPoolID(objectPoolID_);
-      object->setObjectTypeStr(objectType_);
- 
-      //add it to the Free Object List
-      freeList_->insertFirst(object);
-   }// end for
+      if ((placementMethod_ == NULL) || (slab != NULL))
+      {
+         unconstructedObjects_ = initialCapacity_;
+      }//end if
+      currentFreeObjects_ = unconstructedObjects_;
+   }//end if
+   else
+   {
+      //initialize the Linked List of Free Objects to the initial capacity
+      currentFreeObjects_ = createObjects(initialCapacity, freeList_, &slab);
+   }//end else
 
-   //set current Free objects to initial capacity
-   currentFreeObjects_ = initialCapacity;
+   if (slab != NULL)
+   {
+      slabList_->push_back(slab);
+   }//end if
 
    //increment the creation counter
-   creationCount_ = (long)initialCapacity;
+   creationCount_ = (long)freeList_->getListSize();
+   stats_->currentCapacity_ = currentCapacity_;
 
    //allocate the historical capacity array of integers and 
    //set the first element in the Historical Capacity Array to the initial capacity
@@ -155,15 +189,26 @@ ObjectPool::ObjectPool(int objectPoolID, int initialCapacity,
 //-----------------------------------------------------------------------------
 ObjectPool::~ObjectPool()
 {
+   stats_->isActive_ = 0;
    delete historicalCapacityArray_;
 
    //clean the Free Object Linked List
-   freeList_->deleteListContents();
+   destroyListContents(freeList_);
    delete freeList_;
 
    //clean the Used Linked List
-   usedList_->deleteListContents();
+   destroyListContents(usedList_);
    delete usedList_;
+
+   //unmap the slabs now that none of their objects remain
+   if (slabList_ != NULL)
+   {
+      for (unsigned int i = 0; i < slabList_->size(); i++)
+      {
+         delete (*slabList_)[i];
+      }//end for
+      delete slabList_;
+   }//end if
 }//end destructor
 
 
@@ -181,9 +226,26 @@ OPMBase* ObjectPool::reserve(bool blockWaitingForAccess)
 {
    ACE_UNUSED_ARG(blockWaitingForAccess); // ONLY used in SyncObjectPools
 
+   //in lazy mode, once the constructed objects are all in use, construct the
+   // next object of the initial capacity
+   if (freeList_->isEmpty() && (unconstructedObjects_ > 0))
+   {
+      constructLazyObject();
+   }//end if
+
+   //if the maintenance thread has not kept up with demand, grow the pool here
+   // rather than fail the reservation
+   if (freeList_->isEmpty() && backgroundMaintenance_ && (growthMode_ != OPM_NO_GROWTH))
+   {
+      synchronousGrowths_ += 1L;
+      autoIncreaseLists();
+   }//end if
+
    //return NULL if the free list is empty - either Ran-out or wasn't init'ed correctly
    if (freeList_->isEmpty())
    {
+      //also bumped (atomically) by failed non-blocking lock attempts
+      __sync_fetch_and_add(&stats_->reserveFailCount_, 1ULL);
       ostringstream ostr;
       ostr << "Pool has no free " << objectType_ << " object types" << ends;
       STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
@@ -195,8 +257,20 @@ OPMBase* ObjectPool::reserve(bool blockWaitingForAccess)
    if ((growthMode_ != OPM_NO_GROWTH) && 
        (currentUsedObjects_ >= (currentCapacity_ - initialThreshold_)))
    {
-	   //auto-increase (grow) the Free List
-	   autoIncreaseLists();
+      //leave the growth to the maintenance thread (just wake it up once) if it
+      // is maintaining this pool; otherwise auto-increase (grow) the Free List
+      if (backgroundMaintenance_)
+      {
+         if (growthRequested_ == false)
+         {
+            growthRequested_ = true;
+            OPM::requestMaintenance();
+         }//end if
+      }//end if
+      else
+      {
+         autoIncreaseLists();
+      }//end else
    }//end if
    //check if not resizable and if the pool is about to run out of objects
    else if (currentUsedObjects_ == (currentCapacity_ - 1))
@@ -215,6 +289,8 @@ OPMBase* ObjectPool::reserve(bool blockWaitingForAccess)
 
    //increment the object counts
    currentUsedObjects_ += 1;
+   if (currentUsedObjects_ > intervalPeakUsedObjects_)
+      intervalPeakUsedObjects_ = currentUsedObjects_;
    //set the peak usage if its larger
    if (currentUsedObjects_ > peakUsedObjects_)
    {
@@ -235,8 +311,13 @@ OPMBase* ObjectPool::reserve(bool blockWaitingForAccess)
       totalUsedObjects_ = 0L;
 
    //add the OPMBase object to the head of the Used Linked List
+   object->setObjectState(OPM_OBJECT_USED);
    usedList_->insertFirst(object);
 
+   stats_->reserveCount_++;
+   stats_->currentUsed_ = currentUsedObjects_;
+   stats_->peakUsed_ = peakUsedObjects_;
+
    //if in DEBUG mode, print a successful DEBUG log message
    if (Logger::getSubsystemLogLevel(OPMLOG) == DEVELOPERLOG)
    {
@@ -259,29 +340,99 @@ OPMBase* ObjectPool::reserve(bool blockWaitingForAccess)
 //-----------------------------------------------------------------------------
 bool ObjectPool::release(OPMBase* object, const char* callingFileName, int callingLineNumb)
 {
-   //if in DEBUG mode, perform a check to see if the object belongs in this pool
-   if (Logger::getSubsystemLogLevel(OPMLOG) == DEVELOPERLOG)
+   return releaseObject(object, false, callingFileName, callingLineNumb);
+}//end release
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Reserve up to objectCount objects in a single operation.
+// Design:      Stops early (without logging an error) once the free list runs
+//              out after at least one object has been reserved.
+//-----------------------------------------------------------------------------
+int ObjectPool::reserveBatch(OPMBase** objects, int objectCount, bool blockWaitingForAccess)
+{
+   ACE_UNUSED_ARG(blockWaitingForAccess); // ONLY used in SyncObjectPools
+
+   int reservedCount = 0;
+   while (reservedCount < objectCount)
    {
-      if (!containsObject(object))
+      if ((reservedCount > 0) && freeList_->isEmpty() && (unconstructedObjects_ == 0))
       {
-         ostringstream ostr;
-         ostr << "Attempt to release object into WRONG POOL (" << objectPoolID_ 
-              << ") - containsObject returns false - aborting! Called from "
-              << callingFileName << " (" << callingLineNumb << ") and Process "
-              << "(" << getpid() << ")" << ends;
-         STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
-         return false;
+         break;
       }//end if
-      else if (object->getPoolID() != objectPoolID_)
+
+      // Call the non-virtual (unlocked) implementation
+      OPMBase* object = ObjectPool::reserve();
+      if (object == NULL)
       {
-         ostringstream ostr;
-         ostr << "Attempt to release object with poolID (" << object->getPoolID() 
-              << ") into WRONG POOL (" << objectPoolID_ << ") - aborting! Called from "
-              << callingFileName << " (" << callingLineNumb << ") and Process "
-              << "(" << getpid() << ")" << ends;
-         STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
-         return false;
+         break;
+      }//end if
+      objects[reservedCount++] = object;
+   }//end while
+   return reservedCount;
+}//end reserveBatch
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Release objectCount (already cleaned) objects back into the pool
+//              in a single operation.
+// Design:      The objects must be in the OPM_OBJECT_CACHED state
+//-----------------------------------------------------------------------------
+int ObjectPool::releaseBatch(OPMBase** objects, int objectCount, const char* callingFileName,
+   int callingLineNumb)
+{
+   int releasedCount = 0;
+   for (int i = 0; i < objectCount; i++)
+   {
+      if (releaseObject(objects[i], true, callingFileName, callingLineNumb))
+      {
+         releasedCount++;
       }//end if
+   }//end for
+   return releasedCount;
+}//end releaseBatch
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Common implementation of release and releaseBatch that moves an
+//              object from the Used List back into the Free List.
+// Design:      This method automatically monitors the number of in-use objects
+//              and will shrink the pool when the number drops below the
+//              previous increment's threshold value.
+//-----------------------------------------------------------------------------
+bool ObjectPool::releaseObject(OPMBase* object, bool fromThreadCache, const char* callingFileName,
+   int callingLineNumb)
+{
+   //check (in constant time) that the object belongs to this pool
+   if (object->getPoolID() != objectPoolID_)
+   {
+      ostringstream ostr;
+      ostr << "Attempt to release object with poolID (" << object->getPoolID() 
+           << ") into WRONG POOL (" << objectPoolID_ << ") - aborting! Called from "
+           << callingFileName << " (" << callingLineNumb << ") and Process "
+           << "(" << getpid() << ")" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+      return false;
+   }//end if
+
+   //check that the object is currently reserved (or parked in a thread cache if
+   // that is where it is being returned from). Objects in any other state are
+   // already released or were not created via OPM, and unlinking them from the
+   // Used List would corrupt it.
+   OPMObjectStateType expectedState = (fromThreadCache ? OPM_OBJECT_CACHED : OPM_OBJECT_USED);
+   if (object->getObjectState() != expectedState)
+   {
+      ostringstream oss;
+      oss << "Attempt to release object into the WRONG POOL, is already " 
+          << "released, or may not have been created via OPM. "
+          << "Called from " << callingFileName << " (" 
+          << callingLineNumb << ") and Process "  
+          << "(" << getpid() << ")" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, (char*)oss.str().c_str());
+      return false;
    }//end if
 
    //retrieve the OPMBase object in use from the Used List
@@ -305,19 +456,29 @@ bool ObjectPool::release(OPMBase* object, const char* callingFileName, int calli
       //decrement the used object count
       currentUsedObjects_ -= 1;
 
-      //Clean the Object before returning to the pool
-      object->clean();
+      //Clean the Object before returning to the pool (unless a thread cache
+      // has already done so)
+      if (!fromThreadCache)
+      {
+         object->clean();
+      }//end if
 
       //add the OPMBase object back into the Free Linked List
+      object->setObjectState(OPM_OBJECT_FREE);
       freeList_->insertFirst(object);
 
       //increment the free object counter
       currentFreeObjects_ += 1;
 
-      //decrease the number of objects in the Free List and Used List (if Resizable)
+      stats_->releaseCount_++;
+      stats_->currentUsed_ = currentUsedObjects_;
+
+      //decrease the number of objects in the Free List and Used List (if Resizable),
+      // unless the maintenance thread is applying its time decayed shrink policy
       if ((growthMode_ == OPM_GROW_AND_SHRINK) && 
+          (backgroundMaintenance_ == false) &&
           (previousThresholdCount_ != -1) &&
-          (currentUsedObjects_ <= previousThresholdCount_))
+          (currentUsedObjects_ <= getShrinkWatermark()))
       {
          autoDecreaseLists();
       }//end if
@@ -334,7 +495,7 @@ bool ObjectPool::release(OPMBase* object, const char* callingFileName, int calli
       STRACELOG(DEBUGLOG, OPMLOG, (char*)oss.str().c_str());
    }//end if
    return true;
-}//end release
+}//end releaseObject
 
 
 //-----------------------------------------------------------------------------
@@ -348,31 +509,80 @@ bool ObjectPool::release(OPMBase* object, const char* callingFileName, int calli
 //-----------------------------------------------------------------------------
 void ObjectPool::autoIncreaseLists()
 {
+   unsigned long long startUsec = OPMStats::getTimeUsec();
+
+   //create additional objects and store in the Free List
+   OPMLinkedList objectList;
+   OPMSlab* slab = NULL;
+   int createdCount = createIncrement(&objectList, &slab);
+   addIncrement(&objectList, createdCount, slab);
+
+   //background maintenance adds its increments directly, so this always runs on a reserving thread
+   if (createdCount > 0)
+   {
+      OPMStats::recordGrowth(stats_, OPMStats::getTimeUsec() - startUsec, true);
+   }//end if
+}//end autoIncreaseLists
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Create one capacity increment of objects into the specified
+//              list
+// Design:      Thread safe pools call this without holding the pool lock, so
+//              it must not touch any counters or lists of the pool itself
+//-----------------------------------------------------------------------------
+int ObjectPool::createIncrement(OPMLinkedList* objectList, OPMSlab** slab)
+{
+   //NUMA sub-pools first touch their new objects from their own node
+   cpu_set_t previousCpus;
+   bool isBound = ((numaNode_ >= 0) && (OPMNuma::getCurrentNode() != numaNode_) &&
+                   OPMNuma::bindToNode(numaNode_, &previousCpus));
+
+   int createdCount = createObjects(capacityIncrement_, objectList, slab);
+
+   if (isBound)
+   {
+      OPMNuma::restoreBinding(&previousCpus);
+   }//end if
+   return createdCount;
+}//end createIncrement
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Add a capacity increment built by createIncrement to the pool
+// Design:      The new objects are spliced onto the head of the Free List, so
+//              that (in slab mode) they are handed out in address order.
+//-----------------------------------------------------------------------------
+void ObjectPool::addIncrement(OPMLinkedList* objectList, int createdCount, OPMSlab* slab)
+{
+   //nothing was created (the error has already been logged), so leave the
+   // capacity history alone
+   if (createdCount <= 0)
+   {
+      if (slab != NULL)
+         delete slab;
+      return;
+   }//end if
+
    //increment enlargement count
    numberEnlargements_ += 1;
    //store the old threshold value in 'previousThresholdCount_'
    previousThresholdCount_ = currentCapacity_ - initialThreshold_;
 
-   //create additional objects and store in the Free List
-   for (int i = 0; i < capacityIncrement_; i++)
+   //store the new objects in the Free List
+   freeList_->insertListFirst(objectList);
+   if (slab != NULL)
    {
-      //create each object by calling its static bootStrap method (initialize)
-      // and also pass in the default objectInitializer which may be 0 if
-      // none is specified.
-      OPMBase* object = (OPMBase*)((*bootStrapMethod_)(objectInitParam_));
-
-      //set the PoolID and objectType string in the object
-      object->setPoolID(objectPoolID_);
-      object->setObjectTypeStr(objectType_);
-
-      //add it to the Object List
-      freeList_->insertFirst(object);
-   }//end for
+      slabList_->push_back(slab);
+   }//end if
 
    //set counters
-   currentFreeObjects_ += capacityIncrement_;
-   currentCapacity_ += capacityIncrement_;
-   creationCount_ += (long)capacityIncrement_;
+   currentFreeObjects_ += createdCount;
+   currentCapacity_ += createdCount;
+   stats_->currentCapacity_ = currentCapacity_;
+   creationCount_ += (long)createdCount;
    //check to see if the creationCount_ has overflowed to a negative value. If
    // it has, we reset it to zero so the user does not get confused with a neg.
    if (creationCount_ < 0L)
@@ -387,7 +597,7 @@ void ObjectPool::autoIncreaseLists()
    //send a DEBUG log msg
    TRACELOG(DEBUGLOG, OPMLOG, "Increase to %d objs, # increases over init capacity = <%d>", 
       currentCapacity_, numberEnlargements_,0,0,0,0);
-}//end autoIncreaseLists
+}//end addIncrement
 
 
 //-----------------------------------------------------------------------------
@@ -404,6 +614,12 @@ void ObjectPool::autoDecreaseLists()
    if (numberEnlargements_ <= 0)
       return;
 
+   //in slab mode, the objects of the last increment can only be given back
+   // all at once (along with their slab) -- if any are still in use then
+   // defer the reduction until a later release
+   if ((placementMethod_ != NULL) && (destroyNewestSlab() == false))
+      return;
+
    //retrieve the new capacity from the historical capacity array and decrement count
    int newCapacity = (*historicalCapacityArray_)[numberEnlargements_ -= 1];
 
@@ -424,16 +640,22 @@ void ObjectPool::autoDecreaseLists()
    // capacity, we know how many objects to delete from the Free List
    int numbToDelete = currentCapacity_ - newCapacity;
 
-   for (int i = 0; i < numbToDelete; i++)
+   //slab mode objects have already been destroyed along with their slab
+   for (int i = 0; (placementMethod_ == NULL) && (i < numbToDelete); i++)
    {
-      //delete from the top of the list--nulled out and deallocated
-      OPMBase* object = freeList_->removeFirst();
-      delete object;
+      //delete from the top of the list--nulled out and deallocated, or (in
+      // lazy mode) just drop an object that was never constructed
+      if (freeList_->isEmpty() && (unconstructedObjects_ > 0))
+         unconstructedObjects_ -= 1;
+      else
+         destroyObject(freeList_->removeFirst());
    }//end for
 
    //update the counters
    currentCapacity_ = newCapacity;
    currentFreeObjects_ -= numbToDelete;
+   stats_->currentCapacity_ = currentCapacity_;
+   stats_->shrinkCount_++;
 }//end autoDecreaseFreeList
 
 
@@ -459,6 +681,82 @@ int ObjectPool::getCurrentUsedObjects()
 }//end getCurrentUsedObjects
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the current number of objects parked in thread caches
+// Design:      
+//-----------------------------------------------------------------------------
+int ObjectPool::getCurrentCachedObjects()
+{
+   return currentCachedObjects_;
+}//end getCurrentCachedObjects
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Adjust the count of objects parked in thread caches
+// Design:      Atomic, since the thread caches do not hold the pool lock
+//-----------------------------------------------------------------------------
+void ObjectPool::adjustCachedObjects(int delta)
+{
+   __sync_fetch_and_add(&currentCachedObjects_, delta);
+}//end adjustCachedObjects
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the maximum number of objects each thread may cache
+// Design:      
+//-----------------------------------------------------------------------------
+int ObjectPool::getThreadCacheSize()
+{
+   return threadCacheSize_;
+}//end getThreadCacheSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Add thread cache reservations/releases to the statistics
+// Design:      Atomic, since the thread caches do not hold the pool lock
+//-----------------------------------------------------------------------------
+void ObjectPool::addCacheOperations(int reserveCount, int releaseCount)
+{
+   __sync_fetch_and_add(&stats_->cacheReserveCount_, (unsigned long long)reserveCount);
+   __sync_fetch_and_add(&stats_->cacheReleaseCount_, (unsigned long long)releaseCount);
+}//end addCacheOperations
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Method to enable/disable the per-thread object caches
+// Design:      Unsynchronized pools are only used from a single thread, so
+//              thread caches are not supported for them.
+//-----------------------------------------------------------------------------
+bool ObjectPool::setThreadCacheSize(int cacheSize)
+{
+   if (cacheSize != 0)
+   {
+      ostringstream ostr;
+      ostr << "Thread caches are only supported for thread safe pools (" << objectType_ << ")" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+      return false;
+   }//end if
+   threadCacheSize_ = 0;
+   return true;
+}//end setThreadCacheSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the Object PoolID that identifies this object pool
+// Design:      
+//-----------------------------------------------------------------------------
+int ObjectPool::getObjectPoolID()
+{
+   return objectPoolID_;
+}//end getObjectPoolID
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return the object type String being held in this pool
@@ -511,20 +809,50 @@ long ObjectPool::getObjectInitParam()
 //-----------------------------------------------------------------------------
 bool ObjectPool::isEmpty()
 {
-   return freeList_->isEmpty();
+   return (freeList_->isEmpty() && (unconstructedObjects_ == 0));
 }//end isEmpty
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Method to test, without the pool lock, whether reserve would
+//              find no free object
+// Design:      A background maintained pool that may grow still succeeds (it
+//              grows synchronously) once its free objects have run out.
+//-----------------------------------------------------------------------------
+bool ObjectPool::isExhausted()
+{
+   return ((currentFreeObjects_ <= 0) &&
+           ((backgroundMaintenance_ == false) || (growthMode_ == OPM_NO_GROWTH)));
+}//end isExhausted
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Make this pool the sub-pool of a NUMA node
+// Design:      Called by OPM before the pool is published
+//-----------------------------------------------------------------------------
+void ObjectPool::setNumaNode(int numaNode)
+{
+   numaNode_ = numaNode;
+}//end setNumaNode
+
+
 //-----------------------------------------------------------------------------
 // Method Type:  INSTANCE
 // Description:  Method to check if a specified object is in the Free Linked 
-//               List or the Used Linked List
-// Design:      
+//               List or the Used Linked List (or a thread cache)
+// Design:       Uses the pool ID and ownership state kept in each object, so
+//               this runs in constant time regardless of the pool capacity.
+//               No lock is taken: the pool ID never changes, and the state
+//               is read once with a single (volatile) load. If another thread
+//               is destroying the object in a shrink at the same time, the
+//               answer is only a hint of the state at the moment of the read.
 //-----------------------------------------------------------------------------
 bool ObjectPool::containsObject(OPMBase* object)
 {
-   //linearly search the Used and Free Linked List
-   return (freeList_->containsObject(object) || usedList_->containsObject(object));
+   OPMObjectStateType objectState = object->getObjectState();
+   return ((object->getPoolID() == objectPoolID_) && (objectState != OPM_OBJECT_UNOWNED));
 }//end containsObject
 
 
@@ -540,6 +868,57 @@ void ObjectPool::setCapacityIncrement(int capacityIncrement)
 }//end setCapacityIncrement
 
 
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Method to hand the growing and shrinking of this pool over to
+//               the OPM maintenance thread
+// Design:       Unsynchronized pools are only used from a single thread, so
+//               they cannot be maintained from another one.
+//-----------------------------------------------------------------------------
+bool ObjectPool::setBackgroundMaintenance(bool enable, const ACE_Time_Value& shrinkDelay)
+{
+   ACE_UNUSED_ARG(shrinkDelay);
+   if (enable)
+   {
+      ostringstream ostr;
+      ostr << "Background maintenance is only supported for thread safe pools (" << objectType_ << ")" << ends;
+      STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+      return false;
+   }//end if
+   backgroundMaintenance_ = false;
+   return true;
+}//end setBackgroundMaintenance
+
+
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Return true if the OPM maintenance thread grows and shrinks
+//               this pool
+// Design:      
+//-----------------------------------------------------------------------------
+bool ObjectPool::isBackgroundMaintained()
+{
+   return backgroundMaintenance_;
+}//end isBackgroundMaintained
+
+
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Perform one maintenance pass over this pool
+// Design:       SyncObjectPool overrides this to build the new increments
+//               outside of the pool lock.
+//-----------------------------------------------------------------------------
+void ObjectPool::performMaintenance(const ACE_Time_Value& now)
+{
+   int pendingIncrements = getPendingIncrements();
+   for (int i = 0; i < pendingIncrements; i++)
+   {
+      autoIncreaseLists();
+   }//end for
+   decayCapacity(now);
+}//end performMaintenance
+
+
 //-----------------------------------------------------------------------------
 // Method Type:  INSTANCE
 // Description:  Method prints the Object Usage Summary for this Object Pool 
@@ -572,8 +951,33 @@ void ObjectPool::printUsageSummary()
        << "Total Objects Created: " << creationCount_ << "\n"
        << "Current Used Count: " << currentUsedObjects_ << "\n"
        << "Current Free Count: " << currentFreeObjects_ << "\n"
+       << "Current Unconstructed Count: " << unconstructedObjects_ << "\n"
+       << "Current Thread Cached Count: " << currentCachedObjects_ << "\n"
+       << "Background Maintenance: " << (backgroundMaintenance_ ? "ENABLED" : "DISABLED") << "\n"
+       << "Synchronous Growths: " << synchronousGrowths_ << "\n"
        << "Total Used Count: " << totalUsedObjects_ << "\n"
        << "Peak Used Object Count: " << peakUsedObjects_ << "\n"
+       << "Pool Reserve/Release Count: " << stats_->reserveCount_ << "/" << stats_->releaseCount_ << "\n"
+       << "Thread Cache Reserve/Release Count: " << stats_->cacheReserveCount_ << "/"
+       << stats_->cacheReleaseCount_ << "\n"
+       << "Failed Reserve Count: " << stats_->reserveFailCount_ << "\n"
+       << "Lock Contention Count: " << stats_->contentionCount_ << "\n"
+       << "Lock Wait Time (usec): " << stats_->lockWaitUsec_ << "\n";
+
+   //only the buckets that have seen a wait are worth showing
+   for (int bucket = 0; bucket < OPM_STATS_HISTOGRAM_BUCKETS; bucket++)
+   {
+      if (stats_->lockWaitHistogram_[bucket] != 0)
+      {
+         oss << "   Lock Waits >= " << OPMStats::getHistogramBucketStart(bucket) << " usec: "
+             << stats_->lockWaitHistogram_[bucket] << "\n";
+      }//end if
+   }//end for
+
+   oss << "Growth Count (Synchronous): " << stats_->growthCount_ << " ("
+       << stats_->synchronousGrowthCount_ << ")\n"
+       << "Growth Time Total/Max (usec): " << stats_->growthUsec_ << "/" << stats_->maxGrowthUsec_ << "\n"
+       << "Shrink Count: " << stats_->shrinkCount_ << "\n"
        << "*******************************************************\n"
        << ends;
    STRACELOG(DEBUGLOG, OPMLOG, oss.str().c_str());
@@ -584,10 +988,284 @@ void ObjectPool::printUsageSummary()
 // PROTECTED methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of capacity increments that the maintenance
+//              thread should add, and clear the pending growth request
+// Design:      Enough increments are added to bring usage back under the same
+//              threshold that reserve grows the pool at, so that a burst that
+//              overran several increments is caught up with in one pass.
+//-----------------------------------------------------------------------------
+int ObjectPool::getPendingIncrements()
+{
+   growthRequested_ = false;
+
+   int growthThreshold = currentCapacity_ - initialThreshold_;
+   if ((growthMode_ == OPM_NO_GROWTH) || (currentUsedObjects_ < growthThreshold) ||
+       (capacityIncrement_ <= 0))
+   {
+      return 0;
+   }//end if
+
+   int pendingIncrements = ((currentUsedObjects_ - growthThreshold) / capacityIncrement_) + 1;
+   if (pendingIncrements > OPM_MAX_PREGROWTH_INCREMENTS)
+   {
+      pendingIncrements = OPM_MAX_PREGROWTH_INCREMENTS;
+   }//end if
+   return pendingIncrements;
+}//end getPendingIncrements
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Shrink the pool by one capacity increment if usage has stayed
+//              at or below the shrink watermark for at least the shrink delay
+// Design:      The peak usage since the previous pass (rather than the current
+//              usage) is compared, so that a burst between two passes restarts
+//              the delay. Each further shrink needs another full delay, so a
+//              pool that grew in a burst gives its capacity back gradually.
+//-----------------------------------------------------------------------------
+void ObjectPool::decayCapacity(const ACE_Time_Value& now)
+{
+   if ((growthMode_ != OPM_GROW_AND_SHRINK) || (previousThresholdCount_ == -1) ||
+       (intervalPeakUsedObjects_ > getShrinkWatermark()))
+   {
+      lowUsageSince_ = now;
+   }//end if
+   else if ((now - lowUsageSince_) >= shrinkDelay_)
+   {
+      //restart the delay once an increment has actually been given back (a slab
+      // mode pool may have to defer the shrink until its newest slab is all free)
+      int previousCapacity = currentCapacity_;
+      autoDecreaseLists();
+      if (currentCapacity_ != previousCapacity)
+      {
+         lowUsageSince_ = now;
+      }//end if
+   }//end else if
+
+   //start the next interval's peak from the current usage
+   intervalPeakUsedObjects_ = currentUsedObjects_;
+}//end decayCapacity
+
+
 //-----------------------------------------------------------------------------
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the number of used objects at or below which the pool
+//              may shrink by one increment
+// Design:      Half a capacity increment below the threshold at which that
+//              increment was added, so that there is a dead band between the
+//              grow and shrink points.
+//-----------------------------------------------------------------------------
+int ObjectPool::getShrinkWatermark()
+{
+   return previousThresholdCount_ - (capacityIncrement_ / 2);
+}//end getShrinkWatermark
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Create objectCount objects and add them to the specified list
+// Design:      In slab mode, all of the objects are constructed in place in
+//              one newly mapped slab. They are inserted in reverse so that
+//              the list hands them out in ascending address order. The caller
+//              takes ownership of the slab.
+//-----------------------------------------------------------------------------
+int ObjectPool::createObjects(int objectCount, OPMLinkedList* objectList, OPMSlab** slabPtr)
+{
+   OPMSlab* slab = NULL;
+   int createdCount = 0;
+   *slabPtr = NULL;
+
+   if (placementMethod_ != NULL)
+   {
+      slab = new OPMSlab(objectSize_, objectCount, slabOptions_);
+      if (slab->isAllocated() == false)
+      {
+         ostringstream ostr;
+         ostr << "Unable to allocate slab of " << objectCount << " " << objectType_
+              << " objects" << ends;
+         STRACELOG(ERRORLOG, OPMLOG, ostr.str().c_str());
+         delete slab;
+         return 0;
+      }//end if
+      *slabPtr = slab;
+   }//end if
+
+   for (int i = objectCount - 1; i >= 0; i--)
+   {
+      OPMBase* object = constructObject(slab, i);
+      if (object == NULL)
+      {
+         continue;
+      }//end if
+
+      //add it to the list of new objects
+      objectList->insertFirst(object);
+      createdCount++;
+   }//end for
+
+   if ((slab != NULL) && (slab->isHugePageBacked()))
+   {
+      TRACELOG(DEBUGLOG, OPMLOG, "Slab of %d objects for poolId (%d) is hugepage backed",
+         objectCount,objectPoolID_,0,0,0,0);
+   }//end if
+   return createdCount;
+}//end createObjects
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Construct a single object and mark it as a free object of this
+//              pool
+// Design:      
+//-----------------------------------------------------------------------------
+OPMBase* ObjectPool::constructObject(OPMSlab* slab, int slot)
+{
+   //create the object by calling its static bootStrap method (initialize),
+   // or its placement method for the slot in the slab, and also pass
+   // in the default objectInitializer which may be 0 if none is specified.
+   OPMBase* object = NULL;
+   if (slab != NULL)
+   {
+      object = (*placementMethod_)(slab->getObjectMemory(slot), objectInitParam_);
+      if (object != NULL)
+      {
+         slabObjectOffset_ = (char*)object - (char*)slab->getObjectMemory(slot);
+      }//end if
+   }//end if
+   else
+   {
+      object = (OPMBase*)((*bootStrapMethod_)(objectInitParam_));
+   }//end else
+
+   // We should NOT allow this to happen
+   if (object == NULL)
+   {
+       TRACELOG(ERRORLOG, OPMLOG, "Object instance creation failed for object number (%d), but continuing with leak",(slot+1),0,0,0,0,0);
+       return NULL;
+   }//end if
+   else if (Logger::getSubsystemLogLevel(OPMLOG) == DEVELOPERLOG)
+   {
+      TRACELOG(DEBUGLOG, OPMLOG, "OPM Object number (%d) successfully instantiated for poolId (%d)",(slot+1),objectPoolID_,0,0,0,0);
+   }//end else
+
+   //set the PoolID, objectType string and state in the object
+   object->setPoolID(objectPoolID_);
+   object->setObjectTypeStr(objectType_);
+   object->setObjectState(OPM_OBJECT_FREE);
+   return object;
+}//end constructObject
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: In lazy mode, construct the next object of the initial capacity
+//              and add it to the Free List
+// Design:      Slab mode objects are constructed in ascending slots of the
+//              initial slab, so they are still handed out in address order
+//-----------------------------------------------------------------------------
+bool ObjectPool::constructLazyObject()
+{
+   OPMSlab* slab = NULL;
+   if (placementMethod_ != NULL)
+   {
+      slab = (*slabList_)[0];
+   }//end if
+
+   OPMBase* object = constructObject(slab, nextLazySlot_);
+   nextLazySlot_ += 1;
+   unconstructedObjects_ -= 1;
+   if (object == NULL)
+   {
+      //the capacity is kept as is (the same as a failed eager construction)
+      currentFreeObjects_ -= 1;
+      return false;
+   }//end if
+
+   creationCount_ += 1L;
+   freeList_->insertFirst(object);
+   return true;
+}//end constructLazyObject
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Destroy all of the objects in the most recently mapped slab
+//              and unmap it, if they are all free.
+// Design:      The object in each slot is found from the slot address (and
+//              the offset of OPMBase within the objects).
+//-----------------------------------------------------------------------------
+bool ObjectPool::destroyNewestSlab()
+{
+   //never give back the initial capacity slab
+   if (slabList_->size() <= 1)
+   {
+      return false;
+   }//end if
+
+   OPMSlab* slab = slabList_->back();
+   int slabObjects = slab->getObjectCount();
+
+   for (int i = 0; i < slabObjects; i++)
+   {
+      OPMBase* object = (OPMBase*)((char*)slab->getObjectMemory(i) + slabObjectOffset_);
+      if (object->getObjectState() != OPM_OBJECT_FREE)
+      {
+         return false;
+      }//end if
+   }//end for
+
+   for (int i = 0; i < slabObjects; i++)
+   {
+      OPMBase* object = (OPMBase*)((char*)slab->getObjectMemory(i) + slabObjectOffset_);
+      destroyObject(freeList_->remove(object));
+   }//end for
+
+   slabList_->pop_back();
+   delete slab;
+   return true;
+}//end destroyNewestSlab
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Destroy (delete, or explicitly destruct for slab mode) a single
+//              object
+// Design:      Slab memory is released with the slab itself
+//-----------------------------------------------------------------------------
+void ObjectPool::destroyObject(OPMBase* object)
+{
+   object->setObjectState(OPM_OBJECT_UNOWNED);
+   if (placementMethod_ != NULL)
+   {
+      object->~OPMBase();
+   }//end if
+   else
+   {
+      delete object;
+   }//end else
+}//end destroyObject
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Remove and destroy every object in the specified list
+// Design:      
+//-----------------------------------------------------------------------------
+void ObjectPool::destroyListContents(OPMLinkedList* list)
+{
+   while (list->isEmpty() == false)
+   {
+      destroyObject(list->removeFirst());
+   }//end while
+}//end destroyListContents
+
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
@@ -28,6 +28,8 @@
 #include "OPM.h"
 #include "OPMBase.h"
 #include "OPMLinkedList.h"
+#include "OPMSlab.h"
+#include "OPMStats.h"
 
 #define OPM_DEFAULT_INITIAL_CAPACITY      10
 
@@ -37,6 +39,9 @@
 
 #define OPM_MAX_RESIZES                   100
 
+// Most capacity increments the maintenance thread will add to a pool in one pass
+#define OPM_MAX_PREGROWTH_INCREMENTS      8
+
 //-----------------------------------------------------------------------------
 // Forward Declarations.
 //-----------------------------------------------------------------------------
@@ -87,6 +92,14 @@ class ObjectPool
        * @param bootStrapMethod pointer to a function or method (OPMBase::initialize)
        *   that will create the object and return a pointer to it
        * @param growthMode Either NO_GROWTH, GROWTH_ALLOWED, or GROW_AND_SHRINK
+       * @param placementMethod pointer to a function or method that constructs the
+       *   object in place in slab memory, or NULL if the objects are created with
+       *   bootStrapMethod on the heap
+       * @param objectSize Bytes of slab memory needed per object (slab mode only)
+       * @param slabOptions OR'ed OPM_SLAB_ options (slab mode only)
+       * @param lazyConstruction If true, the objects of the initial capacity are
+       *   only constructed as they are first reserved (in slab mode, the initial
+       *   slab is mapped up front but not prefaulted)
        */
       ObjectPool(int objectPoolID,
                  int initialCapacity, 
@@ -95,7 +108,11 @@ class ObjectPool
                  const char* objectType, 
                  long objectInitParam,
                  OPM_INIT_PTR bootStrapMethod, 
-                 OPMGrowthModeType growthMode);
+                 OPMGrowthModeType growthMode,
+                 OPM_PLACEMENT_INIT_PTR placementMethod = NULL,
+                 size_t objectSize = 0,
+                 int slabOptions = OPM_SLAB_DEFAULT,
+                 bool lazyConstruction = false);
 
       /** Virtual Destructor */
       virtual ~ObjectPool();
@@ -119,7 +136,8 @@ class ObjectPool
        * Release an object back into the pool after using it. This makes the
        * object available again for use in other tasks. This method automatically
        * monitors the number of in-use objects and will shrink the pool when the
-       * number drops below the previous increment's threshold value.
+       * number drops half an increment below the previous increment's threshold
+       * value (unless the pool is maintained by the OPM maintenance thread).
        * @param object Object to release back into the pool.
        * @param callingFileName - Specifies the source file from which the object 
        *    is being released (this will be printed as a DEBUG log using a MACRO)
@@ -131,6 +149,32 @@ class ObjectPool
        *         not created via OPM)
        */
       virtual bool release(OPMBase* object, const char* callingFileName, int callingLineNumb);
+
+      /**
+       * Reserve up to objectCount objects in a single operation. This is used to
+       * refill the per-thread object caches so that the (thread safe) pool is
+       * only locked once per batch.
+       * @param objects Array that receives the reserved objects
+       * @param objectCount Maximum number of objects to reserve
+       * @param blockWaitingForAccess See reserve
+       * @return Number of objects actually reserved (0 if none are available)
+       */
+      virtual int reserveBatch(OPMBase** objects, int objectCount, bool blockWaitingForAccess = true);
+
+      /**
+       * Release objectCount objects back into the pool in a single operation. The
+       * objects must already have been cleaned and be in the OPM_OBJECT_CACHED
+       * state, as this is used to drain the per-thread object caches (which clean
+       * objects as they are released).
+       * @param objects Array of objects to release
+       * @param objectCount Number of objects in the array
+       * @param callingFileName - Specifies the source file from which the objects 
+       *    are being released
+       * @param callingLineNumb - Specifies the source line from which the objects 
+       *    are being released
+       * @return Number of objects successfully released
+       */
+      virtual int releaseBatch(OPMBase** objects, int objectCount, const char* callingFileName, int callingLineNumb);
       
       /** Return the current capacity of this pool */
       int getCurrentCapacity();
@@ -138,6 +182,43 @@ class ObjectPool
       /** Return the current number of Used Objects in this pool */
       int getCurrentUsedObjects();
 
+      /**
+       * Return the current number of objects parked in thread caches. These are
+       * counted as Used Objects by the pool although no application holds them.
+       */
+      int getCurrentCachedObjects();
+
+      /**
+       * Adjust the count of objects parked in thread caches (atomically, as the
+       * thread caches do this without holding the pool lock)
+       * @param delta Number of objects added to (or removed from if negative) caches
+       */
+      void adjustCachedObjects(int delta);
+
+      /** Return the maximum number of objects each thread may cache (0 if disabled) */
+      int getThreadCacheSize();
+
+      /**
+       * Add reservations served, and releases absorbed, by a thread cache to the
+       * statistics of this pool (atomically, as the thread caches do this
+       * without holding the pool lock)
+       * @param reserveCount Number of reservations served by the thread cache
+       * @param releaseCount Number of releases absorbed by the thread cache
+       */
+      void addCacheOperations(int reserveCount, int releaseCount);
+
+      /**
+       * Method to enable/disable the per-thread object caches for this pool. Only
+       * thread safe pools (SyncObjectPool) support thread caches.
+       * @param cacheSize Maximum number of objects each thread may cache
+       * @return <tt>true</tt> if the cache size was set<br>
+       *         <tt>false</tt> if this pool does not support thread caches
+       */
+      virtual bool setThreadCacheSize(int cacheSize);
+
+      /** Return the Object PoolID that identifies this object pool in the OPM */
+      int getObjectPoolID();
+
       /** Return the object type String being held in this pool */
       const char* getObjectType();
 
@@ -157,10 +238,27 @@ class ObjectPool
        */
       virtual bool isEmpty();
 
+      /**
+       * Method to test, WITHOUT taking the pool lock, whether reserve would find
+       * no free object. Since the answer may be stale, it is only a hint (used
+       * to decide when to fall back to another NUMA sub-pool).
+       */
+      bool isExhausted();
+
+      /**
+       * Make this pool a NUMA sub-pool, whose capacity increments are then
+       * constructed by a thread bound to the node so that their memory is
+       * first touched there.
+       * @param numaNode NUMA node of this sub-pool (see OPMNuma)
+       */
+      void setNumaNode(int numaNode);
+
       /**
        * Method to check if a specified object is in the Free Linked List or the
-       * Used Linked List. This method traverses both lists looking for pointer
-       * equality.
+       * Used Linked List. This method checks the pool ID and ownership state
+       * stored in the object, so it runs in constant time. It takes no lock, so
+       * for an object that another thread is concurrently removing from the
+       * pool the answer is only a hint.
        * @return <tt>true</tt> if the Object is in the list<br>
        *         <tt>false</tt> if the Object is NOT in the list
        */
@@ -172,14 +270,91 @@ class ObjectPool
        */
       virtual void setCapacityIncrement(int capacityIncrement);
 
+      /**
+       * Method to hand the growing and shrinking of this pool over to the OPM
+       * maintenance thread (or take it back). When enabled, crossing the growth
+       * threshold in reserve only wakes the maintenance thread, which builds the
+       * next capacity increment without holding the pool lock; reserve itself
+       * only grows the pool if the Free List has actually run dry. Shrinking
+       * (GROW_AND_SHRINK) is also moved to the maintenance thread, which only
+       * gives back an increment once usage has stayed below the shrink watermark
+       * for shrinkDelay. Only thread safe pools (SyncObjectPool) support this.
+       * @param enable Whether the maintenance thread grows and shrinks this pool
+       * @param shrinkDelay How long usage must stay low before each shrink
+       * @return <tt>true</tt> if the setting was changed<br>
+       *         <tt>false</tt> if this pool does not support background maintenance
+       */
+      virtual bool setBackgroundMaintenance(bool enable, const ACE_Time_Value& shrinkDelay);
+
+      /** Return true if the OPM maintenance thread grows and shrinks this pool */
+      bool isBackgroundMaintained();
+
+      /**
+       * Perform one maintenance pass over this pool: pre-grow it if usage is at
+       * or above the growth threshold, and apply the time decayed shrink policy.
+       * Called periodically (and when woken by reserve) by the OPM maintenance thread.
+       * @param now Current time of day
+       */
+      virtual void performMaintenance(const ACE_Time_Value& now);
+
       /* Method prints the Object Usage Summary for this Object Pool if DEBUG logs are enabled */
       virtual void printUsageSummary();
 
    protected:
 
+      /**
+       * Return the number of capacity increments that the maintenance thread
+       * should add to bring usage back under the growth threshold (0 if none),
+       * and clear the pending growth request.
+       */
+      int getPendingIncrements();
+
+      /**
+       * Create one capacity increment of objects (and in slab mode its slab)
+       * into the specified list. This touches no shared pool state, so thread
+       * safe pools call it WITHOUT holding the pool lock.
+       * @param objectList List that receives the new objects
+       * @param slab Receives the new slab (slab mode only, otherwise NULL)
+       * @return Number of objects actually created
+       */
+      int createIncrement(OPMLinkedList* objectList, OPMSlab** slab);
+
+      /**
+       * Add a capacity increment built by createIncrement to the pool
+       * @param objectList List holding the new objects (left empty)
+       * @param createdCount Number of objects in the list
+       * @param slab Slab holding the new objects (slab mode only, otherwise NULL)
+       */
+      void addIncrement(OPMLinkedList* objectList, int createdCount, OPMSlab* slab);
+
+      /**
+       * Shrink the pool by one capacity increment if usage has stayed at or
+       * below the shrink watermark for at least the shrink delay.
+       * @param now Current time of day
+       */
+      void decayCapacity(const ACE_Time_Value& now);
+
       /** Pool Increment Size which is the number of objects to add when growing */
       int capacityIncrement_;
 
+      /** Maximum number of objects each thread may cache for this pool (0 if disabled) */
+      volatile int threadCacheSize_;
+
+      /** Whether the OPM maintenance thread grows and shrinks this pool */
+      volatile bool backgroundMaintenance_;
+
+      /** How long usage must stay at or below the shrink watermark before each shrink */
+      ACE_Time_Value shrinkDelay_;
+
+      /** Time since which usage has stayed at or below the shrink watermark */
+      ACE_Time_Value lowUsageSince_;
+
+      /** Statistics of this pool (in the OPM statistics segment) */
+      OPMPoolStats* stats_;
+
+      /** NUMA node whose memory this sub-pool's objects are placed in (-1 if none) */
+      int numaNode_;
+
    private:
  
 
@@ -219,18 +394,39 @@ class ObjectPool
        */
       long creationCount_;
 
-      /** Current number of objects in the Free List */
+      /**
+       * Current number of free objects: those in the Free List plus (in lazy
+       * mode) those of the initial capacity not yet constructed
+       */
       int currentFreeObjects_;
 
+      /** Number of objects of the initial capacity not yet constructed (lazy mode) */
+      int unconstructedObjects_;
+
+      /** Index of the next initial slab slot to construct an object in (lazy slab mode) */
+      int nextLazySlot_;
+
       /** Current number of objects in the Used List */
       int currentUsedObjects_;
 
+      /** Current number of Used List objects that are parked in thread caches */
+      volatile int currentCachedObjects_;
+
       /** Total of all objects used from this pool during runtime */
       long totalUsedObjects_;
 
       /** Peak number of used objects (at any one time) during runtime */
       int peakUsedObjects_;
 
+      /** Peak number of used objects since the last maintenance pass */
+      int intervalPeakUsedObjects_;
+
+      /** Whether reserve has already woken the maintenance thread to grow this pool */
+      bool growthRequested_;
+
+      /** Number of times reserve had to grow the pool itself (the Free List ran dry) */
+      long synchronousGrowths_;
+
       /** Indicates the type of the object stored in this pool */
       char* objectType_;
 
@@ -260,6 +456,68 @@ class ObjectPool
        */
       void autoDecreaseLists();
 
+      /**
+       * Return the number of used objects at or below which the pool may shrink
+       * by one increment. This is half a capacity increment below the point at
+       * which that increment was added (hysteresis), so that a pool hovering
+       * around its growth threshold does not repeatedly grow and shrink.
+       */
+      int getShrinkWatermark();
+
+      /**
+       * Create objectCount objects (with the bootStrap method, or in place in a
+       * newly mapped slab for slab mode pools) and add them to objectList. This
+       * touches no shared pool state.
+       * @param objectCount Number of objects to create
+       * @param objectList List that receives the new objects (in address order)
+       * @param slab Receives the new slab (slab mode only, otherwise NULL)
+       * @return Number of objects actually created
+       */
+      int createObjects(int objectCount, OPMLinkedList* objectList, OPMSlab** slab);
+
+      /**
+       * Construct a single object (with the bootStrap method, or in place in the
+       * specified slot of the slab for slab mode pools) and mark it as a free
+       * object of this pool.
+       * @param slab Slab to construct the object in (slab mode only, otherwise NULL)
+       * @param slot Index of the slab slot to construct the object in
+       * @return The new object or NULL if construction failed
+       */
+      OPMBase* constructObject(OPMSlab* slab, int slot);
+
+      /**
+       * In lazy mode, construct the next object of the initial capacity and add
+       * it to the Free List.
+       * @return <tt>true</tt> if an object was added to the Free List
+       */
+      bool constructLazyObject();
+
+      /**
+       * In slab mode, remove all of the objects in the most recently mapped slab
+       * from the Free List, destroy them and unmap the slab.
+       * @return <tt>false</tt> (and nothing is changed) if any object in the
+       *         slab is not currently free
+       */
+      bool destroyNewestSlab();
+
+      /** Destroy (delete, or explicitly destruct for slab mode) a single object */
+      void destroyObject(OPMBase* object);
+
+      /** Remove and destroy every object in the specified list */
+      void destroyListContents(OPMLinkedList* list);
+
+      /**
+       * Common implementation of release and releaseBatch that moves an object
+       * from the Used List back into the Free List.
+       * @param object Object to release back into the pool.
+       * @param fromThreadCache Whether the object is being returned (already
+       *        cleaned) from a thread cache rather than by the application
+       * @param callingFileName Source file from which the object is being released
+       * @param callingLineNumb Source line from which the object is being released
+       */
+      bool releaseObject(OPMBase* object, bool fromThreadCache, const char* callingFileName,
+                         int callingLineNumb);
+
       /** Initial Threshold between the initial capacity and its corresponding threshold value */
       int initialThreshold_;
 
@@ -272,6 +530,30 @@ class ObjectPool
        */
       OPM_INIT_PTR bootStrapMethod_;
 
+      /** 
+       * Pointer to a function or method that constructs the object in place in
+       * slab memory (NULL unless this is a slab mode pool)
+       */
+      OPM_PLACEMENT_INIT_PTR placementMethod_;
+
+      /** Number of bytes of slab memory needed per object (slab mode only) */
+      size_t objectSize_;
+
+      /** OR'ed OPM_SLAB_ options used for mapping new slabs (slab mode only) */
+      int slabOptions_;
+
+      /**
+       * Slabs holding the objects in slab mode, in the order they were mapped:
+       * the first holds the initial capacity and each other one capacity increment
+       */
+      vector<OPMSlab*>* slabList_;
+
+      /**
+       * Offset of the OPMBase part of each object from the start of its slab
+       * slot (non-zero if OPMBase is not the first base class of the objects)
+       */
+      ptrdiff_t slabObjectOffset_;
+
       /** 
        * Flag to determine if object pool is resizable or not and in what way (grow / shrink /
        * none / both).
@@ -16,6 +16,8 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <ace/OS_NS_sys_time.h>
+
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
@@ -43,9 +45,12 @@
 //-----------------------------------------------------------------------------
 SyncObjectPool::SyncObjectPool(int objectPoolID, int initialCapacity, 
     double thresholdPercentage, int capacityIncrement, const char* objectType, 
-    long objectInitParam, OPM_INIT_PTR bootStrapMethod, OPMGrowthModeType growthMode)
+    long objectInitParam, OPM_INIT_PTR bootStrapMethod, OPMGrowthModeType growthMode,
+    OPM_PLACEMENT_INIT_PTR placementMethod, size_t objectSize, int slabOptions,
+    bool lazyConstruction)
     :ObjectPool::ObjectPool(objectPoolID, initialCapacity, thresholdPercentage, 
-      capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode)
+      capacityIncrement, objectType, objectInitParam, bootStrapMethod, growthMode,
+      placementMethod, objectSize, slabOptions, lazyConstruction)
 {
 }//end constructor
 
@@ -75,12 +80,12 @@ OPMBase* SyncObjectPool::reserve(bool blockWaitingForAccess)
    if (blockWaitingForAccess == true)
    {
       // Do a blocking acquire
-      poolMutex_.acquire();
+      acquirePoolMutex();
    }//end if
    else
    {
       // Do a non-blocking acquire
-      if (poolMutex_.tryacquire() == ERROR)
+      if (tryAcquirePoolMutex() == false)
       {
          // Acquire failed since some other thread has the lock, so return a NULL
          return NULL;
@@ -101,15 +106,60 @@ OPMBase* SyncObjectPool::reserve(bool blockWaitingForAccess)
 //              and will shrink the pool when the number drops below the
 //              previous increment's threshold value.
 //-----------------------------------------------------------------------------
-bool SyncObjectPool::release(OPMBase* object, char* callingFileName, int callingLineNumb)
+bool SyncObjectPool::release(OPMBase* object, const char* callingFileName, int callingLineNumb)
 {
-   poolMutex_.acquire(); 
+   acquirePoolMutex();
    bool result = ObjectPool::release(object, callingFileName, callingLineNumb);
    poolMutex_.release();
    return result;
 }//end release
 
 
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Reserve up to objectCount objects while holding the pool lock
+//              once.
+// Design:      Used to refill the per-thread object caches
+//-----------------------------------------------------------------------------
+int SyncObjectPool::reserveBatch(OPMBase** objects, int objectCount, bool blockWaitingForAccess)
+{
+   if (blockWaitingForAccess == true)
+   {
+      // Do a blocking acquire
+      acquirePoolMutex();
+   }//end if
+   else
+   {
+      // Do a non-blocking acquire
+      if (tryAcquirePoolMutex() == false)
+      {
+         // Acquire failed since some other thread has the lock
+         return 0;
+      }//end if
+   }//end else
+
+   int result = ObjectPool::reserveBatch(objects, objectCount);
+   poolMutex_.release();
+   return result;
+}//end reserveBatch
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Release objectCount (already cleaned) objects while holding the
+//              pool lock once.
+// Design:      Used to drain the per-thread object caches
+//-----------------------------------------------------------------------------
+int SyncObjectPool::releaseBatch(OPMBase** objects, int objectCount, const char* callingFileName,
+   int callingLineNumb)
+{
+   acquirePoolMutex();
+   int result = ObjectPool::releaseBatch(objects, objectCount, callingFileName, callingLineNumb);
+   poolMutex_.release();
+   return result;
+}//end releaseBatch
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Method to test if this pool is empty
@@ -126,31 +176,81 @@ bool SyncObjectPool::isEmpty()
 
 //-----------------------------------------------------------------------------
 // Method Type:  INSTANCE
-// Description:  Method to check if a specified object is in the Free Linked 
-//               List or the Used Linked List
+// Description:  Method to set or reset the capacity increment of this Object Pool
 // Design:      
 //-----------------------------------------------------------------------------
-bool SyncObjectPool::containsObject(OPMBase* object)
+void SyncObjectPool::setCapacityIncrement(int capacityIncrement)
 {
    poolMutex_.acquire();
-   bool result = ObjectPool::containsObject(object);
+   //set the capacity increment for the Free Linked List
+   capacityIncrement_ = capacityIncrement;
    poolMutex_.release();
-   return result;
-}//end containsObject
+}//end setCapacityIncrement
 
 
 //-----------------------------------------------------------------------------
 // Method Type:  INSTANCE
-// Description:  Method to set or reset the capacity increment of this Object Pool
+// Description:  Method to enable/disable the per-thread object caches
 // Design:      
 //-----------------------------------------------------------------------------
-void SyncObjectPool::setCapacityIncrement(int capacityIncrement)
+bool SyncObjectPool::setThreadCacheSize(int cacheSize)
+{
+   threadCacheSize_ = cacheSize;
+   return true;
+}//end setThreadCacheSize
+
+
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Method to hand the growing and shrinking of this pool over to
+//               the OPM maintenance thread (or take it back)
+// Design:      
+//-----------------------------------------------------------------------------
+bool SyncObjectPool::setBackgroundMaintenance(bool enable, const ACE_Time_Value& shrinkDelay)
 {
    poolMutex_.acquire();
-   //set the capacity increment for the Free Linked List
-   capacityIncrement_ = capacityIncrement;
+   shrinkDelay_ = shrinkDelay;
+   lowUsageSince_ = ACE_OS::gettimeofday();
+   backgroundMaintenance_ = enable;
    poolMutex_.release();
-}//end setCapacityIncrement
+   return true;
+}//end setBackgroundMaintenance
+
+
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Perform one maintenance pass over this pool
+// Design:       Object construction (and slab mapping/prefaulting) is the
+//               expensive part of growing, so it is done between the two lock
+//               holds; reserve may keep handing out the remaining free objects
+//               in the meantime.
+//-----------------------------------------------------------------------------
+void SyncObjectPool::performMaintenance(const ACE_Time_Value& now)
+{
+   poolMutex_.acquire();
+   int pendingIncrements = ObjectPool::getPendingIncrements();
+   poolMutex_.release();
+
+   for (int i = 0; i < pendingIncrements; i++)
+   {
+      OPMLinkedList objectList;
+      OPMSlab* slab = NULL;
+      unsigned long long startUsec = OPMStats::getTimeUsec();
+      int createdCount = ObjectPool::createIncrement(&objectList, &slab);
+
+      poolMutex_.acquire();
+      ObjectPool::addIncrement(&objectList, createdCount, slab);
+      if (createdCount > 0)
+      {
+         OPMStats::recordGrowth(stats_, OPMStats::getTimeUsec() - startUsec, false);
+      }//end if
+      poolMutex_.release();
+   }//end for
+
+   poolMutex_.acquire();
+   ObjectPool::decayCapacity(now);
+   poolMutex_.release();
+}//end performMaintenance
 
 
 //-----------------------------------------------------------------------------
@@ -175,6 +275,44 @@ void SyncObjectPool::printUsageSummary()
 // PRIVATE methods.
 //-----------------------------------------------------------------------------
 
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Acquire the pool lock, recording any time spent waiting for it
+// Design:       The uncontended case costs one tryacquire and no clock reads;
+//               the wait is recorded once the lock is held, since that is
+//               what protects the statistics.
+//-----------------------------------------------------------------------------
+void SyncObjectPool::acquirePoolMutex()
+{
+   if (poolMutex_.tryacquire() != ERROR)
+   {
+      return;
+   }//end if
+
+   unsigned long long startUsec = OPMStats::getTimeUsec();
+   poolMutex_.acquire();
+   OPMStats::recordLockWait(stats_, OPMStats::getTimeUsec() - startUsec);
+}//end acquirePoolMutex
+
+
+//-----------------------------------------------------------------------------
+// Method Type:  INSTANCE
+// Description:  Try to acquire the pool lock without blocking
+// Design:       A failed attempt does not hold the lock, so its counters are
+//               updated atomically.
+//-----------------------------------------------------------------------------
+bool SyncObjectPool::tryAcquirePoolMutex()
+{
+   if (poolMutex_.tryacquire() != ERROR)
+   {
+      return true;
+   }//end if
+
+   __sync_fetch_and_add(&stats_->contentionCount_, 1ULL);
+   __sync_fetch_and_add(&stats_->reserveFailCount_, 1ULL);
+   return false;
+}//end tryAcquirePoolMutex
+
 //-----------------------------------------------------------------------------
 // Nested Class Definitions:
 //-----------------------------------------------------------------------------
@@ -77,6 +77,10 @@ class SyncObjectPool : public ObjectPool
        * @param bootStrapMethod pointer to a function or method (OPMBase::initialize)
        *        that will create the object and return a pointer to it
        * @param growthMode Either NO_GROWTH, GROWTH_ALLOWED, or GROW_AND_SHRINK
+       * @param placementMethod See ObjectPool (NULL unless slab mode)
+       * @param objectSize See ObjectPool (slab mode only)
+       * @param slabOptions See ObjectPool (slab mode only)
+       * @param lazyConstruction See ObjectPool
        */
       SyncObjectPool(int objectPoolID,
                  int initialCapacity, 
@@ -85,7 +89,11 @@ class SyncObjectPool : public ObjectPool
                  const char* objectType, 
                  long objectInitParam,
                  OPM_INIT_PTR bootStrapMethod, 
-                 OPMGrowthModeType growthMode);
+                 OPMGrowthModeType growthMode,
+                 OPM_PLACEMENT_INIT_PTR placementMethod = NULL,
+                 size_t objectSize = 0,
+                 int slabOptions = OPM_SLAB_DEFAULT,
+                 bool lazyConstruction = false);
 
       /** Virtual Destructor */
       virtual ~SyncObjectPool();
@@ -118,7 +126,26 @@ class SyncObjectPool : public ObjectPool
        *         data structure (could be wrong pool, is already released, or was
        *         not created via OPM)
        */
-      bool release(OPMBase* object, char* callingFileName, int callingLineNumb);
+      bool release(OPMBase* object, const char* callingFileName, int callingLineNumb);
+
+      /**
+       * Reserve up to objectCount objects while holding the pool lock once.
+       * @param objects Array that receives the reserved objects
+       * @param objectCount Maximum number of objects to reserve
+       * @param blockWaitingForAccess If false, returns 0 if the lock is held elsewhere
+       * @return Number of objects actually reserved
+       */
+      int reserveBatch(OPMBase** objects, int objectCount, bool blockWaitingForAccess = true);
+
+      /**
+       * Release objectCount (already cleaned) objects while holding the pool lock once.
+       * @param objects Array of objects to release
+       * @param objectCount Number of objects in the array
+       * @param callingFileName Source file from which the objects are being released
+       * @param callingLineNumb Source line from which the objects are being released
+       * @return Number of objects successfully released
+       */
+      int releaseBatch(OPMBase** objects, int objectCount, const char* callingFileName, int callingLineNumb);
       
       /**
        * Method to test if this pool is empty
@@ -127,21 +154,36 @@ class SyncObjectPool : public ObjectPool
        */
       bool isEmpty();
 
-      /**
-       * Method to check if a specified object is in the Free Linked List or the
-       * Used Linked List. This method traverses both lists looking for pointer
-       * equality.
-       * @return <tt>true</tt> if the Object is in the list<br>
-       *         <tt>false</tt> if the Object is NOT in the list
-       */
-      bool containsObject(OPMBase* object);
-
       /**
        * Method to set or reset the capacity increment of this Object Pool
        * @param capacityIncrement The new capacity increment value
        */
       void setCapacityIncrement(int capacityIncrement);
 
+      /**
+       * Method to enable/disable the per-thread object caches for this pool
+       * @param cacheSize Maximum number of objects each thread may cache
+       * @return <tt>true</tt> always for thread safe pools
+       */
+      bool setThreadCacheSize(int cacheSize);
+
+      /**
+       * Method to hand the growing and shrinking of this pool over to the OPM
+       * maintenance thread (or take it back)
+       * @param enable Whether the maintenance thread grows and shrinks this pool
+       * @param shrinkDelay How long usage must stay low before each shrink
+       * @return <tt>true</tt> always for thread safe pools
+       */
+      bool setBackgroundMaintenance(bool enable, const ACE_Time_Value& shrinkDelay);
+
+      /**
+       * Perform one maintenance pass over this pool. New capacity increments
+       * are built without holding the pool lock, which is only taken to check
+       * the watermarks and to splice the new objects into the Free List.
+       * @param now Current time of day
+       */
+      void performMaintenance(const ACE_Time_Value& now);
+
       /* Method prints the Object Usage Summary for this Object Pool if DEBUG logs are enabled */
       void printUsageSummary();
 
@@ -151,6 +193,19 @@ class SyncObjectPool : public ObjectPool
 
    private:
 
+      /**
+       * Acquire the pool lock (blocking), recording the time spent waiting in
+       * the pool statistics if another thread held it
+       */
+      void acquirePoolMutex();
+
+      /**
+       * Try to acquire the pool lock without blocking, recording a failed
+       * attempt in the pool statistics
+       * @return <tt>true</tt> if the lock was acquired
+       */
+      bool tryAcquirePoolMutex();
+
       /** Mutex that controls task access to this object pool */
       ACE_Recursive_Thread_Mutex poolMutex_;
 };
@@ -0,0 +1,212 @@
+/******************************************************************************
+*
+* File name:   OPMStat.cpp
+* Subsystem:   Platform Services
+* Description: Command line tool that reads the OPM statistics segment of a
+*              running process and prints per-pool rates, lock contention,
+*              lock wait histograms and growth costs.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "platform/opm/OPMStats.h"
+
+// Common defines
+#include "platform/common/Defines.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+/* From the C++ FAQ, create a module-level identification string using a compile
+   define - BUILD_LABEL must have NO spaces passed in from the make command
+   line */
+#define StrConvert(x) #x
+#define XstrConvert(x) StrConvert(x)
+static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)OPM Statistics"
+   "\n   Build Label: " XstrConvert(BUILD_LABEL)
+   "\n   Compile Time: " __DATE__ " " __TIME__;
+
+/** Directory that holds the statistics segments */
+#define OPMSTAT_SEGMENT_DIR "/dev/shm/"
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: List the processes that have an OPM statistics segment
+// Design:
+//-----------------------------------------------------------------------------
+static void opmStatListSegments()
+{
+   DIR* directory = opendir(OPMSTAT_SEGMENT_DIR);
+   if (directory == NULL)
+   {
+      printf("Unable to open %s\n", OPMSTAT_SEGMENT_DIR);
+      return;
+   }//end if
+
+   const char* segmentPrefix = OPM_STATS_SEGMENT_PREFIX + strlen(OPMSTAT_SEGMENT_DIR);
+   int prefixLength = strlen(segmentPrefix);
+   printf("Processes with OPM statistics:\n");
+   struct dirent* entry;
+   while ((entry = readdir(directory)) != NULL)
+   {
+      if (strncmp(entry->d_name, segmentPrefix, prefixLength) == 0)
+      {
+         //a process that exits without shutting down the OPM leaves its segment behind
+         const char* processId = entry->d_name + prefixLength;
+         printf("   %s%s\n", processId, ((kill(atoi(processId), 0) == ERROR) ? " (not running)" : ""));
+      }//end if
+   }//end while
+   closedir(directory);
+}//end opmStatListSegments
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Print the statistics of each active pool. If a previous
+//              snapshot is given, counters are printed as per-second rates
+//              over the interval instead of totals.
+// Design:
+//-----------------------------------------------------------------------------
+static void opmStatPrintPools(const OPMPoolStats* current, const OPMPoolStats* previous,
+   int poolCount, double intervalSeconds)
+{
+   printf("%4s %-24s %9s %9s %12s %12s %12s %12s %9s %10s %10s %8s %8s\n",
+      "ID", "ObjectType", "Capacity", "Used", (previous ? "Reserve/s" : "Reserves"),
+      (previous ? "Release/s" : "Releases"), (previous ? "CacheRes/s" : "CacheRes"),
+      (previous ? "CacheRel/s" : "CacheRel"), "Failed", "Contended", "WaitUsec",
+      "Growths", "Shrinks");
+
+   for (int i = 0; i < poolCount; i++)
+   {
+      const OPMPoolStats& stats = current[i];
+      if (stats.isActive_ == 0)
+      {
+         continue;
+      }//end if
+
+      unsigned long long reserves = stats.reserveCount_;
+      unsigned long long releases = stats.releaseCount_;
+      unsigned long long cacheReserves = stats.cacheReserveCount_;
+      unsigned long long cacheReleases = stats.cacheReleaseCount_;
+      if (previous != NULL)
+      {
+         reserves = (unsigned long long)((reserves - previous[i].reserveCount_) / intervalSeconds);
+         releases = (unsigned long long)((releases - previous[i].releaseCount_) / intervalSeconds);
+         cacheReserves = (unsigned long long)((cacheReserves - previous[i].cacheReserveCount_) / intervalSeconds);
+         cacheReleases = (unsigned long long)((cacheReleases - previous[i].cacheReleaseCount_) / intervalSeconds);
+      }//end if
+
+      printf("%4d %-24.24s %9d %9d %12llu %12llu %12llu %12llu %9llu %10llu %10llu %8llu %8llu\n",
+         stats.poolID_, stats.objectType_, stats.currentCapacity_, stats.currentUsed_,
+         reserves, releases, cacheReserves, cacheReleases, stats.reserveFailCount_,
+         stats.contentionCount_, stats.lockWaitUsec_, stats.growthCount_, stats.shrinkCount_);
+   }//end for
+
+   //print the detail that does not fit in the table only for pools that have it
+   for (int i = 0; i < poolCount; i++)
+   {
+      const OPMPoolStats& stats = current[i];
+      if ((stats.isActive_ == 0) || ((stats.contentionCount_ == 0) && (stats.growthCount_ == 0)))
+      {
+         continue;
+      }//end if
+
+      printf("\nPool %d (%s): peak used %d, growth time total/max %llu/%llu usec, %llu of %llu growths synchronous\n",
+         stats.poolID_, stats.objectType_, stats.peakUsed_, stats.growthUsec_, stats.maxGrowthUsec_,
+         stats.synchronousGrowthCount_, stats.growthCount_);
+      for (int bucket = 0; bucket < OPM_STATS_HISTOGRAM_BUCKETS; bucket++)
+      {
+         if (stats.lockWaitHistogram_[bucket] != 0)
+         {
+            printf("   lock wait >= %8llu usec: %llu\n", OPMStats::getHistogramBucketStart(bucket),
+               stats.lockWaitHistogram_[bucket]);
+         }//end if
+      }//end for
+   }//end for
+}//end opmStatPrintPools
+
+
+//-----------------------------------------------------------------------------
+// Function Type: main function for OPM statistics binary
+// Description: With no arguments, lists the processes that have statistics.
+//              With a process Id, prints the totals; with an interval, prints
+//              rates every interval (count times, or until interrupted).
+// Design:      Only reads the segment, so the target process is never stopped.
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+   if (argc < 2)
+   {
+      printf("Usage:\n  OPMStat [<pid> [<interval seconds> [<count>]]]\n");
+      opmStatListSegments();
+      return 0;
+   }//end if
+
+   pid_t processId = (pid_t)atoi(argv[1]);
+   int intervalSeconds = (argc > 2) ? atoi(argv[2]) : 0;
+   int count = (argc > 3) ? atoi(argv[3]) : 0;
+
+   const OPMStatsSegment* segment = OPMStats::attach(processId);
+   if (segment == NULL)
+   {
+      printf("No OPM statistics found for process %d\n", (int)processId);
+      return ERROR;
+   }//end if
+
+   //copy the pool entries out of the segment so that rates are computed from
+   // a consistent pair of snapshots
+   // (static, since operator new does not keep them cache line aligned)
+   static OPMPoolStats snapshots[2][OPM_STATS_MAX_POOLS];
+   OPMPoolStats* current = snapshots[0];
+   OPMPoolStats* previous = snapshots[1];
+   memcpy((void*)current, (const void*)segment->pools_, sizeof(segment->pools_));
+
+   printf("OPM statistics for process %d\n", segment->processId_);
+   opmStatPrintPools(current, NULL, segment->poolCount_, 0);
+
+   for (int i = 0; (intervalSeconds > 0) && ((count == 0) || (i < count)); i++)
+   {
+      sleep(intervalSeconds);
+      //stop if the process has shut the OPM down (or exited cleanly)
+      if (segment->magic_ != OPM_STATS_MAGIC)
+      {
+         printf("\nProcess %d has shut down its OPM statistics\n", (int)processId);
+         break;
+      }//end if
+
+      OPMPoolStats* swap = previous;
+      previous = current;
+      current = swap;
+      memcpy((void*)current, (const void*)segment->pools_, sizeof(segment->pools_));
+
+      printf("\n");
+      opmStatPrintPools(current, previous, segment->poolCount_, (double)intervalSeconds);
+   }//end for
+
+   OPMStats::detach(segment);
+   return OK;
+}//end main
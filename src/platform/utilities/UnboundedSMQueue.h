@@ -59,7 +59,9 @@
  * which enforce concurrency in shared memory (such as this queue), and then
  * we pass process-local objects through the shared memory from one process
  * to another. (ALSO NOTE: creating pools of objects in shared memory is the
- * job of the in-memory database provider)
+ * job of the in-memory database provider; the one exception is the OPMSharedPool
+ * of raw message buffers that the LocalSMMailbox queue passes by offset so that
+ * messages are not copied through the queue)
  * <p>
  * $Author: Stephen Horton$
  * $Revision: 1$
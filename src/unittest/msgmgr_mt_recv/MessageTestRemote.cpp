@@ -18,8 +18,10 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <cstdio>
 #include <unistd.h>
 #include <sys/resource.h>
+#include <ace/OS_NS_unistd.h>
 #include <ace/Thread_Manager.h>
 
 //-----------------------------------------------------------------------------
@@ -28,12 +30,15 @@
 
 #include "MessageTestRemote.h"
 #include "platform/msgmgr/DistributedMailbox.h"
+#include "platform/msgmgr/LocalMailbox.h"
+#include "platform/msgmgr/LocalMessageQueue.h"
 #include "platform/msgmgr/MailboxProcessor.h"
 #include "platform/msgmgr/MessageFactory.h"
 #include "platform/msgmgr/TimerMessage.h"
 
 #include "MessageTest1Message.h"
 #include "MessageTestRemoteMessage.h"
+#include "MessageTestSequenceMessage.h"
 #include "MessageTestTimerMessage.h"
 
 #include "platform/logger/Logger.h"
@@ -57,6 +62,34 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Test
 // Static singleton instance
 MessageTestRemote* MessageTestRemote::messageTestInstance_ = NULL;
 
+/* Producer threads, and messages posted by each, of the queue stress test */
+#define MESSAGE_QUEUE_TEST_PRODUCERS 4
+#define MESSAGE_QUEUE_TEST_MESSAGES 200000
+
+/* Messages posted with each batch enqueue (and dequeued at most at once) */
+#define MESSAGE_QUEUE_TEST_BATCH 8
+
+/* Longest time (in msec) to wait for a consumer that should return */
+#define MESSAGE_QUEUE_TEST_WAIT_MSEC 5000
+
+/* Processing threads, keys, and messages posted per key of the sharded processing test */
+#define MAILBOX_SHARD_TEST_THREADS 4
+#define MAILBOX_SHARD_TEST_KEYS 64
+#define MAILBOX_SHARD_TEST_SEQUENCES 2000
+
+/* Longest time (in msec) to wait for the sharded processing test messages to be handled */
+#define MAILBOX_SHARD_TEST_WAIT_MSEC 30000
+
+/* State shared between the queue tests and their threads */
+struct MessageQueueTestWork
+{
+   LocalMessageQueue* queue_;
+   int key_;
+   volatile int isDone_;
+   int errorCount_;
+   MessageBase* message_;
+};
+
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
 //-----------------------------------------------------------------------------
@@ -376,6 +409,408 @@ void messageRemoteSendingTest()
 }//end messageRemoteSendingTest
 
 
+//-----------------------------------------------------------------------------
+// Function Type: queue stress test producer thread
+// Description: Posts MESSAGE_QUEUE_TEST_MESSAGES numbered messages, alternating
+//              between single and batch enqueues
+// Design:
+//-----------------------------------------------------------------------------
+void* messageQueueProducer(void* arg)
+{
+   MessageQueueTestWork* work = (MessageQueueTestWork*)arg;
+   MailboxAddress sourceAddress;
+   sourceAddress.locationType = LOCAL_MAILBOX;
+   sourceAddress.mailboxName = "QueueStressTest";
+
+   MessageBase* batch[MESSAGE_QUEUE_TEST_BATCH];
+   int sequence = 0;
+   while (sequence < MESSAGE_QUEUE_TEST_MESSAGES)
+   {
+      for (int i = 0; i < MESSAGE_QUEUE_TEST_BATCH; i++)
+      {
+         if (work->queue_->enqueue(new MessageTestSequenceMessage(sourceAddress, work->key_, sequence++)) == ERROR)
+         {
+            work->errorCount_++;
+         }//end if
+      }//end for
+      for (int i = 0; i < MESSAGE_QUEUE_TEST_BATCH; i++)
+      {
+         batch[i] = new MessageTestSequenceMessage(sourceAddress, work->key_, sequence++);
+      }//end for
+      if (work->queue_->enqueue(batch, MESSAGE_QUEUE_TEST_BATCH) != MESSAGE_QUEUE_TEST_BATCH)
+      {
+         work->errorCount_++;
+      }//end if
+   }//end while
+   return NULL;
+}//end messageQueueProducer
+
+
+//-----------------------------------------------------------------------------
+// Function Type: queue stress test consumer thread
+// Description: Dequeues (blocking) until every producer's messages have been
+//              received, checking that each producer's sequence numbers arrive
+//              exactly once and in order
+// Design:      The queue empties often, so the consumer parks and is woken by
+//              the producers many times over. A lost message leaves it blocked
+//              until the test deactivates the queue.
+//-----------------------------------------------------------------------------
+void* messageQueueConsumer(void* arg)
+{
+   MessageQueueTestWork* work = (MessageQueueTestWork*)arg;
+   int nextSequence[MESSAGE_QUEUE_TEST_PRODUCERS];
+   for (int i = 0; i < MESSAGE_QUEUE_TEST_PRODUCERS; i++)
+   {
+      nextSequence[i] = 0;
+   }//end for
+
+   MessageBase* messages[MESSAGE_QUEUE_TEST_BATCH];
+   int remainingCount = MESSAGE_QUEUE_TEST_PRODUCERS * MESSAGE_QUEUE_TEST_MESSAGES;
+   while (remainingCount > 0)
+   {
+      int messageCount = work->queue_->dequeue(messages, MESSAGE_QUEUE_TEST_BATCH, true);
+      if (messageCount == 0)
+      {
+         // Deactivated by the test
+         work->errorCount_++;
+         break;
+      }//end if
+      for (int i = 0; i < messageCount; i++)
+      {
+         MessageTestSequenceMessage* message = (MessageTestSequenceMessage*)messages[i];
+         int key = message->getKey();
+         if ((key < 0) || (key >= MESSAGE_QUEUE_TEST_PRODUCERS) || (message->getSequence() != nextSequence[key]))
+         {
+            work->errorCount_++;
+         }//end if
+         else
+         {
+            nextSequence[key]++;
+         }//end else
+         remainingCount--;
+         delete message;
+      }//end for
+   }//end while
+
+   // Nothing may follow the last expected message
+   if (work->queue_->dequeue(false) != NULL)
+   {
+      work->errorCount_++;
+   }//end if
+   work->isDone_ = 1;
+   return NULL;
+}//end messageQueueConsumer
+
+
+//-----------------------------------------------------------------------------
+// Function Type: queue wake up test consumer thread
+// Description: Dequeues a single message, blocking on the (empty) queue
+// Design:
+//-----------------------------------------------------------------------------
+void* messageQueueWaiter(void* arg)
+{
+   MessageQueueTestWork* work = (MessageQueueTestWork*)arg;
+   work->message_ = work->queue_->dequeue(true);
+   work->isDone_ = 1;
+   return NULL;
+}//end messageQueueWaiter
+
+
+//-----------------------------------------------------------------------------
+// Function Type: queue test helper
+// Description: Wait up to MESSAGE_QUEUE_TEST_WAIT_MSEC for a consumer thread to
+//              finish, and deactivate its queue to release it if it does not
+// Design:
+//-----------------------------------------------------------------------------
+bool messageQueueWaitForConsumer(MessageQueueTestWork* work)
+{
+   for (int msec = 0; (work->isDone_ == 0) && (msec < MESSAGE_QUEUE_TEST_WAIT_MSEC); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   if (work->isDone_ != 0)
+   {
+      return true;
+   }//end if
+   work->queue_->deactivate();
+   return false;
+}//end messageQueueWaitForConsumer
+
+
+//-----------------------------------------------------------------------------
+// Function Type: LocalMessageQueue Test
+// Description: Multi-producer / single consumer stress test of the lock free
+//              queue, followed by checks that a consumer parked on an empty
+//              queue is woken by a post and released by deactivate
+// Design:      Drives LocalMessageQueue directly, without a mailbox in front
+//              of it
+//-----------------------------------------------------------------------------
+void messageQueueTest()
+{
+   MailboxAddress sourceAddress;
+   sourceAddress.locationType = LOCAL_MAILBOX;
+   sourceAddress.mailboxName = "QueueStressTest";
+
+   // Stress test
+   LocalMessageQueue stressQueue;
+   stressQueue.activate();
+   MessageQueueTestWork consumerWork;
+   consumerWork.queue_ = &stressQueue;
+   consumerWork.key_ = 0;
+   consumerWork.isDone_ = 0;
+   consumerWork.errorCount_ = 0;
+   consumerWork.message_ = NULL;
+   MessageQueueTestWork producerWork[MESSAGE_QUEUE_TEST_PRODUCERS];
+   ACE_thread_t producerIds[MESSAGE_QUEUE_TEST_PRODUCERS];
+   ACE_thread_t consumerId;
+
+   ACE_Time_Value startTime = ACE_OS::gettimeofday();
+   ACE_Thread_Manager::instance()->spawn(messageQueueConsumer, &consumerWork, THR_NEW_LWP | THR_JOINABLE,
+      &consumerId);
+   for (int i = 0; i < MESSAGE_QUEUE_TEST_PRODUCERS; i++)
+   {
+      producerWork[i] = consumerWork;
+      producerWork[i].key_ = i;
+      ACE_Thread_Manager::instance()->spawn(messageQueueProducer, &producerWork[i],
+         THR_NEW_LWP | THR_JOINABLE, &producerIds[i]);
+   }//end for
+   int errorCount = 0;
+   for (int i = 0; i < MESSAGE_QUEUE_TEST_PRODUCERS; i++)
+   {
+      ACE_Thread_Manager::instance()->join(producerIds[i]);
+      errorCount += producerWork[i].errorCount_;
+   }//end for
+   bool isFinished = messageQueueWaitForConsumer(&consumerWork);
+   ACE_Thread_Manager::instance()->join(consumerId);
+   ACE_Time_Value elapsedTime = ACE_OS::gettimeofday() - startTime;
+   errorCount += consumerWork.errorCount_;
+
+   if ((isFinished == false) || (errorCount != 0) || (stressQueue.getDepth() != 0))
+   {
+      printf("\nQueue stress test FAILED (%d errors, consumer %s, depth %d)\n", errorCount,
+         (isFinished ? "finished" : "blocked"), stressQueue.getDepth());
+   }//end if
+   else
+   {
+      printf("\nQueue stress test passed (%d producers, %d messages each, %ld msec)\n",
+         MESSAGE_QUEUE_TEST_PRODUCERS, MESSAGE_QUEUE_TEST_MESSAGES, (long)elapsedTime.msec());
+   }//end else
+
+   // A consumer parked on an empty queue must wake up for a post
+   LocalMessageQueue wakeQueue;
+   wakeQueue.activate();
+   MessageQueueTestWork waiterWork;
+   waiterWork.queue_ = &wakeQueue;
+   waiterWork.key_ = 0;
+   waiterWork.isDone_ = 0;
+   waiterWork.errorCount_ = 0;
+   waiterWork.message_ = NULL;
+   ACE_Thread_Manager::instance()->spawn(messageQueueWaiter, &waiterWork, THR_NEW_LWP | THR_JOINABLE,
+      &consumerId);
+   ACE_OS::sleep(ACE_Time_Value(0, 100000));
+   bool wasParked = (waiterWork.isDone_ == 0);
+   MessageBase* wakeMessage = new MessageTestSequenceMessage(sourceAddress, 0, 0);
+   wakeQueue.enqueue(wakeMessage);
+   isFinished = messageQueueWaitForConsumer(&waiterWork);
+   ACE_Thread_Manager::instance()->join(consumerId);
+   if ((wasParked == false) || (isFinished == false) || (waiterWork.message_ != wakeMessage))
+   {
+      printf("Queue wake up test FAILED (consumer %s, %s)\n", (wasParked ? "parked" : "did not park"),
+         (isFinished ? "woken" : "not woken"));
+   }//end if
+   else
+   {
+      printf("Queue wake up test passed\n");
+   }//end else
+   if (waiterWork.message_ == NULL)
+   {
+      // Still queued if the consumer was never woken
+      wakeQueue.dequeue(false);
+   }//end if
+   delete wakeMessage;
+
+   // ..and deactivate must release it, with nothing dequeued
+   LocalMessageQueue deactivateQueue;
+   deactivateQueue.activate();
+   waiterWork.queue_ = &deactivateQueue;
+   waiterWork.isDone_ = 0;
+   waiterWork.message_ = NULL;
+   ACE_Thread_Manager::instance()->spawn(messageQueueWaiter, &waiterWork, THR_NEW_LWP | THR_JOINABLE,
+      &consumerId);
+   ACE_OS::sleep(ACE_Time_Value(0, 100000));
+   wasParked = (waiterWork.isDone_ == 0);
+   deactivateQueue.deactivate();
+   isFinished = messageQueueWaitForConsumer(&waiterWork);
+   ACE_Thread_Manager::instance()->join(consumerId);
+   if ((wasParked == false) || (isFinished == false) || (waiterWork.message_ != NULL))
+   {
+      printf("Queue deactivate test FAILED (consumer %s, %s)\n", (wasParked ? "parked" : "did not park"),
+         (isFinished ? "released" : "not released"));
+   }//end if
+   else
+   {
+      printf("Queue deactivate test passed\n");
+   }//end else
+}//end messageQueueTest
+
+
+/* State shared between the sharded processing test and its message handler */
+struct MailboxShardTestState
+{
+   volatile int inHandler_[MAILBOX_SHARD_TEST_KEYS];
+   int nextSequence_[MAILBOX_SHARD_TEST_KEYS];
+   volatile int handledCount_;
+   volatile int errorCount_;
+};
+static MailboxShardTestState mailboxShardTestState;
+
+
+//-----------------------------------------------------------------------------
+// Function Type: sharded processing test message handler
+// Description: Checks that the messages of each key arrive in sequence, and
+//              that no two threads are ever in the handler for the same key
+// Design:      The per key flag is taken with an atomic compare and swap, so a
+//              second thread entering for the same key is caught rather than
+//              racing on the sequence number
+//-----------------------------------------------------------------------------
+int mailboxShardTestHandler(MessageBase* message)
+{
+   MessageTestSequenceMessage* sequenceMessage = (MessageTestSequenceMessage*)message;
+   int key = sequenceMessage->getKey();
+   if (__sync_bool_compare_and_swap(&mailboxShardTestState.inHandler_[key], 0, 1) == false)
+   {
+      __sync_fetch_and_add(&mailboxShardTestState.errorCount_, 1);
+   }//end if
+   else
+   {
+      if (sequenceMessage->getSequence() != mailboxShardTestState.nextSequence_[key])
+      {
+         __sync_fetch_and_add(&mailboxShardTestState.errorCount_, 1);
+      }//end if
+      mailboxShardTestState.nextSequence_[key] = sequenceMessage->getSequence() + 1;
+
+      // Stay in the handler a little now and then, so that a wrongly handed
+      // out key has the chance to be seen on two threads
+      if ((sequenceMessage->getSequence() % 100) == 0)
+      {
+         ACE_OS::thr_yield();
+      }//end if
+      __sync_bool_compare_and_swap(&mailboxShardTestState.inHandler_[key], 1, 0);
+   }//end else
+   __sync_fetch_and_add(&mailboxShardTestState.handledCount_, 1);
+   return OK;
+}//end mailboxShardTestHandler
+
+
+//-----------------------------------------------------------------------------
+// Function Type: sharded processing test key function
+// Description: Returns the key carried by a sequence message
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int mailboxShardTestKey(MessageBase* message)
+{
+   return ((MessageTestSequenceMessage*)message)->getKey();
+}//end mailboxShardTestKey
+
+
+//-----------------------------------------------------------------------------
+// Function Type: sharded processing test thread
+// Description: Runs the sharded processing loop until the mailbox is deactivated
+// Design:
+//-----------------------------------------------------------------------------
+void* mailboxShardTestProcessor(void* arg)
+{
+   MailboxProcessor* mailboxProcessor = (MailboxProcessor*)arg;
+   mailboxProcessor->processMailboxSharded(MAILBOX_SHARD_TEST_THREADS, mailboxShardTestKey);
+   return NULL;
+}//end mailboxShardTestProcessor
+
+
+//-----------------------------------------------------------------------------
+// Function Type: MailboxProcessor sharded mode Test
+// Description: Posts interleaved sequences for many keys to a local mailbox
+//              processed by several sharded threads, and checks that each key
+//              is handled in order and on only one thread at a time
+// Design:      The keys are posted round robin, so consecutive messages of a
+//              key are always separated by the messages of every other key
+//-----------------------------------------------------------------------------
+void mailboxShardTest()
+{
+   for (int key = 0; key < MAILBOX_SHARD_TEST_KEYS; key++)
+   {
+      mailboxShardTestState.inHandler_[key] = 0;
+      mailboxShardTestState.nextSequence_[key] = 0;
+   }//end for
+   mailboxShardTestState.handledCount_ = 0;
+   mailboxShardTestState.errorCount_ = 0;
+
+   MailboxAddress shardAddress;
+   shardAddress.locationType = LOCAL_MAILBOX;
+   shardAddress.mailboxName = "MailboxShardTest";
+   MailboxOwnerHandle* shardMailbox = LocalMailbox::createMailbox(shardAddress);
+   if ((shardMailbox == NULL) || (shardMailbox->activate() == ERROR))
+   {
+      printf("\nMailbox sharded processing test FAILED (unable to create the mailbox)\n");
+      return;
+   }//end if
+
+   MessageHandlerList* shardHandlerList = new MessageHandlerList();
+   MessageHandler shardMessageHandler = makeFunctor((MessageHandler*)0, mailboxShardTestHandler);
+   shardHandlerList->add(MSGMGR_TEST2_MSG_ID, shardMessageHandler);
+   MailboxProcessor* mailboxProcessor = new MailboxProcessor(shardHandlerList, *shardMailbox);
+   ACE_thread_t processorId;
+   ACE_Thread_Manager::instance()->spawn(mailboxShardTestProcessor, mailboxProcessor,
+      THR_NEW_LWP | THR_JOINABLE, &processorId);
+
+   int postErrorCount = 0;
+   for (int sequence = 0; sequence < MAILBOX_SHARD_TEST_SEQUENCES; sequence++)
+   {
+      for (int key = 0; key < MAILBOX_SHARD_TEST_KEYS; key++)
+      {
+         MessageBase* sequenceMessage = new MessageTestSequenceMessage(shardAddress, key, sequence);
+         if (shardMailbox->post(sequenceMessage) == ERROR)
+         {
+            delete sequenceMessage;
+            postErrorCount++;
+         }//end if
+      }//end for
+   }//end for
+
+   int expectedCount = (MAILBOX_SHARD_TEST_KEYS * MAILBOX_SHARD_TEST_SEQUENCES) - postErrorCount;
+   for (int msec = 0; (mailboxShardTestState.handledCount_ < expectedCount) &&
+        (msec < MAILBOX_SHARD_TEST_WAIT_MSEC); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   shardMailbox->deactivate();
+   ACE_Thread_Manager::instance()->join(processorId);
+
+   int incompleteCount = 0;
+   for (int key = 0; key < MAILBOX_SHARD_TEST_KEYS; key++)
+   {
+      if (mailboxShardTestState.nextSequence_[key] != MAILBOX_SHARD_TEST_SEQUENCES)
+      {
+         incompleteCount++;
+      }//end if
+   }//end for
+
+   if ((postErrorCount != 0) || (mailboxShardTestState.errorCount_ != 0) || (incompleteCount != 0))
+   {
+      printf("\nMailbox sharded processing test FAILED (%d post errors, %d order errors, %d keys incomplete)\n",
+         postErrorCount, mailboxShardTestState.errorCount_, incompleteCount);
+   }//end if
+   else
+   {
+      printf("\nMailbox sharded processing test passed (%d threads, %d keys, %d messages each)\n",
+         MAILBOX_SHARD_TEST_THREADS, MAILBOX_SHARD_TEST_KEYS, MAILBOX_SHARD_TEST_SEQUENCES);
+   }//end else
+
+   delete mailboxProcessor;
+   delete shardHandlerList;
+   delete shardMailbox;
+}//end mailboxShardTest
+
+
 //-----------------------------------------------------------------------------
 // Function Type: main function for test binary
 // Description:
@@ -405,6 +840,12 @@ int main(int argc, char* argv[])
    // Initialize the OPM
    OPM::initialize();
 
+   // Exercise the lock free queue behind the local mailboxes
+   messageQueueTest();
+
+   // Check the per key ordering of the sharded mailbox processing
+   mailboxShardTest();
+
    MessageTestRemote* messageTestRemote = new MessageTestRemote();
    if (!messageTestRemote)
    {
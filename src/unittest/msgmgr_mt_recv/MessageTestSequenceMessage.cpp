@@ -1,9 +1,8 @@
 /******************************************************************************
 *
-* File name:   MessageBlockWrapper.cpp
+* File name:   MessageTestSequenceMessage.cpp
 * Subsystem:   Platform Services
-* Description: This class creates a wrapper around the ACE Message Block
-*              class so that we can pool ACE Message Blocks inside the OPM.
+* Description: Test Message carrying a producer key and sequence number
 *
 * Name                 Date       Release
 * -------------------- ---------- ---------------------------------------------
@@ -17,17 +16,21 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <sstream>
 
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
-#include "MessageBlockWrapper.h"
+#include "MessageTestSequenceMessage.h"
+
+#include "platform/common/MessageIds.h"
 
 //-----------------------------------------------------------------------------
 // Static Declarations.
 //-----------------------------------------------------------------------------
 
+#define VERSION_NUMBER 1
 
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
@@ -39,8 +42,11 @@
 // Description: 
 // Design:     
 //-----------------------------------------------------------------------------
-MessageBlockWrapper::MessageBlockWrapper(int blockSize)
-                    :ACE_Message_Block(blockSize)
+MessageTestSequenceMessage::MessageTestSequenceMessage(const MailboxAddress& sourceAddress, int key,
+   int sequence)
+  :MessageBase(sourceAddress, VERSION_NUMBER),
+   key_(key),
+   sequence_(sequence)
 {
 }//end constructor
 
@@ -50,89 +56,55 @@ MessageBlockWrapper::MessageBlockWrapper(int blockSize)
 // Description: 
 // Design:     
 //-----------------------------------------------------------------------------
-MessageBlockWrapper::~MessageBlockWrapper()
+MessageTestSequenceMessage::~MessageTestSequenceMessage()
 {
-   // Release the Message_Block so that it can be reference counted and disposed of
-   // NOTE: this may NOT work, so do NOT ever let OPM delete these objects!!
-   // Only allow OPM to grow these objects.
-   release();
 }//end virtual destructor
 
 
-//-----------------------------------------------------------------------------
-// Method Type: STATIC
-// Description: OPMBase static initializer method for bootstrapping the objects
-// Design:
-//-----------------------------------------------------------------------------
-OPMBase* MessageBlockWrapper::initialize(int initializer)
-{
-   MessageBlockWrapper* messageBlock = NULL;
-   if (initializer == 0)
-   {
-      messageBlock = new MessageBlockWrapper();
-   }//end if
-   else
-   {
-      messageBlock = new MessageBlockWrapper(initializer);
-   }//end else
-   return messageBlock;
-}//end initialize
-
-
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
-// Description: OPMBase clean method gets called when the object gets released 
-//              back into its pool
+// Description: Return the message Id
 // Design:
 //-----------------------------------------------------------------------------
-void MessageBlockWrapper::clean()
+unsigned short MessageTestSequenceMessage::getMessageId() const
 {
-}//end clean
+   return MSGMGR_TEST2_MSG_ID;
+}//end getMessageId
 
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
-// Description: Overridden ACE_Message_Block Method
-// Design:
+// Description: Return the String'ized form of the class contents 
+// Design:     
 //-----------------------------------------------------------------------------
-void MessageBlockWrapper::base(char *data, size_t size)
+string MessageTestSequenceMessage::toString()
 {
-   ACE_Message_Block::base(data,size);
-}//end base
+   ostringstream ostr;
+   ostr << "MessageTestSequenceMessage key " << key_ << " sequence " << sequence_ << ends;
+   return ostr.str();
+}//end toString
 
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
-// Description: Overridden ACE_Message_Block Method
+// Description: Return the key of the poster
 // Design:
 //-----------------------------------------------------------------------------
-char* MessageBlockWrapper::base (void) const
+int MessageTestSequenceMessage::getKey() const
 {
-   return ACE_Message_Block::base();
-}//end base
+   return key_;
+}//end getKey
 
 
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
-// Description: Overridden ACE_Message_Block Method
+// Description: Return the sequence number within the key
 // Design:
 //-----------------------------------------------------------------------------
-void MessageBlockWrapper::msg_priority(unsigned long priority)
-{
-   ACE_Message_Block::msg_priority(priority);
-}//end msg_priority
-
-
-//-----------------------------------------------------------------------------
-// Method Type: INSTANCE
-// Description: Return the String'ized form of the class contents 
-// Design:     
-//-----------------------------------------------------------------------------
-string MessageBlockWrapper::toString()
+int MessageTestSequenceMessage::getSequence() const
 {
-   string s = "";
-   return (s);
-}//end toString
+   return sequence_;
+}//end getSequence
 
 
 //-----------------------------------------------------------------------------
@@ -1,9 +1,8 @@
 /******************************************************************************
 * 
-* File name:   MessageBlockWrapper.h 
+* File name:   MessageTestSequenceMessage.h 
 * Subsystem:   Platform Services 
-* Description: This class creates a wrapper around the ACE Message Block
-*              class so that we can pool ACE Message Blocks inside the OPM. 
+* Description: Test Message carrying a producer key and sequence number
 * 
 * Name                 Date       Release 
 * -------------------- ---------- ---------------------------------------------
@@ -12,20 +11,18 @@
 *
 ******************************************************************************/
 
-#ifndef _PLAT_MESSAGE_BLOCK_WRAPPER_H_
-#define _PLAT_MESSAGE_BLOCK_WRAPPER_H_
+#ifndef _PLAT_MESSAGE_TEST_SEQUENCE_MESSAGE_H_
+#define _PLAT_MESSAGE_TEST_SEQUENCE_MESSAGE_H_
 
 //-----------------------------------------------------------------------------
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
-#include <ace/Message_Block.h>
-
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
 
-#include "platform/opm/OPMBase.h"
+#include "platform/msgmgr/MessageBase.h"
 
 //-----------------------------------------------------------------------------
 // Forward Declarations.
@@ -43,40 +40,27 @@
 //
 
 /**
- * MessageBlockWrapper is a wrapper class around the ACE_Message_Block class. 
- * <p>
- * This simple wrapper exists so that we can create a pool of 
- * ACE_Message_Blocks inside the OPM.
+ * MessageTestSequenceMessage is Test Message carrying a producer key and sequence number. 
  * <p>
+ * This message demonstrates local mailbox message passing only.
  * $Author: Stephen Horton$
  * $Revision: 1$
  */
 
-class MessageBlockWrapper : public OPMBase, ACE_Message_Block
+class MessageTestSequenceMessage : public MessageBase
 {
    public:
 
       /** Constructor */
-      MessageBlockWrapper(int blockSize = 0);
+      MessageTestSequenceMessage(const MailboxAddress& sourceAddress, int key, int sequence);
 
       /** Virtual Destructor */
-      virtual ~MessageBlockWrapper();
-
-      /** OPMBase static initializer method for bootstrapping the objects */
-      static OPMBase* initialize(int initializer);
-
-      /** OPMBase clean method gets called when the object gets released back
-          into its pool */
-      void clean();
-
-      /** Overridden ACE_Message_Block Method */
-      void base(char *data, size_t size);
-
-      /** Overridden ACE_Message_Block Method */
-      char *base (void) const;
+      virtual ~MessageTestSequenceMessage();
 
-      /** Overridden ACE_Message_Block Method */
-      void msg_priority (unsigned long priority);
+      /**
+       * Returns the Message Id
+       */
+      unsigned short getMessageId() const;
 
       /** 
        * String'ized debugging method
@@ -84,6 +68,12 @@ class MessageBlockWrapper : public OPMBase, ACE_Message_Block
        */
       string toString();
 
+      /** Returns the key of the poster */
+      int getKey() const;
+
+      /** Returns the sequence number within the key */
+      int getSequence() const;
+
    protected:
 
    private:
@@ -92,13 +82,19 @@ class MessageBlockWrapper : public OPMBase, ACE_Message_Block
        * Copy Constructor declared private so that default automatic
        * methods aren't used.
        */
-      MessageBlockWrapper(const MessageBlockWrapper& rhs);
+      MessageTestSequenceMessage(const MessageTestSequenceMessage& rhs);
 
       /**
        * Assignment operator declared private so that default automatic
        * methods aren't used.
        */
-      MessageBlockWrapper& operator= (const MessageBlockWrapper& rhs);
+      MessageTestSequenceMessage& operator= (const MessageTestSequenceMessage& rhs);
+
+      /** Key of the poster */
+      int key_;
+
+      /** Sequence number within the key */
+      int sequence_;
 
 };
 
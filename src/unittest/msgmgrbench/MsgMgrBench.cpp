@@ -0,0 +1,403 @@
+/******************************************************************************
+*
+* File name:   MsgMgrBench.cpp
+* Subsystem:   Platform Services
+* Description: Implements the distributed mailbox proxy benchmark (socket
+*              writes per message and throughput, with and without the
+*              coalescing of the outbound queue) with machine readable output.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <time.h>
+#include <unistd.h>
+#include <ace/Get_Opt.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/SOCK_Acceptor.h>
+#include <ace/SOCK_Stream.h>
+#include <ace/Thread_Manager.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "MsgMgrBench.h"
+
+#include "platform/msgmgr/DistributedMailboxProxy.h"
+#include "platform/msgmgr/MailboxHandle.h"
+#include "platform/msgmgr/MailboxLookupService.h"
+#include "platform/msgmgr/MessageBuffer.h"
+#include "platform/msgmgr/MessageFactory.h"
+
+#include "platform/opm/OPM.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+// Common defines
+#include "platform/common/Defines.h"
+#include "platform/common/MessageIds.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+/* From the C++ FAQ, create a module-level identification string using a compile
+   define - BUILD_LABEL must have NO spaces passed in from the make command
+   line */
+#define StrConvert(x) #x
+#define XstrConvert(x) StrConvert(x)
+static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Benchmark"
+   "\n   Build Label: " XstrConvert(BUILD_LABEL)
+   "\n   Compile Time: " __DATE__ " " __TIME__;
+
+#define VERSION_NUMBER 1
+
+/* Default number of messages posted to each proxy */
+#define MSGMGR_BENCH_DEFAULT_MESSAGES 1000000
+
+/* Default port of the first receiving peer (each variant uses the next port,
+   since the lookup service keeps a proxy, and its options, for each address) */
+#define MSGMGR_BENCH_DEFAULT_PORT 7800
+
+/* Length in bytes of each benchmark frame, as sent on the socket */
+#define MSGMGR_BENCH_FRAME_LENGTH (MSGMGR_FRAME_HEADER_LENGTH + sizeof(unsigned short) + sizeof(int) + \
+   MSGMGR_BENCH_PAYLOAD_SIZE)
+
+/* Size of each read made by the receiving peer */
+#define MSGMGR_BENCH_RECEIVE_SIZE 65536
+
+/* Longest time (in seconds) to wait for the peer to accept or the proxy to connect */
+#define MSGMGR_BENCH_CONNECT_WAIT_SEC 5
+
+/* Coalescing delay of the coalescing variants (microseconds) */
+#define MSGMGR_BENCH_COALESCE_DELAY_USEC 1000
+
+/* Proxy options measured; a line of the output each */
+struct MsgMgrBenchVariant
+{
+   const char* name;
+   bool isNoDelay;
+   unsigned int coalesceBytes;
+};
+
+static const MsgMgrBenchVariant msgMgrBenchVariants[] =
+{
+   { "uncoalesced",          false, 0 },
+   { "uncoalesced_nodelay",  true,  0 },
+   { "coalesce_4k_nodelay",  true,  4096 },
+   { "coalesce_16k_nodelay", true,  16384 },
+};
+
+/* State shared with the receiving peer thread */
+struct MsgMgrBenchReceiver
+{
+   ACE_SOCK_Acceptor acceptor;
+   unsigned long long expectedBytes;
+   unsigned long long receivedBytes;
+};
+
+/* Output for the results */
+static FILE* msgMgrBenchOutput = NULL;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Constructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+MsgMgrBenchMessage::MsgMgrBenchMessage(const MailboxAddress& sourceAddress, int sequence)
+  :MessageBase(sourceAddress, VERSION_NUMBER),
+   sequence_(sequence)
+{
+   memset(payload_, (sequence & 0xff), sizeof(payload_));
+}//end constructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Virtual Destructor
+// Description:
+// Design:
+//-----------------------------------------------------------------------------
+MsgMgrBenchMessage::~MsgMgrBenchMessage()
+{
+}//end virtual destructor
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the message Id
+// Design:
+//-----------------------------------------------------------------------------
+unsigned short MsgMgrBenchMessage::getMessageId() const
+{
+   return MSGMGR_TEST1_MSG_ID;
+}//end getMessageId
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Serialize this message into the supplied message buffer
+// Design:
+//-----------------------------------------------------------------------------
+int MsgMgrBenchMessage::serialize(MessageBuffer& buffer)
+{
+   buffer << sequence_;
+   buffer.appendBytes(payload_, sizeof(payload_));
+   return OK;
+}//end serialize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: Return the String'ized form of the class contents
+// Design:
+//-----------------------------------------------------------------------------
+string MsgMgrBenchMessage::toString()
+{
+   ostringstream ostr;
+   ostr << "MsgMgrBenchMessage: Sequence=" << sequence_ << ends;
+   return (ostr.str());
+}//end toString
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Return a monotonic time stamp in nanoseconds
+// Design:
+//-----------------------------------------------------------------------------
+static inline unsigned long long msgMgrBenchGetTimeNsec()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return ((unsigned long long)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}//end msgMgrBenchGetTimeNsec
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark thread function
+// Description: Receiving peer: accepts the proxy connection and reads until
+//              every byte posted has arrived (or the connection is lost)
+// Design:      Reads as much as the socket holds, like the DistributedMailbox
+//              does, so that the receiving side is not the bottleneck
+//-----------------------------------------------------------------------------
+static void* msgMgrBenchReceive(void* arg)
+{
+   MsgMgrBenchReceiver* receiver = (MsgMgrBenchReceiver*)arg;
+   ACE_SOCK_Stream peerStream;
+   ACE_Time_Value acceptTimeout(MSGMGR_BENCH_CONNECT_WAIT_SEC);
+   if (receiver->acceptor.accept(peerStream, NULL, &acceptTimeout) == ERROR)
+   {
+      return NULL;
+   }//end if
+
+   unsigned char* receiveBuffer = new unsigned char[MSGMGR_BENCH_RECEIVE_SIZE];
+   while (receiver->receivedBytes < receiver->expectedBytes)
+   {
+      ssize_t numberBytes = peerStream.recv(receiveBuffer, MSGMGR_BENCH_RECEIVE_SIZE);
+      if (numberBytes <= 0)
+      {
+         break;
+      }//end if
+      receiver->receivedBytes += numberBytes;
+   }//end while
+   delete [] receiveBuffer;
+   peerStream.close();
+   return NULL;
+}//end msgMgrBenchReceive
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark
+// Description: Posts the messages to a proxy with the options of a variant,
+//              and records the socket writes per message (from the proxy's
+//              write count) and the throughput (until the last byte arrives)
+// Design:      Each message is allocated and posted as an application would.
+//              The synchronous variants post without a timeout, so that a full
+//              socket blocks the post rather than failing it; the coalescing
+//              variants retry a post refused by a full outbound queue.
+//-----------------------------------------------------------------------------
+static void msgMgrBenchProxyPost(const MsgMgrBenchVariant& variant, int port, int messages)
+{
+   MailboxAddress peerAddress;
+   peerAddress.locationType = DISTRIBUTED_MAILBOX;
+   peerAddress.mailboxName = "MsgMgrBenchPeer";
+   peerAddress.inetAddress.set(port, "127.0.0.1");
+   peerAddress.neid = "100000001";
+
+   DistributedConnectionOptions options;
+   DistributedMailboxProxy::getConnectionOptions(peerAddress, options);
+   options.isNoDelay = variant.isNoDelay;
+   options.coalesceBytes = variant.coalesceBytes;
+   options.coalesceDelayUsec = ((variant.coalesceBytes > 0) ? MSGMGR_BENCH_COALESCE_DELAY_USEC : 0);
+   DistributedMailboxProxy::setConnectionOptions(peerAddress, options);
+
+   MsgMgrBenchReceiver receiver;
+   receiver.expectedBytes = (unsigned long long)messages * MSGMGR_BENCH_FRAME_LENGTH;
+   receiver.receivedBytes = 0;
+   ACE_thread_t receiverId;
+   if ((receiver.acceptor.open(peerAddress.inetAddress, 1) == ERROR) ||
+       (ACE_Thread_Manager::instance()->spawn(msgMgrBenchReceive, &receiver, THR_NEW_LWP | THR_JOINABLE,
+          &receiverId) == ERROR))
+   {
+      fprintf(stderr, "Unable to start the receiving peer on port %d\n", port);
+      receiver.acceptor.close();
+      return;
+   }//end if
+
+   MailboxHandle* proxyHandle = MailboxLookupService::find(peerAddress);
+   for (int msec = 0; (proxyHandle != NULL) && (proxyHandle->getConnectionState() != MAILBOX_CONNECTED) &&
+        (msec < (MSGMGR_BENCH_CONNECT_WAIT_SEC * 1000)); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   if ((proxyHandle == NULL) || (proxyHandle->getConnectionState() != MAILBOX_CONNECTED))
+   {
+      fprintf(stderr, "Proxy for variant %s did not connect\n", variant.name);
+      receiver.acceptor.close();
+      ACE_Thread_Manager::instance()->join(receiverId);
+      delete proxyHandle;
+      return;
+   }//end if
+
+   MailboxAddress sourceAddress;
+   sourceAddress.locationType = DISTRIBUTED_MAILBOX;
+   sourceAddress.mailboxName = "MsgMgrBench";
+   sourceAddress.inetAddress.set(port, "127.0.0.1");
+
+   unsigned int startWriteCount = proxyHandle->getWriteCount();
+   unsigned long long startTime = msgMgrBenchGetTimeNsec();
+   int postedCount = 0;
+   while (postedCount < messages)
+   {
+      MessageBase* message = new MsgMgrBenchMessage(sourceAddress, postedCount);
+      int result = proxyHandle->post(message, NULL);
+      while ((result == ERROR) && (variant.coalesceBytes > 0) &&
+             (proxyHandle->getConnectionState() == MAILBOX_CONNECTED))
+      {
+         ACE_OS::thr_yield();
+         result = proxyHandle->post(message, NULL);
+      }//end while
+      if (result == ERROR)
+      {
+         delete message;
+         break;
+      }//end if
+      postedCount++;
+   }//end while
+
+   // Synchronous posts have been written once they return; queued ones once
+   // the peer has read them all
+   if (postedCount < messages)
+   {
+      receiver.expectedBytes = (unsigned long long)postedCount * MSGMGR_BENCH_FRAME_LENGTH;
+   }//end if
+   ACE_Thread_Manager::instance()->join(receiverId);
+   double elapsedSec = (double)(msgMgrBenchGetTimeNsec() - startTime) / 1000000000.0;
+   unsigned int writeCount = proxyHandle->getWriteCount() - startWriteCount;
+
+   if ((postedCount < messages) || (receiver.receivedBytes < receiver.expectedBytes))
+   {
+      fprintf(stderr, "Variant %s posted %d of %d messages, and %llu of %llu bytes arrived\n", variant.name,
+         postedCount, messages, receiver.receivedBytes, receiver.expectedBytes);
+   }//end if
+   fprintf(msgMgrBenchOutput, "proxy_post,%s,%u,%d,%d,%.0f,%u,%.4f\n", variant.name, variant.coalesceBytes,
+      (variant.isNoDelay ? 1 : 0), postedCount, ((elapsedSec > 0.0) ? (postedCount / elapsedSec) : 0.0),
+      writeCount, ((postedCount > 0) ? ((double)writeCount / postedCount) : 0.0));
+   fflush(msgMgrBenchOutput);
+
+   delete proxyHandle;
+   receiver.acceptor.close();
+}//end msgMgrBenchProxyPost
+
+
+//-----------------------------------------------------------------------------
+// Function Type: main function for MsgMgr benchmark binary
+// Description: Runs every variant over loopback and writes one CSV line per
+//              result (lines starting with '#' are comments)
+// Design:
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+   int messages = MSGMGR_BENCH_DEFAULT_MESSAGES;
+   int port = MSGMGR_BENCH_DEFAULT_PORT;
+   const char* outputFileName = NULL;
+
+   ACE_Get_Opt get_opt (argc, argv, "n:p:o:h");
+   int c;
+   while ((c = get_opt ()) != -1)
+   {
+      switch (c)
+      {
+         case 'n':
+            messages = atoi(get_opt.optarg);
+            break;
+         case 'p':
+            port = atoi(get_opt.optarg);
+            break;
+         case 'o':
+            outputFileName = get_opt.optarg;
+            break;
+         default:
+            printf("Usage:\n  MsgMgrBench\n"
+                   "    -n <count> Messages posted to each proxy (default %d)\n"
+                   "    -p <port> Port of the first receiving peer; each variant uses the next (default %d)\n"
+                   "    -o <file> Write the results to a file instead of stdout\n",
+                   MSGMGR_BENCH_DEFAULT_MESSAGES, MSGMGR_BENCH_DEFAULT_PORT);
+            return ERROR;
+      }//end switch
+   }//end while
+
+   if (messages < 1)
+   {
+      messages = 1;
+   }//end if
+
+   msgMgrBenchOutput = stdout;
+   if ((outputFileName != NULL) && ((msgMgrBenchOutput = fopen(outputFileName, "w")) == NULL))
+   {
+      fprintf(stderr, "Unable to write %s\n", outputFileName);
+      return ERROR;
+   }//end if
+
+   // Initialize the Logger with local-only output, and keep the MsgMgr and OPM
+   // logs out of the measurements
+   Logger::getInstance()->initialize(true);
+   Logger::setSubsystemLogLevel(MSGMGRLOG, ERRORLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+   OPM::initialize();
+
+   time_t now = time(NULL);
+   fprintf(msgMgrBenchOutput, "# MsgMgrBench build %s, %s", XstrConvert(BUILD_LABEL), ctime(&now));
+   fprintf(msgMgrBenchOutput, "# loopback, messages=%d frame_bytes=%d coalesce_delay_usec=%d\n",
+      messages, (int)MSGMGR_BENCH_FRAME_LENGTH, MSGMGR_BENCH_COALESCE_DELAY_USEC);
+   fprintf(msgMgrBenchOutput, "benchmark,variant,coalesce_bytes,nodelay,messages,msgs_per_sec,writes,writes_per_msg\n");
+
+   int variantCount = sizeof(msgMgrBenchVariants) / sizeof(msgMgrBenchVariants[0]);
+   for (int variant = 0; variant < variantCount; variant++)
+   {
+      msgMgrBenchProxyPost(msgMgrBenchVariants[variant], port + variant, messages);
+   }//end for
+
+   if (msgMgrBenchOutput != stdout)
+   {
+      fclose(msgMgrBenchOutput);
+   }//end if
+   return OK;
+}//end main
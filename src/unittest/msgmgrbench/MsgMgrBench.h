@@ -0,0 +1,111 @@
+/******************************************************************************
+*
+* File name:   MsgMgrBench.h
+* Subsystem:   Platform Services
+* Description: Implements the distributed mailbox proxy benchmark (socket
+*              writes per message and throughput, with and without the
+*              coalescing of the outbound queue) with machine readable output.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_MSGMGR_BENCH_H_
+#define _PLAT_MSGMGR_BENCH_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <string>
+
+using namespace std;
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "platform/msgmgr/MessageBase.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Size in bytes of the payload carried by each benchmark message, which makes
+    its frame 48 bytes long (header, Message Id, sequence and payload) */
+#define MSGMGR_BENCH_PAYLOAD_SIZE 40
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * Benchmark message posted to the distributed mailbox proxies under test. It
+ * serializes to a fixed size, so that the receiving side can count bytes
+ * rather than decode frames.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class MsgMgrBenchMessage : public MessageBase
+{
+   public:
+
+      /** Constructor */
+      MsgMgrBenchMessage(const MailboxAddress& sourceAddress, int sequence);
+
+      /** Virtual Destructor */
+      virtual ~MsgMgrBenchMessage();
+
+      /**
+       * Returns the Message Id
+       */
+      unsigned short getMessageId() const;
+
+      /**
+       * Subclassed serialization implementation
+       */
+      int serialize(MessageBuffer& buffer);
+
+      /**
+       * String'ized debugging method
+       * @return string representation of the contents of this object
+       */
+      string toString();
+
+   protected:
+
+   private:
+
+      /**
+       * Copy Constructor declared private so that default automatic
+       * methods aren't used.
+       */
+      MsgMgrBenchMessage(const MsgMgrBenchMessage& rhs);
+
+      /**
+       * Assignment operator declared private so that default automatic
+       * methods aren't used.
+       */
+      MsgMgrBenchMessage& operator= (const MsgMgrBenchMessage& rhs);
+
+      /** Sequence number of the message */
+      int sequence_;
+
+      /** Payload */
+      unsigned char payload_[MSGMGR_BENCH_PAYLOAD_SIZE];
+
+};
+
+#endif
@@ -17,8 +17,12 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <cstdio>
+#include <climits>
 #include <unistd.h>
 #include <sys/resource.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/OS_NS_unistd.h>
 #include <ace/Thread_Manager.h>
 
 //-----------------------------------------------------------------------------
@@ -28,6 +32,7 @@
 #include "MessageTest.h"
 #include "platform/msgmgr/MailboxProcessor.h"
 #include "platform/msgmgr/LocalMailbox.h"
+#include "platform/msgmgr/ReactorPool.h"
 #include "platform/msgmgr/TimerMessage.h"
 
 #include "MessageTest1Message.h"
@@ -55,6 +60,25 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Test
 // Static singleton instance
 MessageTest* MessageTest::messageTestInstance_ = NULL;
 
+/* Resolution (in usec) and range (in sec) of the timer wheel under test. At this
+   resolution a level 0 rotation is 25.6 msec and a level 1 rotation 6.55 sec */
+#define TIMER_WHEEL_TEST_RESOLUTION_USEC 100
+#define TIMER_WHEEL_TEST_RANGE_SEC 10
+
+/* How late (in msec) a timer wheel expiration may be received */
+#define TIMER_WHEEL_TEST_LATE_MSEC 30
+
+/* Timer of the timer wheel test that crosses two cascades, which expires in the
+   background while the other timer wheel tests run, and the time it arrived */
+static TimerMessage* timerWheelTestLongTimer = NULL;
+static ACE_Time_Value timerWheelTestLongArrival;
+
+/* Watermarks of the flow control test mailbox, and how long (in msec) its drainer
+   waits before draining a blocked post */
+#define FLOW_CONTROL_TEST_HIGH 4
+#define FLOW_CONTROL_TEST_LOW 1
+#define FLOW_CONTROL_TEST_DRAIN_DELAY_MSEC 50
+
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
 //-----------------------------------------------------------------------------
@@ -359,6 +383,755 @@ void messageSendingTest()
 }//end messageSendingTest
 
 
+//-----------------------------------------------------------------------------
+// Function Type: timer wheel test helper
+// Description: Wait up to waitMsec for a timer to arrive in the mailbox, and
+//              return the time it arrived (zero if it did not)
+// Design:      The long timer may arrive at any point, and is only noted.
+//              Any other message is counted as an error.
+//-----------------------------------------------------------------------------
+ACE_Time_Value timerWheelTestWait(MailboxOwnerHandle* mailbox, TimerMessage* expectedTimer, int waitMsec,
+   int& errorCount)
+{
+   for (int msec = 0; msec <= waitMsec; msec++)
+   {
+      MessageBase* message = mailbox->getMessageNonBlocking();
+      while (message != NULL)
+      {
+         ACE_Time_Value arrivalTime = ACE_OS::gettimeofday();
+         if ((message == timerWheelTestLongTimer) && (timerWheelTestLongArrival == ACE_Time_Value::zero))
+         {
+            timerWheelTestLongArrival = arrivalTime;
+         }//end if
+         else if (message != expectedTimer)
+         {
+            errorCount++;
+         }//end else if
+         if (message == expectedTimer)
+         {
+            return arrivalTime;
+         }//end if
+         message = mailbox->getMessageNonBlocking();
+      }//end while
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   return ACE_Time_Value::zero;
+}//end timerWheelTestWait
+
+
+//-----------------------------------------------------------------------------
+// Function Type: timer wheel test helper
+// Description: Check that a timer arrived no earlier than its expected time,
+//              and no later than TIMER_WHEEL_TEST_LATE_MSEC after it
+// Design:
+//-----------------------------------------------------------------------------
+bool timerWheelTestOnTime(const ACE_Time_Value& arrivalTime, const ACE_Time_Value& expectedTime)
+{
+   return ((arrivalTime >= expectedTime) &&
+           (arrivalTime <= (expectedTime + ACE_Time_Value(0, TIMER_WHEEL_TEST_LATE_MSEC * 1000))));
+}//end timerWheelTestOnTime
+
+
+//-----------------------------------------------------------------------------
+// Function Type: TimerWheel Test
+// Description: Schedules timers on a mailbox using a timer wheel, and checks:
+//              a timeout shorter than one level 0 rotation, timeouts crossing
+//              one and two cascades, that the range is accepted and one tick
+//              beyond it rejected, the period of a recurring timer, cancel
+//              before and after expiry, and that useTimerWheel is refused
+//              while timers are outstanding
+// Design:      The expirations are taken from the mailbox directly, so the
+//              test decides when the (non-reusable) timers are deleted
+//-----------------------------------------------------------------------------
+void timerWheelTest()
+{
+   MailboxAddress wheelAddress;
+   wheelAddress.locationType = LOCAL_MAILBOX;
+   wheelAddress.mailboxName = "TimerWheelTest";
+   MailboxOwnerHandle* wheelMailbox = LocalMailbox::createMailbox(wheelAddress);
+   ACE_Time_Value resolution(0, TIMER_WHEEL_TEST_RESOLUTION_USEC);
+   ACE_Time_Value maxRange(TIMER_WHEEL_TEST_RANGE_SEC);
+   if ((wheelMailbox == NULL) || (wheelMailbox->activate() == ERROR) ||
+       (wheelMailbox->useTimerWheel(resolution, maxRange) == ERROR))
+   {
+      printf("\nTimer wheel test FAILED (unable to set up the mailbox)\n");
+      return;
+   }//end if
+   printf("\n");
+
+   // Crosses two cascades: first parked in level 2, then cascaded through level 1
+   ACE_Time_Value longTimeout(7);
+   timerWheelTestLongTimer = new TimerMessage(wheelAddress, 1, longTimeout);
+   timerWheelTestLongArrival = ACE_Time_Value::zero;
+   ACE_Time_Value longStart = ACE_OS::gettimeofday();
+   long longTimerId = wheelMailbox->scheduleTimer(timerWheelTestLongTimer);
+
+   // With that timer outstanding, switching wheels must be refused
+   if ((longTimerId <= 0) || (wheelMailbox->useTimerWheel(resolution, maxRange) != ERROR))
+   {
+      printf("Timer wheel switch refused test FAILED (timer Id %ld)\n", longTimerId);
+   }//end if
+   else
+   {
+      printf("Timer wheel switch refused test passed\n");
+   }//end else
+
+   // Shorter than one level 0 rotation, then cancel after the expiry
+   int errorCount = 0;
+   ACE_Time_Value shortTimeout(0, 10000);
+   TimerMessage* shortTimer = new TimerMessage(wheelAddress, 1, shortTimeout);
+   ACE_Time_Value shortStart = ACE_OS::gettimeofday();
+   long shortTimerId = wheelMailbox->scheduleTimer(shortTimer);
+   ACE_Time_Value shortArrival = timerWheelTestWait(wheelMailbox, shortTimer, 1000, errorCount);
+   int cancelResult = wheelMailbox->cancelTimer(shortTimerId, shortTimer);
+   if ((shortTimerId <= 0) || (errorCount != 0) || !timerWheelTestOnTime(shortArrival, shortStart + shortTimeout))
+   {
+      printf("Timer wheel level 0 timeout test FAILED (%ld usec)\n",
+         (long)((shortArrival - shortStart).sec() * 1000000 + (shortArrival - shortStart).usec()));
+   }//end if
+   else
+   {
+      printf("Timer wheel level 0 timeout test passed\n");
+   }//end else
+   if (cancelResult != ERROR)
+   {
+      printf("Timer wheel cancel after expiry test FAILED\n");
+   }//end if
+   else
+   {
+      printf("Timer wheel cancel after expiry test passed\n");
+   }//end else
+   delete shortTimer;
+
+   // Crosses one cascade (from level 1 into level 0)
+   ACE_Time_Value cascadeTimeout(0, 100000);
+   TimerMessage* cascadeTimer = new TimerMessage(wheelAddress, 1, cascadeTimeout);
+   ACE_Time_Value cascadeStart = ACE_OS::gettimeofday();
+   long cascadeTimerId = wheelMailbox->scheduleTimer(cascadeTimer);
+   ACE_Time_Value cascadeArrival = timerWheelTestWait(wheelMailbox, cascadeTimer, 1000, errorCount);
+   if ((cascadeTimerId <= 0) || (errorCount != 0) ||
+       !timerWheelTestOnTime(cascadeArrival, cascadeStart + cascadeTimeout))
+   {
+      printf("Timer wheel one cascade test FAILED (%ld msec)\n", (long)(cascadeArrival - cascadeStart).msec());
+   }//end if
+   else
+   {
+      printf("Timer wheel one cascade test passed\n");
+   }//end else
+   delete cascadeTimer;
+
+   // The range itself is accepted, and one tick beyond it is rejected
+   TimerMessage* rangeTimer = new TimerMessage(wheelAddress, 1, maxRange);
+   long rangeTimerId = wheelMailbox->scheduleTimer(rangeTimer);
+   TimerMessage* beyondTimer = new TimerMessage(wheelAddress, 1, maxRange + resolution);
+   long beyondTimerId = wheelMailbox->scheduleTimer(beyondTimer);
+   if ((rangeTimerId <= 0) || (beyondTimerId != ERROR))
+   {
+      printf("Timer wheel range test FAILED (timer Ids %ld, %ld)\n", rangeTimerId, beyondTimerId);
+   }//end if
+   else
+   {
+      printf("Timer wheel range test passed\n");
+   }//end else
+   delete beyondTimer;
+
+   // Cancel before the expiry (which deletes the timer); it must never arrive
+   cancelResult = wheelMailbox->cancelTimer(rangeTimerId, rangeTimer);
+   TimerMessage* canceledTimer = new TimerMessage(wheelAddress, 1, ACE_Time_Value(0, 20000));
+   long canceledTimerId = wheelMailbox->scheduleTimer(canceledTimer);
+   if ((cancelResult == ERROR) || (wheelMailbox->cancelTimer(canceledTimerId, canceledTimer) == ERROR) ||
+       (timerWheelTestWait(wheelMailbox, NULL, 100, errorCount) != ACE_Time_Value::zero) || (errorCount != 0))
+   {
+      printf("Timer wheel cancel before expiry test FAILED\n");
+   }//end if
+   else
+   {
+      printf("Timer wheel cancel before expiry test passed\n");
+   }//end else
+
+   // A recurring timer keeps its period, without drifting
+   const int expirationCount = 5;
+   ACE_Time_Value period(0, 50000);
+   TimerMessage* recurringTimer = new TimerMessage(wheelAddress, 1, period, period);
+   ACE_Time_Value recurringStart = ACE_OS::gettimeofday();
+   long recurringTimerId = wheelMailbox->scheduleTimer(recurringTimer);
+   int onTimeCount = 0;
+   for (int expiration = 1; expiration <= expirationCount; expiration++)
+   {
+      ACE_Time_Value recurringArrival = timerWheelTestWait(wheelMailbox, recurringTimer, 1000, errorCount);
+      ACE_Time_Value expectedTime = recurringStart;
+      for (int count = 0; count < expiration; count++)
+      {
+         expectedTime += period;
+      }//end for
+      if (timerWheelTestOnTime(recurringArrival, expectedTime))
+      {
+         onTimeCount++;
+      }//end if
+   }//end for
+   cancelResult = wheelMailbox->cancelTimer(recurringTimerId, recurringTimer);
+   if ((recurringTimerId <= 0) || (cancelResult == ERROR) || (onTimeCount != expirationCount) || (errorCount != 0))
+   {
+      printf("Timer wheel recurring period test FAILED (%d of %d on time)\n", onTimeCount, expirationCount);
+   }//end if
+   else
+   {
+      printf("Timer wheel recurring period test passed\n");
+   }//end else
+
+   // The long timer, then no timer is left outstanding and switching is allowed
+   if (timerWheelTestLongArrival == ACE_Time_Value::zero)
+   {
+      timerWheelTestWait(wheelMailbox, timerWheelTestLongTimer, TIMER_WHEEL_TEST_RANGE_SEC * 1000, errorCount);
+   }//end if
+   if (!timerWheelTestOnTime(timerWheelTestLongArrival, longStart + longTimeout))
+   {
+      printf("Timer wheel two cascade test FAILED (%ld msec)\n",
+         (long)(timerWheelTestLongArrival - longStart).msec());
+   }//end if
+   else
+   {
+      printf("Timer wheel two cascade test passed\n");
+   }//end else
+   if (wheelMailbox->useTimerWheel(resolution, maxRange) == ERROR)
+   {
+      printf("Timer wheel switch allowed test FAILED\n");
+   }//end if
+   else
+   {
+      printf("Timer wheel switch allowed test passed\n");
+   }//end else
+
+   // The canceled recurring timer may have expired into the mailbox once more
+   // before the cancel
+   while (wheelMailbox->getMessageNonBlocking() != NULL)
+   {
+   }//end while
+   delete recurringTimer;
+   delete timerWheelTestLongTimer;
+   timerWheelTestLongTimer = NULL;
+   wheelMailbox->deactivate();
+   delete wheelMailbox;
+}//end timerWheelTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Timer disposal Test
+// Description: Destroys a mailbox with timers pending on the reactor it shares
+//              with another mailbox, and checks that its pending one-shot
+//              timers are deleted, its pending recurring timer is left to the
+//              application, a timer that already expired into its queue is
+//              deleted once, and a timer of the other mailbox still expires
+// Design:      main sizes the reactor pool to one reactor, so the two mailboxes
+//              share it. MessageTestTimerMessage counts its deletions.
+//-----------------------------------------------------------------------------
+void timerDisposalTest()
+{
+   MailboxAddress disposalAddress;
+   disposalAddress.locationType = LOCAL_MAILBOX;
+   disposalAddress.mailboxName = "TimerDisposalTest";
+   MailboxAddress survivorAddress;
+   survivorAddress.locationType = LOCAL_MAILBOX;
+   survivorAddress.mailboxName = "TimerDisposalSurvivor";
+   MailboxOwnerHandle* disposalMailbox = LocalMailbox::createMailbox(disposalAddress);
+   MailboxOwnerHandle* survivorMailbox = LocalMailbox::createMailbox(survivorAddress);
+   if ((disposalMailbox == NULL) || (survivorMailbox == NULL) ||
+       (disposalMailbox->activate() == ERROR) || (survivorMailbox->activate() == ERROR))
+   {
+      printf("Timer disposal test FAILED (unable to set up the mailboxes)\n");
+      return;
+   }//end if
+
+   const int pendingCount = 3;
+   unsigned int deletedCount = MessageTestTimerMessage::getDeletedCount();
+   ACE_Time_Value pendingTimeout(60);
+   int errorCount = 0;
+   for (int index = 0; index < pendingCount; index++)
+   {
+      if (disposalMailbox->scheduleTimer(new MessageTestTimerMessage(disposalAddress, pendingTimeout,
+          ACE_Time_Value::zero)) == ERROR)
+      {
+         errorCount++;
+      }//end if
+   }//end for
+   MessageTestTimerMessage* recurringTimer = new MessageTestTimerMessage(disposalAddress, pendingTimeout,
+      pendingTimeout);
+   MessageTestTimerMessage* expiredTimer = new MessageTestTimerMessage(disposalAddress, ACE_Time_Value(0, 10000),
+      ACE_Time_Value::zero);
+   ACE_Time_Value survivorTimeout(0, 200000);
+   MessageTestTimerMessage* survivorTimer = new MessageTestTimerMessage(survivorAddress, survivorTimeout,
+      ACE_Time_Value::zero);
+   if ((disposalMailbox->scheduleTimer(recurringTimer) == ERROR) ||
+       (disposalMailbox->scheduleTimer(expiredTimer) == ERROR) ||
+       (survivorMailbox->scheduleTimer(survivorTimer) == ERROR))
+   {
+      errorCount++;
+   }//end if
+
+   // Let the short timer expire into the queue, then destroy the mailbox
+   ACE_OS::sleep(ACE_Time_Value(0, 50000));
+   disposalMailbox->deactivate();
+   delete disposalMailbox;
+   unsigned int disposedCount = MessageTestTimerMessage::getDeletedCount() - deletedCount;
+
+   // The recurring timer was left to us; the other mailbox's timer still expires
+   delete recurringTimer;
+   MessageBase* survivorMessage = NULL;
+   for (int msec = 0; (survivorMessage == NULL) && (msec < 1000); msec++)
+   {
+      survivorMessage = survivorMailbox->getMessageNonBlocking();
+      if (survivorMessage == NULL)
+      {
+         ACE_OS::sleep(ACE_Time_Value(0, 1000));
+      }//end if
+   }//end for
+
+   if ((errorCount != 0) || (disposedCount != (unsigned int)(pendingCount + 1)) ||
+       (survivorMessage != survivorTimer))
+   {
+      printf("Timer disposal test FAILED (%d timers deleted, %d errors, other mailbox timer %s)\n",
+         disposedCount, errorCount, ((survivorMessage == survivorTimer) ? "expired" : "lost"));
+   }//end if
+   else
+   {
+      printf("Timer disposal test passed\n");
+   }//end else
+
+   if (survivorMessage != NULL)
+   {
+      survivorMessage->deleteMessage();
+   }//end if
+   survivorMailbox->deactivate();
+   delete survivorMailbox;
+}//end timerDisposalTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Timer wheel disposal Test
+// Description: Destroys a mailbox while a recurring timer and a one-shot timer
+//              of it are outstanding on the shared timer wheel, and checks that
+//              the one-shot timer is deleted, and that the recurring timer is
+//              taken off the wheel and left to the application
+// Design:      The recurring timer can only be scheduled again (on another
+//              mailbox of the same wheel) once the wheel no longer has it. The
+//              mailbox is destroyed before the first expiration, which the
+//              wheel then ticks past.
+//-----------------------------------------------------------------------------
+void timerWheelDisposalTest()
+{
+   MailboxAddress disposalAddress;
+   disposalAddress.locationType = LOCAL_MAILBOX;
+   disposalAddress.mailboxName = "TimerWheelDisposalTest";
+   MailboxAddress survivorAddress;
+   survivorAddress.locationType = LOCAL_MAILBOX;
+   survivorAddress.mailboxName = "TimerWheelDisposalSurvivor";
+   MailboxOwnerHandle* disposalMailbox = LocalMailbox::createMailbox(disposalAddress);
+   MailboxOwnerHandle* survivorMailbox = LocalMailbox::createMailbox(survivorAddress);
+   ACE_Time_Value resolution(0, TIMER_WHEEL_TEST_RESOLUTION_USEC);
+   ACE_Time_Value maxRange(TIMER_WHEEL_TEST_RANGE_SEC);
+   if ((disposalMailbox == NULL) || (survivorMailbox == NULL) ||
+       (disposalMailbox->activate() == ERROR) || (survivorMailbox->activate() == ERROR) ||
+       (disposalMailbox->useTimerWheel(resolution, maxRange) == ERROR) ||
+       (survivorMailbox->useTimerWheel(resolution, maxRange) == ERROR))
+   {
+      printf("Timer wheel disposal test FAILED (unable to set up the mailboxes)\n");
+      return;
+   }//end if
+
+   unsigned int deletedCount = MessageTestTimerMessage::getDeletedCount();
+   ACE_Time_Value period(0, 200000);
+   MessageTestTimerMessage* recurringTimer = new MessageTestTimerMessage(disposalAddress, period, period);
+   MessageTestTimerMessage* pendingTimer = new MessageTestTimerMessage(disposalAddress, ACE_Time_Value(5),
+      ACE_Time_Value::zero);
+   int errorCount = 0;
+   if ((disposalMailbox->scheduleTimer(recurringTimer) == ERROR) ||
+       (disposalMailbox->scheduleTimer(pendingTimer) == ERROR))
+   {
+      errorCount++;
+   }//end if
+
+   // Destroy the mailbox, then let the wheel run past the recurring timer's
+   // first expiration
+   ACE_OS::sleep(ACE_Time_Value(0, 50000));
+   disposalMailbox->deactivate();
+   delete disposalMailbox;
+   unsigned int disposedCount = MessageTestTimerMessage::getDeletedCount() - deletedCount;
+   ACE_OS::sleep(ACE_Time_Value(0, 300000));
+
+   // The recurring timer is off the wheel, so it can go to the other mailbox
+   recurringTimer->setExpirationTime(ACE_Time_Value::zero);
+   long survivorTimerId = survivorMailbox->scheduleTimer(recurringTimer);
+   MessageBase* survivorMessage = NULL;
+   for (int msec = 0; (survivorMessage == NULL) && (msec < 1000); msec++)
+   {
+      survivorMessage = survivorMailbox->getMessageNonBlocking();
+      if (survivorMessage == NULL)
+      {
+         ACE_OS::sleep(ACE_Time_Value(0, 1000));
+      }//end if
+   }//end for
+   if ((survivorTimerId <= 0) || (survivorMailbox->cancelTimer(survivorTimerId, recurringTimer) == ERROR))
+   {
+      errorCount++;
+   }//end if
+
+   if ((errorCount != 0) || (disposedCount != 1) || (survivorMessage != recurringTimer))
+   {
+      printf("Timer wheel disposal test FAILED (%u timers deleted, %d errors, timer %s on the other mailbox)\n",
+         disposedCount, errorCount, ((survivorMessage == recurringTimer) ? "expired" : "lost"));
+   }//end if
+   else
+   {
+      printf("Timer wheel disposal test passed\n");
+   }//end else
+
+   // The canceled recurring timer may have expired into the mailbox once more
+   while (survivorMailbox->getMessageNonBlocking() != NULL)
+   {
+   }//end while
+   survivorMailbox->deactivate();
+   delete survivorMailbox;
+   delete recurringTimer;
+}//end timerWheelDisposalTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Flow control Test helper
+// Description: Post a test message with the given priority, deleting it if the
+//              post is rejected. Returns the post result.
+// Design:
+//-----------------------------------------------------------------------------
+static int flowControlTestPost(MailboxOwnerHandle* mailbox, const MailboxAddress& address,
+   unsigned int priorityLevel, const ACE_Time_Value* timeout = &ACE_Time_Value::zero)
+{
+   MessageBase* messagePtr = new MessageTest1Message(address);
+   messagePtr->setPriority(priorityLevel);
+   int result = mailbox->post(messagePtr, timeout);
+   if (result == ERROR)
+   {
+      delete messagePtr;
+   }//end if
+   return result;
+}//end flowControlTestPost
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Flow control Test helper
+// Description: Dequeue and dispose of up to maxCount messages. Returns the
+//              number of messages dequeued.
+// Design:
+//-----------------------------------------------------------------------------
+static int flowControlTestDrain(MailboxOwnerHandle* mailbox, int maxCount)
+{
+   int drainedCount = 0;
+   MessageBase* messagePtr = NULL;
+   while ((drainedCount < maxCount) && ((messagePtr = mailbox->getMessageNonBlocking()) != NULL))
+   {
+      messagePtr->deleteMessage();
+      drainedCount++;
+   }//end while
+   return drainedCount;
+}//end flowControlTestDrain
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Flow control Test helper
+// Description: Return the number of messages queued in all of the lanes
+// Design:
+//-----------------------------------------------------------------------------
+static int flowControlTestDepth(MailboxOwnerHandle* mailbox)
+{
+   int depth = 0;
+   for (unsigned int lane = 0; lane < LOCAL_MESSAGE_QUEUE_LANES; lane++)
+   {
+      depth += mailbox->getQueueLaneDepth(lane);
+   }//end for
+   return depth;
+}//end flowControlTestDepth
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Flow control Test thread
+// Description: Drain the flow control test mailbox to its low watermark after
+//              a delay, releasing the post blocked on the overload
+// Design:
+//-----------------------------------------------------------------------------
+static void* flowControlTestDrainer(void* mailbox)
+{
+   ACE_OS::sleep(ACE_Time_Value(0, FLOW_CONTROL_TEST_DRAIN_DELAY_MSEC * 1000));
+   flowControlTestDrain((MailboxOwnerHandle*)mailbox, FLOW_CONTROL_TEST_HIGH - FLOW_CONTROL_TEST_LOW);
+   return NULL;
+}//end flowControlTestDrainer
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Flow control Test
+// Description: Overloads a mailbox under each flow control policy and checks
+//              which posts are admitted: BLOCK waits for the drain to the low
+//              watermark (or until the post timeout), FAIL_FAST rejects every
+//              post, and SHED_LOW_PRIORITY rejects the posts below the shed
+//              priority (a batch stops at the first of them). Timer
+//              expirations are admitted regardless.
+// Design:      The queue is filled to the high watermark with lowest priority
+//              messages, so the next post finds it overloaded
+//-----------------------------------------------------------------------------
+void flowControlTest()
+{
+   MailboxAddress flowAddress;
+   flowAddress.locationType = LOCAL_MAILBOX;
+   flowAddress.mailboxName = "FlowControlTest";
+   MailboxOwnerHandle* flowMailbox = LocalMailbox::createMailbox(flowAddress);
+   if ((flowMailbox == NULL) || (flowMailbox->activate() == ERROR))
+   {
+      printf("Flow control test FAILED (unable to set up the mailbox)\n");
+      return;
+   }//end if
+
+   int errorCount = 0;
+   if ((flowMailbox->setFlowControl(FLOW_CONTROL_TEST_HIGH, FLOW_CONTROL_TEST_HIGH, MAILBOX_FLOW_FAIL_FAST) != ERROR) ||
+       (flowMailbox->setFlowControl(FLOW_CONTROL_TEST_HIGH, FLOW_CONTROL_TEST_LOW, MAILBOX_FLOW_FAIL_FAST) == ERROR))
+   {
+      printf("Flow control test FAILED (watermarks not validated)\n");
+      errorCount++;
+   }//end if
+
+   // FAIL_FAST: rejected from the high watermark until drained to the low watermark
+   for (int index = 0; index < FLOW_CONTROL_TEST_HIGH; index++)
+   {
+      if (flowControlTestPost(flowMailbox, flowAddress, 0) == ERROR)
+      {
+         printf("Flow control test FAILED (fail fast rejected post %d below the high watermark)\n", index);
+         errorCount++;
+      }//end if
+   }//end for
+   if ((flowControlTestPost(flowMailbox, flowAddress, 7) != ERROR) ||
+       (flowControlTestDrain(flowMailbox, FLOW_CONTROL_TEST_HIGH - FLOW_CONTROL_TEST_LOW - 1) !=
+          (FLOW_CONTROL_TEST_HIGH - FLOW_CONTROL_TEST_LOW - 1)) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 7) != ERROR))
+   {
+      printf("Flow control test FAILED (fail fast admitted a post while overloaded)\n");
+      errorCount++;
+   }//end if
+
+   // A timer expiration is admitted while the queue is still overloaded
+   MessageTestTimerMessage* overloadTimer = new MessageTestTimerMessage(flowAddress, ACE_Time_Value(0, 10000),
+      ACE_Time_Value::zero);
+   if (flowMailbox->scheduleTimer(overloadTimer) == ERROR)
+   {
+      delete overloadTimer;
+      errorCount++;
+   }//end if
+   int overloadedDepth = FLOW_CONTROL_TEST_LOW + 1;
+   for (int msec = 0; (flowControlTestDepth(flowMailbox) == overloadedDepth) && (msec < 1000); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   if ((flowControlTestDepth(flowMailbox) != (overloadedDepth + 1)) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 7) != ERROR))
+   {
+      printf("Flow control test FAILED (timer expiration not admitted while overloaded)\n");
+      errorCount++;
+   }//end if
+
+   // Draining to the low watermark releases the overload
+   flowControlTestDrain(flowMailbox, (overloadedDepth + 1) - FLOW_CONTROL_TEST_LOW);
+   if (flowControlTestPost(flowMailbox, flowAddress, 0) == ERROR)
+   {
+      printf("Flow control test FAILED (fail fast rejected a post once drained)\n");
+      errorCount++;
+   }//end if
+   flowControlTestDrain(flowMailbox, INT_MAX);
+
+   // SHED_LOW_PRIORITY: only the posts below the shed priority are rejected
+   flowMailbox->setFlowControl(FLOW_CONTROL_TEST_HIGH, FLOW_CONTROL_TEST_LOW, MAILBOX_FLOW_SHED_LOW_PRIORITY, 2);
+   for (int index = 0; index < FLOW_CONTROL_TEST_HIGH; index++)
+   {
+      flowControlTestPost(flowMailbox, flowAddress, 0);
+   }//end for
+   if ((flowControlTestPost(flowMailbox, flowAddress, 0) != ERROR) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 1) != ERROR) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 2) == ERROR) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 5) == ERROR))
+   {
+      printf("Flow control test FAILED (shedding not by priority)\n");
+      errorCount++;
+   }//end if
+
+   const int batchCount = 3;
+   MessageBase* batch[batchCount];
+   unsigned int batchPriorities[batchCount] = { 3, 1, 4 };
+   for (int index = 0; index < batchCount; index++)
+   {
+      batch[index] = new MessageTest1Message(flowAddress);
+      batch[index]->setPriority(batchPriorities[index]);
+   }//end for
+   int batchPostedCount = flowMailbox->postBatch(batch, batchCount);
+   for (int index = ((batchPostedCount < 0) ? 0 : batchPostedCount); index < batchCount; index++)
+   {
+      delete batch[index];
+   }//end for
+   if (batchPostedCount != 1)
+   {
+      printf("Flow control test FAILED (batch posted %d messages instead of stopping at the shed one)\n",
+         batchPostedCount);
+      errorCount++;
+   }//end if
+   flowControlTestDrain(flowMailbox, INT_MAX);
+
+   // BLOCK: waits up to the post timeout for the drain to the low watermark
+   flowMailbox->setFlowControl(FLOW_CONTROL_TEST_HIGH, FLOW_CONTROL_TEST_LOW, MAILBOX_FLOW_BLOCK);
+   for (int index = 0; index < FLOW_CONTROL_TEST_HIGH; index++)
+   {
+      flowControlTestPost(flowMailbox, flowAddress, 0);
+   }//end for
+   ACE_Time_Value blockTimeout(0, FLOW_CONTROL_TEST_DRAIN_DELAY_MSEC * 1000);
+   ACE_Time_Value startTime = ACE_OS::gettimeofday();
+   if ((flowControlTestPost(flowMailbox, flowAddress, 7) != ERROR) ||
+       (flowControlTestPost(flowMailbox, flowAddress, 7, &blockTimeout) != ERROR) ||
+       ((ACE_OS::gettimeofday() - startTime) < blockTimeout))
+   {
+      printf("Flow control test FAILED (block did not wait out the post timeout)\n");
+      errorCount++;
+   }//end if
+
+   ACE_thread_t drainerId;
+   ACE_Time_Value drainTimeout(5);
+   startTime = ACE_OS::gettimeofday();
+   if (ACE_Thread_Manager::instance()->spawn((ACE_THR_FUNC) flowControlTestDrainer, (void*) flowMailbox,
+       THR_NEW_LWP | THR_JOINABLE, &drainerId) == -1)
+   {
+      printf("Flow control test FAILED (unable to spawn the drainer)\n");
+      errorCount++;
+   }//end if
+   else
+   {
+      int blockedResult = flowControlTestPost(flowMailbox, flowAddress, 0, &drainTimeout);
+      ACE_Time_Value blockedTime = ACE_OS::gettimeofday() - startTime;
+      ACE_Thread_Manager::instance()->join(drainerId);
+      if ((blockedResult == ERROR) || (blockedTime >= drainTimeout) ||
+          (flowControlTestDepth(flowMailbox) != (FLOW_CONTROL_TEST_LOW + 1)))
+      {
+         printf("Flow control test FAILED (block did not return once drained)\n");
+         errorCount++;
+      }//end if
+   }//end else
+
+   if (errorCount == 0)
+   {
+      printf("Flow control test passed\n");
+   }//end if
+
+   flowMailbox->deactivate();
+   delete flowMailbox;
+}//end flowControlTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Lane scheduler Test
+// Description: Queues messages of several priorities on a mailbox and checks
+//              the lane depths and the order they are dequeued in: strict
+//              priority then FIFO, with the priorities above the top lane
+//              sharing it, and then the lane weights per weighted fair round
+// Design:      Single threaded; everything is posted before the first dequeue
+//-----------------------------------------------------------------------------
+void laneSchedulerTest()
+{
+   MailboxAddress laneAddress;
+   laneAddress.locationType = LOCAL_MAILBOX;
+   laneAddress.mailboxName = "LaneSchedulerTest";
+   MailboxOwnerHandle* laneMailbox = LocalMailbox::createMailbox(laneAddress);
+   if ((laneMailbox == NULL) || (laneMailbox->activate() == ERROR))
+   {
+      printf("Lane scheduler test FAILED (unable to set up the mailbox)\n");
+      return;
+   }//end if
+
+   // Strict priority: 9, 7 and 12 share the top lane, so they keep their post order
+   const int strictCount = 8;
+   unsigned int strictPriorities[strictCount] = { 0, 3, 9, 3, 0, 7, 12, 5 };
+   int strictOrder[strictCount] = { 2, 5, 6, 7, 1, 3, 0, 4 };
+   int strictLaneDepths[LOCAL_MESSAGE_QUEUE_LANES] = { 2, 0, 0, 2, 0, 1, 0, 3 };
+   MessageBase* strictMessages[strictCount];
+   int errorCount = 0;
+   for (int index = 0; index < strictCount; index++)
+   {
+      strictMessages[index] = new MessageTest1Message(laneAddress);
+      strictMessages[index]->setPriority(strictPriorities[index]);
+      if (laneMailbox->post(strictMessages[index]) == ERROR)
+      {
+         delete strictMessages[index];
+         strictMessages[index] = NULL;
+         errorCount++;
+      }//end if
+   }//end for
+   for (unsigned int lane = 0; lane < LOCAL_MESSAGE_QUEUE_LANES; lane++)
+   {
+      if (laneMailbox->getQueueLaneDepth(lane) != strictLaneDepths[lane])
+      {
+         printf("Lane scheduler test FAILED (lane %u depth %d, expected %d)\n",
+            lane, laneMailbox->getQueueLaneDepth(lane), strictLaneDepths[lane]);
+         errorCount++;
+      }//end if
+   }//end for
+   for (int index = 0; index < strictCount; index++)
+   {
+      MessageBase* messagePtr = laneMailbox->getMessageNonBlocking();
+      if (messagePtr != strictMessages[strictOrder[index]])
+      {
+         printf("Lane scheduler test FAILED (strict dequeue %d out of order)\n", index);
+         errorCount++;
+      }//end if
+      if (messagePtr != NULL)
+      {
+         messagePtr->deleteMessage();
+      }//end if
+   }//end for
+
+   // Weighted fair: each round serves the top lane 3, lane 3 twice and lane 0
+   // once, whatever the post order
+   unsigned int laneWeights[LOCAL_MESSAGE_QUEUE_LANES] = { 1, 1, 1, 2, 1, 1, 1, 3 };
+   const int fairCount = 12;
+   unsigned int fairPriorities[fairCount] = { 0, 0, 3, 3, 3, 3, 7, 7, 7, 7, 7, 7 };
+   unsigned int fairLanes[fairCount] = { 7, 7, 7, 3, 3, 0, 7, 7, 7, 3, 3, 0 };
+   if (laneMailbox->setQueuePolicy(MAILBOX_WEIGHTED_FAIR, laneWeights) == ERROR)
+   {
+      errorCount++;
+   }//end if
+   for (int index = 0; index < fairCount; index++)
+   {
+      MessageBase* messagePtr = new MessageTest1Message(laneAddress);
+      messagePtr->setPriority(fairPriorities[index]);
+      if (laneMailbox->post(messagePtr) == ERROR)
+      {
+         delete messagePtr;
+         errorCount++;
+      }//end if
+   }//end for
+   for (int index = 0; index < fairCount; index++)
+   {
+      MessageBase* messagePtr = laneMailbox->getMessageNonBlocking();
+      if ((messagePtr == NULL) || (LocalMessageQueue::getLane(messagePtr->getPriority()) != fairLanes[index]))
+      {
+         printf("Lane scheduler test FAILED (weighted fair dequeue %d not from lane %u)\n",
+            index, fairLanes[index]);
+         errorCount++;
+      }//end if
+      if (messagePtr != NULL)
+      {
+         messagePtr->deleteMessage();
+      }//end if
+   }//end for
+
+   if (errorCount == 0)
+   {
+      printf("Lane scheduler test passed\n");
+   }//end if
+
+   laneMailbox->deactivate();
+   delete laneMailbox;
+}//end laneSchedulerTest
+
+
 //-----------------------------------------------------------------------------
 // Function Type: main function for test binary
 // Description:
@@ -384,9 +1157,20 @@ int main(int argc, char* argv[])
    //Logger::setSubsystemLogLevel(OPMLOG, DEVELOPERLOG);
    Logger::setSubsystemLogLevel(MSGMGRLOG, DEVELOPERLOG);
 
+   // Run every mailbox of this test on one reactor, so that the timer disposal
+   // test destroys a mailbox whose reactor another mailbox still uses
+   ReactorPool::setPoolSize(1);
+
    // Initialize the OPM
    OPM::initialize();
 
+   // Exercise the timer wheel, and the timers of a destroyed mailbox
+   timerWheelTest();
+   timerDisposalTest();
+   timerWheelDisposalTest();
+   flowControlTest();
+   laneSchedulerTest();
+
    MessageTest* messageTest = new MessageTest();
    if (!messageTest)
    {
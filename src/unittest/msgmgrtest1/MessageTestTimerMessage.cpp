@@ -30,6 +30,8 @@
 
 #define VERSION_NUMBER 1
 
+ACE_Atomic_Op<ACE_Thread_Mutex, unsigned int> MessageTestTimerMessage::deletedCount_ = 0;
+
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
 //-----------------------------------------------------------------------------
@@ -55,9 +57,21 @@ MessageTestTimerMessage::MessageTestTimerMessage(const MailboxAddress& sourceAdd
 //-----------------------------------------------------------------------------
 MessageTestTimerMessage::~MessageTestTimerMessage()
 {
+   deletedCount_++;
 }//end virtual destructor
 
 
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: Return the number of test timer messages deleted so far
+// Design:
+//-----------------------------------------------------------------------------
+unsigned int MessageTestTimerMessage::getDeletedCount()
+{
+   return deletedCount_.value();
+}//end getDeletedCount
+
+
 //-----------------------------------------------------------------------------
 // Method Type: INSTANCE
 // Description: Return the message Id
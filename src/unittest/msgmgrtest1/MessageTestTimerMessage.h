@@ -18,6 +18,9 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <ace/Atomic_Op.h>
+#include <ace/Thread_Mutex.h>
+
 //-----------------------------------------------------------------------------
 // Component includes, includes elements of our system.
 //-----------------------------------------------------------------------------
@@ -59,6 +62,12 @@ class MessageTestTimerMessage : public TimerMessage
       /** Virtual Destructor */
       virtual ~MessageTestTimerMessage();
 
+      /**
+       * Returns the number of test timer messages deleted so far, which the
+       * tests use to see how the MsgMgr disposed of them
+       */
+      static unsigned int getDeletedCount();
+
       /**
        * Returns the Message Id
        */
@@ -74,6 +83,9 @@ class MessageTestTimerMessage : public TimerMessage
 
    private:
 
+      /** Number of test timer messages deleted so far */
+      static ACE_Atomic_Op<ACE_Thread_Mutex, unsigned int> deletedCount_;
+
       /**
        * Copy Constructor declared private so that default automatic
        * methods aren't used.
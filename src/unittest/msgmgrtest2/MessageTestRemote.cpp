@@ -18,8 +18,14 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <unistd.h>
 #include <sys/resource.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/SOCK_Connector.h>
+#include <ace/SOCK_Stream.h>
 #include <ace/Thread_Manager.h>
 
 //-----------------------------------------------------------------------------
@@ -29,6 +35,7 @@
 #include "MessageTestRemote.h"
 #include "platform/msgmgr/DistributedMailbox.h"
 #include "platform/msgmgr/MailboxProcessor.h"
+#include "platform/msgmgr/MessageBuffer.h"
 #include "platform/msgmgr/MessageFactory.h"
 #include "platform/msgmgr/TimerMessage.h"
 
@@ -57,6 +64,16 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Test
 // Static singleton instance
 MessageTestRemote* MessageTestRemote::messageTestInstance_ = NULL;
 
+/* Port of the distributed mailbox that the framing tests send crafted bytes to */
+#define MESSAGE_FRAMING_TEST_PORT 7791
+
+/* Longest time (in msec) that the framing tests wait for a message or a close */
+#define MESSAGE_FRAMING_TEST_WAIT_MSEC 2000
+
+/* Time (in msec) that the framing tests leave between the pieces of a frame, and
+   wait to make sure that nothing is delivered */
+#define MESSAGE_FRAMING_TEST_PAUSE_MSEC 100
+
 //-----------------------------------------------------------------------------
 // PUBLIC methods.
 //-----------------------------------------------------------------------------
@@ -368,6 +385,246 @@ void messageRemoteSendingTest()
 }//end messageRemoteSendingTest
 
 
+//-----------------------------------------------------------------------------
+// Function Type: framing test helper
+// Description: Serialize a message behind its frame header, and return the
+//              frame length (header included)
+// Design:      The string form of the message is kept for comparing it with
+//              the message received, and the message is deleted
+//-----------------------------------------------------------------------------
+int messageFramingBuild(MessageBase* message, unsigned char* frameBytes, string& messageString)
+{
+   MessageBuffer messageBuffer(MAX_MESSAGE_LENGTH);
+   MessageFactory::serializeMessage(message, messageBuffer);
+   messageString = message->toString();
+   delete message;
+
+   unsigned int messageLength = messageBuffer.getBufferLength();
+   frameBytes[0] = (unsigned char)(messageLength >> 8);
+   frameBytes[1] = (unsigned char)(messageLength & 0xff);
+   memcpy(frameBytes + MSGMGR_FRAME_HEADER_LENGTH, messageBuffer.getBuffer(), messageLength);
+   return MSGMGR_FRAME_HEADER_LENGTH + messageLength;
+}//end messageFramingBuild
+
+
+//-----------------------------------------------------------------------------
+// Function Type: framing test helper
+// Description: Wait up to waitMsec for a message to be delivered to the mailbox
+// Design:
+//-----------------------------------------------------------------------------
+MessageBase* messageFramingReceive(MailboxOwnerHandle* mailbox, int waitMsec)
+{
+   MessageBase* message = mailbox->getMessageNonBlocking();
+   for (int msec = 0; (message == NULL) && (msec < waitMsec); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+      message = mailbox->getMessageNonBlocking();
+   }//end for
+   return message;
+}//end messageFramingReceive
+
+
+//-----------------------------------------------------------------------------
+// Function Type: framing test helper
+// Description: Check that each expected message is delivered, in order, and
+//              that nothing else follows it. Returns the number of errors.
+// Design:
+//-----------------------------------------------------------------------------
+int messageFramingExpect(MailboxOwnerHandle* mailbox, string* messageStrings, int messageCount)
+{
+   int errorCount = 0;
+   for (int index = 0; index < messageCount; index++)
+   {
+      MessageBase* message = messageFramingReceive(mailbox, MESSAGE_FRAMING_TEST_WAIT_MSEC);
+      if ((message == NULL) || (message->toString() != messageStrings[index]))
+      {
+         errorCount++;
+      }//end if
+      delete message;
+   }//end for
+
+   MessageBase* message = messageFramingReceive(mailbox, MESSAGE_FRAMING_TEST_PAUSE_MSEC);
+   if (message != NULL)
+   {
+      errorCount++;
+      delete message;
+   }//end if
+   return errorCount;
+}//end messageFramingExpect
+
+
+//-----------------------------------------------------------------------------
+// Function Type: framing test helper
+// Description: Check whether the mailbox closed a client connection
+// Design:      A timed out read fails with ETIME; a close reads end of file
+//              (or fails with a reset)
+//-----------------------------------------------------------------------------
+bool messageFramingIsClosed(ACE_SOCK_Stream& clientStream)
+{
+   unsigned char readByte = 0;
+   ACE_Time_Value readTimeout(0, MESSAGE_FRAMING_TEST_WAIT_MSEC * 1000);
+   ssize_t result = clientStream.recv(&readByte, 1, &readTimeout);
+   return ((result == 0) || ((result < 0) && (errno != ETIME)));
+}//end messageFramingIsClosed
+
+
+//-----------------------------------------------------------------------------
+// Function Type: framing test helper
+// Description: Open a client connection to the mailbox under test
+// Design:
+//-----------------------------------------------------------------------------
+bool messageFramingConnect(const MailboxAddress& framingAddress, ACE_SOCK_Stream& clientStream)
+{
+   ACE_SOCK_Connector connector;
+   ACE_Time_Value connectTimeout(0, MESSAGE_FRAMING_TEST_WAIT_MSEC * 1000);
+   return (connector.connect(clientStream, framingAddress.inetAddress, &connectTimeout) != ERROR);
+}//end messageFramingConnect
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Distributed Mailbox framing Test
+// Description: Sends crafted byte streams to a distributed mailbox: a frame
+//              split across reads, several frames in one read, a zero length
+//              frame, an oversize frame, and a partial frame followed by EOF
+// Design:      Invalid frame lengths lose the framing, so the mailbox must
+//              close the connection without delivering anything; a partial
+//              frame at EOF must be dropped, and the mailbox must still accept
+//              new connections afterwards
+//-----------------------------------------------------------------------------
+void messageFramingTest()
+{
+   MailboxAddress framingAddress;
+   framingAddress.locationType = DISTRIBUTED_MAILBOX;
+   framingAddress.mailboxName = "MessageFramingTest";
+   framingAddress.inetAddress.set(MESSAGE_FRAMING_TEST_PORT, "127.0.0.1");
+   framingAddress.neid = "100000001";
+   MailboxOwnerHandle* framingMailbox = DistributedMailbox::createMailbox(framingAddress);
+   if ((framingMailbox == NULL) || (framingMailbox->activate() == ERROR))
+   {
+      printf("\nFraming test FAILED (unable to set up the mailbox)\n");
+      return;
+   }//end if
+   printf("\n");
+
+   const int frameCount = 3;
+   unsigned char frameBytes[frameCount * (MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH)];
+   string messageStrings[frameCount];
+   ACE_Time_Value pauseTime(0, MESSAGE_FRAMING_TEST_PAUSE_MSEC * 1000);
+
+   // A frame split across reads, first within its header and then within its body
+   ACE_SOCK_Stream clientStream;
+   int errorCount = (messageFramingConnect(framingAddress, clientStream) ? 0 : 1);
+   int frameLength = messageFramingBuild(new MessageTestRemoteMessage(framingAddress, 1, "splitFrame"),
+      frameBytes, messageStrings[0]);
+   clientStream.send_n(frameBytes, 1);
+   ACE_OS::sleep(pauseTime);
+   clientStream.send_n(frameBytes + 1, MSGMGR_FRAME_HEADER_LENGTH + 2);
+   ACE_OS::sleep(pauseTime);
+   if (framingMailbox->getMessageNonBlocking() != NULL)
+   {
+      errorCount++;
+   }//end if
+   clientStream.send_n(frameBytes + MSGMGR_FRAME_HEADER_LENGTH + 3, frameLength - MSGMGR_FRAME_HEADER_LENGTH - 3);
+   errorCount += messageFramingExpect(framingMailbox, messageStrings, 1);
+   if (errorCount != 0)
+   {
+      printf("Framing split frame test FAILED (%d errors)\n", errorCount);
+   }//end if
+   else
+   {
+      printf("Framing split frame test passed\n");
+   }//end else
+
+   // Several frames in one read (on the same connection)
+   int bytesLength = 0;
+   for (int index = 0; index < frameCount; index++)
+   {
+      bytesLength += messageFramingBuild(new MessageTestRemoteMessage(framingAddress, index, "packedFrame"),
+         frameBytes + bytesLength, messageStrings[index]);
+   }//end for
+   clientStream.send_n(frameBytes, bytesLength);
+   errorCount = messageFramingExpect(framingMailbox, messageStrings, frameCount);
+   if (errorCount != 0)
+   {
+      printf("Framing several frames test FAILED (%d errors)\n", errorCount);
+   }//end if
+   else
+   {
+      printf("Framing several frames test passed\n");
+   }//end else
+   clientStream.close();
+
+   // A zero length frame, followed by a valid frame that must not be delivered
+   errorCount = (messageFramingConnect(framingAddress, clientStream) ? 0 : 1);
+   frameBytes[0] = 0;
+   frameBytes[1] = 0;
+   frameLength = messageFramingBuild(new MessageTestRemoteMessage(framingAddress, 1, "afterZeroFrame"),
+      frameBytes + MSGMGR_FRAME_HEADER_LENGTH, messageStrings[0]);
+   clientStream.send_n(frameBytes, MSGMGR_FRAME_HEADER_LENGTH + frameLength);
+   if (!messageFramingIsClosed(clientStream))
+   {
+      errorCount++;
+   }//end if
+   errorCount += messageFramingExpect(framingMailbox, messageStrings, 0);
+   if (errorCount != 0)
+   {
+      printf("Framing zero length frame test FAILED (%d errors)\n", errorCount);
+   }//end if
+   else
+   {
+      printf("Framing zero length frame test passed\n");
+   }//end else
+   clientStream.close();
+
+   // An oversize frame
+   errorCount = (messageFramingConnect(framingAddress, clientStream) ? 0 : 1);
+   memset(frameBytes, 0, MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH + 1);
+   frameBytes[0] = (unsigned char)((MAX_MESSAGE_LENGTH + 1) >> 8);
+   frameBytes[1] = (unsigned char)((MAX_MESSAGE_LENGTH + 1) & 0xff);
+   clientStream.send_n(frameBytes, MSGMGR_FRAME_HEADER_LENGTH + MAX_MESSAGE_LENGTH + 1);
+   if (!messageFramingIsClosed(clientStream))
+   {
+      errorCount++;
+   }//end if
+   errorCount += messageFramingExpect(framingMailbox, messageStrings, 0);
+   if (errorCount != 0)
+   {
+      printf("Framing oversize frame test FAILED (%d errors)\n", errorCount);
+   }//end if
+   else
+   {
+      printf("Framing oversize frame test passed\n");
+   }//end else
+   clientStream.close();
+
+   // A partial frame followed by EOF is dropped, and a new connection still works
+   errorCount = (messageFramingConnect(framingAddress, clientStream) ? 0 : 1);
+   frameLength = messageFramingBuild(new MessageTestRemoteMessage(framingAddress, 1, "partialFrame"),
+      frameBytes, messageStrings[0]);
+   clientStream.send_n(frameBytes, frameLength / 2);
+   ACE_OS::sleep(pauseTime);
+   clientStream.close();
+   errorCount += messageFramingExpect(framingMailbox, messageStrings, 0);
+   errorCount += (messageFramingConnect(framingAddress, clientStream) ? 0 : 1);
+   frameLength = messageFramingBuild(new MessageTestRemoteMessage(framingAddress, 2, "afterPartialFrame"),
+      frameBytes, messageStrings[0]);
+   clientStream.send_n(frameBytes, frameLength);
+   errorCount += messageFramingExpect(framingMailbox, messageStrings, 1);
+   if (errorCount != 0)
+   {
+      printf("Framing partial frame at EOF test FAILED (%d errors)\n", errorCount);
+   }//end if
+   else
+   {
+      printf("Framing partial frame at EOF test passed\n");
+   }//end else
+   clientStream.close();
+
+   framingMailbox->deactivate();
+   delete framingMailbox;
+}//end messageFramingTest
+
+
 //-----------------------------------------------------------------------------
 // Function Type: main function for test binary
 // Description:
@@ -403,6 +660,10 @@ int main(int argc, char* argv[])
       return ERROR;
    }//end if
 
+   // Check the framing of the distributed mailbox byte stream (the test messages
+   // are registered with the MessageFactory by now)
+   messageFramingTest();
+
    // Spawn a test thread that 1.) sleeps some time to allow the mailbox processing loop
    // called next to get fully initialized, and 2.) starts sending some messages to the
    // local mailbox.
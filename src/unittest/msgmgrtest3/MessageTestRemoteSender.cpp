@@ -18,8 +18,15 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <csignal>
+#include <cstdio>
+#include <vector>
 #include <unistd.h>
 #include <sys/resource.h>
+#include <ace/INET_Addr.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/SOCK_Acceptor.h>
+#include <ace/SOCK_Stream.h>
 #include <ace/Thread_Manager.h>
 
 //-----------------------------------------------------------------------------
@@ -29,6 +36,8 @@
 #include "platform/msgmgr/MailboxLookupService.h"
 #include "platform/msgmgr/DistributedMailboxProxy.h"
 #include "platform/msgmgr/MailboxHandle.h"
+#include "platform/msgmgr/MessageBuffer.h"
+#include "platform/msgmgr/MessageFactory.h"
 
 #include "MessageTestRemoteMessage.h"
 
@@ -50,6 +59,928 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)MsgMgr Test
    "\n   Build Label: " XstrConvert(BUILD_LABEL)
    "\n   Compile Time: " __DATE__ " " __TIME__;
 
+/* Ports of the raw socket peers that the proxy tests connect to (one per test,
+   since the lookup service keeps a proxy for each address) */
+#define MESSAGE_PEER_BATCH_PORT 7790
+#define MESSAGE_PEER_REPLAY_PORT 7792
+#define MESSAGE_PEER_REWIND_PORT 7793
+#define MESSAGE_PEER_TIMEOUT_PORT 7794
+#define MESSAGE_PEER_QUEUE_LIMIT_PORT 7795
+#define MESSAGE_PEER_DEACTIVATE_PORT 7796
+
+/* Longest time (in seconds) that the proxy tests wait for the peer or the proxy */
+#define MESSAGE_PEER_WAIT_SEC 5
+
+/* Length of the string value making a test message a third of MAX_MESSAGE_LENGTH */
+#define MESSAGE_TEST_LONG_STRING_LENGTH 250
+
+/* Socket buffer size that lets the proxy tests stall the proxy output with a few
+   hundred of the long test messages */
+#define MESSAGE_PEER_SOCKET_BUFFER_SIZE 4096
+
+/* Number of long test messages posted to stall the proxy output */
+#define MESSAGE_PEER_STALL_COUNT 400
+
+/* Delivery failures reported to messageDeliveryFailureRecord */
+static volatile unsigned int messageDeliveryFailureCalls = 0;
+static volatile unsigned int messageDeliveryFailureCount = 0;
+static volatile int messageDeliveryFailurePort = 0;
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Set the distributed address of a raw socket peer
+// Design:
+//-----------------------------------------------------------------------------
+void messagePeerAddress(MailboxAddress& peerAddress, const char* mailboxName, int port)
+{
+   peerAddress.locationType = DISTRIBUTED_MAILBOX;
+   peerAddress.mailboxName = mailboxName;
+   peerAddress.inetAddress.set(port, "127.0.0.1");
+   peerAddress.neid = "100000001";
+}//end messagePeerAddress
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Open the listening socket of a raw socket peer
+// Design:      A receive buffer size set on the listening socket is inherited
+//              by the connections it accepts
+//-----------------------------------------------------------------------------
+int messagePeerListen(ACE_SOCK_Acceptor& peerAcceptor, MailboxAddress& peerAddress, int receiveBufferSize)
+{
+   if (peerAcceptor.open(peerAddress.inetAddress, 1) == ERROR)
+   {
+      printf("Unable to listen on port %d\n", peerAddress.inetAddress.get_port_number());
+      return ERROR;
+   }//end if
+   if ((receiveBufferSize > 0) &&
+       (peerAcceptor.set_option(SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize)) == ERROR))
+   {
+      printf("Unable to set the receive buffer size on port %d\n", peerAddress.inetAddress.get_port_number());
+      return ERROR;
+   }//end if
+   return OK;
+}//end messagePeerListen
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Find the proxy for a distributed address served by a raw socket
+//              peer, and accept its connection on the peer
+// Design:      The proxy connects from the engine thread, so this waits until
+//              it reports the connection up (its posts are then sent at once)
+//-----------------------------------------------------------------------------
+MailboxHandle* messagePeerConnect(ACE_SOCK_Acceptor& peerAcceptor, ACE_SOCK_Stream& peerStream,
+   MailboxAddress& peerAddress, const char* mailboxName, int port, int receiveBufferSize = 0)
+{
+   messagePeerAddress(peerAddress, mailboxName, port);
+   if (messagePeerListen(peerAcceptor, peerAddress, receiveBufferSize) == ERROR)
+   {
+      return NULL;
+   }//end if
+
+   MailboxHandle* proxyHandle = MailboxLookupService::find(peerAddress);
+   ACE_Time_Value acceptTimeout(MESSAGE_PEER_WAIT_SEC);
+   if ((proxyHandle == NULL) || (peerAcceptor.accept(peerStream, NULL, &acceptTimeout) == ERROR))
+   {
+      printf("Proxy to port %d did not connect\n", port);
+      delete proxyHandle;
+      return NULL;
+   }//end if
+
+   for (int msec = 0; (proxyHandle->getConnectionState() != MAILBOX_CONNECTED) &&
+        (msec < (MESSAGE_PEER_WAIT_SEC * 1000)); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   return proxyHandle;
+}//end messagePeerConnect
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Read one frame sent by a proxy to the raw socket peer
+// Design:      Returns the frame length, or ERROR on timeout or a closed
+//              connection. The frame is left in frameBytes.
+//-----------------------------------------------------------------------------
+int messagePeerReadFrame(ACE_SOCK_Stream& peerStream, unsigned char* frameBytes)
+{
+   unsigned char frameHeader[MSGMGR_FRAME_HEADER_LENGTH];
+   ACE_Time_Value readTimeout(MESSAGE_PEER_WAIT_SEC);
+   if (peerStream.recv_n(frameHeader, MSGMGR_FRAME_HEADER_LENGTH, &readTimeout) != MSGMGR_FRAME_HEADER_LENGTH)
+   {
+      return ERROR;
+   }//end if
+   int frameLength = (frameHeader[0] << 8) | frameHeader[1];
+   if ((frameLength == 0) || (frameLength > MAX_MESSAGE_LENGTH) ||
+       (peerStream.recv_n(frameBytes, frameLength, &readTimeout) != frameLength))
+   {
+      return ERROR;
+   }//end if
+   return frameLength;
+}//end messagePeerReadFrame
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Recreate the messages of a frame read by the raw socket peer
+// Design:      Returns the Message Id found at the front of the frame (the
+//              batch Id for a batch)
+//-----------------------------------------------------------------------------
+unsigned short messagePeerDecodeFrame(unsigned char* frameBytes, int frameLength, MessageBase** messages,
+   int& messageCount)
+{
+   MessageBuffer frameBuffer((unsigned char*)NULL, 0);
+   frameBuffer.assignSharedBuffer(frameBytes, frameLength);
+   frameBuffer.setInsertPosition(frameLength);
+   messageCount = MessageFactory::recreateMessagesFromBuffer(frameBuffer, messages, MSGMGR_MAX_BATCH_MESSAGES);
+   return (unsigned short)((frameBytes[0] << 8) | frameBytes[1]);
+}//end messagePeerDecodeFrame
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Return the index of the expected message that a single message
+//              frame carries, or ERROR
+// Design:      The recreated message is deleted
+//-----------------------------------------------------------------------------
+int messagePeerSequence(unsigned char* frameBytes, int frameLength, string* expectedStrings, int expectedCount)
+{
+   MessageBase* recreated[MSGMGR_MAX_BATCH_MESSAGES];
+   int recreatedCount = 0;
+   messagePeerDecodeFrame(frameBytes, frameLength, recreated, recreatedCount);
+   int sequence = ERROR;
+   for (int index = 0; index < recreatedCount; index++)
+   {
+      if (recreatedCount == 1)
+      {
+         string recreatedString = recreated[index]->toString();
+         for (int expected = 0; (expected < expectedCount) && (sequence == ERROR); expected++)
+         {
+            if (recreatedString == expectedStrings[expected])
+            {
+               sequence = expected;
+            }//end if
+         }//end for
+      }//end if
+      delete recreated[index];
+   }//end for
+   return sequence;
+}//end messagePeerSequence
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Read frames from the raw socket peer, expecting the messages
+//              of the given sequences in order. Returns the number of errors.
+// Design:
+//-----------------------------------------------------------------------------
+int messagePeerExpectSequences(ACE_SOCK_Stream& peerStream, string* expectedStrings, int expectedCount,
+   int firstSequence, int lastSequence)
+{
+   unsigned char frameBytes[MAX_MESSAGE_LENGTH];
+   for (int sequence = firstSequence; sequence <= lastSequence; sequence++)
+   {
+      int frameLength = messagePeerReadFrame(peerStream, frameBytes);
+      if (frameLength == ERROR)
+      {
+         printf("Missing the frame of message %d\n", sequence);
+         return (lastSequence - sequence + 1);
+      }//end if
+      int receivedSequence = messagePeerSequence(frameBytes, frameLength, expectedStrings, expectedCount);
+      if (receivedSequence != sequence)
+      {
+         printf("Received message %d where message %d was expected\n", receivedSequence, sequence);
+         return 1;
+      }//end if
+   }//end for
+   return 0;
+}//end messagePeerExpectSequences
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Drop the connection of the raw socket peer with a reset
+// Design:      Lingering for 0 seconds makes the close reset the connection,
+//              so the proxy fails its next write rather than sending it into
+//              a half closed connection
+//-----------------------------------------------------------------------------
+void messagePeerAbort(ACE_SOCK_Stream& peerStream)
+{
+   linger lingerOption;
+   lingerOption.l_onoff = 1;
+   lingerOption.l_linger = 0;
+   peerStream.set_option(SOL_SOCKET, SO_LINGER, &lingerOption, sizeof(lingerOption));
+   peerStream.close();
+}//end messagePeerAbort
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Create long test messages numbered by their integer value,
+//              keeping their strings to recognize them when they come back
+// Design:
+//-----------------------------------------------------------------------------
+void messagePeerCreateSequence(MailboxAddress& sourceAddress, MessageBase** messages, string* expectedStrings,
+   int messageCount)
+{
+   string longValue(MESSAGE_TEST_LONG_STRING_LENGTH, 'x');
+   for (int index = 0; index < messageCount; index++)
+   {
+      messages[index] = new MessageTestRemoteMessage(sourceAddress, index, longValue);
+      expectedStrings[index] = messages[index]->toString();
+   }//end for
+}//end messagePeerCreateSequence
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Post messages to a proxy, returning the number of them posted
+// Design:      The messages not posted are deleted here
+//-----------------------------------------------------------------------------
+int messagePeerPostSequence(MailboxHandle* proxyHandle, MessageBase** messages, int firstSequence,
+   int lastSequence)
+{
+   int postedCount = 0;
+   for (int sequence = firstSequence; sequence <= lastSequence; sequence++)
+   {
+      if (proxyHandle->post(messages[sequence]) == OK)
+      {
+         postedCount++;
+      }//end if
+      else
+      {
+         delete messages[sequence];
+      }//end else
+   }//end for
+   return postedCount;
+}//end messagePeerPostSequence
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Delivery failure handler of the proxy tests
+// Design:      Called on the proxy engine thread (or in deactivate)
+//-----------------------------------------------------------------------------
+void messageDeliveryFailureRecord(const MailboxAddress& remoteAddress, unsigned int droppedCount)
+{
+   messageDeliveryFailurePort = remoteAddress.inetAddress.get_port_number();
+   messageDeliveryFailureCount += droppedCount;
+   messageDeliveryFailureCalls++;
+}//end messageDeliveryFailureRecord
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Clear the recorded delivery failures and set the options of
+//              the proxy tests for a raw socket peer address
+// Design:      Options are read when the proxy is created, so this comes
+//              before the find
+//-----------------------------------------------------------------------------
+void messagePeerOptions(MailboxAddress& peerAddress, unsigned int sendBufferSize, unsigned int maxQueuedBytes,
+   unsigned int deliveryTimeoutMsec)
+{
+   messageDeliveryFailureCalls = 0;
+   messageDeliveryFailureCount = 0;
+   messageDeliveryFailurePort = 0;
+
+   DistributedConnectionOptions options;
+   DistributedMailboxProxy::getConnectionOptions(peerAddress, options);
+   options.sendBufferSize = sendBufferSize;
+   options.coalesceBytes = 4096;
+   options.coalesceDelayUsec = 1000;
+   options.maxQueuedBytes = maxQueuedBytes;
+   options.deliveryTimeoutMsec = deliveryTimeoutMsec;
+   options.deliveryFailureHandler = makeFunctor((DeliveryFailureHandler*)0, messageDeliveryFailureRecord);
+   DistributedMailboxProxy::setConnectionOptions(peerAddress, options);
+}//end messagePeerOptions
+
+
+//-----------------------------------------------------------------------------
+// Function Type: proxy test helper
+// Description: Wait for the delivery failure handler to be called the given
+//              number of times
+// Design:
+//-----------------------------------------------------------------------------
+bool messageDeliveryFailureWait(unsigned int expectedCalls)
+{
+   for (int msec = 0; (messageDeliveryFailureCalls < expectedCalls) && (msec < (MESSAGE_PEER_WAIT_SEC * 1000)); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   return (messageDeliveryFailureCalls == expectedCalls);
+}//end messageDeliveryFailureWait
+
+
+//-----------------------------------------------------------------------------
+// Function Type: batch test helper
+// Description: Compare recreated messages against the originals (contents and
+//              priority level), deleting the recreated ones
+// Design:
+//-----------------------------------------------------------------------------
+int messageBatchCompare(MessageBase** recreated, int recreatedCount, string* expectedStrings,
+   unsigned int* expectedPriorities, int expectedCount)
+{
+   int errorCount = ((recreatedCount == expectedCount) ? 0 : 1);
+   for (int index = 0; index < recreatedCount; index++)
+   {
+      if ((index < expectedCount) && ((recreated[index]->toString() != expectedStrings[index]) ||
+          (recreated[index]->getPriority() != expectedPriorities[index])))
+      {
+         errorCount++;
+      }//end if
+      delete recreated[index];
+   }//end for
+   return errorCount;
+}//end messageBatchCompare
+
+
+//-----------------------------------------------------------------------------
+// Function Type: batch test helper
+// Description: Append a message to a batch being built by hand, behind the
+//              length that the batch declares for it
+// Design:
+//-----------------------------------------------------------------------------
+void messageBatchAppend(MessageBuffer& batchBuffer, MessageBuffer& messageBuffer, unsigned short declaredLength)
+{
+   batchBuffer << declaredLength;
+   batchBuffer.appendBytes(messageBuffer.getBuffer(), messageBuffer.getBufferLength());
+}//end messageBatchAppend
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Batch envelope round trip Test
+// Description: Serializes batches and recreates their messages in process:
+//              a batch mixing priority and non-priority messages, a batch
+//              with a message of an unregistered Message Id in the middle, and
+//              a batch with a message that overruns its declared length
+// Design:      An unregistered message is skipped using its declared length;
+//              an overrun loses the position of the next message, so the rest
+//              of the batch is dropped
+//-----------------------------------------------------------------------------
+void messageBatchRoundTripTest(MailboxAddress& sourceAddress)
+{
+   const int batchCount = 4;
+   unsigned int priorities[batchCount] = { 0, 3, 0, 9 };
+   MessageBase* originals[batchCount];
+   string expectedStrings[batchCount];
+   for (int index = 0; index < batchCount; index++)
+   {
+      originals[index] = new MessageTestRemoteMessage(sourceAddress, index, "batchValue");
+      originals[index]->setPriority(priorities[index]);
+      expectedStrings[index] = originals[index]->toString();
+   }//end for
+
+   // Mixed priority batch
+   MessageBuffer batchBuffer(MAX_MESSAGE_LENGTH);
+   MessageBuffer scratchBuffer(MAX_MESSAGE_LENGTH);
+   MessageBase* recreated[MSGMGR_MAX_BATCH_MESSAGES];
+   int batchedCount = MessageFactory::serializeBatch(originals, batchCount, batchBuffer, scratchBuffer);
+   int recreatedCount = MessageFactory::recreateMessagesFromBuffer(batchBuffer, recreated, MSGMGR_MAX_BATCH_MESSAGES);
+   int errorCount = messageBatchCompare(recreated, recreatedCount, expectedStrings, priorities, batchCount);
+   if ((batchedCount != batchCount) || (errorCount != 0))
+   {
+      printf("\nBatch mixed priority test FAILED (%d batched, %d recreated, %d errors)\n", batchedCount,
+         recreatedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("\nBatch mixed priority test passed\n");
+   }//end else
+
+   // Serialize messages 0, 1 and 2 on their own for the batches built by hand
+   MessageBuffer messageBuffer0(MAX_MESSAGE_LENGTH);
+   MessageBuffer messageBuffer1(MAX_MESSAGE_LENGTH);
+   MessageBuffer messageBuffer2(MAX_MESSAGE_LENGTH);
+   MessageBuffer* messageBuffers[3] = { &messageBuffer0, &messageBuffer1, &messageBuffer2 };
+   for (int index = 0; index < 3; index++)
+   {
+      MessageFactory::serializeMessage(originals[index], *messageBuffers[index]);
+   }//end for
+
+   // Unregistered Message Id between messages 0 and 2
+   MessageBuffer unknownBuffer(MAX_MESSAGE_LENGTH);
+   unknownBuffer << (unsigned short)MSGMGR_TEST1_MSG_ID;
+   unknownBuffer << (int)1234;
+   unsigned int rejectedCount = MessageFactory::getRejectedCount(MSGMGR_TEST1_MSG_ID);
+   MessageBuffer unknownBatch(MAX_MESSAGE_LENGTH);
+   unknownBatch << (unsigned short)MSGMGR_BATCH_MSG_ID;
+   messageBatchAppend(unknownBatch, *messageBuffers[0], messageBuffers[0]->getBufferLength());
+   messageBatchAppend(unknownBatch, unknownBuffer, unknownBuffer.getBufferLength());
+   messageBatchAppend(unknownBatch, *messageBuffers[2], messageBuffers[2]->getBufferLength());
+   recreatedCount = MessageFactory::recreateMessagesFromBuffer(unknownBatch, recreated, MSGMGR_MAX_BATCH_MESSAGES);
+   string unknownStrings[2] = { expectedStrings[0], expectedStrings[2] };
+   unsigned int unknownPriorities[2] = { priorities[0], priorities[2] };
+   errorCount = messageBatchCompare(recreated, recreatedCount, unknownStrings, unknownPriorities, 2);
+   if ((errorCount != 0) || (MessageFactory::getRejectedCount(MSGMGR_TEST1_MSG_ID) != (rejectedCount + 1)))
+   {
+      printf("Batch unregistered Message Id test FAILED (%d recreated, %d errors)\n", recreatedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("Batch unregistered Message Id test passed\n");
+   }//end else
+
+   // Message 1 declares a length shorter than its contents
+   MessageBuffer overrunBatch(MAX_MESSAGE_LENGTH);
+   overrunBatch << (unsigned short)MSGMGR_BATCH_MSG_ID;
+   messageBatchAppend(overrunBatch, *messageBuffers[0], messageBuffers[0]->getBufferLength());
+   messageBatchAppend(overrunBatch, *messageBuffers[1], messageBuffers[1]->getBufferLength() - 8);
+   messageBatchAppend(overrunBatch, *messageBuffers[2], messageBuffers[2]->getBufferLength());
+   recreatedCount = MessageFactory::recreateMessagesFromBuffer(overrunBatch, recreated, MSGMGR_MAX_BATCH_MESSAGES);
+   errorCount = messageBatchCompare(recreated, recreatedCount, expectedStrings, priorities, 1);
+   if (errorCount != 0)
+   {
+      printf("Batch length overrun test FAILED (%d recreated, %d errors)\n", recreatedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("Batch length overrun test passed\n");
+   }//end else
+
+   for (int index = 0; index < batchCount; index++)
+   {
+      delete originals[index];
+   }//end for
+}//end messageBatchRoundTripTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Batch post Test
+// Description: Checks the frames that DistributedMailboxProxy::postBatch sends
+//              to a raw socket peer: a lone message goes out in the regular
+//              (single message) format, several messages go out as a batch,
+//              and a message left over once a batch is full goes out alone in
+//              the regular format again
+// Design:      Three of the long test messages fill a batch. The proxy deletes
+//              the messages it sends.
+//-----------------------------------------------------------------------------
+void messageBatchPostTest(MailboxAddress& sourceAddress)
+{
+   ACE_SOCK_Acceptor peerAcceptor;
+   ACE_SOCK_Stream peerStream;
+   MailboxAddress peerAddress;
+   MailboxHandle* proxyHandle = messagePeerConnect(peerAcceptor, peerStream, peerAddress,
+      "MessageTestBatchPeer", MESSAGE_PEER_BATCH_PORT);
+   if (proxyHandle == NULL)
+   {
+      printf("Batch post test FAILED (no connection)\n");
+      peerAcceptor.close();
+      return;
+   }//end if
+
+   const int postCount = 5;
+   string longValue(MESSAGE_TEST_LONG_STRING_LENGTH, 'x');
+   MessageBase* messages[postCount];
+   string expectedStrings[postCount];
+   unsigned int priorities[postCount];
+   for (int index = 0; index < postCount; index++)
+   {
+      messages[index] = new MessageTestRemoteMessage(sourceAddress, index, longValue);
+      expectedStrings[index] = messages[index]->toString();
+      priorities[index] = 0;
+   }//end for
+
+   // A lone message, then a batch that overflows into a lone message
+   int errorCount = 0;
+   int postedCount = proxyHandle->postBatch(messages, 1);
+   postedCount += proxyHandle->postBatch(&messages[1], postCount - 1);
+   unsigned short expectedIds[3] = { MSGMGR_TEST_DISTRIBUTED_MSG_ID, MSGMGR_BATCH_MSG_ID,
+                                     MSGMGR_TEST_DISTRIBUTED_MSG_ID };
+   int expectedCounts[3] = { 1, 3, 1 };
+   int firstIndex = 0;
+   unsigned char frameBytes[MAX_MESSAGE_LENGTH];
+   for (int frame = 0; frame < 3; frame++)
+   {
+      int frameLength = messagePeerReadFrame(peerStream, frameBytes);
+      if (frameLength == ERROR)
+      {
+         errorCount++;
+         break;
+      }//end if
+      MessageBase* recreated[MSGMGR_MAX_BATCH_MESSAGES];
+      int recreatedCount = 0;
+      unsigned short frameId = messagePeerDecodeFrame(frameBytes, frameLength, recreated, recreatedCount);
+      errorCount += messageBatchCompare(recreated, recreatedCount, &expectedStrings[firstIndex],
+         &priorities[firstIndex], expectedCounts[frame]);
+      if (frameId != expectedIds[frame])
+      {
+         errorCount++;
+      }//end if
+      firstIndex += expectedCounts[frame];
+   }//end for
+
+   if ((postedCount != postCount) || (errorCount != 0))
+   {
+      printf("Batch post test FAILED (%d posted, %d errors)\n", postedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("Batch post test passed\n");
+   }//end else
+
+   delete proxyHandle;
+   peerStream.close();
+   peerAcceptor.close();
+}//end messageBatchPostTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Proxy replay Test
+// Description: Checks that the messages posted to a proxy whose connection
+//              was lost are replayed on its next connection, none duplicated
+//              and none lost
+// Design:      The peer reads everything sent on the first connection before
+//              resetting it, so no frame is in flight when the proxy writes
+//              into the reset connection. A last message posted once the
+//              replay is read shows that nothing was sent twice.
+//-----------------------------------------------------------------------------
+void messageProxyReplayTest(MailboxAddress& sourceAddress)
+{
+   const int firstCount = 10;
+   const int postCount = 20;
+   ACE_SOCK_Acceptor peerAcceptor;
+   ACE_SOCK_Stream peerStream;
+   MailboxAddress peerAddress;
+   messagePeerAddress(peerAddress, "MessageTestReplayPeer", MESSAGE_PEER_REPLAY_PORT);
+   messagePeerOptions(peerAddress, 0, DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES, DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC);
+   MailboxHandle* proxyHandle = messagePeerConnect(peerAcceptor, peerStream, peerAddress,
+      "MessageTestReplayPeer", MESSAGE_PEER_REPLAY_PORT);
+   if (proxyHandle == NULL)
+   {
+      printf("Proxy replay test FAILED (no connection)\n");
+      peerAcceptor.close();
+      return;
+   }//end if
+
+   MessageBase* messages[postCount + 1];
+   string expectedStrings[postCount + 1];
+   messagePeerCreateSequence(sourceAddress, messages, expectedStrings, postCount + 1);
+
+   // Deliver the first messages, then reset the connection and post the rest
+   int postedCount = messagePeerPostSequence(proxyHandle, messages, 0, firstCount - 1);
+   int errorCount = messagePeerExpectSequences(peerStream, expectedStrings, postCount + 1, 0, firstCount - 1);
+   messagePeerAbort(peerStream);
+   ACE_OS::sleep(ACE_Time_Value(0, 100000));
+   postedCount += messagePeerPostSequence(proxyHandle, messages, firstCount, postCount - 1);
+
+   ACE_Time_Value acceptTimeout(MESSAGE_PEER_WAIT_SEC);
+   if (peerAcceptor.accept(peerStream, NULL, &acceptTimeout) == ERROR)
+   {
+      printf("Proxy replay test FAILED (no reconnect)\n");
+      delete messages[postCount];
+      delete proxyHandle;
+      peerAcceptor.close();
+      return;
+   }//end if
+   errorCount += messagePeerExpectSequences(peerStream, expectedStrings, postCount + 1, firstCount, postCount - 1);
+   postedCount += messagePeerPostSequence(proxyHandle, messages, postCount, postCount);
+   errorCount += messagePeerExpectSequences(peerStream, expectedStrings, postCount + 1, postCount, postCount);
+
+   if ((postedCount != (postCount + 1)) || (errorCount != 0))
+   {
+      printf("Proxy replay test FAILED (%d posted, %d errors)\n", postedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("Proxy replay test passed\n");
+   }//end else
+
+   delete proxyHandle;
+   peerStream.close();
+   peerAcceptor.close();
+}//end messageProxyReplayTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Proxy partial write Test
+// Description: Checks that a proxy whose output stalled in the middle of a
+//              frame sends that frame again whole on its next connection, and
+//              the rest of its queue after it
+// Design:      With small socket buffers and a peer that does not read, the
+//              write that fills the socket almost never ends on a frame
+//              boundary. The frames written completely to the reset connection
+//              are taken as delivered (and are lost with it), so the replay
+//              may start anywhere; it has to start on a frame boundary and run
+//              on to the last message without a gap or a duplicate.
+//-----------------------------------------------------------------------------
+void messageProxyRewindTest(MailboxAddress& sourceAddress)
+{
+   const int postCount = MESSAGE_PEER_STALL_COUNT;
+   ACE_SOCK_Acceptor peerAcceptor;
+   ACE_SOCK_Stream peerStream;
+   MailboxAddress peerAddress;
+   messagePeerAddress(peerAddress, "MessageTestRewindPeer", MESSAGE_PEER_REWIND_PORT);
+   messagePeerOptions(peerAddress, MESSAGE_PEER_SOCKET_BUFFER_SIZE, DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES,
+      DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC);
+   MailboxHandle* proxyHandle = messagePeerConnect(peerAcceptor, peerStream, peerAddress,
+      "MessageTestRewindPeer", MESSAGE_PEER_REWIND_PORT, MESSAGE_PEER_SOCKET_BUFFER_SIZE);
+   if (proxyHandle == NULL)
+   {
+      printf("Proxy partial write test FAILED (no connection)\n");
+      peerAcceptor.close();
+      return;
+   }//end if
+
+   MessageBase* messages[postCount + 1];
+   string expectedStrings[postCount + 1];
+   messagePeerCreateSequence(sourceAddress, messages, expectedStrings, postCount + 1);
+
+   // Stall the output, then reset the connection without reading it
+   int postedCount = messagePeerPostSequence(proxyHandle, messages, 0, postCount - 1);
+   ACE_OS::sleep(ACE_Time_Value(0, 200000));
+   messagePeerAbort(peerStream);
+
+   int errorCount = 0;
+   int firstSequence = ERROR;
+   unsigned char frameBytes[MAX_MESSAGE_LENGTH];
+   ACE_Time_Value acceptTimeout(MESSAGE_PEER_WAIT_SEC);
+   if (peerAcceptor.accept(peerStream, NULL, &acceptTimeout) == ERROR)
+   {
+      printf("Proxy partial write test FAILED (no reconnect)\n");
+      delete messages[postCount];
+      delete proxyHandle;
+      peerAcceptor.close();
+      return;
+   }//end if
+   int frameLength = messagePeerReadFrame(peerStream, frameBytes);
+   if (frameLength != ERROR)
+   {
+      firstSequence = messagePeerSequence(frameBytes, frameLength, expectedStrings, postCount + 1);
+   }//end if
+   if (firstSequence == ERROR)
+   {
+      errorCount++;
+   }//end if
+   else
+   {
+      errorCount += messagePeerExpectSequences(peerStream, expectedStrings, postCount + 1, firstSequence + 1,
+         postCount - 1);
+      postedCount += messagePeerPostSequence(proxyHandle, messages, postCount, postCount);
+      errorCount += messagePeerExpectSequences(peerStream, expectedStrings, postCount + 1, postCount, postCount);
+   }//end else
+
+   if ((errorCount != 0) || (firstSequence == 0))
+   {
+      printf("Proxy partial write test FAILED (replay from %d, %d errors)\n", firstSequence, errorCount);
+   }//end if
+   else
+   {
+      printf("Proxy partial write test passed (replay from message %d of %d)\n", firstSequence, postedCount);
+   }//end else
+
+   if (firstSequence == ERROR)
+   {
+      delete messages[postCount];
+   }//end if
+   delete proxyHandle;
+   peerStream.close();
+   peerAcceptor.close();
+}//end messageProxyRewindTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Proxy delivery timeout Test
+// Description: Checks that a proxy unable to connect for deliveryTimeoutMsec
+//              drops its queue and reports the number of messages dropped to
+//              the delivery failure handler, and that a post made after the
+//              drop starts the connect attempts over
+// Design:      Nothing listens on the peer port
+//-----------------------------------------------------------------------------
+void messageProxyDeliveryTimeoutTest(MailboxAddress& sourceAddress)
+{
+   const int firstCount = 5;
+   const int postCount = 7;
+   MailboxAddress peerAddress;
+   messagePeerAddress(peerAddress, "MessageTestTimeoutPeer", MESSAGE_PEER_TIMEOUT_PORT);
+   messagePeerOptions(peerAddress, 0, DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES, 200);
+   MailboxHandle* proxyHandle = MailboxLookupService::find(peerAddress);
+   if (proxyHandle == NULL)
+   {
+      printf("Proxy delivery timeout test FAILED (no proxy)\n");
+      return;
+   }//end if
+
+   MessageBase* messages[postCount];
+   string expectedStrings[postCount];
+   messagePeerCreateSequence(sourceAddress, messages, expectedStrings, postCount);
+
+   int errorCount = 0;
+   int postedCount = messagePeerPostSequence(proxyHandle, messages, 0, firstCount - 1);
+   if (!messageDeliveryFailureWait(1) || (messageDeliveryFailureCount != (unsigned int)firstCount))
+   {
+      printf("First queue dropped %d messages in %d calls\n", messageDeliveryFailureCount, messageDeliveryFailureCalls);
+      errorCount++;
+   }//end if
+   postedCount += messagePeerPostSequence(proxyHandle, messages, firstCount, postCount - 1);
+   if (!messageDeliveryFailureWait(2) || (messageDeliveryFailureCount != (unsigned int)postCount))
+   {
+      printf("Second queue dropped %d messages in %d calls\n", messageDeliveryFailureCount - firstCount,
+         messageDeliveryFailureCalls);
+      errorCount++;
+   }//end if
+
+   if ((postedCount != postCount) || (messageDeliveryFailurePort != MESSAGE_PEER_TIMEOUT_PORT) || (errorCount != 0))
+   {
+      printf("Proxy delivery timeout test FAILED (%d posted, %d errors)\n", postedCount, errorCount);
+   }//end if
+   else
+   {
+      printf("Proxy delivery timeout test passed\n");
+   }//end else
+
+   delete proxyHandle;
+}//end messageProxyDeliveryTimeoutTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Proxy queue limit Test
+// Description: Checks that a post to a proxy whose queue holds maxQueuedBytes
+//              returns ERROR and leaves the message to the caller
+// Design:      Nothing listens on the peer port, so the queue only grows. The
+//              limit lets the queue take 4 messages: a post is refused once
+//              the queue has reached the limit.
+//-----------------------------------------------------------------------------
+void messageProxyQueueLimitTest(MailboxAddress& sourceAddress)
+{
+   const int acceptedCount = 4;
+   MessageBase* messages[acceptedCount + 1];
+   string expectedStrings[acceptedCount + 1];
+   messagePeerCreateSequence(sourceAddress, messages, expectedStrings, acceptedCount + 1);
+
+   MessageBuffer messageBuffer(MAX_MESSAGE_LENGTH);
+   MessageFactory::serializeMessage(messages[0], messageBuffer);
+   unsigned int frameLength = MSGMGR_FRAME_HEADER_LENGTH + messageBuffer.getBufferLength();
+
+   MailboxAddress peerAddress;
+   messagePeerAddress(peerAddress, "MessageTestQueueLimitPeer", MESSAGE_PEER_QUEUE_LIMIT_PORT);
+   messagePeerOptions(peerAddress, 0, ((acceptedCount - 1) * frameLength) + 1, DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC);
+   MailboxHandle* proxyHandle = MailboxLookupService::find(peerAddress);
+   if (proxyHandle == NULL)
+   {
+      printf("Proxy queue limit test FAILED (no proxy)\n");
+      for (int index = 0; index <= acceptedCount; index++)
+      {
+         delete messages[index];
+      }//end for
+      return;
+   }//end if
+
+   int postedCount = 0;
+   for (int index = 0; index < acceptedCount; index++)
+   {
+      if (proxyHandle->post(messages[index]) == OK)
+      {
+         postedCount++;
+      }//end if
+      else
+      {
+         delete messages[index];
+      }//end else
+   }//end for
+   MessageBase* refusedMessage = messages[acceptedCount];
+   int refusedResult = proxyHandle->post(refusedMessage);
+   if ((postedCount != acceptedCount) || (refusedResult != ERROR) ||
+       (refusedMessage->toString() != expectedStrings[acceptedCount]))
+   {
+      printf("Proxy queue limit test FAILED (%d posted, last post returned %d)\n", postedCount, refusedResult);
+   }//end if
+   else
+   {
+      printf("Proxy queue limit test passed\n");
+   }//end else
+
+   if (refusedResult == ERROR)
+   {
+      delete refusedMessage;
+   }//end if
+   delete proxyHandle;
+}//end messageProxyQueueLimitTest
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Proxy deactivate Test
+// Description: Checks deactivating a proxy (and deleting its owner handle)
+//              while the engine has its output registered: the messages not
+//              written are reported dropped, the peer receives the others,
+//              and the connection is closed once the registration ends
+// Design:      The registration holds a reference to the proxy, so the proxy
+//              outlives its owner handle until the engine calls handle_close.
+//              The peer only reads once the proxy is deactivated; the frame
+//              left partially written counts as dropped.
+//-----------------------------------------------------------------------------
+void messageProxyDeactivateTest(MailboxAddress& sourceAddress)
+{
+   const int postCount = MESSAGE_PEER_STALL_COUNT;
+   ACE_SOCK_Acceptor peerAcceptor;
+   ACE_SOCK_Stream peerStream;
+   MailboxAddress peerAddress;
+   messagePeerAddress(peerAddress, "MessageTestDeactivatePeer", MESSAGE_PEER_DEACTIVATE_PORT);
+   messagePeerOptions(peerAddress, MESSAGE_PEER_SOCKET_BUFFER_SIZE, DISTRIBUTED_PROXY_DEFAULT_MAX_QUEUED_BYTES,
+      DISTRIBUTED_PROXY_DEFAULT_DELIVERY_TIMEOUT_MSEC);
+   if (messagePeerListen(peerAcceptor, peerAddress, MESSAGE_PEER_SOCKET_BUFFER_SIZE) == ERROR)
+   {
+      printf("Proxy deactivate test FAILED (no listener)\n");
+      return;
+   }//end if
+
+   MailboxOwnerHandle* proxyOwnerHandle = DistributedMailboxProxy::createMailbox(peerAddress);
+   ACE_Time_Value acceptTimeout(MESSAGE_PEER_WAIT_SEC);
+   if ((proxyOwnerHandle == NULL) || (proxyOwnerHandle->activate() == ERROR) ||
+       (peerAcceptor.accept(peerStream, NULL, &acceptTimeout) == ERROR))
+   {
+      printf("Proxy deactivate test FAILED (no connection)\n");
+      delete proxyOwnerHandle;
+      peerAcceptor.close();
+      return;
+   }//end if
+   MailboxHandle* proxyHandle = proxyOwnerHandle->generateMailboxHandleCopy();
+   for (int msec = 0; (proxyHandle->getConnectionState() != MAILBOX_CONNECTED) &&
+        (msec < (MESSAGE_PEER_WAIT_SEC * 1000)); msec++)
+   {
+      ACE_OS::sleep(ACE_Time_Value(0, 1000));
+   }//end for
+   delete proxyHandle;
+
+   MessageBase* messages[postCount + 1];
+   string expectedStrings[postCount + 1];
+   messagePeerCreateSequence(sourceAddress, messages, expectedStrings, postCount + 1);
+   int postedCount = 0;
+   for (int index = 0; index < postCount; index++)
+   {
+      if (proxyOwnerHandle->post(messages[index]) == OK)
+      {
+         postedCount++;
+      }//end if
+      else
+      {
+         delete messages[index];
+      }//end else
+   }//end for
+
+   // Deactivate with the output stalled, and check that a post is then refused
+   ACE_OS::sleep(ACE_Time_Value(0, 200000));
+   int deactivateResult = proxyOwnerHandle->deactivate();
+   unsigned int droppedCount = messageDeliveryFailureCount;
+   int refusedResult = proxyOwnerHandle->post(messages[postCount]);
+   if (refusedResult == ERROR)
+   {
+      delete messages[postCount];
+   }//end if
+   delete proxyOwnerHandle;
+
+   // Read until the proxy closes the connection
+   vector<unsigned char> received;
+   bool isClosed = false;
+   unsigned char readBytes[MAX_MESSAGE_LENGTH];
+   while (!isClosed)
+   {
+      ACE_Time_Value readTimeout(MESSAGE_PEER_WAIT_SEC);
+      ssize_t readCount = peerStream.recv(readBytes, sizeof(readBytes), &readTimeout);
+      if (readCount < 0)
+      {
+         break;
+      }//end if
+      received.insert(received.end(), readBytes, readBytes + readCount);
+      isClosed = (readCount == 0);
+   }//end while
+
+   // The complete frames carry the first messages in order
+   int errorCount = 0;
+   int receivedCount = 0;
+   unsigned int offset = 0;
+   while ((offset + MSGMGR_FRAME_HEADER_LENGTH) <= received.size())
+   {
+      int frameLength = (received[offset] << 8) | received[offset + 1];
+      if ((offset + MSGMGR_FRAME_HEADER_LENGTH + frameLength) > received.size())
+      {
+         break;
+      }//end if
+      if (messagePeerSequence(&received[offset + MSGMGR_FRAME_HEADER_LENGTH], frameLength, expectedStrings,
+          postCount) != receivedCount)
+      {
+         errorCount++;
+      }//end if
+      receivedCount++;
+      offset += MSGMGR_FRAME_HEADER_LENGTH + frameLength;
+   }//end while
+
+   if ((deactivateResult != OK) || (refusedResult != ERROR) || !isClosed || (errorCount != 0) ||
+       (messageDeliveryFailureCalls != 1) || ((receivedCount + droppedCount) != (unsigned int)postedCount))
+   {
+      printf("Proxy deactivate test FAILED (%d received, %d dropped, %d posted, closed %d, %d errors)\n",
+         receivedCount, droppedCount, postedCount, isClosed, errorCount);
+   }//end if
+   else
+   {
+      printf("Proxy deactivate test passed (%d received, %d dropped)\n", receivedCount, droppedCount);
+   }//end else
+
+   peerStream.close();
+   peerAcceptor.close();
+}//end messageProxyDeactivateTest
+
 //-----------------------------------------------------------------------------
 // Function Type: message sending Test
 // Description:
@@ -165,6 +1096,28 @@ int main(int argc, char* argv[])
    // Initialize the OPM
    OPM::initialize();
 
+   // Register support for the test messages, which the batch tests recreate
+   MessageBootStrapMethod testRemoteMessageBootStrapMethod = makeFunctor( (MessageBootStrapMethod*)0,
+                                               MessageTestRemoteMessage::deserialize);
+   MessageFactory::registerSupport(MSGMGR_TEST_DISTRIBUTED_MSG_ID, testRemoteMessageBootStrapMethod);
+
+   // Run the batch envelope tests
+   MailboxAddress testSourceAddress;
+   testSourceAddress.locationType = DISTRIBUTED_MAILBOX;
+   testSourceAddress.mailboxName = "TestRemoteSender";
+   testSourceAddress.inetAddress.set(8888,"192.168.100.199");
+   messageBatchRoundTripTest(testSourceAddress);
+   messageBatchPostTest(testSourceAddress);
+
+   // Run the proxy connection state tests. A peer dropping a connection must fail the
+   // proxy writes rather than end the test with SIGPIPE.
+   signal(SIGPIPE, SIG_IGN);
+   messageProxyReplayTest(testSourceAddress);
+   messageProxyRewindTest(testSourceAddress);
+   messageProxyDeliveryTimeoutTest(testSourceAddress);
+   messageProxyQueueLimitTest(testSourceAddress);
+   messageProxyDeactivateTest(testSourceAddress);
+
    // Loop and send distributed messages
    messageRemoteSender();
 }//end main
@@ -0,0 +1,726 @@
+/******************************************************************************
+*
+* File name:   OPMBench.cpp
+* Subsystem:   Platform Services
+* Description: Implements the OPM microbenchmarks (reserve/release throughput
+*              and latency, growth latency and isCreatedByOPM cost) with
+*              machine readable output that can be compared to a baseline.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <ace/Get_Opt.h>
+#include <ace/Thread_Manager.h>
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "OPMBench.h"
+
+#include "platform/opm/OPM.h"
+
+// Log Manager related includes.
+#include "platform/logger/Logger.h"
+
+// Common defines
+#include "platform/common/Defines.h"
+
+//-----------------------------------------------------------------------------
+// Static Declarations.
+//-----------------------------------------------------------------------------
+
+/* From the C++ FAQ, create a module-level identification string using a compile
+   define - BUILD_LABEL must have NO spaces passed in from the make command
+   line */
+#define StrConvert(x) #x
+#define XstrConvert(x) StrConvert(x)
+static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)OPM Benchmark"
+   "\n   Build Label: " XstrConvert(BUILD_LABEL)
+   "\n   Compile Time: " __DATE__ " " __TIME__;
+
+/* Default reserve/release pairs performed by each thread (in each of the
+   untimed and timed passes) */
+#define OPM_BENCH_DEFAULT_OPERATIONS 200000
+
+/* Default tolerance (percent) before a difference from the baseline is a regression */
+#define OPM_BENCH_DEFAULT_TOLERANCE 10
+
+/* Latency differences (nanoseconds) below this are never regressions, since
+   they are within the resolution of the clock */
+#define OPM_BENCH_MIN_LATENCY_DELTA 20
+
+/* Objects each thread holds at once, so pools see a small working set
+   rather than the same object over and over */
+#define OPM_BENCH_BATCH 8
+
+/* Thread cache size used by the cached pool variant */
+#define OPM_BENCH_CACHE_SIZE 32
+
+/* Objects reserved (without releasing) by the growth benchmark */
+#define OPM_BENCH_GROWTH_OBJECTS 100000
+
+/* Initial capacity of the pools in the growth benchmark */
+#define OPM_BENCH_GROWTH_INITIAL_SIZE 64
+
+/* isCreatedByOPM calls timed together as one sample, since a single call
+   is shorter than the resolution of the clock */
+#define OPM_BENCH_SAMPLE_BATCH 16
+
+/* Maximum number of results kept for the baseline comparison */
+#define OPM_BENCH_MAX_RESULTS 256
+
+/* Benchmark variants */
+#define OPM_BENCH_NEW_DELETE 0
+#define OPM_BENCH_POOL 1
+
+/* One benchmark measurement; a line of the output */
+struct OPMBenchResult
+{
+   char benchmark[32];
+   char variant[32];
+   int threads;
+   int param;
+   unsigned long long operations;
+   double opsPerSec;
+   unsigned int p50;
+   unsigned int p99;
+   unsigned int p999;
+   unsigned int max;
+};
+
+/* Work given to (and latencies returned by) each reserve/release thread */
+struct OPMBenchWork
+{
+   int mode;
+   int poolID;
+   int operations;
+   double elapsedSec;
+   std::vector<unsigned int> reserveLatency;
+   std::vector<unsigned int> releaseLatency;
+};
+
+/* Results measured so far */
+static OPMBenchResult opmBenchResults[OPM_BENCH_MAX_RESULTS];
+static int opmBenchResultCount = 0;
+
+/* Output for the results */
+static FILE* opmBenchOutput = NULL;
+
+/* Released by the main thread once every benchmark thread has been spawned */
+static volatile int opmBenchStartFlag = 0;
+
+//-----------------------------------------------------------------------------
+// PUBLIC methods.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Method Type: STATIC
+// Description: OPMBase static initializer method for bootstrapping the objects
+// Design:
+//-----------------------------------------------------------------------------
+OPMBase* OPMBenchObject::initialize(int initializer)
+{
+   int tmp __attribute__ ((unused)) = initializer;
+   return (new OPMBenchObject());
+}//end initialize
+
+
+//-----------------------------------------------------------------------------
+// Method Type: INSTANCE
+// Description: OPMBase clean method gets called when the object gets released
+//              back into its pool
+// Design:      Does nothing, so that only the pool is measured
+//-----------------------------------------------------------------------------
+void OPMBenchObject::clean()
+{
+}//end clean
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Return a monotonic time stamp in nanoseconds
+// Design:
+//-----------------------------------------------------------------------------
+static inline unsigned long long opmBenchGetTimeNsec()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return ((unsigned long long)now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}//end opmBenchGetTimeNsec
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Return the cost of reading the clock (included in every
+//              latency sample)
+// Design:
+//-----------------------------------------------------------------------------
+static unsigned int opmBenchGetTimerOverhead()
+{
+   const int samples = 100000;
+   unsigned long long startTime = opmBenchGetTimeNsec();
+   for (int i = 0; i < samples; i++)
+   {
+      opmBenchGetTimeNsec();
+   }//end for
+   return (unsigned int)((opmBenchGetTimeNsec() - startTime) / samples);
+}//end opmBenchGetTimerOverhead
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Record (and print) a result, with the percentiles of the given
+//              latency samples
+// Design:      Sorts the samples
+//-----------------------------------------------------------------------------
+static void opmBenchRecordResult(const char* benchmark, const char* variant, int threads, int param,
+   unsigned long long operations, double opsPerSec, std::vector<unsigned int>& latencies)
+{
+   if (opmBenchResultCount >= OPM_BENCH_MAX_RESULTS)
+   {
+      return;
+   }//end if
+
+   OPMBenchResult& result = opmBenchResults[opmBenchResultCount++];
+   memset(&result, 0, sizeof(result));
+   strncpy(result.benchmark, benchmark, sizeof(result.benchmark) - 1);
+   strncpy(result.variant, variant, sizeof(result.variant) - 1);
+   result.threads = threads;
+   result.param = param;
+   result.operations = operations;
+   result.opsPerSec = opsPerSec;
+
+   if (latencies.empty() == false)
+   {
+      std::sort(latencies.begin(), latencies.end());
+      size_t count = latencies.size();
+      result.p50 = latencies[(count * 50) / 100];
+      result.p99 = latencies[(count * 99) / 100];
+      result.p999 = latencies[(count * 999) / 1000];
+      result.max = latencies[count - 1];
+   }//end if
+
+   fprintf(opmBenchOutput, "%s,%s,%d,%d,%llu,%.0f,%u,%u,%u,%u\n", result.benchmark, result.variant,
+      result.threads, result.param, result.operations, result.opsPerSec, result.p50, result.p99,
+      result.p999, result.max);
+   fflush(opmBenchOutput);
+}//end opmBenchRecordResult
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark thread function
+// Description: Reserves and releases batches of objects, first untimed (for
+//              throughput) and then timing each operation (for latency).
+// Design:      Timing each operation slows the loop down, which is why the
+//              throughput comes from a separate pass.
+//-----------------------------------------------------------------------------
+static void* opmBenchReserveReleaseThread(void* arg)
+{
+   OPMBenchWork* work = (OPMBenchWork*)arg;
+   void* objects[OPM_BENCH_BATCH];
+   int batches = work->operations / OPM_BENCH_BATCH;
+
+   while (opmBenchStartFlag == 0)
+   {
+      sched_yield();
+   }//end while
+
+   unsigned long long startTime = opmBenchGetTimeNsec();
+   for (int i = 0; i < batches; i++)
+   {
+      for (int j = 0; j < OPM_BENCH_BATCH; j++)
+      {
+         if (work->mode == OPM_BENCH_NEW_DELETE)
+         {
+            OPMBenchPayload* payload = new OPMBenchPayload;
+            payload->data[0] = (char)j;
+            objects[j] = payload;
+         }//end if
+         else
+         {
+            OPMBenchObject* object = (OPMBenchObject*)OPM_RESERVE(work->poolID);
+            object->payload.data[0] = (char)j;
+            objects[j] = object;
+         }//end else
+      }//end for
+      for (int j = 0; j < OPM_BENCH_BATCH; j++)
+      {
+         if (work->mode == OPM_BENCH_NEW_DELETE)
+         {
+            delete (OPMBenchPayload*)objects[j];
+         }//end if
+         else
+         {
+            OPM_RELEASE((OPMBase*)objects[j]);
+         }//end else
+      }//end for
+   }//end for
+   work->elapsedSec = (opmBenchGetTimeNsec() - startTime) / 1000000000.0;
+
+   work->reserveLatency.reserve(batches * OPM_BENCH_BATCH);
+   work->releaseLatency.reserve(batches * OPM_BENCH_BATCH);
+   for (int i = 0; i < batches; i++)
+   {
+      for (int j = 0; j < OPM_BENCH_BATCH; j++)
+      {
+         unsigned long long opStartTime = opmBenchGetTimeNsec();
+         if (work->mode == OPM_BENCH_NEW_DELETE)
+         {
+            OPMBenchPayload* payload = new OPMBenchPayload;
+            payload->data[0] = (char)j;
+            objects[j] = payload;
+         }//end if
+         else
+         {
+            OPMBenchObject* object = (OPMBenchObject*)OPM_RESERVE(work->poolID);
+            object->payload.data[0] = (char)j;
+            objects[j] = object;
+         }//end else
+         work->reserveLatency.push_back((unsigned int)(opmBenchGetTimeNsec() - opStartTime));
+      }//end for
+      for (int j = 0; j < OPM_BENCH_BATCH; j++)
+      {
+         unsigned long long opStartTime = opmBenchGetTimeNsec();
+         if (work->mode == OPM_BENCH_NEW_DELETE)
+         {
+            delete (OPMBenchPayload*)objects[j];
+         }//end if
+         else
+         {
+            OPM_RELEASE((OPMBase*)objects[j]);
+         }//end else
+         work->releaseLatency.push_back((unsigned int)(opmBenchGetTimeNsec() - opStartTime));
+      }//end for
+   }//end for
+
+   if (work->mode != OPM_BENCH_NEW_DELETE)
+   {
+      OPM::flushThreadCache();
+   }//end if
+   return NULL;
+}//end opmBenchReserveReleaseThread
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark
+// Description: Run the reserve/release benchmark for one variant and thread
+//              count, and record the reserve and release results.
+// Design:      Throughput is reserve/release pairs per second over all of the
+//              threads, taken from the slowest thread.
+//-----------------------------------------------------------------------------
+static void opmBenchReserveRelease(const char* variant, int mode, int poolID, int threads, int operations)
+{
+   std::vector<OPMBenchWork> work(threads);
+   std::vector<ACE_thread_t> threadIds(threads);
+
+   opmBenchStartFlag = 0;
+   for (int i = 0; i < threads; i++)
+   {
+      work[i].mode = mode;
+      work[i].poolID = poolID;
+      work[i].operations = operations;
+      work[i].elapsedSec = 0;
+      ACE_Thread_Manager::instance()->spawn(opmBenchReserveReleaseThread, &work[i],
+         THR_NEW_LWP | THR_JOINABLE, &threadIds[i]);
+   }//end for
+   __sync_synchronize();
+   opmBenchStartFlag = 1;
+
+   double elapsedSec = 0;
+   std::vector<unsigned int> reserveLatency;
+   std::vector<unsigned int> releaseLatency;
+   for (int i = 0; i < threads; i++)
+   {
+      ACE_Thread_Manager::instance()->join(threadIds[i]);
+      elapsedSec = std::max(elapsedSec, work[i].elapsedSec);
+      reserveLatency.insert(reserveLatency.end(), work[i].reserveLatency.begin(), work[i].reserveLatency.end());
+      releaseLatency.insert(releaseLatency.end(), work[i].releaseLatency.begin(), work[i].releaseLatency.end());
+   }//end for
+
+   unsigned long long pairs = (unsigned long long)threads * (operations - (operations % OPM_BENCH_BATCH));
+   double opsPerSec = (elapsedSec > 0) ? (pairs / elapsedSec) : 0;
+   opmBenchRecordResult("reserve", variant, threads, 0, pairs, opsPerSec, reserveLatency);
+   opmBenchRecordResult("release", variant, threads, 0, pairs, opsPerSec, releaseLatency);
+}//end opmBenchReserveRelease
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark
+// Description: Compare new/delete, ObjectPool (single thread only, since it
+//              is not thread safe), SyncObjectPool and SyncObjectPool with a
+//              thread cache from 1 up to maxThreads threads.
+// Design:      Thread counts double up to maxThreads (which is always run)
+//-----------------------------------------------------------------------------
+static void opmBenchReserveReleaseSuite(int maxThreads, int operations)
+{
+   // Large enough that none of the pools grow during the measurement
+   int initialSize = (maxThreads * (OPM_BENCH_BATCH + OPM_BENCH_CACHE_SIZE)) + 1024;
+
+   int objectPoolID = OPM::createPool("OPMBenchObjectPool", 0, (OPM_INIT_PTR)&OPMBenchObject::initialize,
+      0.8, 256, initialSize, false, OPM_GROWTH_ALLOWED);
+   int syncPoolID = OPM::createPool("OPMBenchSyncPool", 0, (OPM_INIT_PTR)&OPMBenchObject::initialize,
+      0.8, 256, initialSize, true, OPM_GROWTH_ALLOWED);
+   int cachedPoolID = OPM::createPool("OPMBenchCachedPool", 0, (OPM_INIT_PTR)&OPMBenchObject::initialize,
+      0.8, 256, initialSize, true, OPM_GROWTH_ALLOWED);
+   if ((objectPoolID == ERROR) || (syncPoolID == ERROR) || (cachedPoolID == ERROR) ||
+       (OPM::setPoolThreadCacheSize(cachedPoolID, OPM_BENCH_CACHE_SIZE) == false))
+   {
+      fprintf(stderr, "Unable to create the reserve/release benchmark pools\n");
+      return;
+   }//end if
+
+   opmBenchReserveRelease("objectpool", OPM_BENCH_POOL, objectPoolID, 1, operations);
+
+   int threads = 1;
+   while (true)
+   {
+      opmBenchReserveRelease("newdelete", OPM_BENCH_NEW_DELETE, 0, threads, operations);
+      opmBenchReserveRelease("syncpool", OPM_BENCH_POOL, syncPoolID, threads, operations);
+      opmBenchReserveRelease("syncpool_cache", OPM_BENCH_POOL, cachedPoolID, threads, operations);
+      if (threads >= maxThreads)
+      {
+         break;
+      }//end if
+      threads = std::min(threads * 2, maxThreads);
+   }//end while
+}//end opmBenchReserveReleaseSuite
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark
+// Description: Measure reserve latency while a pool grows from
+//              OPM_BENCH_GROWTH_INITIAL_SIZE to OPM_BENCH_GROWTH_OBJECTS, for
+//              several capacity increments, with the increments added on the
+//              reserving thread (synchronous) or by the maintenance thread
+//              (background).
+// Design:      The growth spikes show up in the p99/p999/max columns
+//-----------------------------------------------------------------------------
+static void opmBenchGrowthSuite()
+{
+   int increments[] = { 64, 1024, 16384 };
+   int numberIncrements = sizeof(increments) / sizeof(int);
+   const char* variants[] = { "synchronous", "background" };
+
+   if (OPM::startMaintenanceThread() == false)
+   {
+      fprintf(stderr, "Unable to start the OPM maintenance thread\n");
+   }//end if
+
+   OPMBase** objects = new OPMBase*[OPM_BENCH_GROWTH_OBJECTS];
+   for (int variant = 0; variant < 2; variant++)
+   {
+      for (int i = 0; i < numberIncrements; i++)
+      {
+         char poolName[64];
+         sprintf(poolName, "OPMBenchGrowth_%s_%d", variants[variant], increments[i]);
+         int poolID = OPM::createPool(poolName, 0, (OPM_INIT_PTR)&OPMBenchObject::initialize, 0.8,
+            increments[i], OPM_BENCH_GROWTH_INITIAL_SIZE, true, OPM_GROWTH_ALLOWED);
+         if ((poolID == ERROR) ||
+             ((variant == 1) && (OPM::setPoolBackgroundMaintenance(poolID, true) == false)))
+         {
+            fprintf(stderr, "Unable to create growth benchmark pool %s\n", poolName);
+            continue;
+         }//end if
+
+         std::vector<unsigned int> latencies;
+         latencies.reserve(OPM_BENCH_GROWTH_OBJECTS);
+         unsigned long long startTime = opmBenchGetTimeNsec();
+         for (int j = 0; j < OPM_BENCH_GROWTH_OBJECTS; j++)
+         {
+            unsigned long long opStartTime = opmBenchGetTimeNsec();
+            objects[j] = OPM_RESERVE(poolID);
+            latencies.push_back((unsigned int)(opmBenchGetTimeNsec() - opStartTime));
+         }//end for
+         double elapsedSec = (opmBenchGetTimeNsec() - startTime) / 1000000000.0;
+
+         int reservedCount = 0;
+         for (int j = 0; j < OPM_BENCH_GROWTH_OBJECTS; j++)
+         {
+            if (objects[j] != NULL)
+            {
+               OPM_RELEASE(objects[j]);
+               reservedCount++;
+            }//end if
+         }//end for
+         if (reservedCount != OPM_BENCH_GROWTH_OBJECTS)
+         {
+            fprintf(stderr, "Growth benchmark pool %s returned %d null objects\n", poolName,
+               OPM_BENCH_GROWTH_OBJECTS - reservedCount);
+         }//end if
+
+         opmBenchRecordResult("growth", variants[variant], 1, increments[i], OPM_BENCH_GROWTH_OBJECTS,
+            (elapsedSec > 0) ? (OPM_BENCH_GROWTH_OBJECTS / elapsedSec) : 0, latencies);
+      }//end for
+   }//end for
+   delete [] objects;
+
+   OPM::stopMaintenanceThread();
+}//end opmBenchGrowthSuite
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Benchmark
+// Description: Measure the cost of isCreatedByOPM on every object of pools of
+//              increasing capacity (all objects reserved). The cost is
+//              expected to be flat across capacities.
+// Design:      Each sample times OPM_BENCH_SAMPLE_BATCH calls
+//-----------------------------------------------------------------------------
+static void opmBenchIsCreatedByOPMSuite()
+{
+   int poolSizes[] = { 100, 1000, 10000, 100000, 1000000 };
+   int numberPoolSizes = sizeof(poolSizes) / sizeof(int);
+
+   for (int i = 0; i < numberPoolSizes; i++)
+   {
+      int poolSize = poolSizes[i];
+      char poolName[64];
+      sprintf(poolName, "OPMBenchOwnership%d", poolSize);
+      int poolID = OPM::createPool(poolName, 0, (OPM_INIT_PTR)&OPMBenchObject::initialize, 0.8,
+         1, poolSize, false, OPM_NO_GROWTH);
+      if (poolID == ERROR)
+      {
+         fprintf(stderr, "Unable to create pool with capacity %d\n", poolSize);
+         break;
+      }//end if
+
+      OPMBase** objects = new OPMBase*[poolSize];
+      for (int j = 0; j < poolSize; j++)
+      {
+         objects[j] = OPM_RESERVE(poolID);
+      }//end for
+
+      std::vector<unsigned int> latencies;
+      latencies.reserve(poolSize / OPM_BENCH_SAMPLE_BATCH);
+      int ownedCount = 0;
+      unsigned long long startTime = opmBenchGetTimeNsec();
+      for (int j = 0; (j + OPM_BENCH_SAMPLE_BATCH) <= poolSize; j += OPM_BENCH_SAMPLE_BATCH)
+      {
+         unsigned long long sampleStartTime = opmBenchGetTimeNsec();
+         for (int k = j; k < (j + OPM_BENCH_SAMPLE_BATCH); k++)
+         {
+            if (OPM::isCreatedByOPM(objects[k]))
+            {
+               ownedCount++;
+            }//end if
+         }//end for
+         latencies.push_back((unsigned int)((opmBenchGetTimeNsec() - sampleStartTime) / OPM_BENCH_SAMPLE_BATCH));
+      }//end for
+      double elapsedSec = (opmBenchGetTimeNsec() - startTime) / 1000000000.0;
+      int checkedCount = poolSize - (poolSize % OPM_BENCH_SAMPLE_BATCH);
+      if (ownedCount != checkedCount)
+      {
+         fprintf(stderr, "isCreatedByOPM failed for %d of %d objects\n", (checkedCount - ownedCount), checkedCount);
+      }//end if
+
+      for (int j = 0; j < poolSize; j++)
+      {
+         OPM_RELEASE(objects[j]);
+      }//end for
+      delete [] objects;
+
+      opmBenchRecordResult("iscreatedbyopm", "objectpool", 1, poolSize, checkedCount,
+         (elapsedSec > 0) ? (checkedCount / elapsedSec) : 0, latencies);
+   }//end for
+}//end opmBenchIsCreatedByOPMSuite
+
+
+//-----------------------------------------------------------------------------
+// Function Type: Helper
+// Description: Compare the results against a baseline file written by an
+//              earlier run, printing the differences to stderr.
+// Design:      A result regresses if its throughput drops, or its p99 latency
+//              rises, by more than the tolerance. Results without a match in
+//              the baseline (or the reverse) are only reported.
+// Returns:     Number of regressions (or ERROR if the baseline is unreadable)
+//-----------------------------------------------------------------------------
+static int opmBenchCompareBaseline(const char* baselineFileName, int tolerancePercent)
+{
+   FILE* baselineFile = fopen(baselineFileName, "r");
+   if (baselineFile == NULL)
+   {
+      fprintf(stderr, "Unable to read baseline %s\n", baselineFileName);
+      return ERROR;
+   }//end if
+
+   fprintf(stderr, "\nComparison with baseline %s (tolerance %d%%)\n", baselineFileName, tolerancePercent);
+   fprintf(stderr, "%-16s %-16s %7s %8s %14s %14s %8s %8s %8s\n", "benchmark", "variant", "threads",
+      "param", "base ops/s", "ops/s", "base p99", "p99", "status");
+
+   int regressionCount = 0;
+   std::vector<bool> isMatched(opmBenchResultCount, false);
+   char line[512];
+   while (fgets(line, sizeof(line), baselineFile) != NULL)
+   {
+      OPMBenchResult baseline;
+      memset(&baseline, 0, sizeof(baseline));
+      if ((line[0] == '#') ||
+          (sscanf(line, "%31[^,],%31[^,],%d,%d,%llu,%lf,%u,%u,%u,%u", baseline.benchmark, baseline.variant,
+             &baseline.threads, &baseline.param, &baseline.operations, &baseline.opsPerSec, &baseline.p50,
+             &baseline.p99, &baseline.p999, &baseline.max) != 10))
+      {
+         // Comment or header line
+         continue;
+      }//end if
+
+      int i;
+      for (i = 0; i < opmBenchResultCount; i++)
+      {
+         const OPMBenchResult& result = opmBenchResults[i];
+         if ((strcmp(result.benchmark, baseline.benchmark) == 0) && (strcmp(result.variant, baseline.variant) == 0) &&
+             (result.threads == baseline.threads) && (result.param == baseline.param))
+         {
+            break;
+         }//end if
+      }//end for
+      if (i == opmBenchResultCount)
+      {
+         fprintf(stderr, "%-16s %-16s %7d %8d %14.0f %14s %8u %8s %8s\n", baseline.benchmark, baseline.variant,
+            baseline.threads, baseline.param, baseline.opsPerSec, "-", baseline.p99, "-", "missing");
+         continue;
+      }//end if
+      isMatched[i] = true;
+
+      const OPMBenchResult& result = opmBenchResults[i];
+      bool isSlower = (result.opsPerSec < (baseline.opsPerSec * (100 - tolerancePercent) / 100.0));
+      bool isLatencyHigher = ((result.p99 > (baseline.p99 * (100 + tolerancePercent) / 100.0)) &&
+                              ((result.p99 - baseline.p99) >= OPM_BENCH_MIN_LATENCY_DELTA));
+      const char* status = "ok";
+      if (isSlower || isLatencyHigher)
+      {
+         status = "REGRESSED";
+         regressionCount++;
+      }//end if
+      fprintf(stderr, "%-16s %-16s %7d %8d %14.0f %14.0f %8u %8u %8s\n", result.benchmark, result.variant,
+         result.threads, result.param, baseline.opsPerSec, result.opsPerSec, baseline.p99, result.p99, status);
+   }//end while
+   fclose(baselineFile);
+
+   for (int i = 0; i < opmBenchResultCount; i++)
+   {
+      if (isMatched[i] == false)
+      {
+         const OPMBenchResult& result = opmBenchResults[i];
+         fprintf(stderr, "%-16s %-16s %7d %8d %14s %14.0f %8s %8u %8s\n", result.benchmark, result.variant,
+            result.threads, result.param, "-", result.opsPerSec, "-", result.p99, "new");
+      }//end if
+   }//end for
+
+   fprintf(stderr, "%d regression(s)\n", regressionCount);
+   return regressionCount;
+}//end opmBenchCompareBaseline
+
+
+//-----------------------------------------------------------------------------
+// Function Type: main function for OPM benchmark binary
+// Description: Runs every benchmark and writes one CSV line per result (lines
+//              starting with '#' are comments). The output of one run can be
+//              kept as the baseline for the next.
+// Design:      Exits with 1 if any result regressed against the baseline
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+   int maxThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   int operations = OPM_BENCH_DEFAULT_OPERATIONS;
+   int tolerancePercent = OPM_BENCH_DEFAULT_TOLERANCE;
+   const char* baselineFileName = NULL;
+   const char* outputFileName = NULL;
+
+   ACE_Get_Opt get_opt (argc, argv, "t:n:c:r:o:h");
+   int c;
+   while ((c = get_opt ()) != -1)
+   {
+      switch (c)
+      {
+         case 't':
+            maxThreads = atoi(get_opt.optarg);
+            break;
+         case 'n':
+            operations = atoi(get_opt.optarg);
+            break;
+         case 'c':
+            baselineFileName = get_opt.optarg;
+            break;
+         case 'r':
+            tolerancePercent = atoi(get_opt.optarg);
+            break;
+         case 'o':
+            outputFileName = get_opt.optarg;
+            break;
+         default:
+            printf("Usage:\n  OPMBench\n"
+                   "    -t <threads> Maximum number of threads (default: number of CPUs)\n"
+                   "    -n <count> Reserve/release pairs per thread and pass (default %d)\n"
+                   "    -o <file> Write the results to a file instead of stdout\n"
+                   "    -c <file> Compare the results with a baseline written by an earlier run\n"
+                   "    -r <percent> Tolerance before a difference is a regression (default %d)\n",
+                   OPM_BENCH_DEFAULT_OPERATIONS, OPM_BENCH_DEFAULT_TOLERANCE);
+            return ERROR;
+      }//end switch
+   }//end while
+
+   if (maxThreads < 1)
+   {
+      maxThreads = 1;
+   }//end if
+   if (operations < OPM_BENCH_BATCH)
+   {
+      operations = OPM_BENCH_BATCH;
+   }//end if
+
+   opmBenchOutput = stdout;
+   if ((outputFileName != NULL) && ((opmBenchOutput = fopen(outputFileName, "w")) == NULL))
+   {
+      fprintf(stderr, "Unable to write %s\n", outputFileName);
+      return ERROR;
+   }//end if
+
+   // Initialize the Logger with local-only output, and keep the OPM logs out
+   // of the measurements
+   Logger::getInstance()->initialize(true);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+   OPM::initialize();
+
+   time_t now = time(NULL);
+   fprintf(opmBenchOutput, "# OPMBench build %s, %s", XstrConvert(BUILD_LABEL), ctime(&now));
+   fprintf(opmBenchOutput, "# cpus=%d max_threads=%d operations=%d timer_overhead_ns=%u\n",
+      (int)sysconf(_SC_NPROCESSORS_ONLN), maxThreads, operations, opmBenchGetTimerOverhead());
+   fprintf(opmBenchOutput, "benchmark,variant,threads,param,operations,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns\n");
+
+   opmBenchReserveReleaseSuite(maxThreads, operations);
+   opmBenchGrowthSuite();
+   opmBenchIsCreatedByOPMSuite();
+
+   if (opmBenchOutput != stdout)
+   {
+      fclose(opmBenchOutput);
+   }//end if
+
+   int result = OK;
+   if ((baselineFileName != NULL) && (opmBenchCompareBaseline(baselineFileName, tolerancePercent) != 0))
+   {
+      result = 1;
+   }//end if
+
+   // OPM::shutdown prints the pool summaries; send them to stderr so that
+   // stdout holds only the results
+   fflush(stdout);
+   dup2(STDERR_FILENO, STDOUT_FILENO);
+   OPM::shutdown();
+   return result;
+}//end main
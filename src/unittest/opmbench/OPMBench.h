@@ -0,0 +1,89 @@
+/******************************************************************************
+*
+* File name:   OPMBench.h
+* Subsystem:   Platform Services
+* Description: Implements the OPM microbenchmarks (reserve/release throughput
+*              and latency, growth latency and isCreatedByOPM cost) with
+*              machine readable output that can be compared to a baseline.
+*
+* Name                 Date       Release
+* -------------------- ---------- ---------------------------------------------
+* Stephen Horton       01/01/2014 Initial release
+*
+*
+******************************************************************************/
+
+#ifndef _PLAT_OPM_BENCH_H_
+#define _PLAT_OPM_BENCH_H_
+
+//-----------------------------------------------------------------------------
+// System include files, includes 3rd party libraries.
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// Component includes, includes elements of our system.
+//-----------------------------------------------------------------------------
+
+#include "platform/opm/OPMBase.h"
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+
+/** Size in bytes of the payload carried by each benchmark object */
+#define OPM_BENCH_PAYLOAD_SIZE 64
+
+/**
+ * Payload of a benchmark object, allocated on its own for the new/delete
+ * variant (OPMBase objects log a warning when they are deleted, which would
+ * be measured instead of the heap)
+ */
+struct OPMBenchPayload
+{
+   char data[OPM_BENCH_PAYLOAD_SIZE];
+};
+
+// For C++ class declarations, we have one (and only one) of these access
+// blocks per class in this order: public, protected, and then private.
+//
+// Inside each block, we declare class members in this order:
+// 1) nested classes (if applicable)
+// 2) static methods
+// 3) static data
+// 4) instance methods (constructors/destructors first)
+// 5) instance data
+//
+
+/**
+ * Benchmark object kept in the OPM pools under test. Its clean method does
+ * no work, so that only the pool itself is measured.
+ * <p>
+ * $Author: Stephen Horton$
+ * $Revision: 1$
+ */
+
+class OPMBenchObject : public OPMBase
+{
+   public:
+
+      /**
+       * OPMBase static initializer method for bootstrapping the objects
+       * @param initializer Unused
+       * @returns Pointer to the new OPMBase object.
+       */
+      static OPMBase* initialize(int initializer);
+
+      /** OPMBase clean method gets called when the object gets released
+          back into its pool */
+      void clean();
+
+      /** Payload, touched on each reserve as an application would */
+      OPMBenchPayload payload;
+
+   protected:
+
+   private:
+
+};
+
+#endif
@@ -15,8 +15,15 @@
 // System include files, includes 3rd party libraries.
 //-----------------------------------------------------------------------------
 
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <new>
 #include <sys/resource.h>
+#include <sys/wait.h>
+#include <ace/OS_NS_sys_time.h>
+#include <ace/Barrier.h>
+#include <ace/OS_NS_unistd.h>
 #include <ace/Task.h>
 #include <ace/Thread_Manager.h>
 
@@ -26,7 +33,10 @@
 
 #include "OPMTest.h"
 
-#include "platform/opm/OPM.h"
+#include "platform/opm/OPMPool.h"
+#include "platform/opm/OPMNuma.h"
+#include "platform/opm/OPMSharedPool.h"
+#include "platform/opm/OPMStats.h"
 
 // Log Manager related includes.
 #include "platform/logger/Logger.h"
@@ -54,6 +64,9 @@ static volatile char main_sccs_id[] __attribute__ ((unused)) = "@(#)OPM Test"
 /* For Testing */
 int opmTestPoolID = 0;
 
+/* Number of OPMTest objects constructed by the pools (see test #7) */
+int opmTestConstructedCount = 0;
+
 #define OPM_TEST_MAX_SECONDS 5
 
 //-----------------------------------------------------------------------------
@@ -67,6 +80,29 @@ int opmTestGetRandomSeconds()
 }//end opmTestGetRandomSeconds
 
 
+//-----------------------------------------------------------------------------
+// Method Type: Test function that gets the resident set size of this process
+// Description: Returns the RSS in KBytes (or 0 if it cannot be read)
+// Design:      Reads the second field of /proc/self/statm (resident pages)
+//-----------------------------------------------------------------------------
+long opmTestGetResidentKB()
+{
+   long totalPages = 0;
+   long residentPages = 0;
+   FILE* statmFile = fopen("/proc/self/statm", "r");
+   if (statmFile == NULL)
+   {
+      return 0;
+   }//end if
+   if (fscanf(statmFile, "%ld %ld", &totalPages, &residentPages) != 2)
+   {
+      residentPages = 0;
+   }//end if
+   fclose(statmFile);
+   return (residentPages * (sysconf(_SC_PAGESIZE) / 1024));
+}//end opmTestGetResidentKB
+
+
 //-----------------------------------------------------------------------------
 // Method Type: Test function that performs check-in and check-out stuff
 // Description: Parameter determines if it should Loop performing check-in/out 
@@ -195,6 +231,373 @@ void opmTest2Start(int numberOfTasks)
 }//end opmTest2Start
 
 
+//-----------------------------------------------------------------------------
+// Method Type: Test3 entry function
+// Description: Benchmarks the cost of release and isCreatedByOPM as the pool
+//              capacity grows from 100 to 1,000,000 objects. Since ownership
+//              is tracked inside each object, the per operation cost should be
+//              flat across all of the pool sizes.
+// Design:      Every object in the pool is reserved, then all of them are
+//              checked with isCreatedByOPM and finally released (in the order
+//              reserved, so each release unlinks from deep in the Used List).
+//              The largest pool is compared against the 10,000 object pool
+//              (the smaller ones are too quick to time reliably); cache misses
+//              allow for some growth, but a search of the lists would cost
+//              about a hundred times more.
+//-----------------------------------------------------------------------------
+void opmTest3Start()
+{
+   int poolSizes[] = { 100, 1000, 10000, 100000, 1000000 };
+   int numberPoolSizes = sizeof(poolSizes) / sizeof(int);
+   const int referenceSizeIndex = 2;
+   const double maximumCostRatio = 4.0;
+   double releaseCost[sizeof(poolSizes) / sizeof(int)];
+   double containsCost[sizeof(poolSizes) / sizeof(int)];
+   int measuredCount = 0;
+
+   // Keep per-object logging out of the measurements
+   LogEntrySeverityType previousLogLevel = Logger::getSubsystemLogLevel(OPMLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+
+   printf("\nOPM release / isCreatedByOPM cost by pool capacity\n");
+   printf("%10s %22s %22s\n", "Capacity", "release (ns/op)", "isCreatedByOPM (ns/op)");
+
+   for (int i = 0; i < numberPoolSizes; i++)
+   {
+      int poolSize = poolSizes[i];
+      char poolName[64];
+      sprintf(poolName, "OPMTestScaling%d", poolSize);
+
+      int poolID = OPM::createPool(poolName, 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+         1, poolSize, false, OPM_NO_GROWTH);
+      if (poolID == ERROR)
+      {
+         printf("Unable to create pool with capacity %d\n", poolSize);
+         break;
+      }//end if
+
+      OPMBase** objects = new OPMBase*[poolSize];
+      for (int j = 0; j < poolSize; j++)
+      {
+         objects[j] = OPM_RESERVE(poolID);
+      }//end for
+
+      ACE_Time_Value startTime = ACE_OS::gettimeofday();
+      int ownedCount = 0;
+      for (int j = 0; j < poolSize; j++)
+      {
+         if (OPM::isCreatedByOPM(objects[j]))
+         {
+            ownedCount++;
+         }//end if
+      }//end for
+      ACE_Time_Value containsTime = ACE_OS::gettimeofday() - startTime;
+
+      startTime = ACE_OS::gettimeofday();
+      for (int j = 0; j < poolSize; j++)
+      {
+         OPM_RELEASE(objects[j]);
+      }//end for
+      ACE_Time_Value releaseTime = ACE_OS::gettimeofday() - startTime;
+
+      if (ownedCount != poolSize)
+      {
+         printf("isCreatedByOPM failed for %d of %d objects\n", (poolSize - ownedCount), poolSize);
+      }//end if
+
+      releaseCost[i] = ((releaseTime.sec() * 1000000.0) + releaseTime.usec()) * 1000.0 / poolSize;
+      containsCost[i] = ((containsTime.sec() * 1000000.0) + containsTime.usec()) * 1000.0 / poolSize;
+      measuredCount++;
+      printf("%10d %22.1f %22.1f\n", poolSize, releaseCost[i], containsCost[i]);
+
+      delete [] objects;
+   }//end for
+
+   Logger::setSubsystemLogLevel(OPMLOG, previousLogLevel);
+
+   if (measuredCount != numberPoolSizes)
+   {
+      printf("Release cost scaling test FAILED (only %d of %d pool sizes measured)\n",
+         measuredCount, numberPoolSizes);
+      return;
+   }//end if
+
+   // Allow for the timer resolution (1 usec over the reference pool)
+   double resolution = 1000.0 / poolSizes[referenceSizeIndex];
+   int largest = numberPoolSizes - 1;
+   if ((releaseCost[largest] > (maximumCostRatio * (releaseCost[referenceSizeIndex] + resolution))) ||
+       (containsCost[largest] > (maximumCostRatio * (containsCost[referenceSizeIndex] + resolution))))
+   {
+      printf("Release cost scaling test FAILED (capacity %d costs more than %.0f times capacity %d)\n",
+         poolSizes[largest], maximumCostRatio, poolSizes[referenceSizeIndex]);
+   }//end if
+   else
+   {
+      printf("Release cost scaling test passed\n");
+   }//end else
+}//end opmTest3Start
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test4 entry function
+// Description: Exercises a slab mode pool: checks that the objects of each
+//              capacity increment are contiguous and cache line aligned, and
+//              that a grown slab is only given back once all of its objects
+//              have been released.
+// Design:      Log level is left as is so that the growth and reduction DEBUG
+//              logs can be seen.
+//-----------------------------------------------------------------------------
+void opmTest4Start()
+{
+   int initialSize = 10;
+   int poolID = OPM::createSlabPool("OPMTestSlab", 0, (OPM_PLACEMENT_INIT_PTR)&OPMTest::initializeInPlace,
+      sizeof(OPMTest), 0.8, 10, initialSize, false, OPM_GROW_AND_SHRINK, OPM_SLAB_PREFAULT);
+   if (poolID == ERROR)
+   {
+      printf("Unable to create slab pool\n");
+      return;
+   }//end if
+
+   // Reserve enough objects to force the pool to grow by one slab
+   int reserveCount = initialSize + 5;
+   OPMBase** objects = new OPMBase*[reserveCount];
+   for (int i = 0; i < reserveCount; i++)
+   {
+      objects[i] = OPM_RESERVE(poolID);
+   }//end for
+
+   // Objects of the initial slab are handed out in address order (check only
+   // the first half, since the pool grows before the initial slab runs out)
+   size_t stride = OPMSlab::getObjectStride(sizeof(OPMTest));
+   int misplacedCount = 0;
+   for (int i = 0; i < (initialSize / 2); i++)
+   {
+      if ((((unsigned long)objects[i]) % OPM_CACHE_LINE_SIZE) != 0)
+      {
+         misplacedCount++;
+      }//end if
+      else if ((i > 0) && ((size_t)((char*)objects[i] - (char*)objects[i-1]) != stride))
+      {
+         misplacedCount++;
+      }//end else if
+   }//end for
+   printf("\nSlab pool: %d of %d initial objects misplaced (stride %d)\n", misplacedCount,
+      (initialSize / 2), (int)stride);
+
+   // Hold the last object (which came from the newest slab) so the pool cannot
+   // shrink yet
+   for (int i = 0; i < (reserveCount - 1); i++)
+   {
+      OPM_RELEASE(objects[i]);
+   }//end for
+   OPM::printPoolSummary(poolID);
+
+   // Now release the last object, and the newest slab should be unmapped
+   OPM_RELEASE(objects[reserveCount - 1]);
+   OPM::printPoolSummary(poolID);
+
+   delete [] objects;
+}//end opmTest4Start
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test5 entry function
+// Description: Exercises the typed OPM::Pool<T> API: objects held by a scoped
+//              OPM::Pool<T>::Ptr go back into the pool when it goes out of
+//              scope unless they are detached.
+// Design:
+//-----------------------------------------------------------------------------
+void opmTest5Start()
+{
+   int poolID = OPM::Pool<OPMTest>::create("OPMTestTyped", 0, 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+   if ((poolID == ERROR) || (OPM::Pool<OPMTest>::getPoolID() != poolID))
+   {
+      printf("Unable to create typed pool\n");
+      return;
+   }//end if
+
+   OPMTest* detachedObject = NULL;
+   {
+      OPM::Pool<OPMTest>::Ptr scopedObject;
+      OPM::Pool<OPMTest>::Ptr detachingObject(poolID);
+      if (scopedObject.isNull() || detachingObject.isNull())
+      {
+         printf("Typed pool returned a null object\n");
+         return;
+      }//end if
+      scopedObject->doSomething();
+      detachedObject = detachingObject.detach();
+   }
+
+   // Only the detached object should still be reserved
+   printf("\nTyped pool: %s\n", (OPM::isCreatedByOPM(detachedObject) &&
+      (detachedObject->getObjectState() == OPM_OBJECT_USED)) ? "detached object held" : "FAILED");
+   OPM::printPoolSummary(poolID);
+   OPM_RELEASE(detachedObject);
+}//end opmTest5Start
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test6 entry function
+// Description: Exercises background maintenance: the maintenance thread (and
+//              not reserve) grows the pool once usage crosses the threshold,
+//              and the pool only shrinks after usage has stayed low for the
+//              shrink delay.
+// Design:      The summaries should show 1 expansion, 0 synchronous growths,
+//              a capacity of 20 right after the releases and 10 after the delay
+//-----------------------------------------------------------------------------
+void opmTest6Start()
+{
+   const int initialSize = 10;
+   int poolID = OPM::createPool("OPMTestMaintained", 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+      10, initialSize, true, OPM_GROW_AND_SHRINK);
+   if ((poolID == ERROR) || (OPM::startMaintenanceThread(10) == false) ||
+       (OPM::setPoolBackgroundMaintenance(poolID, true, 1) == false))
+   {
+      printf("Unable to create background maintained pool\n");
+      return;
+   }//end if
+
+   // Cross the growth threshold (8 of 10 objects used) and give the maintenance
+   // thread time to add the next increment
+   OPMBase* objects[initialSize];
+   for (int i = 0; i < (initialSize - 1); i++)
+   {
+      objects[i] = OPM_RESERVE(poolID);
+   }//end for
+   ACE_OS::sleep(ACE_Time_Value(0, 100000));
+
+   // Hover around the growth threshold; the pool must not shrink and regrow
+   for (int i = 0; i < 5; i++)
+   {
+      OPM_RELEASE(objects[initialSize - 2]);
+      objects[initialSize - 2] = OPM_RESERVE(poolID);
+   }//end for
+   printf("\nMaintained pool after growth:\n");
+   OPM::printPoolSummary(poolID);
+
+   for (int i = 0; i < (initialSize - 1); i++)
+   {
+      OPM_RELEASE(objects[i]);
+   }//end for
+   printf("\nMaintained pool right after release:\n");
+   OPM::printPoolSummary(poolID);
+
+   // Wait out the shrink delay
+   ACE_OS::sleep(ACE_Time_Value(1, 500000));
+   printf("\nMaintained pool after the shrink delay:\n");
+   OPM::printPoolSummary(poolID);
+
+   OPM::setPoolBackgroundMaintenance(poolID, false);
+   OPM::stopMaintenanceThread();
+}//end opmTest6Start
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test7 entry function
+// Description: Compares the pool creation (process startup) time and resident
+//              memory of eager and lazy construction, side by side.
+// Design:      Each mode creates the same mix of heap and prefaulted slab mode
+//              pools, then reserves a few objects from each of them to show the
+//              cost that lazy construction moves to the first reservations.
+//              The pools are single threaded, so no thread cache constructs
+//              objects ahead of the reservations. The times and RSS printed
+//              depend on the machine; only the constructed counts are checked.
+//-----------------------------------------------------------------------------
+void opmTest7Start()
+{
+   const int numberPools = 2;
+   const int initialSize = 1000;
+   const int reserveCount = 10;
+   const size_t slabObjectSize = 2048;
+   const char* modeNames[] = { "eager", "lazy" };
+
+   // Keep per-object logging out of the measurements
+   LogEntrySeverityType previousLogLevel = Logger::getSubsystemLogLevel(OPMLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+
+   printf("\nOPM startup cost of %d heap and %d slab pools of %d objects\n", numberPools,
+      numberPools, initialSize);
+   printf("%8s %18s %14s %22s\n", "Mode", "create (msec)", "RSS (KB)", "first reserves (usec)");
+
+   int errorCount = 0;
+   for (int mode = 0; mode < 2; mode++)
+   {
+      bool isLazy = (mode == 1);
+      OPM::setLazyConstruction(isLazy);
+      int poolIDs[numberPools * 2];
+      int startConstructedCount = opmTestConstructedCount;
+
+      long startResident = opmTestGetResidentKB();
+      ACE_Time_Value startTime = ACE_OS::gettimeofday();
+      for (int i = 0; i < numberPools; i++)
+      {
+         char poolName[64];
+         sprintf(poolName, "OPMTestStartupHeap%s%d", modeNames[mode], i);
+         poolIDs[i] = OPM::createPool(poolName, 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+            10, initialSize, false, OPM_GROWTH_ALLOWED);
+         sprintf(poolName, "OPMTestStartupSlab%s%d", modeNames[mode], i);
+         poolIDs[numberPools + i] = OPM::createSlabPool(poolName, 0,
+            (OPM_PLACEMENT_INIT_PTR)&OPMTest::initializeInPlace, slabObjectSize, 0.8, 10,
+            initialSize, false, OPM_GROWTH_ALLOWED, OPM_SLAB_PREFAULT);
+      }//end for
+      ACE_Time_Value createTime = ACE_OS::gettimeofday() - startTime;
+      long createResident = opmTestGetResidentKB() - startResident;
+
+      // Lazy pools must not construct anything before their first reserve
+      int createdCount = opmTestConstructedCount - startConstructedCount;
+      int expectedCount = (isLazy ? 0 : (numberPools * 2 * initialSize));
+      if (createdCount != expectedCount)
+      {
+         printf("%s pools constructed %d objects at creation, expected %d\n", modeNames[mode],
+            createdCount, expectedCount);
+         errorCount++;
+      }//end if
+
+      startTime = ACE_OS::gettimeofday();
+      OPMBase* objects[reserveCount];
+      for (int i = 0; i < (numberPools * 2); i++)
+      {
+         for (int j = 0; j < reserveCount; j++)
+         {
+            objects[j] = OPM_RESERVE(poolIDs[i]);
+         }//end for
+         for (int j = 0; j < reserveCount; j++)
+         {
+            OPM_RELEASE(objects[j]);
+         }//end for
+      }//end for
+      ACE_Time_Value reserveTime = ACE_OS::gettimeofday() - startTime;
+
+      // ..and then construct exactly the objects that were reserved
+      createdCount = opmTestConstructedCount - startConstructedCount;
+      expectedCount = (isLazy ? (numberPools * 2 * reserveCount) : (numberPools * 2 * initialSize));
+      if (createdCount != expectedCount)
+      {
+         printf("%s pools constructed %d objects after the first reserves, expected %d\n",
+            modeNames[mode], createdCount, expectedCount);
+         errorCount++;
+      }//end if
+
+      printf("%8s %18.2f %14ld %22ld\n", modeNames[mode],
+         (createTime.sec() * 1000.0) + (createTime.usec() / 1000.0), createResident,
+         (reserveTime.sec() * 1000000L) + reserveTime.usec());
+   }//end for
+
+   OPM::setLazyConstruction(false);
+   Logger::setSubsystemLogLevel(OPMLOG, previousLogLevel);
+
+   if (errorCount != 0)
+   {
+      printf("Lazy construction test FAILED\n");
+   }//end if
+   else
+   {
+      printf("Lazy construction test passed\n");
+   }//end else
+}//end opmTest7Start
+
+
 //-----------------------------------------------------------------------------
 // Method Type: Overriden initialize method
 // Description: 
@@ -207,10 +610,25 @@ OPMBase* OPMTest::initialize(int initializer)
    int tmp __attribute__ ((unused)) = initializer;
 
    TRACELOG(DEBUGLOG, OPMLOG, "OPMTest initialize is called in Process (%d)", getpid(),0,0,0,0,0);
+   opmTestConstructedCount++;
    return (new OPMTest());
 }//end initialize
 
 
+//-----------------------------------------------------------------------------
+// Method Type: Slab mode initialize method
+// Description: 
+// Design:     
+//-----------------------------------------------------------------------------
+OPMBase* OPMTest::initializeInPlace(void* memory, long initializer)
+{
+   long tmp __attribute__ ((unused)) = initializer;
+
+   opmTestConstructedCount++;
+   return (new (memory) OPMTest());
+}//end initializeInPlace
+
+
 //-----------------------------------------------------------------------------
 // Method Type: Overriden clean method
 // Description: 
@@ -249,6 +667,562 @@ void OPMTest::doSomething()
 //-----------------------------------------------------------------------------
 
 
+/* Pool shared by the test #8 threads */
+int opmTestStatsPoolID = 0;
+
+/* Reserve/release cycles performed by each test #8 thread */
+#define OPM_TEST_STATS_CYCLES 20000
+
+//-----------------------------------------------------------------------------
+// Method Type: Test8 thread function
+// Description: Reserves and releases objects from the shared pool as quickly
+//              as possible, so that the threads contend for the pool lock.
+// Design:
+//-----------------------------------------------------------------------------
+void* opmTestStatsThread(void*)
+{
+   for (int i = 0; i < OPM_TEST_STATS_CYCLES; i++)
+   {
+      OPMBase* object = OPM_RESERVE(opmTestStatsPoolID);
+      if (object != NULL)
+      {
+         OPM_RELEASE(object);
+      }//end if
+   }//end for
+   return NULL;
+}//end opmTestStatsThread
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test8 entry function
+// Description: Exercises a shared pool from several threads, then reads this
+//              process's statistics segment the way OPMStat does.
+// Design:      The pool counters must match the work done exactly, and the
+//              contended lock acquisitions must all appear in the histogram.
+//-----------------------------------------------------------------------------
+void opmTest8Start()
+{
+   const int numberThreads = 4;
+
+   opmTestStatsPoolID = OPM::createPool("OPMTestStats", 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+      10, 10, true, OPM_GROWTH_ALLOWED);
+   if (opmTestStatsPoolID == ERROR)
+   {
+      printf("Unable to create statistics test pool\n");
+      return;
+   }//end if
+
+   // Keep per-object logging out of the measurements
+   LogEntrySeverityType previousLogLevel = Logger::getSubsystemLogLevel(OPMLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+
+   ACE_thread_t threadIds[numberThreads];
+   for (int i = 0; i < numberThreads; i++)
+   {
+      ACE_Thread_Manager::instance()->spawn(opmTestStatsThread, NULL, THR_NEW_LWP | THR_JOINABLE,
+         &threadIds[i]);
+   }//end for
+   for (int i = 0; i < numberThreads; i++)
+   {
+      ACE_Thread_Manager::instance()->join(threadIds[i]);
+   }//end for
+   Logger::setSubsystemLogLevel(OPMLOG, previousLogLevel);
+
+   const OPMStatsSegment* segment = OPMStats::attach(getpid());
+   if (segment == NULL)
+   {
+      printf("\nUnable to attach to this process's OPM statistics segment\n");
+      return;
+   }//end if
+
+   const OPMPoolStats& stats = segment->pools_[opmTestStatsPoolID];
+   unsigned long long histogramTotal = 0;
+   for (int bucket = 0; bucket < OPM_STATS_HISTOGRAM_BUCKETS; bucket++)
+   {
+      histogramTotal += stats.lockWaitHistogram_[bucket];
+   }//end for
+
+   unsigned long long expectedCount = (unsigned long long)numberThreads * OPM_TEST_STATS_CYCLES;
+   printf("\nStatistics of %s read from the shared segment: %llu reserves, %llu releases,"
+      " %llu contended (%llu usec waiting), %llu growths\n", stats.objectType_, stats.reserveCount_,
+      stats.releaseCount_, stats.contentionCount_, stats.lockWaitUsec_, stats.growthCount_);
+   if ((stats.reserveCount_ != expectedCount) || (stats.releaseCount_ != expectedCount) ||
+       (histogramTotal != stats.contentionCount_))
+   {
+      printf("Statistics test FAILED (expected %llu reserves and releases, histogram total %llu)\n",
+         expectedCount, histogramTotal);
+   }//end if
+   else
+   {
+      printf("Statistics test passed\n");
+   }//end else
+   OPMStats::detach(segment);
+
+   OPM::printPoolSummary(opmTestStatsPoolID);
+}//end opmTest8Start
+
+
+/* Objects each test #9 thread reserves and writes through */
+#define OPM_TEST_NUMA_OBJECTS 8192
+
+/* Size of each test #9 object (slab slot) in bytes */
+#define OPM_TEST_NUMA_OBJECT_SIZE 1024
+
+/* Number of times each test #9 thread writes through its objects */
+#define OPM_TEST_NUMA_PASSES 8
+
+/* Work given to (and result returned by) each test #9 thread */
+struct OPMTestNumaWork
+{
+   int poolID_;
+   int node_;
+   long elapsedUsec_;
+};
+
+//-----------------------------------------------------------------------------
+// Method Type: Test9 thread function
+// Description: Binds to its NUMA node, reserves a set of objects and times
+//              repeated writes through them, then releases them.
+// Design:      Only the writes are timed, so the result reflects where the
+//              objects' memory lives rather than the cost of reserving them.
+//-----------------------------------------------------------------------------
+void* opmTestNumaThread(void* arg)
+{
+   OPMTestNumaWork* work = (OPMTestNumaWork*)arg;
+   cpu_set_t previousCpus;
+   OPMNuma::bindToNode(work->node_, &previousCpus);
+
+   OPMBase** objects = new OPMBase*[OPM_TEST_NUMA_OBJECTS];
+   for (int i = 0; i < OPM_TEST_NUMA_OBJECTS; i++)
+   {
+      objects[i] = OPM_RESERVE(work->poolID_);
+   }//end for
+
+   // Write the part of each slot after the object itself
+   size_t payloadSize = OPM_TEST_NUMA_OBJECT_SIZE - sizeof(OPMTest);
+   ACE_Time_Value startTime = ACE_OS::gettimeofday();
+   for (int pass = 0; pass < OPM_TEST_NUMA_PASSES; pass++)
+   {
+      for (int i = 0; i < OPM_TEST_NUMA_OBJECTS; i++)
+      {
+         if (objects[i] != NULL)
+         {
+            memset((char*)objects[i] + sizeof(OPMTest), pass, payloadSize);
+         }//end if
+      }//end for
+   }//end for
+   ACE_Time_Value elapsed = ACE_OS::gettimeofday() - startTime;
+   work->elapsedUsec_ = (elapsed.sec() * 1000000L) + elapsed.usec();
+
+   for (int i = 0; i < OPM_TEST_NUMA_OBJECTS; i++)
+   {
+      if (objects[i] != NULL)
+      {
+         OPM_RELEASE(objects[i]);
+      }//end if
+   }//end for
+   delete [] objects;
+   return NULL;
+}//end opmTestNumaThread
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test9 entry function
+// Description: Benchmarks NUMA local against interleaved placement: one
+//              thread per node writes through objects reserved from a NUMA
+//              local pool, and then from a NUMA interleaved pool.
+// Design:      Each node's sub-pool holds twice what its thread reserves, so
+//              the local pool never has to fall back to a remote node. On a
+//              single node machine both pools are ordinary pools.
+//-----------------------------------------------------------------------------
+void opmTest9Start()
+{
+   const int nodeCount = OPMNuma::getNodeCount();
+   const char* modeNames[] = { "local", "interleaved" };
+   const OPMNumaModeType modes[] = { OPM_NUMA_LOCAL, OPM_NUMA_INTERLEAVED };
+
+   // Keep per-object logging out of the measurements
+   LogEntrySeverityType previousLogLevel = Logger::getSubsystemLogLevel(OPMLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+
+   printf("\nOPM NUMA placement benchmark: %d node(s), %d objects of %d bytes per node, %d passes\n",
+      nodeCount, OPM_TEST_NUMA_OBJECTS, OPM_TEST_NUMA_OBJECT_SIZE, OPM_TEST_NUMA_PASSES);
+   printf("%12s %14s %20s\n", "Placement", "total (msec)", "per object (nsec)");
+
+   for (int mode = 0; mode < 2; mode++)
+   {
+      char poolName[64];
+      sprintf(poolName, "OPMTestNuma%s", modeNames[mode]);
+      int poolID = OPM::createSlabPool(poolName, 0, (OPM_PLACEMENT_INIT_PTR)&OPMTest::initializeInPlace,
+         OPM_TEST_NUMA_OBJECT_SIZE, 0.9, OPM_TEST_NUMA_OBJECTS, OPM_TEST_NUMA_OBJECTS * 2 * nodeCount,
+         true, OPM_GROWTH_ALLOWED, OPM_SLAB_PREFAULT, modes[mode]);
+      if (poolID == ERROR)
+      {
+         printf("Unable to create %s NUMA pool\n", modeNames[mode]);
+         continue;
+      }//end if
+
+      OPMTestNumaWork work[OPM_MAX_NUMA_NODES];
+      ACE_thread_t threadIds[OPM_MAX_NUMA_NODES];
+      for (int node = 0; node < nodeCount; node++)
+      {
+         work[node].poolID_ = poolID;
+         work[node].node_ = node;
+         work[node].elapsedUsec_ = 0;
+         ACE_Thread_Manager::instance()->spawn(opmTestNumaThread, &work[node],
+            THR_NEW_LWP | THR_JOINABLE, &threadIds[node]);
+      }//end for
+
+      long totalUsec = 0;
+      for (int node = 0; node < nodeCount; node++)
+      {
+         ACE_Thread_Manager::instance()->join(threadIds[node]);
+         totalUsec += work[node].elapsedUsec_;
+      }//end for
+
+      long objectWrites = (long)nodeCount * OPM_TEST_NUMA_OBJECTS * OPM_TEST_NUMA_PASSES;
+      printf("%12s %14.2f %20.1f\n", modeNames[mode], totalUsec / 1000.0,
+         (totalUsec * 1000.0) / objectWrites);
+   }//end for
+
+   Logger::setSubsystemLogLevel(OPMLOG, previousLogLevel);
+}//end opmTest9Start
+
+
+/* Buffers in the test #10 shared pool */
+#define OPM_TEST_SHARED_BUFFERS 32
+
+/* Size of each test #10 shared buffer in bytes */
+#define OPM_TEST_SHARED_BUFFER_SIZE 256
+
+/* Messages the test #10 child process sends through the shared pool */
+#define OPM_TEST_SHARED_MESSAGES 5000
+
+//-----------------------------------------------------------------------------
+// Method Type: Test10 child process function
+// Description: Maps the shared pool, fills buffers in place and passes only
+//              their offsets to the parent through a pipe.
+// Design:      Sends many more messages than there are buffers, so it relies
+//              on the parent releasing them (waiting while the pool is empty).
+//-----------------------------------------------------------------------------
+void opmTestSharedSender(int pipeFd)
+{
+   OPMSharedPool sharedPool("OPMTestShared", OPM_TEST_SHARED_BUFFER_SIZE, OPM_TEST_SHARED_BUFFERS);
+   if (sharedPool.open() == false)
+   {
+      _exit(1);
+   }//end if
+
+   for (unsigned int message = 0; message < OPM_TEST_SHARED_MESSAGES; message++)
+   {
+      unsigned long offset;
+      while ((offset = sharedPool.reserve()) == OPM_SHARED_NULL_OFFSET)
+      {
+         usleep(100);
+      }//end while
+
+      unsigned char* buffer = (unsigned char*)sharedPool.getAddress(offset);
+      memcpy(buffer, &message, sizeof(message));
+      memset(buffer + sizeof(message), (unsigned char)message, OPM_TEST_SHARED_BUFFER_SIZE - sizeof(message));
+      if (write(pipeFd, &offset, sizeof(offset)) != (ssize_t)sizeof(offset))
+      {
+         _exit(1);
+      }//end if
+   }//end for
+   _exit(0);
+}//end opmTestSharedSender
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test10 entry function
+// Description: Exchanges messages with a child process through a shared pool
+//              by offset, checking each in place, then checks exhaustion.
+// Design:      The pool must be empty again once every message has been
+//              received, and must refuse a reservation once it is full.
+//-----------------------------------------------------------------------------
+void opmTest10Start()
+{
+   OPMSharedPool sharedPool("OPMTestShared", OPM_TEST_SHARED_BUFFER_SIZE, OPM_TEST_SHARED_BUFFERS);
+   // Start from a new segment in case an earlier run left one behind
+   sharedPool.remove();
+   if (sharedPool.open() == false)
+   {
+      printf("\nUnable to open shared pool\n");
+      return;
+   }//end if
+
+   int pipeFds[2];
+   if (pipe(pipeFds) == ERROR)
+   {
+      printf("\nUnable to create pipe for shared pool test\n");
+      sharedPool.remove();
+      return;
+   }//end if
+
+   pid_t childId = fork();
+   if (childId == ERROR)
+   {
+      printf("\nUnable to fork shared pool test process\n");
+      close(pipeFds[0]);
+      close(pipeFds[1]);
+      sharedPool.remove();
+      return;
+   }//end if
+   else if (childId == 0)
+   {
+      close(pipeFds[0]);
+      opmTestSharedSender(pipeFds[1]);
+   }//end if
+   close(pipeFds[1]);
+
+   int errorCount = 0;
+   unsigned int received = 0;
+   unsigned long offset;
+   while (read(pipeFds[0], &offset, sizeof(offset)) == (ssize_t)sizeof(offset))
+   {
+      if (sharedPool.isValidOffset(offset) == false)
+      {
+         errorCount++;
+         received++;
+         continue;
+      }//end if
+
+      // Read the message in place, where the child process wrote it
+      unsigned char* buffer = (unsigned char*)sharedPool.getAddress(offset);
+      unsigned int message;
+      memcpy(&message, buffer, sizeof(message));
+      if ((message != received) || (buffer[OPM_TEST_SHARED_BUFFER_SIZE - 1] != (unsigned char)received))
+      {
+         errorCount++;
+      }//end if
+      sharedPool.release(offset);
+      received++;
+   }//end while
+   close(pipeFds[0]);
+
+   int childStatus = 0;
+   waitpid(childId, &childStatus, 0);
+
+   // Fill the pool; the next reservation must fail
+   unsigned long offsets[OPM_TEST_SHARED_BUFFERS];
+   int reservedCount = 0;
+   for (int i = 0; i < OPM_TEST_SHARED_BUFFERS; i++)
+   {
+      if ((offsets[i] = sharedPool.reserve()) != OPM_SHARED_NULL_OFFSET)
+      {
+         reservedCount++;
+      }//end if
+   }//end for
+   bool isExhausted = (sharedPool.reserve() == OPM_SHARED_NULL_OFFSET);
+   for (int i = 0; i < reservedCount; i++)
+   {
+      sharedPool.release(offsets[i]);
+   }//end for
+
+   printf("\n%s\n", sharedPool.toString().c_str());
+   if ((received != OPM_TEST_SHARED_MESSAGES) || (errorCount != 0) || (childStatus != 0) ||
+       (reservedCount != OPM_TEST_SHARED_BUFFERS) || (isExhausted == false) || (sharedPool.getUsedCount() != 0))
+   {
+      printf("Shared pool test FAILED (received %u of %d messages, %d corrupt, %d of %d reserved when empty)\n",
+         received, OPM_TEST_SHARED_MESSAGES, errorCount, reservedCount, OPM_TEST_SHARED_BUFFERS);
+   }//end if
+   else
+   {
+      printf("Shared pool test passed (%u messages exchanged by offset through %d buffers)\n",
+         received, OPM_TEST_SHARED_BUFFERS);
+   }//end else
+
+   sharedPool.close();
+   sharedPool.remove();
+}//end opmTest10Start
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test11 entry function
+// Description: Creates more pools than fit in one block of the pool table, and
+//              checks that the pools of the new block are found by ID and by
+//              name, and that their objects can be reserved and released.
+// Design:      The earlier tests have already created some pools, so the new
+//              pools start part way through the first block.
+//-----------------------------------------------------------------------------
+void opmTest11Start()
+{
+   const int numberPools = OPM_POOL_BLOCK_SIZE + 8;
+
+   // Keep the per-pool creation logs out of the output
+   LogEntrySeverityType previousLogLevel = Logger::getSubsystemLogLevel(OPMLOG);
+   Logger::setSubsystemLogLevel(OPMLOG, ERRORLOG);
+
+   int errorCount = 0;
+   int lastPoolID = ERROR;
+   for (int i = 0; i < numberPools; i++)
+   {
+      char poolName[64];
+      sprintf(poolName, "OPMTestTableGrowth%d", i);
+      int poolID = OPM::createPool(poolName, 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+         1, 1, false, OPM_GROWTH_ALLOWED);
+      if ((poolID == ERROR) || (poolID <= lastPoolID) || (OPM::getObjectPoolID(poolName, 0) != poolID))
+      {
+         errorCount++;
+         continue;
+      }//end if
+      lastPoolID = poolID;
+
+      OPMBase* object = OPM_RESERVE(poolID);
+      if ((object == NULL) || (OPM::isCreatedByOPM(object) == false) ||
+          (OPM::releaseObject(object, __FILE__, __LINE__) == false))
+      {
+         errorCount++;
+      }//end if
+   }//end for
+
+   Logger::setSubsystemLogLevel(OPMLOG, previousLogLevel);
+
+   if ((errorCount != 0) || (lastPoolID < OPM_POOL_BLOCK_SIZE))
+   {
+      printf("\nPool table growth test FAILED (%d errors, last pool ID %d)\n", errorCount, lastPoolID);
+   }//end if
+   else
+   {
+      printf("\nPool table growth test passed (%d pools, last pool ID %d)\n", numberPools, lastPoolID);
+   }//end else
+}//end opmTest11Start
+
+
+/* State shared between test #12 and its thread */
+struct OPMTestReinitWork
+{
+   ACE_Barrier* barrier_;
+   int poolID_;
+   bool reserved_;
+};
+
+//-----------------------------------------------------------------------------
+// Method Type: Test12 thread function
+// Description: Leaves an object in this thread's cache, waits while the main
+//              thread shuts down and re-initializes OPM, then reserves from
+//              the recreated pool.
+// Design:      Each pair of barrier waits hands control to the main thread and
+//              back again.
+//-----------------------------------------------------------------------------
+void* opmTestReinitThread(void* arg)
+{
+   OPMTestReinitWork* work = (OPMTestReinitWork*)arg;
+
+   OPMBase* object = OPM_RESERVE(work->poolID_);
+   if (object != NULL)
+   {
+      OPM_RELEASE(object);
+   }//end if
+   work->barrier_->wait();
+   work->barrier_->wait();
+
+   object = OPM_RESERVE_NONBLOCKED(work->poolID_);
+   work->reserved_ = (object != NULL);
+   work->barrier_->wait();
+   work->barrier_->wait();
+
+   if (object != NULL)
+   {
+      OPM_RELEASE(object);
+   }//end if
+   return NULL;
+}//end opmTestReinitThread
+
+
+//-----------------------------------------------------------------------------
+// Method Type: Test12 entry function
+// Description: Checks that an object left in another thread's cache across
+//              OPM shutdown and initialize is not handed out again from the
+//              pool that reuses its pool ID, and that the default OPM::Pool<T>
+//              pool is created again after the shutdown.
+// Design:      The recreated pool holds two objects and the other thread takes
+//              one of them, so exactly one more can be reserved here. A stale
+//              cache would have served the other thread a deleted object
+//              instead, leaving both to this thread.
+//-----------------------------------------------------------------------------
+void opmTest12Start()
+{
+   const int poolSize = 2;
+
+   OPM::shutdown();
+   OPM::initialize();
+   OPMTestReinitWork work;
+   ACE_Barrier barrier(2);
+   work.barrier_ = &barrier;
+   work.reserved_ = false;
+   work.poolID_ = OPM::createPool("OPMTestReinit", 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+      0, poolSize, true, OPM_NO_GROWTH);
+   if ((work.poolID_ == ERROR) || (OPM::setPoolThreadCacheSize(work.poolID_, poolSize) == false))
+   {
+      printf("Unable to create re-initialization test pool\n");
+      return;
+   }//end if
+
+   ACE_thread_t threadId;
+   ACE_Thread_Manager::instance()->spawn(opmTestReinitThread, &work, THR_NEW_LWP | THR_JOINABLE,
+      &threadId);
+   barrier.wait();
+
+   // The thread's cache now holds an object of the pool about to be deleted
+   OPM::shutdown();
+   OPM::initialize();
+   int poolID = OPM::createPool("OPMTestReinit", 0, (OPM_INIT_PTR)&OPMTest::initialize, 0.8,
+      0, poolSize, true, OPM_NO_GROWTH);
+   OPM::setPoolThreadCacheSize(poolID, poolSize);
+   barrier.wait();
+   barrier.wait();
+
+   OPMBase* objects[poolSize + 1];
+   int reservedCount = 0;
+   while (reservedCount <= poolSize)
+   {
+      objects[reservedCount] = OPM_RESERVE_NONBLOCKED(poolID);
+      if (objects[reservedCount] == NULL)
+      {
+         break;
+      }//end if
+      reservedCount++;
+   }//end while
+   barrier.wait();
+   ACE_Thread_Manager::instance()->join(threadId);
+   for (int i = 0; i < reservedCount; i++)
+   {
+      OPM_RELEASE(objects[i]);
+   }//end for
+
+   if ((poolID != work.poolID_) || (work.reserved_ == false) || (reservedCount != (poolSize - 1)))
+   {
+      printf("\nRe-initialization test FAILED (pool ID %d then %d, thread reserved %d, %d reserved here)\n",
+         work.poolID_, poolID, work.reserved_, reservedCount);
+   }//end if
+   else
+   {
+      printf("\nRe-initialization test passed\n");
+   }//end else
+
+   // The typed pool of test #5 went with the shutdowns, so it is created again
+   // rather than its stale pool ID being reused
+   bool isTypedPoolStale = (OPM::Pool<OPMTest>::getPoolID() != ERROR);
+   int typedPoolID = OPM::Pool<OPMTest>::create("OPMTestTyped", 0, 0.8, 5, 10, true, OPM_GROWTH_ALLOWED);
+   bool isTypedObjectReserved = false;
+   {
+      OPM::Pool<OPMTest>::Ptr typedObject;
+      isTypedObjectReserved = !typedObject.isNull();
+   }
+   if (isTypedPoolStale || (typedPoolID == ERROR) || (OPM::Pool<OPMTest>::getPoolID() != typedPoolID) ||
+       !isTypedObjectReserved)
+   {
+      printf("Typed pool re-creation test FAILED (stale ID %s, pool ID %d, object %s)\n",
+         isTypedPoolStale ? "kept" : "dropped", typedPoolID, isTypedObjectReserved ? "reserved" : "not reserved");
+   }//end if
+   else
+   {
+      printf("Typed pool re-creation test passed\n");
+   }//end else
+}//end opmTest12Start
+
+
 //-----------------------------------------------------------------------------
 // Function Type: main function for test binary
 // Description:
@@ -286,6 +1260,39 @@ int main(int argc, char* argv[])
    // Run test #1 (thread safe)
    opmTestStart(true);
 
+   // Run test #3 release cost scaling benchmark
+   opmTest3Start();
+
+   // Run test #4 slab mode pool
+   opmTest4Start();
+
+   // Run test #5 typed pool and scoped pointer
+   opmTest5Start();
+
+   // Run test #6 background maintained pool
+   opmTest6Start();
+
+   // Run test #7 lazy versus eager construction startup cost
+   opmTest7Start();
+
+   // Run test #8 contention statistics read from the shared segment
+   opmTest8Start();
+
+   // Run test #9 NUMA local versus interleaved placement benchmark
+   opmTest9Start();
+
+   // Run test #10 zero copy exchange through a shared memory pool
+   opmTest10Start();
+
+   // Run test #11 pool table growth beyond one block
+   opmTest11Start();
+
+   // Run test #12 thread caches invalidated by shutdown and re-initialize
+   opmTest12Start();
+
+   // Recreate the pool for test #2, which test #12 shut down
+   opmTestStart(true);
+
    // Run test #2 with the specified number of threads
    opmTest2Start(2);
 
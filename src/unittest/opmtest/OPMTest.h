@@ -60,6 +60,16 @@ class OPMTest : public OPMBase
        */
       static OPMBase* initialize(int initializer);
 
+      /**
+       * Slab mode (OPM::createSlabPool) version of initialize that constructs
+       * the object in the given memory.
+       * @param memory - Slab memory of at least sizeof(OPMTest) bytes
+       * @param initializer - Initializer integer or pointer to initialization
+       *      data needed by the object. 
+       * @returns Pointer to the new OPMBase object.
+       */
+      static OPMBase* initializeInPlace(void* memory, long initializer);
+
       /**
        * Pure Virtual method will be called before releasing the object 
        * back into the pool.